@@ -0,0 +1,152 @@
+#include <atomic>
+using std::atomic;
+
+#include <condition_variable>
+using std::condition_variable;
+
+#include <functional>
+using std::function;
+
+#include <memory>
+using std::make_shared;
+using std::shared_ptr;
+
+#include <mutex>
+using std::lock_guard;
+using std::mutex;
+using std::unique_lock;
+
+#include <thread>
+using std::thread;
+
+#include "batch_thread_pool.hxx"
+
+BatchThreadPool::BatchThreadPool(int32_t _number_threads, int32_t _minimum_slice_size) {
+    number_threads = _number_threads;
+    if (number_threads < 0) {
+        number_threads = 0;
+    }
+
+    minimum_slice_size = _minimum_slice_size;
+    if (minimum_slice_size < 1) {
+        minimum_slice_size = 1;
+    }
+
+    stopping = false;
+
+    for (int32_t i = 0; i < number_threads; i++) {
+        workers.push_back(thread(&BatchThreadPool::worker_loop, this));
+    }
+}
+
+BatchThreadPool::~BatchThreadPool() {
+    {
+        lock_guard<mutex> lock(queue_mutex);
+        stopping = true;
+    }
+    queue_condition.notify_all();
+
+    for (uint32_t i = 0; i < workers.size(); i++) {
+        workers[i].join();
+    }
+}
+
+void BatchThreadPool::worker_loop() {
+    while (true) {
+        function<void()> task;
+        {
+            unique_lock<mutex> lock(queue_mutex);
+            queue_condition.wait(lock, [this] { return stopping || !tasks.empty(); });
+
+            if (stopping && tasks.empty()) {
+                return;
+            }
+
+            task = tasks.front();
+            tasks.pop_front();
+        }
+
+        task();
+    }
+}
+
+int32_t BatchThreadPool::get_number_threads() const {
+    return number_threads;
+}
+
+int32_t BatchThreadPool::get_number_slices(int32_t batch_size) const {
+    int32_t number_slices = batch_size / minimum_slice_size;
+    if (number_slices > number_threads + 1) {
+        number_slices = number_threads + 1;
+    }
+    if (number_slices < 1) {
+        number_slices = 1;
+    }
+    return number_slices;
+}
+
+/**
+ *  Shared between the caller of parallel_for and the helper tasks it queues.  Helper tasks may be dequeued after
+ *  parallel_for has returned (if the caller and other helpers took all the slices first), so this is reference
+ *  counted and the slice function is only dereferenced by tasks that actually claimed a slice.
+ */
+struct SliceState {
+    int32_t batch_size;
+    int32_t number_slices;
+    const function<void(int32_t, int32_t, int32_t)>* slice_function;
+
+    atomic<int32_t> next_slice;
+    atomic<int32_t> remaining_slices;
+
+    mutex done_mutex;
+    condition_variable done_condition;
+};
+
+static void process_slices(const shared_ptr<SliceState>& state) {
+    while (true) {
+        int32_t slice = state->next_slice.fetch_add(1);
+        if (slice >= state->number_slices) {
+            return;
+        }
+
+        int32_t start = (int32_t) (((int64_t) state->batch_size * slice) / state->number_slices);
+        int32_t end = (int32_t) (((int64_t) state->batch_size * (slice + 1)) / state->number_slices);
+        (*state->slice_function)(slice, start, end);
+
+        if (state->remaining_slices.fetch_sub(1) == 1) {
+            lock_guard<mutex> lock(state->done_mutex);
+            state->done_condition.notify_all();
+        }
+    }
+}
+
+void BatchThreadPool::parallel_for(
+    int32_t batch_size, const function<void(int32_t, int32_t, int32_t)>& slice_function
+) {
+    int32_t number_slices = get_number_slices(batch_size);
+
+    if (number_slices == 1) {
+        slice_function(0, 0, batch_size);
+        return;
+    }
+
+    shared_ptr<SliceState> state = make_shared<SliceState>();
+    state->batch_size = batch_size;
+    state->number_slices = number_slices;
+    state->slice_function = &slice_function;
+    state->next_slice = 0;
+    state->remaining_slices = number_slices;
+
+    {
+        lock_guard<mutex> lock(queue_mutex);
+        for (int32_t i = 1; i < number_slices; i++) {
+            tasks.push_back([state] { process_slices(state); });
+        }
+    }
+    queue_condition.notify_all();
+
+    process_slices(state);
+
+    unique_lock<mutex> lock(state->done_mutex);
+    state->done_condition.wait(lock, [&state] { return state->remaining_slices.load() == 0; });
+}
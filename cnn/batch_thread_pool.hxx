@@ -0,0 +1,67 @@
+#ifndef CNN_BATCH_THREAD_POOL_H
+#define CNN_BATCH_THREAD_POOL_H
+
+#include <condition_variable>
+using std::condition_variable;
+
+#include <deque>
+using std::deque;
+
+#include <functional>
+using std::function;
+
+#include <mutex>
+using std::mutex;
+
+#include <thread>
+using std::thread;
+
+#include <vector>
+using std::vector;
+
+#include "stdint.h"
+
+/**
+ *  A pool of threads shared by all the genomes being trained in a process, used to split the images of a mini-batch
+ *  into slices which are processed concurrently (intra-genome parallelism).  Multiple genomes may call parallel_for at
+ *  the same time; the calling thread always works on its own slices as well, so a genome never waits on the pool when
+ *  all the pool threads are busy with other genomes.
+ */
+class BatchThreadPool {
+   private:
+    int32_t number_threads;
+    int32_t minimum_slice_size;
+
+    vector<thread> workers;
+
+    mutex queue_mutex;
+    condition_variable queue_condition;
+    deque<function<void()> > tasks;
+    bool stopping;
+
+    void worker_loop();
+
+   public:
+    /**
+     *  Creates a pool with _number_threads helper threads, a batch will not be split into slices of fewer than
+     *  _minimum_slice_size images.
+     */
+    BatchThreadPool(int32_t _number_threads, int32_t _minimum_slice_size);
+    ~BatchThreadPool();
+
+    int32_t get_number_threads() const;
+
+    /**
+     *  Returns how many slices parallel_for will split a batch of batch_size images into, so callers can allocate
+     *  any per slice buffers before calling it.
+     */
+    int32_t get_number_slices(int32_t batch_size) const;
+
+    /**
+     *  Splits [0, batch_size) into get_number_slices(batch_size) contiguous slices and calls
+     *  slice_function(slice, start, end) for each of them, returning when all slices have been processed.
+     */
+    void parallel_for(int32_t batch_size, const function<void(int32_t, int32_t, int32_t)>& slice_function);
+};
+
+#endif
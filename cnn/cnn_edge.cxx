@@ -417,6 +417,79 @@ void CNN_Edge::accumulate_times(
     total_weight_update_time += weight_update_time;
 }
 
+float CNN_Edge::get_propagate_forward_time() const {
+    return propagate_forward_time;
+}
+
+float CNN_Edge::get_propagate_backward_time() const {
+    return propagate_backward_time;
+}
+
+float CNN_Edge::get_weight_update_time() const {
+    return weight_update_time;
+}
+
+/**
+ *  The number of input/output pixel pairs touched for a single image: for a convolution every weight is applied to
+ *  every pixel of the smaller node, for pooling every pixel of the larger node is visited once.
+ */
+float CNN_Edge::get_propagate_count() const {
+    int input_size_x = input_node->get_size_x();
+    int input_size_y = input_node->get_size_y();
+    int output_size_x = output_node->get_size_x();
+    int output_size_y = output_node->get_size_y();
+
+    if (type == CONVOLUTIONAL) {
+        if (reverse_filter_x && reverse_filter_y) {
+            return (float) filter_x * filter_y * input_size_x * input_size_y;
+        } else if (reverse_filter_x) {
+            return (float) filter_x * filter_y * input_size_x * output_size_y;
+        } else if (reverse_filter_y) {
+            return (float) filter_x * filter_y * output_size_x * input_size_y;
+        } else {
+            return (float) filter_x * filter_y * output_size_x * output_size_y;
+        }
+    } else {
+        if (reverse_filter_x && reverse_filter_y) {
+            return (float) input_size_x * input_size_y;
+        } else if (reverse_filter_y) {
+            return (float) input_size_x * output_size_y;
+        } else if (reverse_filter_x) {
+            return (float) output_size_x * input_size_y;
+        } else {
+            return (float) output_size_x * output_size_y;
+        }
+    }
+}
+
+/**
+ *  Estimated floating point operations for a forward and backward pass of a single image.  A convolution does a
+ *  multiply and add forward, and two of each backward (weight update and input error) per propagate count; pooling
+ *  does a compare forward, a scale per output and a single scatter add backward.
+ */
+float CNN_Edge::get_flop_estimate() const {
+    float propagate_count = get_propagate_count();
+
+    if (type == CONVOLUTIONAL) {
+        return 6.0 * propagate_count;
+    } else {
+        return (2.0 * propagate_count) + (output_node->get_size_x() * output_node->get_size_y());
+    }
+}
+
+/**
+ *  The forward pass part of get_flop_estimate, what running a single image through the edge takes.
+ */
+float CNN_Edge::get_forward_flop_estimate() const {
+    float propagate_count = get_propagate_count();
+
+    if (type == CONVOLUTIONAL) {
+        return 2.0 * propagate_count;
+    } else {
+        return propagate_count + (output_node->get_size_x() * output_node->get_size_y());
+    }
+}
+
 int CNN_Edge::get_type() const {
     return type;
 }
@@ -557,6 +630,7 @@ void CNN_Edge::resize() {
 
     initialize_pools(y_pools, y_pool_offset, input_node->get_size_y(), output_node->get_size_y());
     initialize_pools(x_pools, x_pool_offset, input_node->get_size_x(), output_node->get_size_x());
+    pool_map.clear();
 
     needs_initialization = true;
 }
@@ -725,6 +799,7 @@ bool CNN_Edge::set_nodes(const vector<CNN_Node*> nodes) {
 void CNN_Edge::set_pools() {
     initialize_pools(y_pools, y_pool_offset, input_node->get_size_y(), output_node->get_size_y());
     initialize_pools(x_pools, x_pool_offset, input_node->get_size_x(), output_node->get_size_x());
+    pool_map.clear();
 }
 
 bool CNN_Edge::is_filter_correct() const {
@@ -977,9 +1052,69 @@ void CNN_Edge::check_output_update(
     }
 }
 
+void CNN_Edge::convolve_forward(const float* input, float* output, int32_t slice_batch_size) {
+    int output_size_x = output_node->get_size_x();
+    int output_size_y = output_node->get_size_y();
+    int input_size_x = input_node->get_size_x();
+    int input_size_y = input_node->get_size_y();
+
+    if (reverse_filter_y && reverse_filter_x) {
+        prop_forward_ry_rx(
+            input, weights, output, slice_batch_size, input_size_y, input_size_x, filter_y, filter_x, output_size_y,
+            output_size_x
+        );
+    } else if (reverse_filter_y) {
+        prop_forward_ry(
+            input, weights, output, slice_batch_size, input_size_y, input_size_x, filter_y, filter_x, output_size_y,
+            output_size_x
+        );
+    } else if (reverse_filter_x) {
+        prop_forward_rx(
+            input, weights, output, slice_batch_size, input_size_y, input_size_x, filter_y, filter_x, output_size_y,
+            output_size_x
+        );
+    } else {
+        prop_forward(
+            input, weights, output, slice_batch_size, input_size_y, input_size_x, filter_y, filter_x, output_size_y,
+            output_size_x
+        );
+    }
+}
+
+void CNN_Edge::convolve_backward(
+    float* output_errors, float* input, float* input_errors, float* updates, int32_t slice_batch_size
+) {
+    int input_size_x = input_node->get_size_x();
+    int input_size_y = input_node->get_size_y();
+    int output_size_x = output_node->get_size_x();
+    int output_size_y = output_node->get_size_y();
+
+    if (reverse_filter_x && reverse_filter_y) {
+        prop_backward_ry_rx(
+            output_errors, input, input_errors, updates, weights, slice_batch_size, input_size_y, input_size_x,
+            filter_y, filter_x, output_size_y, output_size_x
+        );
+    } else if (reverse_filter_y) {
+        prop_backward_ry(
+            output_errors, input, input_errors, updates, weights, slice_batch_size, input_size_y, input_size_x,
+            filter_y, filter_x, output_size_y, output_size_x
+        );
+    } else if (reverse_filter_x) {
+        prop_backward_rx(
+            output_errors, input, input_errors, updates, weights, slice_batch_size, input_size_y, input_size_x,
+            filter_y, filter_x, output_size_y, output_size_x
+        );
+    } else {
+        prop_backward(
+            output_errors, input, input_errors, updates, weights, slice_batch_size, input_size_y, input_size_x,
+            filter_y, filter_x, output_size_y, output_size_x
+        );
+    }
+}
+
 void CNN_Edge::propagate_forward(
     bool training, bool accumulate_test_statistics, float epsilon, float alpha, bool perform_dropout,
-    float hidden_dropout_probability, minstd_rand0& generator
+    float hidden_dropout_probability, minstd_rand0& generator, BatchThreadPool* batch_thread_pool
 ) {
     if (!is_reachable()) {
         return;
@@ -989,7 +1124,6 @@ void CNN_Edge::propagate_forward(
     high_resolution_clock::time_point propagate_forward_start_time = high_resolution_clock::now();
 
     float* input = input_node->get_values_out();
-    float* pool_gradients = input_node->get_pool_gradients();
     float* output = output_node->get_values_in();
 
 #ifdef NAN_CHECKS
@@ -1009,26 +1143,16 @@ void CNN_Edge::propagate_forward(
     int input_size_y = input_node->get_size_y();
 
     if (type == CONVOLUTIONAL) {
-        if (reverse_filter_y && reverse_filter_x) {
-            prop_forward_ry_rx(
-                input, weights, output, batch_size, input_size_y, input_size_x, filter_y, filter_x, output_size_y,
-                output_size_x
-            );
-        } else if (reverse_filter_y) {
-            prop_forward_ry(
-                input, weights, output, batch_size, input_size_y, input_size_x, filter_y, filter_x, output_size_y,
-                output_size_x
-            );
-        } else if (reverse_filter_x) {
-            prop_forward_rx(
-                input, weights, output, batch_size, input_size_y, input_size_x, filter_y, filter_x, output_size_y,
-                output_size_x
-            );
+        if (batch_thread_pool != NULL && batch_thread_pool->get_number_slices(batch_size) > 1) {
+            int32_t input_image_size = input_size_y * input_size_x;
+            int32_t output_image_size = output_size_y * output_size_x;
+
+            // each slice of the batch writes to its own images of the output node
+            batch_thread_pool->parallel_for(batch_size, [&](int32_t slice, int32_t start, int32_t end) {
+                convolve_forward(input + (start * input_image_size), output + (start * output_image_size), end - start);
+            });
         } else {
-            prop_forward(
-                input, weights, output, batch_size, input_size_y, input_size_x, filter_y, filter_x, output_size_y,
-                output_size_x
-            );
+            convolve_forward(input, output, batch_size);
         }
 
     } else if (type == POOLING) {
@@ -1069,12 +1193,6 @@ void CNN_Edge::propagate_forward(
                 update_offset(x_pools, x_pool_offset);
                 max_pooling = false;
             }
-
-            pool_forward_ry_rx(
-                input, scale, pool_gradients, output, batch_size, input_size_y, input_size_x, output_size_y,
-                output_size_x, y_pools, x_pools, y_pool_offset, x_pool_offset, generator, training, max_pooling
-            );
-
         } else if (reverse_filter_y) {
             if (output_size_y % input_size_y == 0) {
                 fisher_yates_shuffle(generator, y_pools);
@@ -1087,12 +1205,6 @@ void CNN_Edge::propagate_forward(
                 update_offset(x_pools, x_pool_offset);
                 max_pooling = false;
             }
-
-            pool_forward_ry(
-                input, scale, pool_gradients, output, batch_size, input_size_y, input_size_x, output_size_y,
-                output_size_x, y_pools, x_pools, y_pool_offset, x_pool_offset, generator, training, max_pooling
-            );
-
         } else if (reverse_filter_x) {
             if (input_size_y % output_size_y == 0) {
                 fisher_yates_shuffle(generator, y_pools);
@@ -1105,12 +1217,6 @@ void CNN_Edge::propagate_forward(
                 update_offset(x_pools, x_pool_offset);
                 max_pooling = false;
             }
-
-            pool_forward_rx(
-                input, scale, pool_gradients, output, batch_size, input_size_y, input_size_x, output_size_y,
-                output_size_x, y_pools, x_pools, y_pool_offset, x_pool_offset, generator, training, max_pooling
-            );
-
         } else {
             if (output_size_y % input_size_y == 0) {
                 fisher_yates_shuffle(generator, y_pools);
@@ -1123,12 +1229,21 @@ void CNN_Edge::propagate_forward(
                 update_offset(x_pools, x_pool_offset);
                 max_pooling = false;
             }
+        }
 
-            pool_forward(
-                input, scale, pool_gradients, output, batch_size, input_size_y, input_size_x, output_size_y,
-                output_size_x, y_pools, x_pools, y_pool_offset, x_pool_offset, generator, training, max_pooling
+        if (pool_map.empty() || !max_pooling) {
+            build_pool_map(
+                pool_map, reverse_filter_y, reverse_filter_x, input_size_x, output_size_y, output_size_x, y_pools,
+                x_pools, y_pool_offset, x_pool_offset
             );
         }
+        pool_argmax.resize(batch_size * output_size_y * output_size_x);
+
+        pool_forward(
+            input, scale, pool_map, pool_argmax.data(), output, batch_size, input_size_y, input_size_x, output_size_y,
+            output_size_x, reverse_filter_y, reverse_filter_x, y_pools, x_pools, y_pool_offset, x_pool_offset,
+            generator, training, max_pooling
+        );
 
     } else {
         cerr << "ERROR: unknown edge type in propagate_forward: " << type << endl;
@@ -1243,7 +1358,9 @@ void CNN_Edge::update_weights(float mu, float learning_rate, float weight_decay)
     weight_update_time += time_span.count() / 1000.0;
 }
 
-void CNN_Edge::propagate_backward(bool training, float mu, float learning_rate, float epsilon) {
+void CNN_Edge::propagate_backward(
+    bool training, float mu, float learning_rate, float epsilon, BatchThreadPool* batch_thread_pool
+) {
     if (!is_reachable()) {
         return;
     }
@@ -1266,53 +1383,43 @@ void CNN_Edge::propagate_backward(bool training, float mu, float learning_rate,
     }
 
     if (type == CONVOLUTIONAL) {
-        if (reverse_filter_x && reverse_filter_y) {
-            prop_backward_ry_rx(
-                output_errors, input, input_errors, weight_updates, weights, batch_size, input_size_y, input_size_x,
-                filter_y, filter_x, output_size_y, output_size_x
-            );
-        } else if (reverse_filter_y) {
-            prop_backward_ry(
-                output_errors, input, input_errors, weight_updates, weights, batch_size, input_size_y, input_size_x,
-                filter_y, filter_x, output_size_y, output_size_x
-            );
-        } else if (reverse_filter_x) {
-            prop_backward_rx(
-                output_errors, input, input_errors, weight_updates, weights, batch_size, input_size_y, input_size_x,
-                filter_y, filter_x, output_size_y, output_size_x
-            );
+        if (batch_thread_pool != NULL && batch_thread_pool->get_number_slices(batch_size) > 1) {
+            int32_t number_slices = batch_thread_pool->get_number_slices(batch_size);
+            int32_t input_image_size = input_size_y * input_size_x;
+            int32_t output_image_size = output_size_y * output_size_x;
+
+            slice_weight_updates.assign(number_slices * filter_size, 0.0);
+            vector<int32_t> slice_sizes(number_slices, 0);
+
+            batch_thread_pool->parallel_for(batch_size, [&](int32_t slice, int32_t start, int32_t end) {
+                slice_sizes[slice] = end - start;
+                convolve_backward(
+                    output_errors + (start * output_image_size), input + (start * input_image_size),
+                    input_errors + (start * input_image_size), &slice_weight_updates[slice * filter_size], end - start
+                );
+            });
+
+            // the kernels average the weight updates over the images they were given, so rescale each slice by its
+            // share of the batch. the reduction is done in slice order so the result does not depend on which thread
+            // finished first
+            for (int32_t slice = 0; slice < number_slices; slice++) {
+                float slice_scale = (float) slice_sizes[slice] / (float) batch_size;
+                float* updates = &slice_weight_updates[slice * filter_size];
+
+                for (int32_t current = 0; current < filter_size; current++) {
+                    weight_updates[current] += updates[current] * slice_scale;
+                }
+            }
         } else {
-            prop_backward(
-                output_errors, input, input_errors, weight_updates, weights, batch_size, input_size_y, input_size_x,
-                filter_y, filter_x, output_size_y, output_size_x
-            );
+            convolve_backward(output_errors, input, input_errors, weight_updates, batch_size);
         }
 
     } else if (type == POOLING) {
-        float* pool_gradients = input_node->get_pool_gradients();
-
         float scale_update = 0.0;
-        if (reverse_filter_y && reverse_filter_x) {
-            pool_backward_ry_rx(
-                input_errors, scale_update, input, pool_gradients, output_errors, batch_size, input_size_y,
-                input_size_x, output_size_y, output_size_x, y_pools, x_pools, y_pool_offset, x_pool_offset
-            );
-        } else if (reverse_filter_y) {
-            pool_backward_ry(
-                input_errors, scale_update, input, pool_gradients, output_errors, batch_size, input_size_y,
-                input_size_x, output_size_y, output_size_x, y_pools, x_pools, y_pool_offset, x_pool_offset
-            );
-        } else if (reverse_filter_x) {
-            pool_backward_rx(
-                input_errors, scale_update, input, pool_gradients, output_errors, batch_size, input_size_y,
-                input_size_x, output_size_y, output_size_x, y_pools, x_pools, y_pool_offset, x_pool_offset
-            );
-        } else {
-            pool_backward(
-                input_errors, scale_update, input, pool_gradients, output_errors, batch_size, input_size_y,
-                input_size_x, output_size_y, output_size_x, y_pools, x_pools, y_pool_offset, x_pool_offset
-            );
-        }
+        pool_backward(
+            input_errors, scale_update, input, pool_argmax.data(), output_errors, scale, batch_size, input_size_y,
+            input_size_x, output_size_y, output_size_x
+        );
 
         float pv_scale = previous_velocity_scale;
         float velocity_scale =
@@ -1562,6 +1669,7 @@ istream& operator>>(istream& is, CNN_Edge* edge) {
 
     update_offset(edge->y_pools, edge->y_pool_offset);
     update_offset(edge->x_pools, edge->x_pool_offset);
+    edge->pool_map.clear();
 
     /*
        cerr << "edge " << edge->innovation_number << ", y_pools: ";
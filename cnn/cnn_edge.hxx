@@ -22,6 +22,7 @@ using std::string;
 #include <vector>
 using std::vector;
 
+#include "batch_thread_pool.hxx"
 #include "cnn_node.hxx"
 #include "common/random.hxx"
 #include "image_tools/image_set.hxx"
@@ -64,6 +65,11 @@ class CNN_Edge {
     vector<int> x_pools;
     vector<int> x_pool_offset;
 
+    // the input window of each output pixel (rebuilt whenever the pools change) and the input pixel each output pixel
+    // took its max from in the last forward pass, batch number x output size_y x output size_x
+    vector<int32_t> pool_map;
+    vector<int32_t> pool_argmax;
+
     bool fixed;
     bool disabled;
     bool forward_visited;
@@ -77,6 +83,14 @@ class CNN_Edge {
     float propagate_forward_time;
     float weight_update_time;
 
+    // per slice weight updates when the batch is split across a BatchThreadPool
+    vector<float> slice_weight_updates;
+
+    void convolve_forward(const float* input, float* output, int32_t slice_batch_size);
+    void convolve_backward(
+        float* output_errors, float* input, float* input_errors, float* updates, int32_t slice_batch_size
+    );
+
    public:
     CNN_Edge();
 
@@ -102,6 +116,14 @@ class CNN_Edge {
     void reset_times();
     void accumulate_times(float& total_forward_time, float& total_backward_time, float& total_weight_update_time);
 
+    float get_propagate_forward_time() const;
+    float get_propagate_backward_time() const;
+    float get_weight_update_time() const;
+
+    float get_propagate_count() const;
+    float get_flop_estimate() const;
+    float get_forward_flop_estimate() const;
+
     void set_needs_init();
     bool needs_init() const;
     int get_filter_size() const;
@@ -176,10 +198,12 @@ class CNN_Edge {
 
     void propagate_forward(
         bool training, bool accumulate_test_statistics, float epsilon, float alpha, bool perform_dropout,
-        float hidden_dropout_probability, minstd_rand0& generator
+        float hidden_dropout_probability, minstd_rand0& generator, BatchThreadPool* batch_thread_pool
     );
 
-    void propagate_backward(bool training, float mu, float learning_rate, float epsilon);
+    void propagate_backward(
+        bool training, float mu, float learning_rate, float epsilon, BatchThreadPool* batch_thread_pool
+    );
     void update_weights(float mu, float learning_rate, float weight_decay);
 
     void print_statistics();
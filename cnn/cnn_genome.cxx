@@ -117,6 +117,10 @@ void CNN_Genome::set_progress_function(int (*_progress_function)(float)) {
     progress_function = _progress_function;
 }
 
+void CNN_Genome::set_batch_thread_pool(BatchThreadPool* _batch_thread_pool) {
+    batch_thread_pool = _batch_thread_pool;
+}
+
 int CNN_Genome::get_genome_id() const {
     return genome_id;
 }
@@ -201,6 +205,8 @@ void parse_array(vector<T>& output, istringstream& iss) {
 #ifdef _MYSQL_
 CNN_Genome::CNN_Genome(int _genome_id) {
     progress_function = NULL;
+    batch_thread_pool = NULL;
+    profile_filename = "";
     version_str = EXACT_VERSION_STR;
 
     ostringstream query;
@@ -504,6 +510,7 @@ CNN_Genome::CNN_Genome(
     number_test_images = _number_test_images;
 
     progress_function = NULL;
+    batch_thread_pool = NULL;
 
     velocity_reset = _velocity_reset;
 
@@ -545,6 +552,7 @@ CNN_Genome::CNN_Genome(
     name = "";
     output_filename = "";
     checkpoint_filename = "";
+    profile_filename = "";
 
     nodes = _nodes;
     edges = _edges;
@@ -698,6 +706,36 @@ int CNN_Genome::get_number_weights() const {
     return number_weights;
 }
 
+/**
+ *  Sums the per image forward flop estimates and the forward times (in milliseconds, measured over the last call to
+ *  evaluate) of the reachable convolutional edges, pooling edges and nodes, indexed by COST_CONVOLUTIONAL, COST_POOLING
+ *  and COST_NODE. Only forward work is counted, as that is what the times measure.
+ */
+void CNN_Genome::get_inference_profile(vector<float>& flops, vector<float>& forward_times) const {
+    flops.assign(NUMBER_COST_COMPONENTS, 0.0);
+    forward_times.assign(NUMBER_COST_COMPONENTS, 0.0);
+
+    for (uint32_t i = 0; i < edges.size(); i++) {
+        if (!edges[i]->is_reachable()) {
+            continue;
+        }
+
+        int component = edges[i]->get_type() == CONVOLUTIONAL ? COST_CONVOLUTIONAL : COST_POOLING;
+        flops[component] += edges[i]->get_forward_flop_estimate();
+        // the profile timers accumulate seconds
+        forward_times[component] += 1000.0 * edges[i]->get_propagate_forward_time();
+    }
+
+    for (uint32_t i = 0; i < nodes.size(); i++) {
+        if (!nodes[i]->is_reachable()) {
+            continue;
+        }
+
+        flops[COST_NODE] += nodes[i]->get_forward_flop_estimate();
+        forward_times[COST_NODE] += 1000.0 * nodes[i]->get_input_fired_time();
+    }
+}
+
 int CNN_Genome::get_operations_estimate() const {
     int operations_estimate = 0;
 
@@ -725,45 +763,12 @@ int CNN_Genome::get_operations_estimate() const {
             continue;
         }
 
-        bool reverse_filter_x = edges[i]->is_reverse_filter_x();
-        bool reverse_filter_y = edges[i]->is_reverse_filter_y();
+        float propagate_count = edges[i]->get_propagate_count();
 
         // TODO: calculate differently for POOLING nodes
         if (edges[i]->get_type() == CONVOLUTIONAL) {
-            float propagate_count;
-
-            if (reverse_filter_x && reverse_filter_y) {
-                propagate_count = edges[i]->get_filter_x() * edges[i]->get_filter_y()
-                                  * edges[i]->get_input_node()->get_size_x() * edges[i]->get_input_node()->get_size_y();
-            } else if (reverse_filter_x) {
-                propagate_count = edges[i]->get_filter_x() * edges[i]->get_filter_y()
-                                  * edges[i]->get_input_node()->get_size_x()
-                                  * edges[i]->get_output_node()->get_size_y();
-            } else if (reverse_filter_y) {
-                propagate_count = edges[i]->get_filter_x() * edges[i]->get_filter_y()
-                                  * edges[i]->get_output_node()->get_size_x()
-                                  * edges[i]->get_input_node()->get_size_y();
-            } else {
-                propagate_count = edges[i]->get_filter_x() * edges[i]->get_filter_y()
-                                  * edges[i]->get_output_node()->get_size_x()
-                                  * edges[i]->get_output_node()->get_size_y();
-            }
-
             operations_estimate += propagate_count * ((4.0 * multiply_cost) + (3.0 * add_cost));
-
         } else {
-            float propagate_count;
-
-            if (reverse_filter_x && reverse_filter_y) {
-                propagate_count = edges[i]->get_input_node()->get_size_x() * edges[i]->get_input_node()->get_size_y();
-            } else if (reverse_filter_y) {
-                propagate_count = edges[i]->get_input_node()->get_size_x() * edges[i]->get_output_node()->get_size_y();
-            } else if (reverse_filter_x) {
-                propagate_count = edges[i]->get_output_node()->get_size_x() * edges[i]->get_input_node()->get_size_y();
-            } else {
-                propagate_count = edges[i]->get_output_node()->get_size_x() * edges[i]->get_output_node()->get_size_y();
-            }
-
             operations_estimate += propagate_count * 2.0 * (16.0 * add_cost) + (4.0 * multiply_cost);
         }
 
@@ -1319,7 +1324,8 @@ void CNN_Genome::evaluate_images(
 
     for (uint32_t i = 0; i < edges.size(); i++) {
         edges[i]->propagate_forward(
-            training, accumulate_test_statistics, epsilon, alpha, training, hidden_dropout_probability, generator
+            training, accumulate_test_statistics, epsilon, alpha, training, hidden_dropout_probability, generator,
+            batch_thread_pool
         );
     }
 
@@ -1517,7 +1523,7 @@ void CNN_Genome::check_gradients(const ImagesInterface& images) {
          << ", analytic_predictions: " << analytic_predictions << endl;
 
     for (int32_t i = edges.size() - 1; i >= 0; i--) {
-        edges[i]->propagate_backward(false, mu, learning_rate, epsilon);
+        edges[i]->propagate_backward(false, mu, learning_rate, epsilon, batch_thread_pool);
     }
 
     analytic_error = 0.0;
@@ -1643,7 +1649,8 @@ void CNN_Genome::evaluate_images(
 
     for (uint32_t i = 0; i < edges.size(); i++) {
         edges[i]->propagate_forward(
-            training, accumulate_test_statistics, epsilon, alpha, training, hidden_dropout_probability, generator
+            training, accumulate_test_statistics, epsilon, alpha, training, hidden_dropout_probability, generator,
+            batch_thread_pool
         );
     }
 
@@ -1716,7 +1723,7 @@ void CNN_Genome::evaluate_images(
 
     if (training) {
         for (int32_t i = edges.size() - 1; i >= 0; i--) {
-            edges[i]->propagate_backward(training, mu, learning_rate, epsilon);
+            edges[i]->propagate_backward(training, mu, learning_rate, epsilon, batch_thread_pool);
         }
 
         for (int32_t i = 0; i < edges.size(); i++) {
@@ -2274,9 +2281,16 @@ void CNN_Genome::stochastic_backpropagation(
         fisher_yates_shuffle(generator, backprop_order);
 
         evaluate(training_images, backprop_order, current_training_error, current_training_predictions, true, false);
+        if (profile_filename.compare("") != 0) {
+            write_profile("training");
+        }
+
         evaluate(
             validation_images, validation_order, current_validation_error, current_validation_predictions, false, false
         );
+        if (profile_filename.compare("") != 0) {
+            write_profile("validation");
+        }
 
         bool found_improvement = false;
 
@@ -2386,6 +2400,130 @@ void CNN_Genome::set_checkpoint_filename(string _checkpoint_filename) {
     checkpoint_filename = _checkpoint_filename;
 }
 
+void CNN_Genome::set_profile_filename(string _profile_filename) {
+    profile_filename = _profile_filename;
+}
+
+static string edge_type_name(int type) {
+    if (type == CONVOLUTIONAL) {
+        return "convolutional";
+    } else {
+        return "pooling";
+    }
+}
+
+static string node_type_name(const CNN_Node* node) {
+    if (node->is_input()) {
+        return "input";
+    } else if (node->is_softmax()) {
+        return "softmax";
+    } else if (node->is_output()) {
+        return "output";
+    } else {
+        return "hidden";
+    }
+}
+
+void CNN_Genome::write_profile_csv(ostream& out, string phase) const {
+    for (uint32_t i = 0; i < edges.size(); i++) {
+        if (!edges[i]->is_reachable()) {
+            continue;
+        }
+
+        out << generation_id << "," << epoch << "," << phase << ",edge," << edges[i]->get_innovation_number() << ","
+            << edge_type_name(edges[i]->get_type()) << "," << edges[i]->get_input_innovation_number() << ","
+            << edges[i]->get_output_innovation_number() << "," << edges[i]->get_filter_y() << ","
+            << edges[i]->get_filter_x() << "," << edges[i]->get_flop_estimate() << ","
+            << edges[i]->get_propagate_forward_time() << "," << edges[i]->get_propagate_backward_time() << ","
+            << edges[i]->get_weight_update_time() << endl;
+    }
+
+    for (uint32_t i = 0; i < nodes.size(); i++) {
+        if (!nodes[i]->is_reachable()) {
+            continue;
+        }
+
+        out << generation_id << "," << epoch << "," << phase << ",node," << nodes[i]->get_innovation_number() << ","
+            << node_type_name(nodes[i]) << ",-1,-1," << nodes[i]->get_size_y() << "," << nodes[i]->get_size_x() << ","
+            << nodes[i]->get_flop_estimate() << "," << nodes[i]->get_input_fired_time() << ","
+            << nodes[i]->get_output_fired_time() << ",0" << endl;
+    }
+}
+
+void CNN_Genome::write_profile_json(ostream& out, string phase) const {
+    out << "{\"generation_id\": " << generation_id << ", \"epoch\": " << epoch << ", \"phase\": \"" << phase
+        << "\", \"batch_size\": " << batch_size << ", \"edges\": [";
+
+    bool first = true;
+    for (uint32_t i = 0; i < edges.size(); i++) {
+        if (!edges[i]->is_reachable()) {
+            continue;
+        }
+
+        if (!first) {
+            out << ", ";
+        }
+        first = false;
+
+        out << "{\"innovation_number\": " << edges[i]->get_innovation_number() << ", \"type\": \""
+            << edge_type_name(edges[i]->get_type()) << "\", \"input_node\": " << edges[i]->get_input_innovation_number()
+            << ", \"output_node\": " << edges[i]->get_output_innovation_number()
+            << ", \"filter_y\": " << edges[i]->get_filter_y() << ", \"filter_x\": " << edges[i]->get_filter_x()
+            << ", \"flops_per_image\": " << edges[i]->get_flop_estimate()
+            << ", \"forward_time\": " << edges[i]->get_propagate_forward_time()
+            << ", \"backward_time\": " << edges[i]->get_propagate_backward_time()
+            << ", \"weight_update_time\": " << edges[i]->get_weight_update_time() << "}";
+    }
+
+    out << "], \"nodes\": [";
+
+    first = true;
+    for (uint32_t i = 0; i < nodes.size(); i++) {
+        if (!nodes[i]->is_reachable()) {
+            continue;
+        }
+
+        if (!first) {
+            out << ", ";
+        }
+        first = false;
+
+        out << "{\"innovation_number\": " << nodes[i]->get_innovation_number() << ", \"type\": \""
+            << node_type_name(nodes[i]) << "\", \"size_y\": " << nodes[i]->get_size_y()
+            << ", \"size_x\": " << nodes[i]->get_size_x() << ", \"flops_per_image\": " << nodes[i]->get_flop_estimate()
+            << ", \"forward_time\": " << nodes[i]->get_input_fired_time()
+            << ", \"backward_time\": " << nodes[i]->get_output_fired_time() << "}";
+    }
+
+    out << "]}" << endl;
+}
+
+/**
+ *  Appends the per edge and per node times of the most recent call to evaluate to the profile file.  Files ending in
+ *  .json get one JSON object per line (per epoch and phase), anything else gets CSV rows with one row per edge/node.
+ */
+void CNN_Genome::write_profile(string phase) const {
+    ofstream outfile(profile_filename, ios::out | ios::app);
+    if (!outfile.is_open()) {
+        cerr << "ERROR: could not open profile file '" << profile_filename << "' for writing." << endl;
+        return;
+    }
+
+    bool json = profile_filename.size() >= 5 && profile_filename.compare(profile_filename.size() - 5, 5, ".json") == 0;
+
+    if (json) {
+        write_profile_json(outfile, phase);
+    } else {
+        if (outfile.tellp() == 0) {
+            outfile << "generation_id,epoch,phase,component,innovation_number,type,input_node,output_node,"
+                    << "size_y,size_x,flops_per_image,forward_time,backward_time,weight_update_time" << endl;
+        }
+        write_profile_csv(outfile, phase);
+    }
+
+    outfile.close();
+}
+
 string CNN_Genome::get_version_str() const {
     return version_str;
 }
@@ -2500,6 +2638,8 @@ void CNN_Genome::write(ostream& outfile) {
 
 void CNN_Genome::read(istream& infile) {
     progress_function = NULL;
+    batch_thread_pool = NULL;
+    profile_filename = "";
 
     bool verbose = true;
 
@@ -2837,6 +2977,45 @@ void CNN_Genome::write_to_file(string filename) {
 }
 
 void CNN_Genome::print_graphviz(ostream& out) const {
+    print_graphviz(out, false);
+}
+
+/**
+ *  Returns the graphviz color attributes of a component: marking it as a hot spot if it took at least HOT_SPOT_SHARE
+ *  of the total time in the most recent call to evaluate, otherwise just the given color.
+ */
+static string color_attributes(const string& color, float time, float total_time) {
+    if (total_time <= 0.0 || (time / total_time) < HOT_SPOT_SHARE) {
+        return "color=" + color;
+    }
+
+    ostringstream attributes;
+    attributes << "color=red,style=bold,penwidth=" << fixed << setprecision(1) << (1.0 + (10.0 * (time / total_time)));
+    return attributes.str();
+}
+
+void CNN_Genome::print_graphviz(ostream& out, bool annotate_hot_spots) const {
+    // total time spent in each component during the most recent call to evaluate
+    float total_time = 0.0;
+    if (annotate_hot_spots) {
+        float input_fired_time = 0.0, output_fired_time = 0.0;
+        float forward_time = 0.0, backward_time = 0.0, weight_update_time = 0.0;
+
+        for (uint32_t i = 0; i < nodes.size(); i++) {
+            if (nodes[i]->is_reachable()) {
+                nodes[i]->accumulate_times(input_fired_time, output_fired_time);
+            }
+        }
+
+        for (uint32_t i = 0; i < edges.size(); i++) {
+            if (edges[i]->is_reachable()) {
+                edges[i]->accumulate_times(forward_time, backward_time, weight_update_time);
+            }
+        }
+
+        total_time = input_fired_time + output_fired_time + forward_time + backward_time + weight_update_time;
+    }
+
     out << "digraph CNN {" << endl;
 
     // this will draw graph left to right instead of top to bottom
@@ -2898,9 +3077,20 @@ void CNN_Genome::print_graphviz(ostream& out) const {
             continue;
         }
 
-        out << "\t\tnode" << nodes[i]->get_innovation_number() << " [shape=box,color=black,label=\"input "
-            << nodes[i]->get_innovation_number() << "\\n"
-            << nodes[i]->get_size_x() << " x " << nodes[i]->get_size_y() << "\"];" << endl;
+        // the times are formatted separately so the caller's stream keeps its flags and precision
+        ostringstream label;
+        label << "input " << nodes[i]->get_innovation_number() << "\\n"
+              << nodes[i]->get_size_x() << " x " << nodes[i]->get_size_y();
+
+        string attributes = "color=black";
+        if (annotate_hot_spots) {
+            float node_time = nodes[i]->get_input_fired_time() + nodes[i]->get_output_fired_time();
+            label << "\\n" << fixed << setprecision(4) << node_time << "s";
+            attributes = color_attributes("black", node_time, total_time);
+        }
+
+        out << "\t\tnode" << nodes[i]->get_innovation_number() << " [shape=box," << attributes << ",label=\""
+            << label.str() << "\"];" << endl;
     }
 
     out << endl;
@@ -2911,13 +3101,20 @@ void CNN_Genome::print_graphviz(ostream& out) const {
             continue;
         }
 
-        if (edges[i]->get_type() == CONVOLUTIONAL) {
-            out << "\tnode" << edges[i]->get_input_node()->get_innovation_number() << " -> node"
-                << edges[i]->get_output_node()->get_innovation_number() << " [color=blue];" << endl;
-        } else {
-            out << "\tnode" << edges[i]->get_input_node()->get_innovation_number() << " -> node"
-                << edges[i]->get_output_node()->get_innovation_number() << " [color=green];" << endl;
+        string color = edges[i]->get_type() == CONVOLUTIONAL ? "blue" : "green";
+        string attributes = "color=" + color;
+
+        if (annotate_hot_spots) {
+            float edge_time = edges[i]->get_propagate_forward_time() + edges[i]->get_propagate_backward_time()
+                              + edges[i]->get_weight_update_time();
+
+            ostringstream label;
+            label << ",label=\"" << fixed << setprecision(4) << edge_time << "s\"";
+            attributes = color_attributes(color, edge_time, total_time) + label.str();
         }
+
+        out << "\tnode" << edges[i]->get_input_node()->get_innovation_number() << " -> node"
+            << edges[i]->get_output_node()->get_innovation_number() << " [" << attributes << "];" << endl;
     }
 
     out << endl;
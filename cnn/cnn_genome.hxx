@@ -10,6 +10,7 @@ using std::minstd_rand0;
 #include <vector>
 using std::vector;
 
+#include "batch_thread_pool.hxx"
 #include "cnn_edge.hxx"
 #include "cnn_node.hxx"
 #include "common/random.hxx"
@@ -22,6 +23,15 @@ using std::vector;
 // mysql can't handl the max float value for some reason
 #define EXACT_MAX_FLOAT 10000000
 
+// share of the total evaluation time at which print_graphviz marks an edge or node as a hot spot
+#define HOT_SPOT_SHARE 0.10
+
+// the kinds of kernels the EXACT inference cost model is calibrated for
+#define COST_CONVOLUTIONAL     0
+#define COST_POOLING           1
+#define COST_NODE              2
+#define NUMBER_COST_COMPONENTS 3
+
 class CNN_Genome {
    private:
     string version_str;
@@ -84,11 +94,15 @@ class CNN_Genome {
     string name;
     string checkpoint_filename;
     string output_filename;
+    string profile_filename;
 
     map<string, int> generated_by_map;
 
     int (*progress_function)(float);
 
+    // not owned by the genome, shared by all genomes being trained in this process (may be NULL)
+    BatchThreadPool* batch_thread_pool;
+
    public:
     /**
      *  Initialize a genome from a file
@@ -137,8 +151,10 @@ class CNN_Genome {
     int get_padding() const;
 
     int get_operations_estimate() const;
+    void get_inference_profile(vector<float>& flops, vector<float>& forward_times) const;
 
     void set_progress_function(int (*_progress_function)(float));
+    void set_batch_thread_pool(BatchThreadPool* _batch_thread_pool);
 
     int get_generation_id() const;
 
@@ -245,6 +261,11 @@ class CNN_Genome {
     void set_name(string _name);
     void set_output_filename(string _output_filename);
     void set_checkpoint_filename(string _checkpoint_filename);
+    void set_profile_filename(string _profile_filename);
+
+    void write_profile_csv(ostream& out, string phase) const;
+    void write_profile_json(ostream& out, string phase) const;
+    void write_profile(string phase) const;
 
     void write(ostream& outfile);
     void write_to_file(string filename);
@@ -252,6 +273,7 @@ class CNN_Genome {
     void read(istream& infile);
 
     void print_graphviz(ostream& out) const;
+    void print_graphviz(ostream& out, bool annotate_hot_spots) const;
 
     void set_generated_by(string type);
     int get_generated_by(string type);
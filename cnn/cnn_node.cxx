@@ -162,7 +162,6 @@ CNN_Node::CNN_Node(int _innovation_number, float _depth, int _batch_size, int _s
     values_out = new float[total_size]();
     errors_out = new float[total_size]();
     relu_gradients = new float[total_size]();
-    pool_gradients = new float[total_size]();
 }
 
 #ifdef _MYSQL_
@@ -239,7 +238,6 @@ CNN_Node::CNN_Node(int _node_id) {
     values_out = new float[total_size]();
     errors_out = new float[total_size]();
     relu_gradients = new float[total_size]();
-    pool_gradients = new float[total_size]();
 
     // cout << "read node!" << endl;
     // cout << this << endl;
@@ -304,7 +302,6 @@ CNN_Node::~CNN_Node() {
     delete[] values_out;
     delete[] errors_out;
     delete[] relu_gradients;
-    delete[] pool_gradients;
 
     delete[] values_in;
     delete[] errors_in;
@@ -356,7 +353,6 @@ CNN_Node* CNN_Node::copy() const {
     copy->values_out = new float[total_size]();
     copy->errors_out = new float[total_size]();
     copy->relu_gradients = new float[total_size]();
-    copy->pool_gradients = new float[total_size]();
 
     for (uint32_t i = 0; i < total_size; i++) {
         copy->values_in[i] = values_in[i];
@@ -365,7 +361,6 @@ CNN_Node* CNN_Node::copy() const {
         copy->values_out[i] = values_out[i];
         copy->errors_out[i] = errors_out[i];
         copy->relu_gradients[i] = relu_gradients[i];
-        copy->pool_gradients[i] = pool_gradients[i];
     }
 
     return copy;
@@ -390,7 +385,6 @@ void CNN_Node::initialize() {
     delete[] values_out;
     delete[] errors_out;
     delete[] relu_gradients;
-    delete[] pool_gradients;
 
     values_in = new float[total_size]();
     errors_in = new float[total_size]();
@@ -398,7 +392,6 @@ void CNN_Node::initialize() {
     values_out = new float[total_size]();
     errors_out = new float[total_size]();
     relu_gradients = new float[total_size]();
-    pool_gradients = new float[total_size]();
 }
 
 void CNN_Node::reset_velocities() {
@@ -517,7 +510,6 @@ void CNN_Node::resize_arrays() {
     delete[] values_out;
     delete[] errors_out;
     delete[] relu_gradients;
-    delete[] pool_gradients;
 
     values_in = new float[total_size]();
     errors_in = new float[total_size]();
@@ -525,7 +517,6 @@ void CNN_Node::resize_arrays() {
     values_out = new float[total_size]();
     errors_out = new float[total_size]();
     relu_gradients = new float[total_size]();
-    pool_gradients = new float[total_size]();
 
     needs_initialization = true;
 }
@@ -580,10 +571,6 @@ float* CNN_Node::get_relu_gradients() {
     return relu_gradients;
 }
 
-float* CNN_Node::get_pool_gradients() {
-    return pool_gradients;
-}
-
 void CNN_Node::print(ostream& out) {
     out << "CNN_Node " << innovation_number << ", at depth: " << depth << " of input size x: " << size_x
         << ", y: " << size_y << endl;
@@ -644,17 +631,6 @@ void CNN_Node::print(ostream& out) {
             }
             out << endl;
         }
-
-        out << "    pool_gradients:" << endl;
-        current = batch_number * size_y * size_x;
-        for (int32_t i = 0; i < size_y; i++) {
-            out << "    ";
-            for (int32_t j = 0; j < size_x; j++) {
-                out << setw(13) << setprecision(8) << pool_gradients[current];
-                current++;
-            }
-            out << endl;
-        }
     }
 }
 
@@ -668,6 +644,35 @@ void CNN_Node::accumulate_times(float& total_input_time, float& total_output_tim
     total_output_time += output_fired_time;
 }
 
+float CNN_Node::get_input_fired_time() const {
+    return input_fired_time;
+}
+
+float CNN_Node::get_output_fired_time() const {
+    return output_fired_time;
+}
+
+/**
+ *  Estimated floating point operations per image for the fused batch normalization, ReLU and dropout kernels:
+ *  roughly 10 per value forward (activation, dropout, batch statistics, normalization) and 12 backward.
+ */
+float CNN_Node::get_flop_estimate() const {
+    if (type == INPUT_NODE || type == SOFTMAX_NODE) {
+        return 0.0;
+    }
+    return 22.0 * size_y * size_x;
+}
+
+/**
+ *  The forward pass part of get_flop_estimate.
+ */
+float CNN_Node::get_forward_flop_estimate() const {
+    if (type == INPUT_NODE || type == SOFTMAX_NODE) {
+        return 0.0;
+    }
+    return 10.0 * size_y * size_x;
+}
+
 void CNN_Node::reset() {
     inputs_fired = 0;
     outputs_fired = 0;
@@ -680,7 +685,6 @@ void CNN_Node::reset() {
             values_out[current] = 0.0;
             errors_out[current] = 0.0;
             relu_gradients[current] = 0.0;
-            pool_gradients[current] = 0.0;
         }
     }
 }
@@ -806,129 +810,143 @@ void CNN_Node::print_batch_statistics() {
          << ", running_variance: " << running_variance << ", gamma: " << gamma << ", beta: " << beta << endl;
 }
 
-void CNN_Node::batch_normalize(bool training, bool accumulating_test_statistics, float epsilon, float alpha) {
-    // normalize the batch
-    if (training || accumulating_test_statistics) {
-        batch_mean = 0.0;
-
-        // cout << "pre-batch normalization on node: " << innovation_number << endl;
+/**
+ * Fused forward kernel: applies the (leaky, capped) ReLU, dropout and batch normalization to values_in in as few
+ * passes as possible.  With COMPUTE_BATCH_STATISTICS the first pass over each batch image applies the activation and
+ * dropout while accumulating the sum and sum of squares for the batch statistics, and a second pass normalizes.
+ * Without it (inference) the running statistics are used so everything is done in a single pass.
+ *
+ * The inner loops are branch free (except for DROPOUT_RANDOM, which needs one random number per value in the same
+ * order as before) so the compiler can vectorize across each image.
+ */
+template <bool COMPUTE_BATCH_STATISTICS, int DROPOUT_MODE>
+void CNN_Node::fused_forward(
+    bool accumulating_test_statistics, float epsilon, float alpha, float dropout_probability, minstd_rand0& generator
+) {
+    const int32_t image_size = size_y * size_x;
+    const float dropout_scale = 1.0 - dropout_probability;
+
+    if (COMPUTE_BATCH_STATISTICS) {
+        double sum = 0.0;
+        double sum_squares = 0.0;
+
+        for (int32_t batch_number = 0; batch_number < batch_size; batch_number++) {
+            float* __restrict__ image_values = values_in + (batch_number * image_size);
+            float* __restrict__ image_gradients = relu_gradients + (batch_number * image_size);
+
+            double image_sum = 0.0;
+            double image_sum_squares = 0.0;
+            for (int32_t current = 0; current < image_size; current++) {
+                float value = image_values[current];
+                float gradient = (value <= RELU_MIN) ? RELU_MIN_LEAK : ((value > RELU_MAX) ? RELU_MAX_LEAK : 1.0f);
+                value = (value <= RELU_MIN) ? value * RELU_MIN_LEAK : ((value > RELU_MAX) ? RELU_MAX : value);
+
+                if (DROPOUT_MODE == DROPOUT_RANDOM) {
+                    if (random_0_1(generator) < dropout_probability) {
+                        value = 0.0;
+                        gradient = 0.0;
+                    }
+                } else if (DROPOUT_MODE == DROPOUT_SCALE) {
+                    value *= dropout_scale;
+                }
 
-        for (int32_t current = 0; current < total_size; current++) {
-            batch_mean += values_in[current];
+                image_values[current] = value;
+                image_gradients[current] = gradient;
+                image_sum += value;
+                image_sum_squares += (double) value * value;
+            }
+            sum += image_sum;
+            sum_squares += image_sum_squares;
         }
-        batch_mean /= (uint64_t) batch_size * (uint64_t) size_y * (uint64_t) size_x;
 
-        batch_variance = 0.0;
-        float diff;
-        for (int32_t current = 0; current < total_size; current++) {
-            diff = values_in[current] - batch_mean;
-            batch_variance += diff * diff;
+        double m = (uint64_t) batch_size * (uint64_t) size_y * (uint64_t) size_x;
+        double mean = sum / m;
+        double variance = (sum_squares / m) - (mean * mean);
+        if (variance < 0.0) {
+            variance = 0.0;
         }
-        batch_variance /= (uint64_t) batch_size * (uint64_t) size_y * (uint64_t) size_x;
 
+        batch_mean = mean;
+        batch_variance = variance;
         batch_std_dev = exact_sqrt(batch_variance + epsilon);
-
         inverse_variance = 1.0 / batch_std_dev;
 
-        // cout << endl;
-        // cout << "post-batch normalization on node: " << innovation_number << endl;
-        float temp;
-        for (int32_t current = 0; current < total_size; current++) {
-            temp = (values_in[current] - batch_mean) * inverse_variance;
-            values_in[current] = temp;  // values in becomes x_hat
-            values_out[current] = (gamma * temp) + beta;
-        }
-
 #ifdef NAN_CHECKS
         if (std::isnan(batch_mean) || std::isinf(batch_mean) || std::isnan(batch_variance)
             || std::isinf(batch_variance)) {
             cerr << "ERROR! NAN or INF batch_mean or batch_variance on node " << innovation_number << "!" << endl;
             cerr << "gamma: " << gamma << ", beta: " << beta << endl;
+            throw runtime_error("fused_forward resulted in NAN or INF when calculating batch_mean or batch_variance");
+        }
+#endif
 
-            int current = 0;
-            for (int32_t batch_number = 0; batch_number < batch_size; batch_number++) {
-                for (int32_t y = 0; y < size_y; y++) {
-                    for (int32_t x = 0; x < size_x; x++) {
-                        cout << setw(10) << std::fixed << values_in[current];
-                        current++;
-                    }
-                    cout << endl;
-                }
-                cout << endl;
-            }
+        const float current_mean = batch_mean;
+        const float current_inverse_variance = inverse_variance;
+        const float current_gamma = gamma;
+        const float current_beta = beta;
+
+        for (int32_t batch_number = 0; batch_number < batch_size; batch_number++) {
+            float* __restrict__ image_values = values_in + (batch_number * image_size);
+            float* __restrict__ image_out = values_out + (batch_number * image_size);
 
-            throw runtime_error("batch_normalize resulted in NAN or INF when calculating batch_mean or batch_variance");
+            for (int32_t current = 0; current < image_size; current++) {
+                float value_hat = (image_values[current] - current_mean) * current_inverse_variance;
+                image_values[current] = value_hat;  // values in becomes x_hat
+                image_out[current] = (current_gamma * value_hat) + current_beta;
+            }
         }
-#endif
 
         batch_variance = (batch_size / (batch_size - 1)) * batch_variance;
 
         if (accumulating_test_statistics) {
             running_mean += batch_mean;
             running_variance += batch_variance;
-            // running_mean = (batch_mean * alpha) + ((1.0 - alpha) * running_mean);
-            // running_variance = (batch_variance * alpha) + ((1.0 - alpha) * running_variance);
-
-            // cout << "node " << innovation_number << " accumulating test statistics, batch_mean: " << batch_mean << ",
-            // batch_variance: " << batch_variance << endl;
         } else {
             running_mean = (batch_mean * alpha) + ((1.0 - alpha) * running_mean);
             running_variance = (batch_variance * alpha) + ((1.0 - alpha) * running_variance);
         }
 
-        // cout << "\tnode " << innovation_number << ", batch_mean: " << batch_mean << ", batch_variance: " <<
-        // batch_variance << ", batch_std_dev: " << batch_std_dev << ", running_mean: " << running_mean << ",
-        // running_variance: " << running_variance << endl;
-
     } else {  // testing
-        float term1 = gamma / exact_sqrt(running_variance + epsilon);
-        float term2 = beta - ((gamma * running_mean) / exact_sqrt(running_variance + epsilon));
+        const float term1 = gamma / exact_sqrt(running_variance + epsilon);
+        const float term2 = beta - ((gamma * running_mean) / exact_sqrt(running_variance + epsilon));
+
+        for (int32_t batch_number = 0; batch_number < batch_size; batch_number++) {
+            float* __restrict__ image_values = values_in + (batch_number * image_size);
+            float* __restrict__ image_gradients = relu_gradients + (batch_number * image_size);
+            float* __restrict__ image_out = values_out + (batch_number * image_size);
+
+            for (int32_t current = 0; current < image_size; current++) {
+                float value = image_values[current];
+                float gradient = (value <= RELU_MIN) ? RELU_MIN_LEAK : ((value > RELU_MAX) ? RELU_MAX_LEAK : 1.0f);
+                value = (value <= RELU_MIN) ? value * RELU_MIN_LEAK : ((value > RELU_MAX) ? RELU_MAX : value);
+
+                if (DROPOUT_MODE == DROPOUT_RANDOM) {
+                    if (random_0_1(generator) < dropout_probability) {
+                        value = 0.0;
+                        gradient = 0.0;
+                    }
+                } else if (DROPOUT_MODE == DROPOUT_SCALE) {
+                    value *= dropout_scale;
+                }
 
-        for (int32_t current = 0; current < total_size; current++) {
-            values_out[current] = (term1 * values_in[current]) + term2;
+                image_values[current] = value;
+                image_gradients[current] = gradient;
+                image_out[current] = (term1 * value) + term2;
+            }
+        }
 
 #ifdef NAN_CHECKS
+        for (int32_t current = 0; current < total_size; current++) {
             if (std::isnan(values_out[current]) || std::isinf(values_out[current])) {
-                cerr << "ERROR! NAN or INF batch_mean or batch_variance on node " << innovation_number << "!" << endl;
+                cerr << "ERROR! NAN or INF values_out on node " << innovation_number << "!" << endl;
                 cerr << "values_out[" << current << "]: " << values_out[current] << ", values_in[" << current
                      << "]: " << values_in[current] << endl;
                 cerr << "gamma: " << gamma << ", beta: " << beta << endl;
                 cerr << "term1: " << term1 << ", term2: " << term2 << endl;
-
-                int current = 0;
-                for (int32_t batch_number = 0; batch_number < batch_size; batch_number++) {
-                    for (int32_t y = 0; y < size_y; y++) {
-                        for (int32_t x = 0; x < size_x; x++) {
-                            cout << setw(10) << std::fixed << values_in[current];
-                            current++;
-                        }
-                        cout << endl;
-                    }
-                    cout << endl;
-                }
-
-                throw runtime_error("batch_normalize resulted in NAN or INF when calculating values_out");
+                throw runtime_error("fused_forward resulted in NAN or INF when calculating values_out");
             }
-#endif
-        }
-    }
-}
-
-void CNN_Node::apply_relu(float* values, float* gradients) {
-    for (int32_t current = 0; current < total_size; current++) {
-        // cout << "values_out for node " << innovation_number << " now " << values_out[batch_number][y][x] << " after
-        // adding bias: " << bias[batch_number][y][x] << endl;
-
-        // apply activation function
-        if (values[current] <= RELU_MIN) {
-            values[current] = values[current] * RELU_MIN_LEAK;
-            gradients[current] = RELU_MIN_LEAK;
-        } else if (values[current] > RELU_MAX) {
-            values[current] = RELU_MAX;
-            gradients[current] = RELU_MAX_LEAK;
-        } else {
-            gradients[current] = 1.0;
         }
+#endif
     }
 }
 
@@ -955,50 +973,54 @@ void CNN_Node::apply_dropout(
     }
 }
 
-void CNN_Node::backpropagate_relu(float* errors, float* gradients) {
-    for (int32_t current = 0; current < total_size; current++) {
-        errors[current] *= gradients[current];
-    }
-}
+/**
+ * Fused backward kernel: backpropagates through batch normalization and the ReLU/dropout gradients.  The first pass
+ * over each batch image accumulates the gamma, beta, variance and mean derivatives, the second computes errors_in and
+ * applies the activation gradient in place (previously this was a separate pass in backpropagate_relu).  The gamma and
+ * beta updates are only compiled into the TRAINING version.
+ */
+template <bool TRAINING>
+void CNN_Node::fused_backward(float mu, float learning_rate) {
+    const int32_t image_size = size_y * size_x;
+
+    const float current_mean = batch_mean;
+    const float current_std_dev = batch_std_dev;
+    const float current_gamma = gamma;
 
-void CNN_Node::backpropagate_batch_normalization(bool training, float mu, float learning_rate, float epsilon) {
-    // backprop  batch normalization here
     float delta_beta = 0.0;
     float delta_gamma = 0.0;
-
-    float value_in;
-    float value_hat;
-    // float value_out;
-    float delta_out;
-    // float delta_values_hat;
-    // float delta_values_hat_sum = 0.0;
-    // float delta_values_hat_x_values_sum = 0.0;
-
     float derr_dvariance = 0.0;
-    float derr_dmean = 0.0;
-
     float derr_dmean_term1 = 0.0;
     float derr_dmean_term2 = 0.0;
 
-    float m = (uint64_t) batch_size * (uint64_t) size_y * (uint64_t) size_x;
-    float diff;
-
-    for (int32_t current = 0; current < total_size; current++) {
-        delta_out = errors_out[current];
-        value_hat = values_in[current];
-
-        value_in = (value_hat + batch_mean) * batch_std_dev;
-        diff = value_in - batch_mean;
-
-        delta_beta += delta_out;
-        delta_gamma += value_hat * delta_out;
-
-        derr_dvariance += diff * delta_out * gamma;
+    for (int32_t batch_number = 0; batch_number < batch_size; batch_number++) {
+        const float* __restrict__ image_errors_out = errors_out + (batch_number * image_size);
+        const float* __restrict__ image_values = values_in + (batch_number * image_size);
+
+        float image_delta_beta = 0.0;
+        float image_delta_gamma = 0.0;
+        float image_diff_x_delta = 0.0;
+        float image_diff = 0.0;
+
+        for (int32_t current = 0; current < image_size; current++) {
+            float delta_out = image_errors_out[current];
+            float value_hat = image_values[current];
+            float diff = ((value_hat + current_mean) * current_std_dev) - current_mean;
+
+            image_delta_beta += delta_out;
+            image_delta_gamma += value_hat * delta_out;
+            image_diff_x_delta += diff * delta_out;
+            image_diff += diff;
+        }
 
-        derr_dmean_term1 += delta_out * gamma;
-        derr_dmean_term2 += diff;
+        delta_beta += image_delta_beta;
+        delta_gamma += image_delta_gamma;
+        derr_dvariance += image_diff_x_delta * current_gamma;
+        derr_dmean_term1 += image_delta_beta * current_gamma;
+        derr_dmean_term2 += image_diff;
     }
 
+    float m = (uint64_t) batch_size * (uint64_t) size_y * (uint64_t) size_x;
     float inv_m = 1.0 / m;
     float inv_m_x_2 = 2.0 * inv_m;
 
@@ -1009,20 +1031,33 @@ void CNN_Node::backpropagate_batch_normalization(bool training, float mu, float
 
     derr_dmean_term1 *= -inverse_variance;
     derr_dmean_term2 *= -inv_m_x_2 * derr_dvariance;
-    derr_dmean = derr_dmean_term1 + derr_dmean_term2;
+    float derr_dmean = derr_dmean_term1 + derr_dmean_term2;
 
-    for (int32_t current = 0; current < total_size; current++) {
-        delta_out = errors_out[current] * relu_gradients[current];
-        value_hat = values_in[current];
-        value_in = (value_hat + batch_mean) * batch_std_dev;
+    const float current_inverse_variance = inverse_variance;
+    const float variance_term = derr_dvariance * inv_m_x_2;
+    const float mean_term = derr_dmean * inv_m;
 
-        errors_in[current] = (delta_out * inverse_variance) + (derr_dvariance * inv_m_x_2 * (value_in - batch_mean))
-                             + (derr_dmean * inv_m);
+    for (int32_t batch_number = 0; batch_number < batch_size; batch_number++) {
+        const float* __restrict__ image_errors_out = errors_out + (batch_number * image_size);
+        const float* __restrict__ image_values = values_in + (batch_number * image_size);
+        const float* __restrict__ image_gradients = relu_gradients + (batch_number * image_size);
+        float* __restrict__ image_errors_in = errors_in + (batch_number * image_size);
+
+        for (int32_t current = 0; current < image_size; current++) {
+            float gradient = image_gradients[current];
+            float delta_out = image_errors_out[current] * gradient;
+            float value_in = (image_values[current] + current_mean) * current_std_dev;
+
+            image_errors_in[current] = ((delta_out * current_inverse_variance)
+                                        + (variance_term * (value_in - current_mean)) + mean_term)
+                                       * gradient;
+        }
+    }
 
 #ifdef NAN_CHECKS
+    for (int32_t current = 0; current < total_size; current++) {
         if (std::isnan(errors_in[current]) || std::isinf(errors_in[current])) {
             cerr << "ERROR! errors_in[" << current << "] became: " << errors_in[current] << "!" << endl;
-            cerr << "value_in: " << value_in << endl;
             cerr << "derr_dmean: " << derr_dmean << endl;
             cerr << "inv_m: " << inv_m << endl;
             cerr << "derr_dvariance: " << derr_dvariance << endl;
@@ -1031,29 +1066,19 @@ void CNN_Node::backpropagate_batch_normalization(bool training, float mu, float
             cerr << "batch_mean: " << batch_mean << endl;
             cerr << "batch_size: " << batch_size << endl;
             cerr << "gamma: " << gamma << endl;
-            cerr << "delta_out: " << delta_out << endl;
             cerr << "values_in[" << current << "]: " << values_in[current] << endl;
 
-            for (int32_t current = 0; current < total_size; current++) {
-                cout << "errors_out[" << current << "]: " << errors_out[current] << ", values_in[" << current
-                     << "]: " << values_in[current] << endl;
-            }
-
-            throw runtime_error("backpropagate_batch_normalization resulted in NAN or INF");
+            throw runtime_error("fused_backward resulted in NAN or INF");
         }
-#endif
     }
+#endif
 
-    if (training) {
+    if (TRAINING) {
         // backpropagate beta
         float pv_beta = previous_velocity_beta;
 
         float velocity_beta = (mu * pv_beta) - (learning_rate / batch_size) * delta_beta;
         beta += velocity_beta + mu * (velocity_beta - pv_beta);
-        // beta += velocity_beta;
-
-        // beta += (-mu * pv_beta + (1 + mu) * velocity_beta);
-        // beta -= (beta * weight_decay);
 
         previous_velocity_beta = velocity_beta;
 
@@ -1071,10 +1096,7 @@ void CNN_Node::backpropagate_batch_normalization(bool training, float mu, float
         float pv_gamma = previous_velocity_gamma;
 
         float velocity_gamma = (mu * pv_gamma) - (learning_rate / batch_size) * delta_gamma;
-        // gamma += velocity_gamma;
         gamma += velocity_gamma + mu * (velocity_gamma - pv_gamma);
-        // gamma += (-mu * pv_gamma + (1 + mu) * velocity_gamma);
-        // gamma -= (gamma * weight_decay);
 
         previous_velocity_gamma = velocity_gamma;
 
@@ -1088,9 +1110,6 @@ void CNN_Node::backpropagate_batch_normalization(bool training, float mu, float
             previous_velocity_gamma = 0.0;
         }
     }
-
-    // cout << "\tnode " << innovation_number << ", delta_gamma: " << delta_gamma << ", delta_beta: " << delta_beta <<
-    // ", gamma now: " << gamma << ", beta now: " << beta << endl;
 }
 
 void CNN_Node::set_values(
@@ -1154,16 +1173,39 @@ void CNN_Node::input_fired(
 
     if (inputs_fired == total_inputs) {
         if (type != SOFTMAX_NODE) {
-            apply_relu(values_in, relu_gradients);
-
-            if (hidden_dropout_probability > 0) {
-                apply_dropout(
-                    values_in, relu_gradients, perform_dropout, accumulate_test_statistics, hidden_dropout_probability,
-                    generator
-                );
+            bool compute_batch_statistics = training || accumulate_test_statistics;
+
+            if (hidden_dropout_probability <= 0) {
+                if (compute_batch_statistics) {
+                    fused_forward<true, DROPOUT_NONE>(
+                        accumulate_test_statistics, epsilon, alpha, hidden_dropout_probability, generator
+                    );
+                } else {
+                    fused_forward<false, DROPOUT_NONE>(
+                        accumulate_test_statistics, epsilon, alpha, hidden_dropout_probability, generator
+                    );
+                }
+            } else if (perform_dropout && !accumulate_test_statistics) {
+                if (compute_batch_statistics) {
+                    fused_forward<true, DROPOUT_RANDOM>(
+                        accumulate_test_statistics, epsilon, alpha, hidden_dropout_probability, generator
+                    );
+                } else {
+                    fused_forward<false, DROPOUT_RANDOM>(
+                        accumulate_test_statistics, epsilon, alpha, hidden_dropout_probability, generator
+                    );
+                }
+            } else {
+                if (compute_batch_statistics) {
+                    fused_forward<true, DROPOUT_SCALE>(
+                        accumulate_test_statistics, epsilon, alpha, hidden_dropout_probability, generator
+                    );
+                } else {
+                    fused_forward<false, DROPOUT_SCALE>(
+                        accumulate_test_statistics, epsilon, alpha, hidden_dropout_probability, generator
+                    );
+                }
             }
-
-            batch_normalize(training, accumulate_test_statistics, epsilon, alpha);
         }
 
     } else if (inputs_fired > total_inputs) {
@@ -1195,8 +1237,11 @@ void CNN_Node::output_fired(bool training, float mu, float learning_rate, float
 
     if (outputs_fired == total_outputs) {
         if (type != SOFTMAX_NODE && type != INPUT_NODE) {
-            backpropagate_batch_normalization(training, mu, learning_rate, epsilon);
-            backpropagate_relu(errors_in, relu_gradients);
+            if (training) {
+                fused_backward<true>(mu, learning_rate);
+            } else {
+                fused_backward<false>(mu, learning_rate);
+            }
         }
 
     } else if (outputs_fired > total_outputs) {
@@ -1235,9 +1280,6 @@ bool CNN_Node::has_nan() const {
         if (std::isnan(relu_gradients[current]) || std::isinf(relu_gradients[current])) {
             return true;
         }
-        if (std::isnan(pool_gradients[current]) || std::isinf(pool_gradients[current])) {
-            return true;
-        }
     }
 
     return false;
@@ -1398,7 +1440,6 @@ std::istream& operator>>(std::istream& is, CNN_Node* node) {
     node->values_out = new float[node->total_size]();
     node->errors_out = new float[node->total_size]();
     node->relu_gradients = new float[node->total_size]();
-    node->pool_gradients = new float[node->total_size]();
 
     return is;
 }
@@ -1508,7 +1549,7 @@ bool CNN_Node::is_identical(const CNN_Node* other, bool testing_checkpoint) {
         return false;
     }
 
-    // values, errors_out, relu_gradients, pool_gradients, values_in, errors_in, input_fired_time and output_fired time
+    // values, errors_out, relu_gradients, values_in, errors_in, input_fired_time and output_fired time
     // are all reset to 0 before every pass so don't need to be compared
 
     return true;
@@ -44,6 +44,10 @@ using std::vector;
 #define OUTPUT_NODE   2
 #define SOFTMAX_NODE  3
 
+#define DROPOUT_NONE   0
+#define DROPOUT_RANDOM 1
+#define DROPOUT_SCALE  2
+
 class CNN_Node {
    private:
     int node_id;
@@ -94,7 +98,6 @@ class CNN_Node {
     float* values_out;
     float* errors_out;
     float* relu_gradients;
-    float* pool_gradients;
 
     float* values_in;
     float* errors_in;
@@ -170,13 +173,17 @@ class CNN_Node {
     float* get_errors_out();
 
     float* get_relu_gradients();
-    float* get_pool_gradients();
 
     void print(ostream& out);
 
     void reset_times();
     void accumulate_times(float& total_input_time, float& total_output_time);
 
+    float get_input_fired_time() const;
+    float get_output_fired_time() const;
+    float get_flop_estimate() const;
+    float get_forward_flop_estimate() const;
+
     void reset();
     void save_best_weights();
     void set_weights_to_best();
@@ -211,16 +218,18 @@ class CNN_Node {
 
     void print_batch_statistics();
 
-    void batch_normalize(bool training, bool accumulating_test_statistics, float epsilon, float alpha);
-    void apply_relu(float* values, float* gradients);
+    template <bool COMPUTE_BATCH_STATISTICS, int DROPOUT_MODE>
+    void fused_forward(
+        bool accumulating_test_statistics, float epsilon, float alpha, float dropout_probability,
+        minstd_rand0& generator
+    );
     void apply_dropout(
         float* values, float* gradients, bool perform_dropout, bool accumulate_test_statistics,
         float dropout_probability, minstd_rand0& generator
     );
 
-    // void backpropagate_dropout();
-    void backpropagate_relu(float* errors, float* gradients);
-    void backpropagate_batch_normalization(bool training, float mu, float learning_rate, float epsilon);
+    template <bool TRAINING>
+    void fused_backward(float mu, float learning_rate);
 
     void print_statistics();
     void print_statistics(const float* values, const float* errors, const float* gradients);
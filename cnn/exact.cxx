@@ -74,6 +74,12 @@ bool EXACT::exists_in_database(int exact_id) {
 }
 
 EXACT::EXACT(int exact_id) {
+    annotate_hot_spots = false;
+
+    multi_objective_cost = EXACT_COST_NONE;
+    calibration_flops.assign(NUMBER_COST_COMPONENTS, 0.0);
+    calibration_times.assign(NUMBER_COST_COMPONENTS, 0.0);
+
     ostringstream query;
 
     query << "SELECT * FROM exact_search WHERE id = " << exact_id;
@@ -513,6 +519,11 @@ EXACT::EXACT(
     max_epochs = _max_epochs;
     use_sfmp = _use_sfmp;
     use_node_operations = _use_node_operations;
+    annotate_hot_spots = false;
+
+    multi_objective_cost = EXACT_COST_NONE;
+    calibration_flops.assign(NUMBER_COST_COMPONENTS, 0.0);
+    calibration_times.assign(NUMBER_COST_COMPONENTS, 0.0);
 
     max_genomes = _max_genomes;
 
@@ -919,6 +930,187 @@ string EXACT::get_output_directory() const {
     return output_directory;
 }
 
+void EXACT::set_annotate_hot_spots(bool _annotate_hot_spots) {
+    annotate_hot_spots = _annotate_hot_spots;
+}
+
+void EXACT::set_multi_objective_cost(int _multi_objective_cost) {
+    multi_objective_cost = _multi_objective_cost;
+}
+
+/**
+ *  Adds the forward times the genome measured during its last evaluation (the test set after training), against its
+ *  forward flops, to the calibration of the cost model, and remembers its measured per image latency in milliseconds.
+ */
+void EXACT::calibrate_cost_model(CNN_Genome* genome) {
+    int number_images = genome->get_number_test_images();
+    if (number_images <= 0) {
+        return;
+    }
+
+    vector<float> flops, forward_times;
+    genome->get_inference_profile(flops, forward_times);
+
+    float total_time = 0.0;
+    for (int32_t i = 0; i < NUMBER_COST_COMPONENTS; i++) {
+        total_time += forward_times[i];
+        if (forward_times[i] <= 0.0 || flops[i] <= 0.0) {
+            continue;
+        }
+
+        calibration_flops[i] += (double) flops[i] * number_images;
+        calibration_times[i] += forward_times[i];
+    }
+
+    if (total_time > 0.0) {
+        measured_latencies[genome->get_generation_id()] = total_time / number_images;
+    }
+}
+
+/**
+ *  The estimated milliseconds to run a single image through the genome: its forward flop estimates weighted by the
+ *  calibrated milliseconds per flop of each kernel.  Components without calibration data fall back to the average rate
+ *  over all components (or the raw forward flop count before anything has been measured).  In latency mode the
+ *  genome's own measured latency is used instead if it is available.
+ */
+float EXACT::get_inference_cost(CNN_Genome* genome) const {
+    if (multi_objective_cost == EXACT_COST_LATENCY) {
+        auto measured = measured_latencies.find(genome->get_generation_id());
+        if (measured != measured_latencies.end()) {
+            return measured->second;
+        }
+    }
+
+    double total_flops = 0.0, total_time = 0.0;
+    for (int32_t i = 0; i < NUMBER_COST_COMPONENTS; i++) {
+        total_flops += calibration_flops[i];
+        total_time += calibration_times[i];
+    }
+    double average_rate = total_flops > 0.0 ? total_time / total_flops : 1.0;
+
+    vector<float> flops, forward_times;
+    genome->get_inference_profile(flops, forward_times);
+
+    double cost = 0.0;
+    for (int32_t i = 0; i < NUMBER_COST_COMPONENTS; i++) {
+        if (calibration_flops[i] > 0.0) {
+            cost += flops[i] * (calibration_times[i] / calibration_flops[i]);
+        } else {
+            cost += flops[i] * average_rate;
+        }
+    }
+    return cost;
+}
+
+void EXACT::get_inference_costs(vector<float>& costs) const {
+    costs.resize(genomes.size());
+    for (int32_t i = 0; i < (int32_t) genomes.size(); i++) {
+        costs[i] = get_inference_cost(genomes[i]);
+    }
+}
+
+static bool dominates(float error1, float cost1, float error2, float cost2) {
+    return error1 <= error2 && cost1 <= cost2 && (error1 < error2 || cost1 < cost2);
+}
+
+/**
+ *  Returns true if some genome in the population is at least as accurate and at least as cheap as this genome (and
+ *  better in one of the two).
+ */
+bool EXACT::is_dominated(CNN_Genome* genome) const {
+    float error = genome->get_best_validation_error();
+    float cost = get_inference_cost(genome);
+
+    for (int32_t i = 0; i < (int32_t) genomes.size(); i++) {
+        if (dominates(genomes[i]->get_best_validation_error(), get_inference_cost(genomes[i]), error, cost)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ *  The position of the genome dominated by the most other genomes in the population, ties go to the one with the
+ *  worst validation error.  This is the genome removed when the population is over full in multi objective mode.
+ */
+int32_t EXACT::get_most_dominated_position() const {
+    vector<float> costs;
+    get_inference_costs(costs);
+
+    int32_t most_dominated = (int32_t) genomes.size() - 1;
+    int32_t most_dominated_count = -1;
+    for (int32_t i = 0; i < (int32_t) genomes.size(); i++) {
+        int32_t dominated_count = 0;
+        for (int32_t j = 0; j < (int32_t) genomes.size(); j++) {
+            if (dominates(
+                    genomes[j]->get_best_validation_error(), costs[j], genomes[i]->get_best_validation_error(),
+                    costs[i]
+                )) {
+                dominated_count++;
+            }
+        }
+
+        // genomes are sorted by validation error, so >= keeps the least accurate on ties
+        if (dominated_count >= most_dominated_count) {
+            most_dominated = i;
+            most_dominated_count = dominated_count;
+        }
+    }
+    return most_dominated;
+}
+
+/**
+ *  The positions (in order of validation error) of the evaluated genomes which are not dominated by any other.
+ */
+void EXACT::get_pareto_front(vector<int32_t>& front_positions) const {
+    vector<float> costs;
+    get_inference_costs(costs);
+
+    front_positions.clear();
+    for (int32_t i = 0; i < (int32_t) genomes.size(); i++) {
+        if (genomes[i]->get_best_validation_error() == EXACT_MAX_FLOAT) {
+            continue;
+        }
+
+        bool dominated = false;
+        for (int32_t j = 0; j < (int32_t) genomes.size() && !dominated; j++) {
+            dominated = dominates(
+                genomes[j]->get_best_validation_error(), costs[j], genomes[i]->get_best_validation_error(), costs[i]
+            );
+        }
+
+        if (!dominated) {
+            front_positions.push_back(i);
+        }
+    }
+}
+
+void EXACT::write_pareto_front() {
+    bool write_header = !ifstream(output_directory + "/pareto_front.txt").good();
+
+    fstream out(output_directory + "/pareto_front.txt", fstream::out | fstream::app);
+    if (write_header) {
+        out << "# " << setw(14) << "time"
+            << ", " << setw(14) << "inserted"
+            << ", " << setw(14) << "front size"
+            << ", " << setw(14) << (multi_objective_cost == EXACT_COST_LATENCY ? "latency" : "operations")
+            << " (generation id:validation error:ms per image, forward flops before any are measured)..." << endl;
+    }
+
+    vector<int32_t> front_positions;
+    get_pareto_front(front_positions);
+
+    out << setw(16) << time(NULL) << setw(16) << inserted_genomes << setw(16) << front_positions.size();
+    for (int32_t i = 0; i < (int32_t) front_positions.size(); i++) {
+        CNN_Genome* genome = genomes[front_positions[i]];
+        out << " " << genome->get_generation_id() << ":" << setprecision(5) << fixed
+            << genome->get_best_validation_error() << ":" << setprecision(8) << get_inference_cost(genome);
+    }
+    out << endl;
+
+    out.close();
+}
+
 string EXACT::get_training_filename() const {
     return training_filename;
 }
@@ -1354,6 +1546,10 @@ bool EXACT::insert_genome(CNN_Genome* genome) {
     if (genome->get_best_validation_error() != EXACT_MAX_FLOAT) {
         write_individual_hyperparameters(genome);
 
+        if (multi_objective_cost != EXACT_COST_NONE) {
+            calibrate_cost_model(genome);
+        }
+
         int genome_test_predictions = genome->get_test_predictions();
         int best_genome_test_predictions = 0;
         if (best_predictions_genome != NULL) {
@@ -1408,10 +1604,12 @@ bool EXACT::insert_genome(CNN_Genome* genome) {
                  << parse_fitness(duplicate->get_best_validation_error())
                  << ", new fitness: " << parse_fitness(genome->get_best_validation_error()) << endl;
             genomes.erase(genomes.begin() + duplicate_genome);
+            measured_latencies.erase(duplicate->get_generation_id());
             delete duplicate;
 
         } else {
             cerr << "\tpopulation already contains genome! not inserting." << endl;
+            measured_latencies.erase(genome->get_generation_id());
             if (!was_best_predictions_genome) {
                 delete genome;
             }
@@ -1529,7 +1727,7 @@ bool EXACT::insert_genome(CNN_Genome* genome) {
         gv_file << "#\t\tnode_enable: " << node_enable << endl;
         gv_file << "#\t\tnode_disable: " << node_disable << endl;
 
-        genome->print_graphviz(gv_file);
+        genome->print_graphviz(gv_file, annotate_hot_spots);
         gv_file.close();
     }
     cout << endl;
@@ -1547,11 +1745,21 @@ bool EXACT::insert_genome(CNN_Genome* genome) {
              << endl;
     }
 
-    if ((int32_t) genomes.size() >= population_size
-        && genome->get_best_validation_error() >= genomes.back()->get_best_validation_error()) {
+    bool poor_fitness = (int32_t) genomes.size() >= population_size
+                        && genome->get_best_validation_error() >= genomes.back()->get_best_validation_error();
+    if (poor_fitness && multi_objective_cost != EXACT_COST_NONE) {
+        // less accurate genomes are still kept if they are cheaper than everything as accurate as them
+        poor_fitness = is_dominated(genome);
+        if (!poor_fitness) {
+            cout << "genome is on the pareto front with cost: " << get_inference_cost(genome) << endl;
+        }
+    }
+
+    if (poor_fitness) {
         // this will not be inserted into the population
         cout << "not inserting genome due to poor fitness" << endl;
         was_inserted = false;
+        measured_latencies.erase(genome->get_generation_id());
 
         if (!was_best_predictions_genome) {
             delete genome;
@@ -1572,10 +1780,20 @@ bool EXACT::insert_genome(CNN_Genome* genome) {
         // delete the worst individual if we've reached the population size
         if ((int32_t) genomes.size() > population_size) {
             cout << "deleting worst genome" << endl;
-            CNN_Genome* worst = genomes.back();
-            genomes.pop_back();
+            int32_t worst_position = (int32_t) genomes.size() - 1;
+            if (multi_objective_cost != EXACT_COST_NONE) {
+                worst_position = get_most_dominated_position();
+            }
 
-            if (worst->get_genome_id() != best_predictions_genome_id) {
+            CNN_Genome* worst = genomes[worst_position];
+            genomes.erase(genomes.begin() + worst_position);
+            measured_latencies.erase(worst->get_generation_id());
+
+            if (worst == genome) {
+                was_inserted = false;
+            }
+
+            if (worst->get_genome_id() != best_predictions_genome_id && worst != best_predictions_genome) {
                 delete worst;
             }
         }
@@ -3087,6 +3305,10 @@ void EXACT::write_statistics(int new_generation_id, float new_fitness) {
 
     out.close();
 
+    if (multi_objective_cost != EXACT_COST_NONE) {
+        write_pareto_front();
+    }
+
     out = fstream(output_directory + "/hyperparameters.txt", fstream::out | fstream::app);
 
     float min_initial_mu = 10, max_initial_mu = 0, avg_initial_mu = 0;
@@ -28,6 +28,11 @@ using std::vector;
 #include "cnn_node.hxx"
 #include "image_tools/image_set.hxx"
 
+// the second objective (besides validation error) used to keep a pareto front of the population
+#define EXACT_COST_NONE       0
+#define EXACT_COST_OPERATIONS 1
+#define EXACT_COST_LATENCY    2
+
 class EXACT {
    private:
     int id;
@@ -72,6 +77,15 @@ class EXACT {
     bool use_sfmp;
     bool use_node_operations;
 
+    bool annotate_hot_spots;
+
+    // milliseconds and flops measured for each cost component over all evaluated genomes, their ratio calibrates
+    // the per kernel cost of the flop estimates
+    int multi_objective_cost;
+    vector<double> calibration_flops;
+    vector<double> calibration_times;
+    map<int, float> measured_latencies;
+
     float initial_batch_size_min;
     float initial_batch_size_max;
     float batch_size_min;
@@ -206,6 +220,17 @@ class EXACT {
     int get_id() const;
     string get_search_name() const;
     string get_output_directory() const;
+
+    void set_annotate_hot_spots(bool _annotate_hot_spots);
+    void set_multi_objective_cost(int _multi_objective_cost);
+
+    void calibrate_cost_model(CNN_Genome* genome);
+    float get_inference_cost(CNN_Genome* genome) const;
+    void get_inference_costs(vector<float>& costs) const;
+    bool is_dominated(CNN_Genome* genome) const;
+    int32_t get_most_dominated_position() const;
+    void get_pareto_front(vector<int32_t>& front_positions) const;
+    void write_pareto_front();
     string get_training_filename() const;
     string get_validation_filename() const;
     string get_test_filename() const;
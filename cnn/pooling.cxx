@@ -23,6 +23,7 @@ using std::string;
 using std::vector;
 
 #include "common/random.hxx"
+#include "pooling.hxx"
 
 #define REPEATS 16
 
@@ -99,331 +100,196 @@ void initialize_pools(vector<int>& pools, vector<int>& offset, int input_size, i
 }
 
 /********************************************
- * FORWARD PROPAGATION
+ * POOL MAPS
  ********************************************/
 
-// pool forward when the y dimension of the output is less than the y dimension of the input and
-// the x dimension of the output is less than the the x dimension of the input
-void pool_forward(
-    const float* input, float scale, float* pool_gradients, float* output, int32_t batch_size, int32_t input_size_y,
-    int32_t input_size_x, int32_t output_size_y, int32_t output_size_x, vector<int>& y_pools, vector<int>& x_pools,
-    vector<int>& y_pool_offset, vector<int>& x_pool_offset
+// builds the window of input pixels each output pixel is pooled from, as POOL_MAP_STRIDE values per output pixel:
+// the index of the window's first pixel in the input image, the window's height and the window's width. when the
+// output is larger than the input along a dimension (a reverse filter) the window is a single pixel along it, and
+// each input pixel is copied to a pool of output pixels instead
+void build_pool_map(
+    vector<int32_t>& pool_map, bool reverse_filter_y, bool reverse_filter_x, int32_t input_size_x,
+    int32_t output_size_y, int32_t output_size_x, const vector<int>& y_pools, const vector<int>& x_pools,
+    const vector<int>& y_pool_offset, const vector<int>& x_pool_offset
 ) {
-    int32_t input_batch_offset = 0;
-    int32_t output_batch_offset = 0;
-
-    int32_t input_image_size = input_size_y * input_size_x;
-    int32_t output_image_size = output_size_y * output_size_x;
-
-    for (int32_t batch_number = 0; batch_number < batch_size; batch_number++) {
-        for (int32_t out_y = 0; out_y < y_pools.size(); out_y++) {
-            for (int32_t out_x = 0; out_x < x_pools.size(); out_x++) {
-                int32_t max_y = 0;
-                int32_t max_x = 0;
-
-                int32_t in_y = y_pool_offset[out_y];
-                int32_t in_x = x_pool_offset[out_x];
-
-                // cout << "getting max value for pool starting at " << in_y  << " x " << in_x << " from:" << endl;
-                float max_value = -numeric_limits<float>::max();
-                for (int32_t pool_y = 0; pool_y < y_pools[out_y]; pool_y++) {
-                    for (int32_t pool_x = 0; pool_x < x_pools[out_x]; pool_x++) {
-                        float current_value =
-                            input[input_batch_offset + ((in_y + pool_y) * input_size_x) + in_x + pool_x];
-                        // cout << " " << current_value;
-                        if (current_value > max_value) {
-                            max_value = current_value;
-                            max_y = pool_y;
-                            max_x = pool_x;
-                        }
-                    }
-                }
-                // cout << " -- max value: " << max_value << endl;
-
-                for (int32_t pool_y = 0; pool_y < y_pools[out_y]; pool_y++) {
-                    for (int32_t pool_x = 0; pool_x < x_pools[out_x]; pool_x++) {
-                        if (pool_y == max_y && pool_x == max_x) {
-                            output[output_batch_offset + (out_y * output_size_x) + out_x] += max_value * scale;
-
-                            pool_gradients[input_batch_offset + ((in_y + pool_y) * input_size_x) + in_x + pool_x] =
-                                scale;
-                        } else {
-                            pool_gradients[input_batch_offset + ((in_y + pool_y) * input_size_x) + in_x + pool_x] = 0;
-                        }
-                    }
-                }
+    vector<int32_t> window_y(output_size_y), window_height(output_size_y);
+    if (reverse_filter_y) {
+        for (int32_t in_y = 0; in_y < (int32_t) y_pools.size(); in_y++) {
+            for (int32_t pool_y = 0; pool_y < y_pools[in_y]; pool_y++) {
+                window_y[y_pool_offset[in_y] + pool_y] = in_y;
+                window_height[y_pool_offset[in_y] + pool_y] = 1;
             }
         }
-        input_batch_offset += input_image_size;
-        output_batch_offset += output_image_size;
+    } else {
+        for (int32_t out_y = 0; out_y < output_size_y; out_y++) {
+            window_y[out_y] = y_pool_offset[out_y];
+            window_height[out_y] = y_pools[out_y];
+        }
     }
-}
 
-void pool_forward(
-    const float* input, float scale, float* pool_gradients, float* output, int32_t batch_size, int32_t input_size_y,
-    int32_t input_size_x, int32_t output_size_y, int32_t output_size_x, vector<int>& y_pools, vector<int>& x_pools,
-    vector<int>& y_pool_offset, vector<int>& x_pool_offset, minstd_rand0& generator, bool training, bool max_pooling
-) {
-    if (training || max_pooling) {
-        pool_forward(
-            input, scale, pool_gradients, output, batch_size, input_size_y, input_size_x, output_size_y, output_size_x,
-            y_pools, x_pools, y_pool_offset, x_pool_offset
-        );
+    vector<int32_t> window_x(output_size_x), window_width(output_size_x);
+    if (reverse_filter_x) {
+        for (int32_t in_x = 0; in_x < (int32_t) x_pools.size(); in_x++) {
+            for (int32_t pool_x = 0; pool_x < x_pools[in_x]; pool_x++) {
+                window_x[x_pool_offset[in_x] + pool_x] = in_x;
+                window_width[x_pool_offset[in_x] + pool_x] = 1;
+            }
+        }
     } else {
-        int output_image_size = output_size_y * output_size_x;
-        float* temp_output = new float[batch_size * output_image_size];
-        std::fill_n(temp_output, batch_size * output_image_size, 0);
-
-        for (int32_t i = 0; i < REPEATS; i++) {
-            fisher_yates_shuffle(generator, y_pools);
-            fisher_yates_shuffle(generator, x_pools);
-            update_offset(y_pools, y_pool_offset);
-            update_offset(x_pools, x_pool_offset);
+        for (int32_t out_x = 0; out_x < output_size_x; out_x++) {
+            window_x[out_x] = x_pool_offset[out_x];
+            window_width[out_x] = x_pools[out_x];
+        }
+    }
 
-            pool_forward(
-                input, scale, pool_gradients, temp_output, batch_size, input_size_y, input_size_x, output_size_y,
-                output_size_x, y_pools, x_pools, y_pool_offset, x_pool_offset
-            );
+    pool_map.resize(output_size_y * output_size_x * POOL_MAP_STRIDE);
+    int32_t current = 0;
+    for (int32_t out_y = 0; out_y < output_size_y; out_y++) {
+        for (int32_t out_x = 0; out_x < output_size_x; out_x++) {
+            pool_map[current++] = (window_y[out_y] * input_size_x) + window_x[out_x];
+            pool_map[current++] = window_height[out_y];
+            pool_map[current++] = window_width[out_x];
         }
+    }
+}
 
-        for (int32_t i = 0; i < batch_size * output_image_size; i++) {
-            output[i] += temp_output[i] / REPEATS;
+// returns the size of every pool along a dimension if they are all the same, or 0 if they are not. pools along a
+// reverse filter dimension are only uniform if they are all a single pixel
+int32_t get_uniform_pool_size(const vector<int>& pools, bool reverse_filter) {
+    for (int32_t i = 1; i < (int32_t) pools.size(); i++) {
+        if (pools[i] != pools[0]) {
+            return 0;
         }
+    }
 
-        delete[] temp_output;
+    if (pools.size() == 0 || (reverse_filter && pools[0] != 1)) {
+        return 0;
     }
+    return pools[0];
 }
 
-// pool forward when the y dimension of the output is greater than the y dimension of the input and
-// the x dimension of the output is less than the the x dimension of the input
-void pool_forward_ry(
-    const float* input, float scale, float* pool_gradients, float* output, int32_t batch_size, int32_t input_size_y,
-    int32_t input_size_x, int32_t output_size_y, int32_t output_size_x, vector<int>& y_pools, vector<int>& x_pools,
-    vector<int>& y_pool_offset, vector<int>& x_pool_offset
-) {
-    int32_t input_batch_offset = 0;
-    int32_t output_batch_offset = 0;
+/********************************************
+ * FORWARD PROPAGATION
+ ********************************************/
 
+// pool forward for any pool sizes, the output gets the max value of each window in the pool map (times scale) and
+// pool_argmax gets the index of that value in the input image
+void pool_forward(
+    const float* __restrict__ input, float scale, const vector<int32_t>& pool_map, int32_t* __restrict__ pool_argmax,
+    float* __restrict__ output, int32_t batch_size, int32_t input_size_y, int32_t input_size_x,
+    int32_t output_size_y, int32_t output_size_x
+) {
     int32_t input_image_size = input_size_y * input_size_x;
     int32_t output_image_size = output_size_y * output_size_x;
+    const int32_t* windows = pool_map.data();
 
     for (int32_t batch_number = 0; batch_number < batch_size; batch_number++) {
-        for (int32_t in_y = 0; in_y < input_size_y; in_y++) {
-            for (int32_t out_x = 0; out_x < x_pools.size(); out_x++) {
-                int32_t max_x = 0;
-
-                int32_t out_y = y_pool_offset[in_y];
-                int32_t in_x = x_pool_offset[out_x];
-
-                // cout << "getting max value for pool starting at " << in_y  << " x " << in_x << " from:" << endl;
-                float max_value = -numeric_limits<float>::max();
-                for (int32_t pool_x = 0; pool_x < x_pools[out_x]; pool_x++) {
-                    float current_value = input[input_batch_offset + (in_y * input_size_x) + in_x + pool_x];
-                    // cout << " " << current_value;
-                    if (current_value > max_value) {
-                        max_value = current_value;
-                        max_x = pool_x;
-                    }
-                }
-                // cout << " -- max value: " << max_value << endl;
-
-                for (int32_t pool_x = 0; pool_x < x_pools[out_x]; pool_x++) {
-                    if (pool_x == max_x) {
-                        for (int32_t pool_y = 0; pool_y < y_pools[in_y]; pool_y++) {
-                            // cout << "setting output[" << out_y + pool_y << "][" << out_x << "] to: " << max_value <<
-                            // endl;
-                            output[output_batch_offset + ((out_y + pool_y) * output_size_x) + out_x] +=
-                                max_value * scale;
-                        }
-
-                        // cout << "setting pool_gradient[" << in_y << "][" << in_x + pool_x << "]: to 1" << endl;
-                        pool_gradients[input_batch_offset + (in_y * input_size_x) + in_x + pool_x] = scale;
-                    } else {
-                        // cout << "setting pool_gradient[" << in_y << "][" << in_x + pool_x << "]: to 0" << endl;
-                        pool_gradients[input_batch_offset + (in_y * input_size_x) + in_x + pool_x] = 0;
+        const float* input_image = input + (batch_number * input_image_size);
+        float* output_image = output + (batch_number * output_image_size);
+        int32_t* argmax_image = pool_argmax + (batch_number * output_image_size);
+
+        for (int32_t current = 0; current < output_image_size; current++) {
+            const int32_t* window = windows + (current * POOL_MAP_STRIDE);
+            int32_t window_start = window[0];
+            int32_t max_index = window_start;
+
+            float max_value = -numeric_limits<float>::max();
+            for (int32_t pool_y = 0; pool_y < window[1]; pool_y++) {
+                int32_t row_start = window_start + (pool_y * input_size_x);
+                for (int32_t pool_x = 0; pool_x < window[2]; pool_x++) {
+                    if (input_image[row_start + pool_x] > max_value) {
+                        max_value = input_image[row_start + pool_x];
+                        max_index = row_start + pool_x;
                     }
                 }
             }
+
+            output_image[current] += max_value * scale;
+            argmax_image[current] = max_index;
         }
-        input_batch_offset += input_image_size;
-        output_batch_offset += output_image_size;
     }
 }
 
-void pool_forward_ry(
-    const float* input, float scale, float* pool_gradients, float* output, int32_t batch_size, int32_t input_size_y,
-    int32_t input_size_x, int32_t output_size_y, int32_t output_size_x, vector<int>& y_pools, vector<int>& x_pools,
-    vector<int>& y_pool_offset, vector<int>& x_pool_offset, minstd_rand0& generator, bool training, bool max_pooling
+// pool forward when every window is pool_size_y by pool_size_x and the windows tile the input without gaps. this is
+// done a row of output pixels at a time with branchless selects so the compiler can vectorize across the row, and
+// scans each window in the same order as the general version so ties pick the same pixel
+void pool_forward_uniform(
+    const float* __restrict__ input, float scale, int32_t* __restrict__ pool_argmax, float* __restrict__ output,
+    int32_t batch_size, int32_t input_size_y, int32_t input_size_x, int32_t output_size_y, int32_t output_size_x,
+    int32_t pool_size_y, int32_t pool_size_x
 ) {
-    if (training || max_pooling) {
-        pool_forward_ry(
-            input, scale, pool_gradients, output, batch_size, input_size_y, input_size_x, output_size_y, output_size_x,
-            y_pools, x_pools, y_pool_offset, x_pool_offset
-        );
-    } else {
-        int output_image_size = output_size_y * output_size_x;
-        float* temp_output = new float[batch_size * output_image_size];
-        std::fill_n(temp_output, batch_size * output_image_size, 0);
+    int32_t input_image_size = input_size_y * input_size_x;
+    int32_t output_image_size = output_size_y * output_size_x;
 
-        for (int32_t i = 0; i < REPEATS; i++) {
-            fisher_yates_shuffle(generator, y_pools);
-            fisher_yates_shuffle(generator, x_pools);
-            update_offset(y_pools, y_pool_offset);
-            update_offset(x_pools, x_pool_offset);
+    vector<float> max_values(output_size_x);
+    float* __restrict__ row_max = max_values.data();
 
-            pool_forward_ry(
-                input, scale, pool_gradients, temp_output, batch_size, input_size_y, input_size_x, output_size_y,
-                output_size_x, y_pools, x_pools, y_pool_offset, x_pool_offset
-            );
-        }
+    for (int32_t batch_number = 0; batch_number < batch_size; batch_number++) {
+        const float* input_image = input + (batch_number * input_image_size);
 
-        for (int32_t i = 0; i < batch_size * output_image_size; i++) {
-            output[i] += temp_output[i] / REPEATS;
-        }
+        for (int32_t out_y = 0; out_y < output_size_y; out_y++) {
+            float* output_row = output + (batch_number * output_image_size) + (out_y * output_size_x);
+            int32_t* argmax_row = pool_argmax + (batch_number * output_image_size) + (out_y * output_size_x);
 
-        delete[] temp_output;
-    }
-}
-
-// pool forward when the y dimension of the output is less than the y dimension of the input and
-// the x dimension of the output is greater than the the x dimension of the input
-void pool_forward_rx(
-    const float* input, float scale, float* pool_gradients, float* output, int32_t batch_size, int32_t input_size_y,
-    int32_t input_size_x, int32_t output_size_y, int32_t output_size_x, vector<int>& y_pools, vector<int>& x_pools,
-    vector<int>& y_pool_offset, vector<int>& x_pool_offset
-) {
-    int32_t input_batch_offset = 0;
-    int32_t output_batch_offset = 0;
+            for (int32_t out_x = 0; out_x < output_size_x; out_x++) {
+                row_max[out_x] = -numeric_limits<float>::max();
+                argmax_row[out_x] = (out_y * pool_size_y * input_size_x) + (out_x * pool_size_x);
+            }
 
-    int32_t input_image_size = input_size_y * input_size_x;
-    int32_t output_image_size = output_size_y * output_size_x;
+            for (int32_t pool_y = 0; pool_y < pool_size_y; pool_y++) {
+                for (int32_t pool_x = 0; pool_x < pool_size_x; pool_x++) {
+                    int32_t row_start = (((out_y * pool_size_y) + pool_y) * input_size_x) + pool_x;
+                    const float* input_row = input_image + row_start;
 
-    for (int32_t batch_number = 0; batch_number < batch_size; batch_number++) {
-        for (int32_t out_y = 0; out_y < y_pools.size(); out_y++) {
-            for (int32_t in_x = 0; in_x < input_size_x; in_x++) {
-                int32_t max_y = 0;
-
-                int32_t in_y = y_pool_offset[out_y];
-                int32_t out_x = x_pool_offset[in_x];
-
-                // cout << "getting max value for pool starting at " << in_y  << " x " << in_x << " from:" << endl;
-                float max_value = -numeric_limits<float>::max();
-                for (int32_t pool_y = 0; pool_y < y_pools[out_y]; pool_y++) {
-                    float current_value = input[input_batch_offset + ((in_y + pool_y) * input_size_x) + in_x];
-                    // cout << " " << current_value;
-                    if (current_value > max_value) {
-                        max_value = current_value;
-                        max_y = pool_y;
-                    }
-                }
-                // cout << " -- max value: " << max_value << endl;
-
-                for (int32_t pool_y = 0; pool_y < y_pools[out_y]; pool_y++) {
-                    if (pool_y == max_y) {
-                        for (int32_t pool_x = 0; pool_x < x_pools[in_x]; pool_x++) {
-                            // cout << "setting output[" << out_y << "][" << out_x + pool_x << "] to: " << max_value <<
-                            // endl;
-                            output[output_batch_offset + (out_y * output_size_x) + out_x + pool_x] += max_value * scale;
-                        }
-
-                        // cout << "setting pool_gradient[" << in_y + pool_y << "][" << in_x << "]: to 1" << endl;
-                        pool_gradients[input_batch_offset + ((in_y + pool_y) * input_size_x) + in_x] = scale;
-                    } else {
-                        // cout << "setting pool_gradient[" << in_y + pool_y << "][" << in_x << "]: to 0" << endl;
-                        pool_gradients[input_batch_offset + ((in_y + pool_y) * input_size_x) + in_x] = 0;
+                    for (int32_t out_x = 0; out_x < output_size_x; out_x++) {
+                        float value = input_row[out_x * pool_size_x];
+                        bool greater = value > row_max[out_x];
+                        row_max[out_x] = greater ? value : row_max[out_x];
+                        argmax_row[out_x] = greater ? row_start + (out_x * pool_size_x) : argmax_row[out_x];
                     }
                 }
             }
-        }
-        input_batch_offset += input_image_size;
-        output_batch_offset += output_image_size;
-    }
-}
 
-void pool_forward_rx(
-    const float* input, float scale, float* pool_gradients, float* output, int32_t batch_size, int32_t input_size_y,
-    int32_t input_size_x, int32_t output_size_y, int32_t output_size_x, vector<int>& y_pools, vector<int>& x_pools,
-    vector<int>& y_pool_offset, vector<int>& x_pool_offset, minstd_rand0& generator, bool training, bool max_pooling
-) {
-    if (training || max_pooling) {
-        pool_forward_rx(
-            input, scale, pool_gradients, output, batch_size, input_size_y, input_size_x, output_size_y, output_size_x,
-            y_pools, x_pools, y_pool_offset, x_pool_offset
-        );
-    } else {
-        int output_image_size = output_size_y * output_size_x;
-        float* temp_output = new float[batch_size * output_image_size];
-        std::fill_n(temp_output, batch_size * output_image_size, 0);
-
-        for (int32_t i = 0; i < REPEATS; i++) {
-            fisher_yates_shuffle(generator, y_pools);
-            fisher_yates_shuffle(generator, x_pools);
-            update_offset(y_pools, y_pool_offset);
-            update_offset(x_pools, x_pool_offset);
-
-            pool_forward_rx(
-                input, scale, pool_gradients, temp_output, batch_size, input_size_y, input_size_x, output_size_y,
-                output_size_x, y_pools, x_pools, y_pool_offset, x_pool_offset
-            );
-        }
-
-        for (int32_t i = 0; i < batch_size * output_image_size; i++) {
-            output[i] += temp_output[i] / REPEATS;
+            for (int32_t out_x = 0; out_x < output_size_x; out_x++) {
+                output_row[out_x] += row_max[out_x] * scale;
+            }
         }
-
-        delete[] temp_output;
     }
 }
 
-// pool forward when the y dimension of the output is greater than the y dimension of the input and
-// the x dimension of the output is greater than the the x dimension of the input
-void pool_forward_ry_rx(
-    const float* input, float scale, float* pool_gradients, float* output, int32_t batch_size, int32_t input_size_y,
-    int32_t input_size_x, int32_t output_size_y, int32_t output_size_x, vector<int>& y_pools, vector<int>& x_pools,
-    vector<int>& y_pool_offset, vector<int>& x_pool_offset
+static void pool_forward_dispatch(
+    const float* input, float scale, const vector<int32_t>& pool_map, int32_t* pool_argmax, float* output,
+    int32_t batch_size, int32_t input_size_y, int32_t input_size_x, int32_t output_size_y, int32_t output_size_x,
+    bool reverse_filter_y, bool reverse_filter_x, const vector<int>& y_pools, const vector<int>& x_pools
 ) {
-    int32_t input_batch_offset = 0;
-    int32_t output_batch_offset = 0;
-
-    int32_t input_image_size = input_size_y * input_size_x;
-    int32_t output_image_size = output_size_y * output_size_x;
+    int32_t pool_size_y = get_uniform_pool_size(y_pools, reverse_filter_y);
+    int32_t pool_size_x = get_uniform_pool_size(x_pools, reverse_filter_x);
 
-    for (int32_t batch_number = 0; batch_number < batch_size; batch_number++) {
-        for (int32_t in_y = 0; in_y < input_size_y; in_y++) {
-            for (int32_t in_x = 0; in_x < input_size_x; in_x++) {
-                int32_t out_y = y_pool_offset[in_y];
-                int32_t out_x = x_pool_offset[in_x];
-
-                // cout << "getting max value for pool starting at " << in_y  << " x " << in_x << " from:" << endl;
-                float max_value = input[input_batch_offset + (in_y * input_size_x) + in_x];
-                // cout << " -- max value: " << max_value << endl;
-
-                for (int32_t pool_y = 0; pool_y < y_pools[in_y]; pool_y++) {
-                    for (int32_t pool_x = 0; pool_x < x_pools[in_x]; pool_x++) {
-                        // cout << "setting output[" << out_y + pool_y << "][" << out_x + pool_x << "] to: " <<
-                        // max_value << endl;
-                        output[output_batch_offset + ((out_y + pool_y) * output_size_x) + out_x + pool_x] +=
-                            max_value * scale;
-                    }
-                }
-                // cout << "setting pool_gradient[" << in_y << "][" << in_x << "]: to 1" << endl;
-                pool_gradients[input_batch_offset + (in_y * input_size_x) + in_x] = scale;
-            }
-        }
-        input_batch_offset += input_image_size;
-        output_batch_offset += output_image_size;
+    if (pool_size_y > 0 && pool_size_x > 0) {
+        pool_forward_uniform(
+            input, scale, pool_argmax, output, batch_size, input_size_y, input_size_x, output_size_y, output_size_x,
+            pool_size_y, pool_size_x
+        );
+    } else {
+        pool_forward(
+            input, scale, pool_map, pool_argmax, output, batch_size, input_size_y, input_size_x, output_size_y,
+            output_size_x
+        );
     }
 }
 
-void pool_forward_ry_rx(
-    const float* input, float scale, float* pool_gradients, float* output, int32_t batch_size, int32_t input_size_y,
-    int32_t input_size_x, int32_t output_size_y, int32_t output_size_x, vector<int>& y_pools, vector<int>& x_pools,
+// when not training with stochastic (fractional) pools the output is averaged over REPEATS shuffles of the pools,
+// the pool map is rebuilt for each shuffle and is left matching the final one (as is pool_argmax)
+void pool_forward(
+    const float* input, float scale, vector<int32_t>& pool_map, int32_t* pool_argmax, float* output,
+    int32_t batch_size, int32_t input_size_y, int32_t input_size_x, int32_t output_size_y, int32_t output_size_x,
+    bool reverse_filter_y, bool reverse_filter_x, vector<int>& y_pools, vector<int>& x_pools,
     vector<int>& y_pool_offset, vector<int>& x_pool_offset, minstd_rand0& generator, bool training, bool max_pooling
 ) {
     if (training || max_pooling) {
-        pool_forward_ry_rx(
-            input, scale, pool_gradients, output, batch_size, input_size_y, input_size_x, output_size_y, output_size_x,
-            y_pools, x_pools, y_pool_offset, x_pool_offset
+        pool_forward_dispatch(
+            input, scale, pool_map, pool_argmax, output, batch_size, input_size_y, input_size_x, output_size_y,
+            output_size_x, reverse_filter_y, reverse_filter_x, y_pools, x_pools
         );
     } else {
         int output_image_size = output_size_y * output_size_x;
@@ -435,10 +301,14 @@ void pool_forward_ry_rx(
             fisher_yates_shuffle(generator, x_pools);
             update_offset(y_pools, y_pool_offset);
             update_offset(x_pools, x_pool_offset);
+            build_pool_map(
+                pool_map, reverse_filter_y, reverse_filter_x, input_size_x, output_size_y, output_size_x, y_pools,
+                x_pools, y_pool_offset, x_pool_offset
+            );
 
-            pool_forward_ry_rx(
-                input, scale, pool_gradients, temp_output, batch_size, input_size_y, input_size_x, output_size_y,
-                output_size_x, y_pools, x_pools, y_pool_offset, x_pool_offset
+            pool_forward_dispatch(
+                input, scale, pool_map, pool_argmax, temp_output, batch_size, input_size_y, input_size_x,
+                output_size_y, output_size_x, reverse_filter_y, reverse_filter_x, y_pools, x_pools
             );
         }
 
@@ -454,168 +324,29 @@ void pool_forward_ry_rx(
  * BACK PROPAGATION
  ********************************************/
 
-// pool backward when the y dimension of the output is less than the y dimension of the input and
-// the x dimension of the output is less than the the x dimension of the input
+// pool backward for any pool sizes: each output error is scattered (times scale) to the input pixel its value came
+// from. outputs which were copies of the same input pixel (reverse filters) all add to its error
 void pool_backward(
-    float* input_errors, float& scale_update, const float* inputs, const float* pool_gradients,
-    const float* output_errors, int32_t batch_size, int32_t input_size_y, int32_t input_size_x, int32_t output_size_y,
-    int32_t output_size_x, vector<int>& y_pools, vector<int>& x_pools, vector<int>& y_pool_offset,
-    vector<int>& x_pool_offset
-) {
-    int32_t input_batch_offset = 0;
-    int32_t output_batch_offset = 0;
-
-    int32_t input_image_size = input_size_y * input_size_x;
-    int32_t output_image_size = output_size_y * output_size_x;
-
-    scale_update = 0.0;
-    for (int32_t batch_number = 0; batch_number < batch_size; batch_number++) {
-        for (int32_t out_y = 0; out_y < y_pools.size(); out_y++) {
-            for (int32_t out_x = 0; out_x < x_pools.size(); out_x++) {
-                int32_t in_y = y_pool_offset[out_y];
-                int32_t in_x = x_pool_offset[out_x];
-
-                // cout << "getting max value for pool starting at " << in_y  << " x " << in_x << " from:" << endl;
-                float output_error = output_errors[output_batch_offset + (out_y * output_size_x) + out_x];
-
-                for (int32_t pool_y = 0; pool_y < y_pools[out_y]; pool_y++) {
-                    for (int32_t pool_x = 0; pool_x < x_pools[out_x]; pool_x++) {
-                        int position = input_batch_offset + ((in_y + pool_y) * input_size_x) + in_x + pool_x;
-                        float delta = output_error * pool_gradients[position];  // pool gradients includes scale
-                        input_errors[position] += delta;
-                        scale_update += inputs[position] * delta;
-                    }
-                }
-            }
-        }
-        input_batch_offset += input_image_size;
-        output_batch_offset += output_image_size;
-    }
-    scale_update /= batch_size;
-}
-
-// pool backward when the y dimension of the output is greater than the y dimension of the input and
-// the x dimension of the output is less than the the x dimension of the input
-void pool_backward_ry(
-    float* input_errors, float& scale_update, const float* inputs, const float* pool_gradients,
-    const float* output_errors, int32_t batch_size, int32_t input_size_y, int32_t input_size_x, int32_t output_size_y,
-    int32_t output_size_x, vector<int>& y_pools, vector<int>& x_pools, vector<int>& y_pool_offset,
-    vector<int>& x_pool_offset
-) {
-    int32_t input_batch_offset = 0;
-    int32_t output_batch_offset = 0;
-
-    int32_t input_image_size = input_size_y * input_size_x;
-    int32_t output_image_size = output_size_y * output_size_x;
-
-    scale_update = 0.0;
-    for (int32_t batch_number = 0; batch_number < batch_size; batch_number++) {
-        for (int32_t in_y = 0; in_y < input_size_y; in_y++) {
-            for (int32_t out_x = 0; out_x < x_pools.size(); out_x++) {
-                int32_t out_y = y_pool_offset[in_y];
-                int32_t in_x = x_pool_offset[out_x];
-
-                // cout << "getting max value for pool starting at " << in_y  << " x " << in_x << " from:" << endl;
-                float output_error = 0.0;
-                for (int32_t pool_y = 0; pool_y < y_pools[in_y]; pool_y++) {
-                    output_error += output_errors[output_batch_offset + ((out_y + pool_y) * output_size_x) + out_x];
-                }
-
-                for (int32_t pool_x = 0; pool_x < x_pools[out_x]; pool_x++) {
-                    int position = input_batch_offset + (in_y * input_size_x) + in_x + pool_x;
-                    float delta = output_error * pool_gradients[position];
-                    input_errors[position] += delta;
-                    scale_update += inputs[position] * delta;
-                }
-            }
-        }
-        input_batch_offset += input_image_size;
-        output_batch_offset += output_image_size;
-    }
-    scale_update /= batch_size;
-}
-
-// pool backward when the y dimension of the output is less than the y dimension of the input and
-// the x dimension of the output is greater than the the x dimension of the input
-void pool_backward_rx(
-    float* input_errors, float& scale_update, const float* inputs, const float* pool_gradients,
-    const float* output_errors, int32_t batch_size, int32_t input_size_y, int32_t input_size_x, int32_t output_size_y,
-    int32_t output_size_x, vector<int>& y_pools, vector<int>& x_pools, vector<int>& y_pool_offset,
-    vector<int>& x_pool_offset
+    float* __restrict__ input_errors, float& scale_update, const float* __restrict__ inputs,
+    const int32_t* __restrict__ pool_argmax, const float* __restrict__ output_errors, float scale,
+    int32_t batch_size, int32_t input_size_y, int32_t input_size_x, int32_t output_size_y, int32_t output_size_x
 ) {
-    int32_t input_batch_offset = 0;
-    int32_t output_batch_offset = 0;
-
     int32_t input_image_size = input_size_y * input_size_x;
     int32_t output_image_size = output_size_y * output_size_x;
 
     scale_update = 0.0;
     for (int32_t batch_number = 0; batch_number < batch_size; batch_number++) {
-        for (int32_t out_y = 0; out_y < y_pools.size(); out_y++) {
-            for (int32_t in_x = 0; in_x < input_size_x; in_x++) {
-                int32_t in_y = y_pool_offset[out_y];
-                int32_t out_x = x_pool_offset[in_x];
-
-                // cout << "getting max value for pool starting at " << in_y  << " x " << in_x << " from:" << endl;
-                float output_error = 0.0;
-                for (int32_t pool_x = 0; pool_x < x_pools[in_x]; pool_x++) {
-                    output_error += output_errors[output_batch_offset + (out_y * output_size_x) + out_x + pool_x];
-                }
-
-                for (int32_t pool_y = 0; pool_y < y_pools[out_y]; pool_y++) {
-                    int position = input_batch_offset + ((in_y + pool_y) * input_size_x) + in_x;
-                    float delta = output_error * pool_gradients[position];
-                    input_errors[position] += delta;
-                    scale_update += inputs[position] * delta;
-                }
-            }
+        float* input_error_image = input_errors + (batch_number * input_image_size);
+        const float* input_image = inputs + (batch_number * input_image_size);
+        const float* output_error_image = output_errors + (batch_number * output_image_size);
+        const int32_t* argmax_image = pool_argmax + (batch_number * output_image_size);
+
+        for (int32_t current = 0; current < output_image_size; current++) {
+            int32_t position = argmax_image[current];
+            float delta = output_error_image[current] * scale;
+            input_error_image[position] += delta;
+            scale_update += input_image[position] * delta;
         }
-        input_batch_offset += input_image_size;
-        output_batch_offset += output_image_size;
-    }
-    scale_update /= batch_size;
-}
-
-// pool backward when the y dimension of the output is greater than the y dimension of the input and
-// the x dimension of the output is greater than the the x dimension of the input
-void pool_backward_ry_rx(
-    float* input_errors, float& scale_update, const float* inputs, const float* pool_gradients,
-    const float* output_errors, int32_t batch_size, int32_t input_size_y, int32_t input_size_x, int32_t output_size_y,
-    int32_t output_size_x, vector<int>& y_pools, vector<int>& x_pools, vector<int>& y_pool_offset,
-    vector<int>& x_pool_offset
-) {
-    int32_t input_batch_offset = 0;
-    int32_t output_batch_offset = 0;
-
-    int32_t input_image_size = input_size_y * input_size_x;
-    int32_t output_image_size = output_size_y * output_size_x;
-
-    scale_update = 0.0;
-    for (int32_t batch_number = 0; batch_number < batch_size; batch_number++) {
-        for (int32_t in_y = 0; in_y < input_size_y; in_y++) {
-            for (int32_t in_x = 0; in_x < input_size_x; in_x++) {
-                int32_t out_y = y_pool_offset[in_y];
-                int32_t out_x = x_pool_offset[in_x];
-
-                // cout << "getting max value for pool starting at " << in_y  << " x " << in_x << " from:" << endl;
-                float output_error = 0.0;
-                for (int32_t pool_x = 0; pool_x < x_pools[in_x]; pool_x++) {
-                    for (int32_t pool_y = 0; pool_y < y_pools[in_y]; pool_y++) {
-                        output_error +=
-                            output_errors[output_batch_offset + ((out_y + pool_y) * output_size_x) + out_x + pool_x];
-                    }
-                }
-
-                // cout << "setting input error[" << in_y << "][" << in_x << "] to: " << output_error << endl;
-
-                int position = input_batch_offset + (in_y * input_size_x) + in_x;
-                float delta = output_error * pool_gradients[position];
-                input_errors[position] += delta;
-                scale_update += inputs[position] * delta;
-            }
-        }
-        input_batch_offset += input_image_size;
-        output_batch_offset += output_image_size;
     }
     scale_update /= batch_size;
 }
@@ -628,23 +359,22 @@ void test_pooling(
 ) {
     float* input = new float[batch_size * input_size_y * input_size_x];
     float* input_errors = new float[batch_size * input_size_y * input_size_x];
-    float* pool_gradients = new float[batch_size * input_size_y * input_size_x];
     for (int32_t i = 0; i < batch_size * input_size_y * input_size_x; i++) {
         input[i] = ceil(100 * drand48());
         input_errors[i] = 0;
-        pool_gradients[i] = 0;
     }
 
     float* output = new float[batch_size * output_size_y * output_size_x];
     float* output_errors = new float[batch_size * output_size_y * output_size_x];
+    int32_t* pool_argmax = new int32_t[batch_size * output_size_y * output_size_x];
     for (int32_t i = 0; i < batch_size * output_size_y * output_size_x; i++) {
         output[i] = 0.0;
         output_errors[i] = ceil(100 * drand48());
+        pool_argmax[i] = 0;
     }
 
     print_array("input", input, batch_size, input_size_y, input_size_x);
     print_array("output", output, batch_size, output_size_y, output_size_x);
-    print_array("pool_gradients", pool_gradients, batch_size, input_size_y, input_size_x);
     print_array("input_errors", input_errors, batch_size, input_size_y, input_size_x);
     print_array("output_errors", output_errors, batch_size, output_size_y, output_size_x);
 
@@ -673,60 +403,38 @@ void test_pooling(
     print_vector("y_pool_offset (after shuffle)", y_pool_offset);
     print_vector("x_pool_offset (after shuffle)", x_pool_offset);
 
-    float scale = (10.0 * drand48()) - 5.0;
-    float scale_update;
+    bool reverse_filter_y = input_size_y < output_size_y;
+    bool reverse_filter_x = input_size_x < output_size_x;
 
-    if (input_size_y >= output_size_y && input_size_x >= output_size_x) {
-        pool_forward(
-            input, scale, pool_gradients, output, batch_size, input_size_y, input_size_x, output_size_y, output_size_x,
-            y_pools, x_pools, y_pool_offset, x_pool_offset, generator, training, false
-        );
-        pool_backward(
-            input_errors, scale_update, input, pool_gradients, output_errors, batch_size, input_size_y, input_size_x,
-            output_size_y, output_size_x, y_pools, x_pools, y_pool_offset, x_pool_offset
-        );
+    vector<int32_t> pool_map;
+    build_pool_map(
+        pool_map, reverse_filter_y, reverse_filter_x, input_size_x, output_size_y, output_size_x, y_pools, x_pools,
+        y_pool_offset, x_pool_offset
+    );
 
-    } else if (input_size_x >= output_size_x) {
-        pool_forward_ry(
-            input, scale, pool_gradients, output, batch_size, input_size_y, input_size_x, output_size_y, output_size_x,
-            y_pools, x_pools, y_pool_offset, x_pool_offset, generator, training, false
-        );
-        pool_backward_ry(
-            input_errors, scale_update, input, pool_gradients, output_errors, batch_size, input_size_y, input_size_x,
-            output_size_y, output_size_x, y_pools, x_pools, y_pool_offset, x_pool_offset
-        );
-
-    } else if (input_size_y >= output_size_y) {
-        pool_forward_rx(
-            input, scale, pool_gradients, output, batch_size, input_size_y, input_size_x, output_size_y, output_size_x,
-            y_pools, x_pools, y_pool_offset, x_pool_offset, generator, training, false
-        );
-        pool_backward_rx(
-            input_errors, scale_update, input, pool_gradients, output_errors, batch_size, input_size_y, input_size_x,
-            output_size_y, output_size_x, y_pools, x_pools, y_pool_offset, x_pool_offset
-        );
+    float scale = (10.0 * drand48()) - 5.0;
+    float scale_update;
 
-    } else {
-        pool_forward_ry_rx(
-            input, scale, pool_gradients, output, batch_size, input_size_y, input_size_x, output_size_y, output_size_x,
-            y_pools, x_pools, y_pool_offset, x_pool_offset, generator, training, false
-        );
-        pool_backward_ry_rx(
-            input_errors, scale_update, input, pool_gradients, output_errors, batch_size, input_size_y, input_size_x,
-            output_size_y, output_size_x, y_pools, x_pools, y_pool_offset, x_pool_offset
-        );
-    }
+    pool_forward(
+        input, scale, pool_map, pool_argmax, output, batch_size, input_size_y, input_size_x, output_size_y,
+        output_size_x, reverse_filter_y, reverse_filter_x, y_pools, x_pools, y_pool_offset, x_pool_offset, generator,
+        training, false
+    );
+    pool_backward(
+        input_errors, scale_update, input, pool_argmax, output_errors, scale, batch_size, input_size_y, input_size_x,
+        output_size_y, output_size_x
+    );
     cout << "scale_update: " << scale_update << endl;
 
     print_array("output", output, batch_size, output_size_y, output_size_x);
 
-    print_array("pool_gradients", pool_gradients, batch_size, input_size_y, input_size_x);
+    print_array("pool_argmax", pool_argmax, batch_size, output_size_y, output_size_x);
     print_array("input_errors", input_errors, batch_size, input_size_y, input_size_x);
     print_array("output_errors", output_errors, batch_size, output_size_y, output_size_x);
 
     delete[] input;
     delete[] output;
-    delete[] pool_gradients;
+    delete[] pool_argmax;
     delete[] input_errors;
     delete[] output_errors;
 }
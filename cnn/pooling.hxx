@@ -1,62 +1,47 @@
 #ifndef EXACT_POOLING_HXX
 #define EXACT_POOLING_HXX
 
+#include <random>
+using std::minstd_rand0;
+
 #include <vector>
 using std::vector;
 
+// each output pixel's window in a pool map is its first input pixel, its height and its width
+#define POOL_MAP_STRIDE 3
+
 void update_offset(vector<int>& pools, vector<int>& offset);
 void initialize_pools(vector<int>& pools, vector<int>& offset, int input_size, int output_size);
 
-void pool_forward(
-    const float* input, float scale, float* pool_gradients, float* output, int32_t batch_size, int32_t input_size_y,
-    int32_t input_size_x, int32_t output_size_y, int32_t output_size_x, vector<int>& y_pools, vector<int>& x_pools,
-    vector<int>& y_pool_offset, vector<int>& x_pool_offset, minstd_rand0& generator, bool training, bool max_pooling
+void build_pool_map(
+    vector<int32_t>& pool_map, bool reverse_filter_y, bool reverse_filter_x, int32_t input_size_x,
+    int32_t output_size_y, int32_t output_size_x, const vector<int>& y_pools, const vector<int>& x_pools,
+    const vector<int>& y_pool_offset, const vector<int>& x_pool_offset
 );
 
-void pool_forward_ry(
-    const float* input, float scale, float* pool_gradients, float* output, int32_t batch_size, int32_t input_size_y,
-    int32_t input_size_x, int32_t output_size_y, int32_t output_size_x, vector<int>& y_pools, vector<int>& x_pools,
-    vector<int>& y_pool_offset, vector<int>& x_pool_offset, minstd_rand0& generator, bool training, bool max_pooling
+int32_t get_uniform_pool_size(const vector<int>& pools, bool reverse_filter);
+
+void pool_forward(
+    const float* input, float scale, const vector<int32_t>& pool_map, int32_t* pool_argmax, float* output,
+    int32_t batch_size, int32_t input_size_y, int32_t input_size_x, int32_t output_size_y, int32_t output_size_x
 );
 
-void pool_forward_rx(
-    const float* input, float scale, float* pool_gradients, float* output, int32_t batch_size, int32_t input_size_y,
-    int32_t input_size_x, int32_t output_size_y, int32_t output_size_x, vector<int>& y_pools, vector<int>& x_pools,
-    vector<int>& y_pool_offset, vector<int>& x_pool_offset, minstd_rand0& generator, bool training, bool max_pooling
+void pool_forward_uniform(
+    const float* input, float scale, int32_t* pool_argmax, float* output, int32_t batch_size, int32_t input_size_y,
+    int32_t input_size_x, int32_t output_size_y, int32_t output_size_x, int32_t pool_size_y, int32_t pool_size_x
 );
 
-void pool_forward_ry_rx(
-    const float* input, float scale, float* pool_gradients, float* output, int32_t batch_size, int32_t input_size_y,
-    int32_t input_size_x, int32_t output_size_y, int32_t output_size_x, vector<int>& y_pools, vector<int>& x_pools,
+void pool_forward(
+    const float* input, float scale, vector<int32_t>& pool_map, int32_t* pool_argmax, float* output,
+    int32_t batch_size, int32_t input_size_y, int32_t input_size_x, int32_t output_size_y, int32_t output_size_x,
+    bool reverse_filter_y, bool reverse_filter_x, vector<int>& y_pools, vector<int>& x_pools,
     vector<int>& y_pool_offset, vector<int>& x_pool_offset, minstd_rand0& generator, bool training, bool max_pooling
 );
 
 void pool_backward(
-    float* input_errors, float& scale_update, const float* inputs, const float* pool_gradients,
-    const float* output_errors, int32_t batch_size, int32_t input_size_y, int32_t input_size_x, int32_t output_size_y,
-    int32_t output_size_x, vector<int>& y_pools, vector<int>& x_pools, vector<int>& y_pool_offset,
-    vector<int>& x_pool_offset
-);
-
-void pool_backward_ry(
-    float* input_errors, float& scale_update, const float* inputs, const float* pool_gradients,
-    const float* output_errors, int32_t batch_size, int32_t input_size_y, int32_t input_size_x, int32_t output_size_y,
-    int32_t output_size_x, vector<int>& y_pools, vector<int>& x_pools, vector<int>& y_pool_offset,
-    vector<int>& x_pool_offset
-);
-
-void pool_backward_rx(
-    float* input_errors, float& scale_update, const float* inputs, const float* pool_gradients,
-    const float* output_errors, int32_t batch_size, int32_t input_size_y, int32_t input_size_x, int32_t output_size_y,
-    int32_t output_size_x, vector<int>& y_pools, vector<int>& x_pools, vector<int>& y_pool_offset,
-    vector<int>& x_pool_offset
-);
-
-void pool_backward_ry_rx(
-    float* input_errors, float& scale_update, const float* inputs, const float* pool_gradients,
-    const float* output_errors, int32_t batch_size, int32_t input_size_y, int32_t input_size_x, int32_t output_size_y,
-    int32_t output_size_x, vector<int>& y_pools, vector<int>& x_pools, vector<int>& y_pool_offset,
-    vector<int>& x_pool_offset
+    float* input_errors, float& scale_update, const float* inputs, const int32_t* pool_argmax,
+    const float* output_errors, float scale, int32_t batch_size, int32_t input_size_y, int32_t input_size_x,
+    int32_t output_size_y, int32_t output_size_x
 );
 
 #endif
@@ -0,0 +1,302 @@
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdio>
+
+#include <charconv>
+using std::chars_format;
+using std::to_chars;
+
+#include <condition_variable>
+using std::condition_variable;
+
+#include <mutex>
+using std::lock_guard;
+using std::mutex;
+using std::unique_lock;
+
+#include <string>
+using std::string;
+
+#include <utility>
+using std::move;
+
+#include <vector>
+using std::vector;
+
+#include "common/arguments.hxx"
+#include "common/log.hxx"
+#include "async_writer.hxx"
+
+// appended streams are written in blocks of this many bytes instead of whenever a row is added
+#define ASYNC_WRITER_STREAM_BUFFER_SIZE (1 << 20)
+
+WriteBuffer& WriteBuffer::operator<<(double value) {
+    char number[32];
+    // the same as printf's %g, which is what an ostream uses by default
+    auto result = to_chars(number, number + sizeof(number), value, chars_format::general, 6);
+    text.append(number, result.ptr);
+    return *this;
+}
+
+WriteBuffer& WriteBuffer::operator<<(int32_t value) {
+    char number[16];
+    auto result = to_chars(number, number + sizeof(number), value);
+    text.append(number, result.ptr);
+    return *this;
+}
+
+WriteBuffer& WriteBuffer::operator<<(int64_t value) {
+    char number[24];
+    auto result = to_chars(number, number + sizeof(number), value);
+    text.append(number, result.ptr);
+    return *this;
+}
+
+WriteBuffer& WriteBuffer::operator<<(char value) {
+    text.push_back(value);
+    return *this;
+}
+
+WriteBuffer& WriteBuffer::operator<<(const char* value) {
+    text.append(value);
+    return *this;
+}
+
+WriteBuffer& WriteBuffer::operator<<(const string& value) {
+    text.append(value);
+    return *this;
+}
+
+const string& WriteBuffer::get_text() const {
+    return text;
+}
+
+void WriteBuffer::clear() {
+    text.clear();
+}
+
+int32_t AsyncWriter::max_queued_jobs = 64;
+
+deque<AsyncWriteJob> AsyncWriter::jobs;
+int32_t AsyncWriter::jobs_in_progress = 0;
+bool AsyncWriter::running = false;
+thread* AsyncWriter::writer_thread = NULL;
+
+mutex AsyncWriter::jobs_mutex;
+condition_variable AsyncWriter::jobs_available;
+condition_variable AsyncWriter::jobs_finished;
+
+map<string, FILE*> AsyncWriter::streams;
+vector<string> AsyncWriter::unsynced_files;
+mutex AsyncWriter::streams_mutex;
+
+void AsyncWriter::initialize(const vector<string>& arguments) {
+    get_argument(arguments, "--io_queue_size", false, max_queued_jobs);
+    if (max_queued_jobs < 1) {
+        Log::fatal("ERROR: --io_queue_size must be at least 1, it was %d\n", max_queued_jobs);
+        exit(1);
+    }
+
+    lock_guard<mutex> lock(jobs_mutex);
+    if (!running) {
+        running = true;
+        writer_thread = new thread(run);
+    }
+}
+
+void AsyncWriter::shutdown() {
+    {
+        lock_guard<mutex> lock(jobs_mutex);
+        running = false;
+    }
+    jobs_available.notify_all();
+
+    if (writer_thread != NULL) {
+        writer_thread->join();
+        delete writer_thread;
+        writer_thread = NULL;
+    }
+
+    lock_guard<mutex> lock(streams_mutex);
+    for (auto stream = streams.begin(); stream != streams.end(); stream++) {
+        fclose(stream->second);
+    }
+    streams.clear();
+}
+
+void AsyncWriter::write_job(const AsyncWriteJob& job, WriteBuffer& buffer) {
+    buffer.clear();
+    job.format(buffer);
+    const string& text = buffer.get_text();
+
+    if (job.whole_file && job.durable) {
+        write_durable_file(job.filename, text);
+    } else if (job.whole_file) {
+        FILE* file = fopen(job.filename.c_str(), "w");
+        if (file == NULL) {
+            Log::error("could not open '%s' for writing\n", job.filename.c_str());
+            return;
+        }
+        fwrite(text.data(), 1, text.size(), file);
+        fclose(file);
+
+        lock_guard<mutex> lock(streams_mutex);
+        unsynced_files.push_back(job.filename);
+    } else {
+        lock_guard<mutex> lock(streams_mutex);
+        auto stream = streams.find(job.filename);
+        if (stream == streams.end()) {
+            Log::error("could not append to '%s', it was not opened with AsyncWriter::open_stream\n",
+                       job.filename.c_str());
+            return;
+        }
+        fwrite(text.data(), 1, text.size(), stream->second);
+    }
+}
+
+void AsyncWriter::write_durable_file(const string& filename, const string& text) {
+    {
+        lock_guard<mutex> lock(streams_mutex);
+        for (auto stream = streams.begin(); stream != streams.end(); stream++) {
+            fflush(stream->second);
+            fsync(fileno(stream->second));
+        }
+    }
+
+    string temporary_filename = filename + ".tmp";
+    FILE* file = fopen(temporary_filename.c_str(), "w");
+    if (file == NULL) {
+        Log::error("could not open '%s' for writing\n", temporary_filename.c_str());
+        return;
+    }
+    bool written = fwrite(text.data(), 1, text.size(), file) == text.size();
+    written = fflush(file) == 0 && written;
+    written = fsync(fileno(file)) == 0 && written;
+    fclose(file);
+
+    if (!written) {
+        Log::error("could not write '%s', leaving '%s' as it was\n", temporary_filename.c_str(), filename.c_str());
+        unlink(temporary_filename.c_str());
+        return;
+    }
+    if (rename(temporary_filename.c_str(), filename.c_str()) != 0) {
+        Log::error("could not rename '%s' to '%s'\n", temporary_filename.c_str(), filename.c_str());
+        return;
+    }
+
+    // the rename itself is only durable once the directory holding the file is synced
+    size_t slash = filename.find_last_of('/');
+    string directory = slash == string::npos ? "." : filename.substr(0, slash);
+    int directory_file = open(directory.c_str(), O_RDONLY);
+    if (directory_file >= 0) {
+        fsync(directory_file);
+        close(directory_file);
+    }
+}
+
+void AsyncWriter::run() {
+    Log::set_id("async_writer");
+
+    // the buffer is reused between jobs so formatting does not allocate once it has grown to the largest file
+    WriteBuffer buffer;
+
+    unique_lock<mutex> lock(jobs_mutex);
+    while (true) {
+        jobs_available.wait(lock, [] { return !jobs.empty() || !running; });
+        if (jobs.empty()) {
+            // shutting down and everything queued has been written
+            break;
+        }
+
+        AsyncWriteJob job = move(jobs.front());
+        jobs.pop_front();
+        jobs_in_progress++;
+        // there is room in the queue again
+        jobs_finished.notify_all();
+
+        lock.unlock();
+        write_job(job, buffer);
+        lock.lock();
+
+        jobs_in_progress--;
+        jobs_finished.notify_all();
+    }
+    lock.unlock();
+
+    Log::release_id("async_writer");
+}
+
+void AsyncWriter::enqueue(AsyncWriteJob job) {
+    unique_lock<mutex> lock(jobs_mutex);
+    if (!running) {
+        lock.unlock();
+        WriteBuffer buffer;
+        write_job(job, buffer);
+        return;
+    }
+
+    jobs_finished.wait(lock, [] { return (int32_t) jobs.size() < max_queued_jobs; });
+    jobs.push_back(move(job));
+    lock.unlock();
+    jobs_available.notify_one();
+}
+
+bool AsyncWriter::open_stream(string filename, bool append_to_file) {
+    // anything still queued for a previous stream with this name is written first
+    sync(false);
+
+    lock_guard<mutex> lock(streams_mutex);
+    auto stream = streams.find(filename);
+    if (stream != streams.end()) {
+        fclose(stream->second);
+        streams.erase(stream);
+    }
+
+    FILE* file = fopen(filename.c_str(), append_to_file ? "a" : "w");
+    if (file == NULL) {
+        return false;
+    }
+    setvbuf(file, NULL, _IOFBF, ASYNC_WRITER_STREAM_BUFFER_SIZE);
+    streams[filename] = file;
+    return true;
+}
+
+bool AsyncWriter::is_stream_open(string filename) {
+    lock_guard<mutex> lock(streams_mutex);
+    return streams.count(filename) > 0;
+}
+
+void AsyncWriter::write_file(string filename, function<void(WriteBuffer&)> format, bool durable) {
+    enqueue({filename, true, durable, format});
+}
+
+void AsyncWriter::append(string filename, function<void(WriteBuffer&)> format) {
+    enqueue({filename, false, false, format});
+}
+
+void AsyncWriter::sync(bool do_fsync) {
+    {
+        unique_lock<mutex> lock(jobs_mutex);
+        jobs_finished.wait(lock, [] { return jobs.empty() && jobs_in_progress == 0; });
+    }
+
+    lock_guard<mutex> lock(streams_mutex);
+    for (auto stream = streams.begin(); stream != streams.end(); stream++) {
+        fflush(stream->second);
+        if (do_fsync) {
+            fsync(fileno(stream->second));
+        }
+    }
+
+    if (do_fsync) {
+        for (int32_t i = 0; i < (int32_t) unsynced_files.size(); i++) {
+            int file = open(unsynced_files[i].c_str(), O_RDONLY);
+            if (file >= 0) {
+                fsync(file);
+                close(file);
+            }
+        }
+        unsynced_files.clear();
+    }
+}
@@ -0,0 +1,121 @@
+#ifndef EXAMM_ASYNC_WRITER_HXX
+#define EXAMM_ASYNC_WRITER_HXX
+
+#include <condition_variable>
+using std::condition_variable;
+
+#include <cstdio>
+
+#include <deque>
+using std::deque;
+
+#include <functional>
+using std::function;
+
+#include <map>
+using std::map;
+
+#include <mutex>
+using std::mutex;
+
+#include <string>
+using std::string;
+
+#include <thread>
+using std::thread;
+
+#include <vector>
+using std::vector;
+
+/**
+ *  Text being formatted for an AsyncWriter job. Numbers are formatted with to_chars, doubles the same as an ostream
+ *  with the default precision (6 significant digits, %g) so the files are unchanged from writing them with <<.
+ */
+class WriteBuffer {
+   private:
+    string text;
+
+   public:
+    WriteBuffer& operator<<(double value);
+    WriteBuffer& operator<<(int32_t value);
+    WriteBuffer& operator<<(int64_t value);
+    WriteBuffer& operator<<(char value);
+    WriteBuffer& operator<<(const char* value);
+    WriteBuffer& operator<<(const string& value);
+
+    const string& get_text() const;
+    void clear();
+};
+
+struct AsyncWriteJob {
+    string filename;
+    // whole files are written and closed, otherwise the text is appended to a stream opened with open_stream
+    bool whole_file;
+    // whole files only: written to filename.tmp, fsynced and renamed over filename, after fsyncing the streams
+    bool durable;
+    function<void(WriteBuffer&)> format;
+};
+
+/**
+ *  Moves writing output files off the calling thread: jobs hold the data to write and a function formatting it, and a
+ *  single writer thread formats and writes them in order. The queue is bounded by --io_queue_size jobs, past that
+ *  queueing blocks until the writer catches up. Appended streams are buffered and only flushed and fsynced by
+ *  sync(), which is meant for the end of a run, and by durable whole files, which are meant for checkpoints.
+ *
+ *  If initialize has not been called (or after shutdown) jobs are formatted and written by the caller, so code
+ *  writing through this works the same in programs which do not start the writer thread.
+ */
+class AsyncWriter {
+   private:
+    static int32_t max_queued_jobs;
+
+    static deque<AsyncWriteJob> jobs;
+    static int32_t jobs_in_progress;
+    static bool running;
+    static thread* writer_thread;
+
+    static mutex jobs_mutex;
+    static condition_variable jobs_available;
+    static condition_variable jobs_finished;
+
+    // the appended streams, and the whole files written since the last sync(true) so they can be fsynced then
+    static map<string, FILE*> streams;
+    static vector<string> unsynced_files;
+    static mutex streams_mutex;
+
+    static void write_job(const AsyncWriteJob& job, WriteBuffer& buffer);
+    static void write_durable_file(const string& filename, const string& text);
+    static void run();
+    static void enqueue(AsyncWriteJob job);
+
+   public:
+    static void initialize(const vector<string>& arguments);
+
+    /**
+     *  Writes all queued jobs, stops the writer thread and closes the streams.
+     */
+    static void shutdown();
+
+    /**
+     *  Creates (truncating) filename to append to, or opens it to add to the end of it if append_to_file is true.
+     *  Returns false if it could not be opened.
+     */
+    static bool open_stream(string filename, bool append_to_file = false);
+    static bool is_stream_open(string filename);
+
+    /**
+     *  Writes a whole file. If durable is true (for checkpoints) the appended streams are flushed and fsynced first,
+     *  then the file is written to filename.tmp, fsynced and renamed to filename, so a crash leaves either the previous
+     *  file or the complete new one under filename, and the streams on disk are at least as far along as it.
+     */
+    static void write_file(string filename, function<void(WriteBuffer&)> format, bool durable = false);
+    static void append(string filename, function<void(WriteBuffer&)> format);
+
+    /**
+     *  Waits until every job queued so far has been written, then flushes the streams, and fsyncs them if do_fsync is
+     *  true.
+     */
+    static void sync(bool do_fsync);
+};
+
+#endif
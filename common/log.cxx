@@ -111,6 +111,10 @@ void Log::set_rank(int32_t _process_rank) {
     process_rank = _process_rank;
 }
 
+int32_t Log::get_rank() {
+    return process_rank;
+}
+
 void Log::restrict_to_rank(int32_t _restricted_rank) {
     restricted_rank = _restricted_rank;
 }
@@ -161,6 +161,11 @@ class Log {
      */
     static void set_rank(int32_t _process_rank);
 
+    /**
+     * \return the MPI process rank set with set_rank, or -1 if it was not set
+     */
+    static int32_t get_rank();
+
     /**
      * Specifies which MPI process to allow messages from. A value < 0 will allow messages from any rank.
      *\param _restricted_rank is the MPI rank to only print messages from
@@ -98,9 +98,12 @@ ONENAS* generate_onenas_from_arguments(
 
     SpeciationStrategy* speciation_strategy = generate_speciation_strategy_from_arguments(arguments, seed_genome);
 
+    // a search resumed from a checkpoint keeps adding to the fitness log of the run it continues
+    bool resuming = argument_exists(arguments, "--resume_from");
+
     ONENAS* onenas = new ONENAS(
         number_islands, speciation_strategy, weight_rules, genome_property, output_directory,
-        save_genome_option
+        save_genome_option, resuming
     );
     if (possible_node_types.size() > 0) {
         onenas->set_possible_node_types(possible_node_types);
@@ -183,6 +186,28 @@ OneNasIslandSpeciationStrategy* generate_onenas_island_speciation_strategy_from_
         control_size_method, compare_with_naive
     );
 
+    // scales the genomes generated per generation with drift in the stream instead of a fixed budget
+    if (argument_exists(arguments, "--adaptive_generation_budget")) {
+        int32_t min_generated_population_size = generated_population_size / 4;
+        if (min_generated_population_size < 1) {
+            min_generated_population_size = 1;
+        }
+        get_argument(arguments, "--min_generated_population_size", false, min_generated_population_size);
+        int32_t max_generated_population_size = generated_population_size * 2;
+        get_argument(arguments, "--max_generated_population_size", false, max_generated_population_size);
+        int32_t drift_stable_generations = 5;
+        get_argument(arguments, "--drift_stable_generations", false, drift_stable_generations);
+        double drift_delta = 0.05;
+        get_argument(arguments, "--drift_delta", false, drift_delta);
+        double drift_threshold = 1.0;
+        get_argument(arguments, "--drift_threshold", false, drift_threshold);
+
+        island_strategy->set_adaptive_generation_budget(
+            min_generated_population_size, max_generated_population_size, drift_stable_generations, drift_delta,
+            drift_threshold
+        );
+    }
+
     return island_strategy;
 }
 
@@ -286,23 +311,24 @@ void write_time_series_to_file(const vector<string>& arguments, TimeSeriesSets*
     }
 }
 
-void slice_online_time_series(
-    const vector<string>& arguments, TimeSeriesSets* time_series_sets, vector<vector<vector<double> > >& inputs,
-    vector<vector<vector<double> > >& outputs
-) {
+TimeSeriesWindows* slice_online_time_series(const vector<string>& arguments, TimeSeriesSets* time_series_sets) {
     int32_t time_offset = 1;
     get_argument(arguments, "--time_offset", true, time_offset);
 
-    time_series_sets->export_training_series(time_offset, inputs, outputs);
-    // time_series_sets->export_test_series(time_offset, validation_inputs, validation_outputs);
-
     int32_t sequence_length = 0;
-    if (get_argument(arguments, "--time_series_length", true, sequence_length)) {
-        Log::info("Slicing input training data with time sequence length: %d\n", sequence_length);
-        slice_input_data(inputs, outputs, sequence_length);
-    }
+    get_argument(arguments, "--time_series_length", true, sequence_length);
+
+    // windows overlap if the stride is less than the length
+    int32_t stride = sequence_length;
+    get_argument(arguments, "--time_series_stride", false, stride);
+
+    Log::info("Slicing input training data with time sequence length: %d and stride: %d\n", sequence_length, stride);
+    TimeSeriesWindows* windows =
+        new TimeSeriesWindows(time_series_sets, time_series_sets->get_training_indexes(), time_offset);
+    windows->generate(sequence_length, stride);
 
     Log::info("Generating time series data finished! \n");
+    return windows;
 }
 
 void get_train_validation_data(
@@ -313,71 +339,52 @@ void get_train_validation_data(
     int32_t time_offset = 1;
     get_argument(arguments, "--time_offset", true, time_offset);
 
-    time_series_sets->export_training_series(time_offset, train_inputs, train_outputs);
-    time_series_sets->export_test_series(time_offset, validation_inputs, validation_outputs);
-
     int32_t sequence_length = 0;
     if (get_argument(arguments, "--train_sequence_length", false, sequence_length)) {
         Log::info("Slicing input training data with time sequence length: %d\n", sequence_length);
-        slice_input_data(train_inputs, train_outputs, sequence_length);
+        slice_input_data(
+            time_series_sets, time_series_sets->get_training_indexes(), time_offset, sequence_length, train_inputs,
+            train_outputs
+        );
+    } else {
+        time_series_sets->export_training_series(time_offset, train_inputs, train_outputs);
     }
 
     int32_t validation_sequence_length = 0;
     if (get_argument(arguments, "--validation_sequence_length", false, validation_sequence_length)) {
         Log::info("Slicing input validation data with time sequence length: %d\n", validation_sequence_length);
-        slice_input_data(validation_inputs, validation_outputs, validation_sequence_length);
+        slice_input_data(
+            time_series_sets, time_series_sets->get_test_indexes(), time_offset, validation_sequence_length,
+            validation_inputs, validation_outputs
+        );
+    } else {
+        time_series_sets->export_test_series(time_offset, validation_inputs, validation_outputs);
     }
 
     Log::info("Generating time series data finished! \n");
 }
 
 void slice_input_data(
-    vector<vector<vector<double> > >& inputs, vector<vector<vector<double> > >& outputs, int32_t sequence_length
+    TimeSeriesSets* time_series_sets, const vector<int>& series_indexes, int32_t time_offset, int32_t sequence_length,
+    vector<vector<vector<double> > >& inputs, vector<vector<vector<double> > >& outputs
 ) {
-    vector<vector<vector<double> > > sliced_inputs;
-    vector<vector<vector<double> > > sliced_outputs;
-    for (int32_t n = 0; n < (int32_t) inputs.size(); n++) {
-        int32_t num_row = (int32_t) inputs[n][0].size();
-        int32_t num_inputs = (int32_t) inputs[n].size();
-        int32_t num_outputs = (int32_t) outputs[n].size();
-        int32_t current_row = 0;
-        while (current_row + sequence_length <= num_row) {
-            vector<vector<double> > current_time_series_input;   // <each parameter <time series values>>
-            vector<vector<double> > current_time_series_output;  // <each parameter <time series values>>
-            current_time_series_input = slice_time_series(current_row, sequence_length, num_inputs, inputs[n]);
-            current_time_series_output = slice_time_series(current_row, sequence_length, num_outputs, outputs[n]);
-            sliced_inputs.push_back(current_time_series_input);
-            sliced_outputs.push_back(current_time_series_output);
-            current_row = current_row + sequence_length;
-        }
-        Log::info("Before slicing, original time series %d has %d parameters, and %d length\n", n, num_inputs, num_row);
+    // the slices are exported straight from the time series sets instead of exporting each whole series and then
+    // copying the slices out of it
+    TimeSeriesWindows windows(time_series_sets, series_indexes, time_offset);
+    windows.generate(sequence_length, sequence_length);
+    windows.export_windows(inputs, outputs);
+
+    if (inputs.size() == 0) {
+        Log::fatal("ERROR: no time series is long enough to slice with time sequence length %d\n", sequence_length);
+        exit(1);
     }
 
-    inputs.clear();
-    outputs.clear();
-
-    inputs.assign(sliced_inputs.begin(), sliced_inputs.end());
-    outputs.assign(sliced_outputs.begin(), sliced_outputs.end());
     Log::info(
-        "After slicing, sliced training input data has %d sets, and %d parameters and length %d \n", inputs.size(),
+        "After slicing, sliced input data has %d sets, and %d parameters and length %d \n", inputs.size(),
         inputs[0].size(), inputs[0][0].size()
     );
     Log::info(
-        "After slicing, sliced training output data has %d sets, and %d parameters and length %d \n", outputs.size(),
+        "After slicing, sliced output data has %d sets, and %d parameters and length %d \n", outputs.size(),
         outputs[0].size(), outputs[0][0].size()
     );
 }
-
-vector<vector<double> > slice_time_series(
-    int32_t start_index, int32_t sequence_length, int32_t num_parameter, const vector<vector<double> >& time_series
-) {
-    vector<vector<double> > current_time_series;
-    for (int32_t j = 0; j < num_parameter; j++) {
-        vector<double> current_parameter_slice;
-        current_parameter_slice.assign(
-            time_series[j].begin() + start_index, time_series[j].begin() + start_index + sequence_length
-        );
-        current_time_series.push_back(current_parameter_slice);
-    }
-    return current_time_series;
-}
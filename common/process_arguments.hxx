@@ -19,6 +19,7 @@ using std::vector;
 #include "onenas/neat_speciation_strategy.hxx"
 #include "rnn/rnn_genome.hxx"
 #include "time_series/time_series.hxx"
+#include "time_series/time_series_windows.hxx"
 
 EXAMM* generate_examm_from_arguments(
     const vector<string>& arguments, TimeSeriesSets* time_series_sets, WeightRules* weight_rules,
@@ -56,15 +57,9 @@ void get_train_validation_data(
     vector<vector<vector<double> > >& test_outputs
 );
 void slice_input_data(
-    vector<vector<vector<double> > >& traing_inputs, vector<vector<vector<double> > >& train_outputs,
-    int32_t sequence_length
-);
-vector<vector<double> > slice_time_series(
-    int32_t start_index, int32_t sequence_length, int32_t num_parameter, const vector<vector<double> >& time_series
-);
-void slice_online_time_series(
-    const vector<string>& arguments, TimeSeriesSets* time_series_sets, vector<vector<vector<double> > >& inputs,
-    vector<vector<vector<double> > >& outputs
+    TimeSeriesSets* time_series_sets, const vector<int>& series_indexes, int32_t time_offset, int32_t sequence_length,
+    vector<vector<vector<double> > >& inputs, vector<vector<vector<double> > >& outputs
 );
+TimeSeriesWindows* slice_online_time_series(const vector<string>& arguments, TimeSeriesSets* time_series_sets);
 
 #endif
\ No newline at end of file
@@ -18,6 +18,7 @@ using std::vector;
 
 #include "common/log.hxx"
 #include "common/process_arguments.hxx"
+#include "genome_dispatch.hxx"
 #include "onenas/examm.hxx"
 #include "mpi.h"
 #include "rnn/generate_nn.hxx"
@@ -39,6 +40,9 @@ WeightUpdate* weight_update_method;
 
 bool finished = false;
 
+// bounds how long a genome can hold up the search, on the master and the workers
+GenomeLimits genome_limits;
+
 vector<vector<vector<double> > > training_inputs;
 vector<vector<vector<double> > > training_outputs;
 vector<vector<vector<double> > > validation_inputs;
@@ -114,16 +118,68 @@ void receive_terminate_message(int32_t source) {
     MPI_Recv(terminate_message, 1, MPI_INT, source, TERMINATE_TAG, MPI_COMM_WORLD, &status);
 }
 
-void master(int32_t max_rank) {
+/**
+ * Hands out genomes until the search is done. Returns false if it stopped waiting on a worker which is hung.
+ */
+bool master(int32_t max_rank) {
     // the "main" id will have already been set by the main function so we do not need to re-set it here
     Log::debug("MAX int32_t: %d\n", numeric_limits<int32_t>::max());
 
-    int32_t terminates_sent = 0;
+    DispatchedGenomes dispatched(genome_limits);
+
+    // a worker only asks for work once it has sent back its genome, so each has at most one genome out
+    vector<bool> terminated(max_rank, false);
+    vector<int32_t> genomes_sent_to(max_rank, 0);
+    vector<int32_t> genomes_received_from(max_rank, 0);
+
+    // workers which asked for work once the search was done, while genomes were still out which may time out and
+    // need to be sent again. they are only terminated once nothing is out.
+    vector<int32_t> held_requests;
+
+    auto send_genome = [&](int32_t source, RNN_Genome* genome) {
+        send_genome_to(source, genome);
+        genomes_sent_to[source]++;
+    };
+
+    auto terminate = [&](int32_t source) {
+        Log::info("terminating worker: %d\n", source);
+        send_terminate_message(source);
+        terminated[source] = true;
+    };
+
+    // done once every worker has been terminated, or is hung on a genome which timed out
+    auto workers_done = [&]() {
+        for (int32_t rank = 1; rank < max_rank; rank++) {
+            int32_t genomes_out = genomes_sent_to[rank] - genomes_received_from[rank];
+            bool hung = genomes_out > 0 && genomes_out == dispatched.get_abandoned(rank);
+            if (!terminated[rank] && !hung) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    while (!workers_done()) {
+        if (!held_requests.empty() && (dispatched.has_resends() || dispatched.empty())) {
+            vector<int32_t> requests;
+            requests.swap(held_requests);
+            for (int32_t i = 0; i < (int32_t) requests.size(); i++) {
+                RNN_Genome* resent_genome = dispatched.next_resend(requests[i]);
+                if (resent_genome != NULL) {
+                    send_genome(requests[i], resent_genome);
+                } else if (dispatched.empty()) {
+                    terminate(requests[i]);
+                } else {
+                    held_requests.push_back(requests[i]);
+                }
+            }
+            continue;
+        }
 
-    while (true) {
-        // wait for a incoming message
         MPI_Status status;
-        MPI_Probe(MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &status);
+        if (!dispatched.probe(status)) {
+            continue;
+        }
 
         int32_t source = status.MPI_SOURCE;
         int32_t tag = status.MPI_TAG;
@@ -134,6 +190,13 @@ void master(int32_t max_rank) {
         if (tag == WORK_REQUEST_TAG) {
             receive_work_request(source);
 
+            // genomes which timed out go out again before any new ones
+            RNN_Genome* resent_genome = dispatched.next_resend(source);
+            if (resent_genome != NULL) {
+                send_genome(source, resent_genome);
+                continue;
+            }
+
             // if (transfer_learning_version.compare("v3") == 0 || transfer_learning_version.compare("v1+v3") == 0) {
             //     seed_stirs = 3;
             // }
@@ -142,14 +205,10 @@ void master(int32_t max_rank) {
             examm_mutex.unlock();
 
             if (genome == NULL) {  // search was completed if it returns NULL for an individual
-                // send terminate message
-                Log::info("terminating worker: %d\n", source);
-                send_terminate_message(source);
-                terminates_sent++;
-
-                Log::debug("sent: %d terminates of %d\n", terminates_sent, (max_rank - 1));
-                if (terminates_sent >= max_rank - 1) {
-                    return;
+                if (dispatched.empty()) {
+                    terminate(source);
+                } else {
+                    held_requests.push_back(source);
                 }
 
             } else {
@@ -158,14 +217,20 @@ void master(int32_t max_rank) {
 
                 // send genome
                 Log::debug("sending genome to: %d\n", source);
-                send_genome_to(source, genome);
-
-                // delete this genome as it will not be used again
-                delete genome;
+                send_genome(source, genome);
+                dispatched.sent(source, genome);
             }
         } else if (tag == GENOME_LENGTH_TAG) {
             Log::debug("received genome from: %d\n", source);
             RNN_Genome* genome = receive_genome_from(source);
+            genomes_received_from[source]++;
+
+            if (!dispatched.received(genome->get_generation_id(), source)) {
+                // it was dropped after timing out, or came back from another worker first
+                Log::info("discarding late genome %d from worker %d\n", genome->get_generation_id(), source);
+                delete genome;
+                continue;
+            }
 
             examm_mutex.lock();
             examm->insert_genome(genome);
@@ -179,6 +244,15 @@ void master(int32_t max_rank) {
             MPI_Abort(MPI_COMM_WORLD, 1);
         }
     }
+
+    bool all_terminated = true;
+    for (int32_t rank = 1; rank < max_rank; rank++) {
+        if (!terminated[rank]) {
+            Log::warning("worker %d is hung on a genome which timed out, no longer waiting for it\n", rank);
+            all_terminated = false;
+        }
+    }
+    return all_terminated;
 }
 
 void worker(int32_t rank) {
@@ -207,6 +281,7 @@ void worker(int32_t rank) {
             // have each worker write the backproagation to a separate log file
             string log_id = "genome_" + to_string(genome->get_generation_id()) + "_worker_" + to_string(rank);
             Log::set_id(log_id);
+            genome->set_training_limits(genome_limits.time_limit, genome_limits.memory_limit);
             genome->backpropagate_stochastic(
                 training_inputs, training_outputs, validation_inputs, validation_outputs, weight_update_method
             );
@@ -245,6 +320,10 @@ int main(int argc, char** argv) {
     Log::restrict_to_rank(0);
     std::cout << "initailized log!" << std::endl;
 
+    if (!get_genome_limits(arguments, genome_limits)) {
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
     TimeSeriesSets* time_series_sets = NULL;
     time_series_sets = TimeSeriesSets::generate_from_arguments(arguments);
     get_train_validation_data(
@@ -264,7 +343,11 @@ int main(int argc, char** argv) {
     if (rank == 0) {
         write_time_series_to_file(arguments, time_series_sets);
         examm = generate_examm_from_arguments(arguments, time_series_sets, weight_rules, seed_genome);
-        master(max_rank);
+        if (!master(max_rank)) {
+            // the search is done and written, but MPI_Finalize would wait on the hung workers
+            Log::warning("aborting the hung workers\n");
+            MPI_Abort(MPI_COMM_WORLD, 0);
+        }
     } else {
         worker(rank);
     }
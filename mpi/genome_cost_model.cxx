@@ -0,0 +1,86 @@
+#include <algorithm>
+using std::max;
+
+#include <vector>
+using std::vector;
+
+#include "genome_cost_model.hxx"
+#include "rnn/rnn_node_interface.hxx"
+
+// features are bias, time steps, time steps * weights, then time steps * enabled hidden nodes of each node type. time
+// steps are in thousands and weights in hundreds so the features are of similar magnitude
+#define FIXED_FEATURES      3
+#define TIME_STEP_SCALE     1000.0
+#define WEIGHT_SCALE        100.0
+#define RIDGE_PRIOR         100.0
+#define CALIBRATION_GENOMES 10
+
+GenomeCostModel::GenomeCostModel() : number_features(FIXED_FEATURES + NUMBER_NODE_TYPES), number_observations(0) {
+    coefficients.assign(number_features, 0.0);
+    inverse_covariance.assign(number_features, vector<double>(number_features, 0.0));
+    for (int32_t i = 0; i < number_features; i++) {
+        inverse_covariance[i][i] = RIDGE_PRIOR;
+    }
+}
+
+vector<double> GenomeCostModel::get_features(RNN_Genome* genome, int64_t time_steps) const {
+    double steps = time_steps / TIME_STEP_SCALE;
+
+    vector<double> features(number_features, 0.0);
+    features[0] = 1.0;
+    features[1] = steps;
+    features[2] = steps * genome->get_number_weights() / WEIGHT_SCALE;
+    for (int32_t node_type = 0; node_type < NUMBER_NODE_TYPES; node_type++) {
+        features[FIXED_FEATURES + node_type] = steps * genome->get_enabled_node_count(node_type);
+    }
+    return features;
+}
+
+double GenomeCostModel::predict(const vector<double>& features) const {
+    if (!is_calibrated()) {
+        return features[2];
+    }
+
+    double prediction = 0.0;
+    for (int32_t i = 0; i < number_features; i++) {
+        prediction += coefficients[i] * features[i];
+    }
+    return max(prediction, 0.0);
+}
+
+void GenomeCostModel::observe(const vector<double>& features, double milliseconds) {
+    // the standard recursive least squares update (without forgetting), which gives the same coefficients as a ridge
+    // regression over every genome observed so far without keeping them
+    vector<double> pf(number_features, 0.0);
+    for (int32_t i = 0; i < number_features; i++) {
+        for (int32_t j = 0; j < number_features; j++) {
+            pf[i] += inverse_covariance[i][j] * features[j];
+        }
+    }
+
+    double denominator = 1.0;
+    double error = milliseconds;
+    for (int32_t i = 0; i < number_features; i++) {
+        denominator += features[i] * pf[i];
+        error -= coefficients[i] * features[i];
+    }
+
+    for (int32_t i = 0; i < number_features; i++) {
+        coefficients[i] += pf[i] / denominator * error;
+    }
+    for (int32_t i = 0; i < number_features; i++) {
+        for (int32_t j = 0; j < number_features; j++) {
+            inverse_covariance[i][j] -= pf[i] * pf[j] / denominator;
+        }
+    }
+
+    number_observations++;
+}
+
+bool GenomeCostModel::is_calibrated() const {
+    return number_observations >= CALIBRATION_GENOMES;
+}
+
+int32_t GenomeCostModel::get_number_observations() const {
+    return number_observations;
+}
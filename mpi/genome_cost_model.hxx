@@ -0,0 +1,50 @@
+#ifndef EXAMM_GENOME_COST_MODEL_HXX
+#define EXAMM_GENOME_COST_MODEL_HXX
+
+#include <cstdint>
+
+#include <vector>
+using std::vector;
+
+#include "rnn/rnn_genome.hxx"
+
+/**
+ *  Predicts how many milliseconds a worker will take to train a genome, so the master can hand out the most expensive
+ *  genomes of a generation first and not have one left running alone at its end.
+ *
+ *  Training time is modeled as a fixed cost plus the number of time steps trained (over all epochs) times a per time
+ *  step cost, which is linear in the genome's weights and in its number of enabled hidden nodes of each node type (an
+ *  LSTM node costs far more than a simple one with the same weights). The coefficients are fit online by recursive
+ *  least squares on the training times the workers report, with a small ridge prior so the fit is stable from the
+ *  first observation on.
+ */
+class GenomeCostModel {
+   private:
+    int32_t number_features;
+    int32_t number_observations;
+
+    vector<double> coefficients;
+    // the inverse of the (regularized) covariance of the features observed so far
+    vector<vector<double> > inverse_covariance;
+
+   public:
+    GenomeCostModel();
+
+    /**
+     *  The features of a genome trained for time_steps time steps. The caller keeps them to observe the genome's
+     *  training time with later, as the genome itself may be gone by then.
+     */
+    vector<double> get_features(RNN_Genome* genome, int64_t time_steps) const;
+
+    /**
+     *  Returns the predicted training milliseconds, or until the model has been calibrated on enough genomes a cost
+     *  proportional to time steps times weights, which still orders genomes sensibly.
+     */
+    double predict(const vector<double>& features) const;
+    void observe(const vector<double>& features, double milliseconds);
+
+    bool is_calibrated() const;
+    int32_t get_number_observations() const;
+};
+
+#endif
@@ -0,0 +1,187 @@
+#include <chrono>
+#include <cstdint>
+
+#include <iterator>
+using std::distance;
+
+#include <string>
+using std::string;
+
+#include <thread>
+
+#include <vector>
+using std::vector;
+
+#include "common/arguments.hxx"
+#include "common/log.hxx"
+#include "genome_dispatch.hxx"
+
+bool get_genome_limits(const vector<string>& arguments, GenomeLimits& limits) {
+    // a worker which hangs on a genome (very deep recurrent connections, NaN loops) would otherwise stall the search
+    get_argument(arguments, "--genome_timeout", false, limits.timeout);
+    get_argument(arguments, "--genome_retries", false, limits.retries);
+    get_argument(arguments, "--genome_time_limit", false, limits.time_limit);
+    get_argument(arguments, "--genome_memory_limit", false, limits.memory_limit);
+
+    if (limits.timeout < 0 || limits.retries < 0 || limits.time_limit < 0 || limits.memory_limit < 0) {
+        Log::fatal(
+            "ERROR: --genome_timeout (%lf), --genome_retries (%d), --genome_time_limit (%lf) and --genome_memory_limit "
+            "(%d) must be at least 0\n",
+            limits.timeout, limits.retries, limits.time_limit, limits.memory_limit
+        );
+        return false;
+    }
+    return true;
+}
+
+DispatchedGenomes::DispatchedGenomes(const GenomeLimits& _limits)
+    : limits(_limits), timed_out_genomes(0), dropped_genomes(0) {
+}
+
+DispatchedGenomes::~DispatchedGenomes() {
+    for (auto it = dispatched.begin(); it != dispatched.end(); it++) {
+        delete it->second.genome;
+    }
+}
+
+void DispatchedGenomes::sent(int32_t rank, RNN_Genome* genome) {
+    // the genome is only kept if it may need to be sent again, otherwise it will not be used again
+    bool keep = limits.timeout > 0 && limits.retries > 0;
+    dispatched[genome->get_generation_id()] = {keep ? genome : NULL, rank, std::chrono::steady_clock::now(), 1, false};
+    if (!keep) {
+        delete genome;
+    }
+}
+
+bool DispatchedGenomes::received(int32_t generation_id, int32_t rank) {
+    abandoned.erase(pair<int32_t, int32_t>(rank, generation_id));
+
+    auto entry = dispatched.find(generation_id);
+    if (entry == dispatched.end()) {
+        return false;
+    }
+    delete entry->second.genome;
+    dispatched.erase(entry);
+    return true;
+}
+
+RNN_Genome* DispatchedGenomes::next_resend(int32_t rank) {
+    for (int32_t pass = 0; pass < 2; pass++) {
+        auto it = resend_queue.begin();
+        while (it != resend_queue.end()) {
+            auto entry = dispatched.find(*it);
+            if (entry == dispatched.end() || !entry->second.waiting) {
+                // it came back in the meantime
+                it = resend_queue.erase(it);
+                continue;
+            }
+            if (pass == 0 && entry->second.rank == rank) {
+                it++;
+                continue;
+            }
+            resend_queue.erase(it);
+
+            DispatchedGenome& dispatched_genome = entry->second;
+            Log::warning(
+                "resending genome %d (attempt %d), which timed out on worker %d, to worker %d\n", entry->first,
+                dispatched_genome.attempts + 1, dispatched_genome.rank, rank
+            );
+            dispatched_genome.rank = rank;
+            dispatched_genome.sent = std::chrono::steady_clock::now();
+            dispatched_genome.attempts++;
+            dispatched_genome.waiting = false;
+            return dispatched_genome.genome;
+        }
+    }
+    return NULL;
+}
+
+void DispatchedGenomes::check_deadlines() {
+    if (limits.timeout <= 0) {
+        return;
+    }
+    std::chrono::time_point<std::chrono::steady_clock> now = std::chrono::steady_clock::now();
+
+    for (auto it = dispatched.begin(); it != dispatched.end();) {
+        DispatchedGenome& entry = it->second;
+        double seconds = std::chrono::duration<double>(now - entry.sent).count();
+        if (seconds <= limits.timeout) {
+            it++;
+            continue;
+        }
+
+        if (entry.waiting) {
+            // every worker still in the generation is busy or hung
+            Log::warning(
+                "genome %d waited %.2lf seconds for a worker to send it to, dropping it\n", it->first, seconds
+            );
+            delete entry.genome;
+            it = dispatched.erase(it);
+            dropped_genomes++;
+            continue;
+        }
+
+        timed_out_genomes++;
+        abandoned.insert(pair<int32_t, int32_t>(entry.rank, it->first));
+        if (entry.genome != NULL && entry.attempts <= limits.retries) {
+            Log::warning(
+                "genome %d timed out on worker %d after %.2lf seconds, it will be sent again\n", it->first, entry.rank,
+                seconds
+            );
+            entry.waiting = true;
+            // from now on how long it has waited for a worker
+            entry.sent = now;
+            resend_queue.push_back(it->first);
+            it++;
+
+        } else {
+            Log::warning(
+                "genome %d timed out on worker %d after %.2lf seconds, dropping it\n", it->first, entry.rank, seconds
+            );
+            delete entry.genome;
+            it = dispatched.erase(it);
+            dropped_genomes++;
+        }
+    }
+}
+
+bool DispatchedGenomes::probe(MPI_Status& status) {
+    if (limits.timeout <= 0) {
+        // wait for a incoming message
+        MPI_Probe(MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &status);
+        return true;
+    }
+
+    // checked on every call, as a steady stream of messages would otherwise keep timed out genomes from being noticed
+    check_deadlines();
+
+    int32_t message_waiting = 0;
+    MPI_Iprobe(MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &message_waiting, &status);
+    if (!message_waiting) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        return false;
+    }
+    return true;
+}
+
+bool DispatchedGenomes::empty() const {
+    return dispatched.empty();
+}
+
+bool DispatchedGenomes::has_resends() const {
+    return !resend_queue.empty();
+}
+
+int32_t DispatchedGenomes::get_abandoned(int32_t rank) const {
+    auto first = abandoned.lower_bound(pair<int32_t, int32_t>(rank, INT32_MIN));
+    auto last = abandoned.lower_bound(pair<int32_t, int32_t>(rank + 1, INT32_MIN));
+    return (int32_t) distance(first, last);
+}
+
+int32_t DispatchedGenomes::get_timed_out_genomes() const {
+    return timed_out_genomes;
+}
+
+int32_t DispatchedGenomes::get_dropped_genomes() const {
+    return dropped_genomes;
+}
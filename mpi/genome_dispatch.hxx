@@ -0,0 +1,131 @@
+#ifndef EXAMM_GENOME_DISPATCH_HXX
+#define EXAMM_GENOME_DISPATCH_HXX
+
+#include <chrono>
+
+#include <deque>
+using std::deque;
+
+#include <map>
+using std::map;
+
+#include <set>
+using std::set;
+
+#include <string>
+using std::string;
+
+#include <utility>
+using std::pair;
+
+#include <vector>
+using std::vector;
+
+#include "mpi.h"
+#include "rnn/rnn_genome.hxx"
+
+/**
+ *  How long a genome can hold up an MPI search. The master gives up waiting on a genome after timeout seconds (never
+ *  if 0), sending it to another worker up to retries times before dropping it. Workers give up training a genome after
+ *  time_limit seconds, or once their rank uses more than memory_limit MB (never if 0), and send it back with a NaN
+ *  fitness.
+ */
+struct GenomeLimits {
+    double timeout = 0.0;
+    int32_t retries = 1;
+    double time_limit = 0.0;
+    int32_t memory_limit = 0;
+};
+
+/**
+ *  Reads --genome_timeout, --genome_retries, --genome_time_limit and --genome_memory_limit, returning false (after
+ *  logging why) if any of them is negative.
+ */
+bool get_genome_limits(const vector<string>& arguments, GenomeLimits& limits);
+
+/**
+ *  A genome sent to a worker which has not come back yet.
+ */
+struct DispatchedGenome {
+    // kept to send again if the genome times out, NULL if it is not retried
+    RNN_Genome* genome;
+    int32_t rank;
+    std::chrono::time_point<std::chrono::steady_clock> sent;
+    int32_t attempts;
+    // timed out and waiting for a worker to ask for work
+    bool waiting;
+};
+
+/**
+ *  The master's record of the genomes out on workers, by generation id, which times them out and picks the ones to
+ *  send again. Without a timeout it only tracks which genomes are out, so genomes coming back twice or too late are
+ *  still recognized.
+ */
+class DispatchedGenomes {
+   private:
+    GenomeLimits limits;
+
+    map<int32_t, DispatchedGenome> dispatched;
+    // the ids of the genomes which timed out and wait for a worker to ask for work
+    deque<int32_t> resend_queue;
+    // (rank, generation id) of the genomes which timed out on a rank and have not come back from it, so the master
+    // can tell a worker which is hung from one which is still busy
+    set<pair<int32_t, int32_t> > abandoned;
+
+    int32_t timed_out_genomes;
+    int32_t dropped_genomes;
+
+   public:
+    explicit DispatchedGenomes(const GenomeLimits& limits);
+    ~DispatchedGenomes();
+
+    /**
+     *  Records a new genome as sent to rank. The genome is kept if it may need to be sent again, otherwise it is
+     *  deleted, so the caller must not use it after this.
+     */
+    void sent(int32_t rank, RNN_Genome* genome);
+
+    /**
+     *  Records the genome with this generation id as back from rank. Returns true if it was out and is now back, false
+     *  if it was dropped after timing out or already came back from another worker.
+     */
+    bool received(int32_t generation_id, int32_t rank);
+
+    /**
+     *  Returns a genome which timed out to send to rank (preferably one which did not time out on rank) and records it
+     *  as sent again, or NULL if none are waiting. The genome is still owned by this.
+     */
+    RNN_Genome* next_resend(int32_t rank);
+
+    /**
+     *  Queues the genomes which have been out longer than the timeout to be sent again, or drops them once they are
+     *  out of retries. Genomes which have waited another timeout without a worker asking for work are dropped as well,
+     *  so a generation ends even if every worker is hung. This is a scan of the genomes out, cheap enough to call on
+     *  every message.
+     */
+    void check_deadlines();
+
+    /**
+     *  Gets the next message sent to the master. With a timeout this polls instead of blocking, checking the deadlines
+     *  on every call, and returns false if no message is waiting yet so the caller can loop.
+     */
+    bool probe(MPI_Status& status);
+
+    bool empty() const;
+
+    /**
+     *  Returns true if genomes which timed out are waiting for a worker to ask for work.
+     */
+    bool has_resends() const;
+
+    /**
+     *  Returns how many genomes timed out on rank and have not come back from it. A worker with genomes out which all
+     *  timed out is treated as hung, and is no longer waited on.
+     */
+    int32_t get_abandoned(int32_t rank) const;
+
+    int32_t get_timed_out_genomes() const;
+    int32_t get_dropped_genomes() const;
+};
+
+#endif
@@ -0,0 +1,267 @@
+#include <algorithm>
+using std::stable_sort;
+
+#include <chrono>
+
+#include <mutex>
+using std::lock_guard;
+using std::mutex;
+
+#include <string>
+using std::string;
+using std::to_string;
+
+#include <vector>
+using std::vector;
+
+#include "common/arguments.hxx"
+#include "common/async_writer.hxx"
+#include "common/files.hxx"
+#include "common/log.hxx"
+#include "kfold_sweep.hxx"
+#include "rnn/generate_nn.hxx"
+
+string result_to_string(ResultSet result) {
+    return "[result, job: " + to_string(result.job) + ", training mae: " + to_string(result.training_mae)
+           + ", training mse: " + to_string(result.training_mse) + ", test mae: " + to_string(result.test_mae)
+           + ", test mse: " + to_string(result.test_mse) + ", millis: " + to_string(result.milliseconds) + "]";
+}
+
+KFoldSweep::KFoldSweep(const vector<string>& arguments) {
+    get_argument(arguments, "--time_offset", true, time_offset);
+    get_argument(arguments, "--bp_iterations", true, bp_iterations);
+    get_argument(arguments, "--output_directory", true, output_directory);
+    get_argument(arguments, "--repeats", true, repeats);
+    get_argument(arguments, "--fold_size", true, fold_size);
+
+    weight_rules = new WeightRules();
+    weight_rules->initialize_from_args(arguments);
+
+    weight_update_method = new WeightUpdate();
+    weight_update_method->generate_from_arguments(arguments);
+
+    time_series_sets = TimeSeriesSets::generate_from_arguments(arguments);
+
+    if (fold_size < 1) {
+        Log::fatal("ERROR: --fold_size must be at least 1, it was %d\n", fold_size);
+        exit(1);
+    }
+
+    // series past the last full fold are never tested on, but are always trained on
+    number_folds = time_series_sets->get_number_series() / fold_size;
+    if (number_folds < 2) {
+        Log::fatal(
+            "ERROR: %d time series with --fold_size %d gives %d folds, there need to be at least 2\n",
+            time_series_sets->get_number_series(), fold_size, number_folds
+        );
+        exit(1);
+    }
+    folds.assign(number_folds, NULL);
+
+    rnn_types = {"one_layer_ff",    "two_layer_ff",    "jordan",          "elman",          "one_layer_mgu",
+                 "two_layer_mgu",   "one_layer_gru",   "two_layer_gru",   "one_layer_ugrnn", "two_layer_ugrnn",
+                 "one_layer_delta", "two_layer_delta", "one_layer_lstm",  "two_layer_lstm"};
+
+    for (int32_t i = 0; i < (int32_t) rnn_types.size(); i++) {
+        RNN_Genome* genome = create_genome(rnn_types[i]);
+        rnn_type_weights.push_back(genome->get_number_weights());
+        delete genome;
+    }
+
+    results_recorded.assign(rnn_types.size(), 0);
+    total_results_recorded = 0;
+}
+
+KFoldSweep::~KFoldSweep() {
+    for (int32_t i = 0; i < (int32_t) folds.size(); i++) {
+        delete folds[i];
+    }
+    delete time_series_sets;
+    delete weight_update_method;
+    delete weight_rules;
+}
+
+RNN_Genome* KFoldSweep::create_genome(string rnn_type) {
+    vector<string> input_parameter_names = time_series_sets->get_input_parameter_names();
+    vector<string> output_parameter_names = time_series_sets->get_output_parameter_names();
+    int32_t number_inputs = time_series_sets->get_number_inputs();
+
+    if (rnn_type == "one_layer_lstm") {
+        return create_lstm(input_parameter_names, 1, number_inputs, output_parameter_names, 1, weight_rules);
+    } else if (rnn_type == "two_layer_lstm") {
+        return create_lstm(input_parameter_names, 2, number_inputs, output_parameter_names, 1, weight_rules);
+    } else if (rnn_type == "one_layer_delta") {
+        return create_delta(input_parameter_names, 1, number_inputs, output_parameter_names, 1, weight_rules);
+    } else if (rnn_type == "two_layer_delta") {
+        return create_delta(input_parameter_names, 2, number_inputs, output_parameter_names, 1, weight_rules);
+    } else if (rnn_type == "one_layer_gru") {
+        return create_gru(input_parameter_names, 1, number_inputs, output_parameter_names, 1, weight_rules);
+    } else if (rnn_type == "two_layer_gru") {
+        return create_gru(input_parameter_names, 2, number_inputs, output_parameter_names, 1, weight_rules);
+    } else if (rnn_type == "one_layer_mgu") {
+        return create_mgu(input_parameter_names, 1, number_inputs, output_parameter_names, 1, weight_rules);
+    } else if (rnn_type == "two_layer_mgu") {
+        return create_mgu(input_parameter_names, 2, number_inputs, output_parameter_names, 1, weight_rules);
+    } else if (rnn_type == "one_layer_ugrnn") {
+        return create_ugrnn(input_parameter_names, 1, number_inputs, output_parameter_names, 1, weight_rules);
+    } else if (rnn_type == "two_layer_ugrnn") {
+        return create_ugrnn(input_parameter_names, 2, number_inputs, output_parameter_names, 1, weight_rules);
+    } else if (rnn_type == "one_layer_ff") {
+        return create_ff(input_parameter_names, 1, number_inputs, output_parameter_names, 0, weight_rules);
+    } else if (rnn_type == "two_layer_ff") {
+        return create_ff(input_parameter_names, 2, number_inputs, output_parameter_names, 0, weight_rules);
+    } else if (rnn_type == "jordan") {
+        return create_jordan(input_parameter_names, 1, number_inputs, output_parameter_names, 1, weight_rules);
+    } else if (rnn_type == "elman") {
+        return create_elman(input_parameter_names, 1, number_inputs, output_parameter_names, 1, weight_rules);
+    }
+
+    Log::fatal("ERROR: unknown rnn type '%s' in the kfold sweep\n", rnn_type.c_str());
+    exit(1);
+}
+
+const KFoldData* KFoldSweep::get_fold(int32_t fold) {
+    lock_guard<mutex> lock(folds_mutex);
+
+    if (folds[fold] == NULL) {
+        vector<int32_t> training_indexes;
+        vector<int32_t> test_indexes;
+        for (int32_t series = 0; series < time_series_sets->get_number_series(); series++) {
+            if (series / fold_size == fold) {
+                test_indexes.push_back(series);
+            } else {
+                training_indexes.push_back(series);
+            }
+        }
+        Log::debug(
+            "exporting fold %d, test_indexes.size(): %d, training_indexes.size(): %d\n", fold, test_indexes.size(),
+            training_indexes.size()
+        );
+
+        time_series_sets->set_training_indexes(training_indexes);
+        time_series_sets->set_test_indexes(test_indexes);
+
+        KFoldData* data = new KFoldData();
+        time_series_sets->export_training_series(time_offset, data->training_inputs, data->training_outputs);
+        time_series_sets->export_test_series(time_offset, data->test_inputs, data->test_outputs);
+        folds[fold] = data;
+    }
+
+    return folds[fold];
+}
+
+int32_t KFoldSweep::get_number_jobs() const {
+    return (int32_t) rnn_types.size() * number_folds * repeats;
+}
+
+vector<int32_t> KFoldSweep::get_job_order() const {
+    vector<int32_t> order;
+    for (int32_t job = 0; job < get_number_jobs(); job++) {
+        order.push_back(job);
+    }
+
+    int32_t jobs_per_rnn = number_folds * repeats;
+    stable_sort(order.begin(), order.end(), [this, jobs_per_rnn](int32_t a, int32_t b) {
+        return rnn_type_weights[a / jobs_per_rnn] > rnn_type_weights[b / jobs_per_rnn];
+    });
+    return order;
+}
+
+ResultSet KFoldSweep::run_job(int32_t job, string log_id) {
+    int32_t jobs_per_rnn = number_folds * repeats;
+    string rnn_type = rnn_types[job / jobs_per_rnn];
+    int32_t fold = (job % jobs_per_rnn) / repeats;
+    int32_t repeat = job % repeats;
+
+    Log::debug("evaluating rnn type '%s' with fold: %d, repeat: %d\n", rnn_type.c_str(), fold, repeat);
+
+    const KFoldData* data = get_fold(fold);
+
+    RNN_Genome* genome = create_genome(rnn_type);
+    Log::debug(
+        "RNN INFO FOR '%s', nodes: %d, edges: %d, rec: %d, weights: %d\n", rnn_type.c_str(),
+        genome->get_enabled_node_count(), genome->get_enabled_edge_count(), genome->get_enabled_recurrent_edge_count(),
+        genome->get_number_weights()
+    );
+
+    genome->initialize_randomly(weight_rules);
+    genome->set_bp_iterations(bp_iterations);
+
+    string slice_directory = output_directory + "/" + rnn_type + "/slice_" + to_string(fold);
+    mkpath(slice_directory.c_str(), 0777);
+    genome->set_log_filename(slice_directory + "/repeat_" + to_string(repeat) + ".txt");
+
+    string backprop_log_id = rnn_type + "_slice_" + to_string(fold) + "_repeat_" + to_string(repeat);
+    Log::set_id(backprop_log_id);
+
+    std::chrono::time_point<std::chrono::system_clock> start = std::chrono::system_clock::now();
+    genome->backpropagate_stochastic(
+        data->training_inputs, data->training_outputs, data->test_inputs, data->test_outputs, weight_update_method
+    );
+    std::chrono::time_point<std::chrono::system_clock> end = std::chrono::system_clock::now();
+
+    vector<double> best_parameters;
+    genome->get_weights(best_parameters);
+
+    ResultSet result;
+    result.job = job;
+    result.training_mse = genome->get_mse(best_parameters, data->training_inputs, data->training_outputs);
+    result.training_mae = genome->get_mae(best_parameters, data->training_inputs, data->training_outputs);
+    result.test_mse = genome->get_mse(best_parameters, data->test_inputs, data->test_outputs);
+    result.test_mae = genome->get_mae(best_parameters, data->test_inputs, data->test_outputs);
+    result.milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+
+    Log::release_id(backprop_log_id);
+    Log::set_id(log_id);
+
+    delete genome;
+
+    Log::debug("finished job, result: %s\n", result_to_string(result).c_str());
+    return result;
+}
+
+void KFoldSweep::open_results() {
+    Log::debug("creating directory: '%s'\n", output_directory.c_str());
+    mkpath(output_directory.c_str(), 0777);
+
+    for (int32_t i = 0; i < (int32_t) rnn_types.size(); i++) {
+        string filename = output_directory + "/combined_" + rnn_types[i] + ".csv";
+        if (!AsyncWriter::open_stream(filename)) {
+            Log::fatal("ERROR: could not open '%s' for writing\n", filename.c_str());
+            exit(1);
+        }
+    }
+}
+
+void KFoldSweep::record_result(const ResultSet& result) {
+    int32_t jobs_per_rnn = number_folds * repeats;
+    int32_t rnn = result.job / jobs_per_rnn;
+    int32_t fold = (result.job % jobs_per_rnn) / repeats;
+    int32_t repeat = result.job % repeats;
+
+    lock_guard<mutex> lock(results_mutex);
+    AsyncWriter::append(output_directory + "/combined_" + rnn_types[rnn] + ".csv", [=](WriteBuffer& buffer) {
+        buffer << fold << ',' << repeat << ',' << (int64_t) result.milliseconds << ',' << result.training_mse << ','
+               << result.training_mae << ',' << result.test_mse << ',' << result.test_mae << '\n';
+    });
+    results_recorded[rnn]++;
+    total_results_recorded++;
+
+    Log::debug(
+        "%s, tested on fold[%d], repeat: %d, result: %s\n", rnn_types[rnn].c_str(), fold, repeat,
+        result_to_string(result).c_str()
+    );
+    Log::info(
+        "finished %d of %d jobs, %d of %d for '%s'\n", total_results_recorded, get_number_jobs(), results_recorded[rnn],
+        jobs_per_rnn, rnn_types[rnn].c_str()
+    );
+
+    // jobs take seconds to minutes so every row is flushed, which lets the results be read during the sweep, and
+    // the files are fsynced once an rnn type is done
+    AsyncWriter::sync(results_recorded[rnn] == jobs_per_rnn);
+}
+
+bool KFoldSweep::is_finished() {
+    lock_guard<mutex> lock(results_mutex);
+    return total_results_recorded >= get_number_jobs();
+}
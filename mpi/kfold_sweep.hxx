@@ -0,0 +1,101 @@
+#ifndef EXAMM_KFOLD_SWEEP_HXX
+#define EXAMM_KFOLD_SWEEP_HXX
+
+#include <mutex>
+using std::mutex;
+
+#include <string>
+using std::string;
+
+#include <vector>
+using std::vector;
+
+#include "rnn/rnn_genome.hxx"
+#include "time_series/time_series.hxx"
+#include "weights/weight_rules.hxx"
+#include "weights/weight_update.hxx"
+
+struct ResultSet {
+    int32_t job;
+    double training_mae;
+    double training_mse;
+    double test_mae;
+    double test_mse;
+    long milliseconds;
+};
+
+string result_to_string(ResultSet result);
+
+/**
+ *  The training and test series of one fold, exported once and then shared by every job on that fold.
+ */
+struct KFoldData {
+    vector<vector<vector<double> > > training_inputs;
+    vector<vector<vector<double> > > training_outputs;
+    vector<vector<vector<double> > > test_inputs;
+    vector<vector<vector<double> > > test_outputs;
+};
+
+/**
+ *  A sweep training every rnn type on every fold of the time series repeats times. A job is one (rnn type, fold,
+ *  repeat) triple, numbered rnn type major, then by fold, then by repeat.
+ *
+ *  run_job can be called from multiple threads at once. Results are appended to output_directory/combined_<rnn
+ *  type>.csv as they are recorded (one fold,repeat,milliseconds,training mse,training mae,test mse,test mae row per
+ *  job, in the order they finish) so process_sweep_results can read a sweep while it is still running.
+ */
+class KFoldSweep {
+   private:
+    int32_t time_offset;
+    int32_t bp_iterations;
+    string output_directory;
+    int32_t repeats;
+    int32_t fold_size;
+    int32_t number_folds;
+
+    WeightUpdate* weight_update_method;
+    WeightRules* weight_rules;
+    TimeSeriesSets* time_series_sets;
+
+    vector<string> rnn_types;
+    // the number of weights of each rnn type, used as the cost of its jobs
+    vector<int32_t> rnn_type_weights;
+
+    // exported the first time a job needs them, as exporting changes the training and test indexes of the sets
+    vector<KFoldData*> folds;
+    mutex folds_mutex;
+
+    vector<int32_t> results_recorded;
+    int32_t total_results_recorded;
+    mutex results_mutex;
+
+    RNN_Genome* create_genome(string rnn_type);
+    const KFoldData* get_fold(int32_t fold);
+
+   public:
+    explicit KFoldSweep(const vector<string>& arguments);
+    ~KFoldSweep();
+
+    int32_t get_number_jobs() const;
+
+    /**
+     *  All the jobs, the most expensive rnn types first so the long jobs are not the ones left running at the end.
+     */
+    vector<int32_t> get_job_order() const;
+
+    /**
+     *  Trains and evaluates the network for job. Training logs to its own log id, and log_id (the calling thread's
+     *  id) is set again when it is done.
+     */
+    ResultSet run_job(int32_t job, string log_id);
+
+    /**
+     *  Creates the output directory and truncates the combined result files, only the process recording results
+     *  should call this.
+     */
+    void open_results();
+    void record_result(const ResultSet& result);
+    bool is_finished();
+};
+
+#endif
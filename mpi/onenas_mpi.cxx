@@ -1,4 +1,16 @@
+#include <algorithm>
+using std::stable_sort;
+
 #include <chrono>
+#include <condition_variable>
+using std::condition_variable;
+
+#include <deque>
+using std::deque;
+
+#include <map>
+using std::map;
+
 #include <iomanip>
 using std::fixed;
 using std::setprecision;
@@ -6,11 +18,18 @@ using std::setw;
 
 #include <fstream>
 #include <iostream>
+using std::ifstream;
 using std::ofstream;
 using std::ios;
 
 #include <mutex>
+using std::lock_guard;
 using std::mutex;
+using std::unique_lock;
+
+#include <sstream>
+using std::istringstream;
+using std::ostringstream;
 
 #include <string>
 using std::string;
@@ -18,12 +37,18 @@ using std::string;
 #include <thread>
 using std::thread;
 
+#include <utility>
+using std::pair;
+
 #include <vector>
 using std::vector;
 
+#include "common/async_writer.hxx"
 #include "common/log.hxx"
 #include "common/process_arguments.hxx"
 #include "common/files.hxx"
+#include "genome_cost_model.hxx"
+#include "genome_dispatch.hxx"
 #include "onenas/onenas.hxx"
 #include "onenas/onenas_island_speciation_strategy.hxx"
 #include "mpi.h"
@@ -37,6 +62,12 @@ using std::vector;
 #define GENOME_LENGTH_TAG 2
 #define GENOME_TAG        3
 #define TERMINATE_TAG     4
+#define GENOME_COUNT_TAG  5
+
+// checkpoints start with this string and version and end with the string again, so a checkpoint which was only
+// partly written when the run died is not resumed from
+#define CHECKPOINT_MAGIC   "ONENAS_CHECKPOINT"
+#define CHECKPOINT_VERSION 3
 
 mutex onenas_mutex;
 
@@ -47,17 +78,58 @@ WeightUpdate* weight_update_method;
 
 bool finished = false;
 
-// CSV file objects for logging
-ofstream training_indices_csv;
-ofstream validation_test_indices_csv;
+// CSV files for logging, appended to through the AsyncWriter
+string training_indices_csv;
+string validation_test_indices_csv;
+string genome_costs_csv;
 string output_directory;
 
-vector<vector<vector<double> > > time_series_inputs;
-vector<vector<vector<double> > > time_series_outputs;
+TimeSeriesWindows* time_series_windows = NULL;
 vector<int32_t> time_series_index;
 int32_t generated_population_size;
 int32_t number_islands;
 int32_t total_generation;
+int32_t elite_fine_tune_steps = 0;
+int32_t elite_fine_tune_max_steps = 0;
+
+// each worker rank trains up to this many genomes at once, one per thread, sharing the rank's data
+int32_t threads_per_rank = 1;
+
+// the master checkpoints the search every checkpoint_frequency generations (never if 0)
+int32_t checkpoint_frequency = 0;
+string resume_from = "";
+
+// bounds how long a genome can hold up the search, on the master and the workers
+GenomeLimits genome_limits;
+// the master's record of the genomes out on workers, kept across generations so genomes which timed out on a worker
+// which is hung are not waited on at the end of the run
+DispatchedGenomes* dispatched_genomes = NULL;
+
+// the master hands out the genomes of a generation in the order they are generated (fifo), or generates them all at
+// the start of the generation and hands them out by predicted training time, most expensive first (longest_first)
+string dispatch_order = "longest_first";
+GenomeCostModel* cost_model = NULL;
+
+// there is no barrier between generations, so the master tracks the generation each worker was last terminated for
+// and the genomes it has sent each worker and received back, to know when every worker is done
+vector<int32_t> terminated_generation;
+vector<int32_t> genomes_sent_to;
+vector<int32_t> genomes_received_from;
+
+// work requests from workers which already finished the generation the master is still on, as (rank, number of
+// genomes) pairs answered once the master starts the next generation
+vector<pair<int32_t, int32_t> > deferred_requests;
+
+/**
+ * What the cost model predicted for a genome, kept until the worker reports how long it actually took.
+ */
+struct GenomeCost {
+    vector<double> features;
+    // time steps trained over all epochs
+    int64_t time_steps;
+    double predicted_milliseconds;
+    bool calibrated;
+};
 
 /**
  * Checks if enough genomes have been generated for the current generation
@@ -77,6 +149,8 @@ bool has_generated_enough_genomes(int32_t current_generated_genomes) {
         if (current_generated_population_size != generated_population_size) {
             Log::info("Master: Generated population size updated from %d to %d\n", 
                      generated_population_size, current_generated_population_size);
+            // with an adaptive generation budget this changes often, so it is only logged when it changes
+            generated_population_size = current_generated_population_size;
         }
     }
     
@@ -90,34 +164,109 @@ string get_stats_directory() {
     return output_directory + "/stats";
 }
 
+/**
+ * Drops the rows of a CSV file (keeping its header) whose generation, in column generation_column, is at or past
+ * first_dropped_generation. A search which died after its last checkpoint had already logged rows for generations
+ * it will redo when it is resumed, which would otherwise be in the file twice.
+ */
+void drop_rows_from_generation(string filename, int32_t generation_column, int32_t first_dropped_generation) {
+    ifstream infile(filename);
+    if (!infile.is_open()) {
+        return;
+    }
+
+    string kept_rows;
+    int32_t dropped_rows = 0;
+    string line;
+    for (int32_t row = 0; getline(infile, line); row++) {
+        size_t start = 0;
+        for (int32_t column = 0; column < generation_column && start != string::npos; column++) {
+            start = line.find(',', start);
+            if (start != string::npos) {
+                start++;
+            }
+        }
+
+        if (row > 0 && start != string::npos && atoi(line.c_str() + start) >= first_dropped_generation) {
+            dropped_rows++;
+        } else {
+            kept_rows += line + "\n";
+        }
+    }
+    infile.close();
+
+    if (dropped_rows == 0) {
+        return;
+    }
+
+    string temporary_filename = filename + ".tmp";
+    ofstream outfile(temporary_filename);
+    outfile << kept_rows;
+    outfile.close();
+    if (!outfile.good() || rename(temporary_filename.c_str(), filename.c_str()) != 0) {
+        Log::error("could not drop the rows after the checkpoint from '%s'\n", filename.c_str());
+        return;
+    }
+    Log::info("Dropped %d rows logged after the checkpoint from '%s'\n", dropped_rows, filename.c_str());
+}
+
 /**
  * Initialize CSV files for logging training indices and validation/test indices
  */
-void initialize_csv_files() {
+void initialize_csv_files(bool resuming, int32_t start_generation) {
     // Create output directory if it doesn't exist
     mkpath(output_directory.c_str(), 0777);
     
     // Create stats subdirectory
     string stats_dir = get_stats_directory();
     mkpath(stats_dir.c_str(), 0777);
+
+    // a resumed search adds to the files of the run it continues, from the generation it resumes at
+    if (resuming) {
+        drop_rows_from_generation(stats_dir + "/training_indices.csv", 1, start_generation);
+        drop_rows_from_generation(stats_dir + "/validation_test_indices.csv", 0, start_generation);
+        drop_rows_from_generation(stats_dir + "/genome_costs.csv", 1, start_generation);
+        drop_rows_from_generation(stats_dir + "/episode_priorities.csv", 0, start_generation);
+    }
     
     // Initialize training indices CSV file in stats directory
     string training_csv_path = stats_dir + "/training_indices.csv";
-    training_indices_csv.open(training_csv_path.c_str(), ios::out);
-    if (!training_indices_csv.is_open()) {
+    if (!AsyncWriter::open_stream(training_csv_path, resuming)) {
         Log::error("Failed to open %s for writing\n", training_csv_path.c_str());
         return;
     }
-    training_indices_csv << "genome_id,generation,training_indices\n";
+    training_indices_csv = training_csv_path;
+    if (!resuming) {
+        AsyncWriter::append(training_indices_csv, [](WriteBuffer& csv) {
+            csv << "genome_id,generation,training_indices\n";
+        });
+    }
     
     // Initialize validation/test indices CSV file in stats directory
     string validation_csv_path = stats_dir + "/validation_test_indices.csv";
-    validation_test_indices_csv.open(validation_csv_path.c_str(), ios::out);
-    if (!validation_test_indices_csv.is_open()) {
+    if (!AsyncWriter::open_stream(validation_csv_path, resuming)) {
         Log::error("Failed to open %s for writing\n", validation_csv_path.c_str());
         return;
     }
-    validation_test_indices_csv << "generation,validation_indices,test_index\n";
+    validation_test_indices_csv = validation_csv_path;
+    if (!resuming) {
+        AsyncWriter::append(validation_test_indices_csv, [](WriteBuffer& csv) {
+            csv << "generation,validation_indices,test_index\n";
+        });
+    }
+
+    // the cost model's prediction and the worker's actual training time of each genome
+    string costs_csv_path = stats_dir + "/genome_costs.csv";
+    if (!AsyncWriter::open_stream(costs_csv_path, resuming)) {
+        Log::error("Failed to open %s for writing\n", costs_csv_path.c_str());
+        return;
+    }
+    genome_costs_csv = costs_csv_path;
+    if (!resuming) {
+        AsyncWriter::append(genome_costs_csv, [](WriteBuffer& csv) {
+            csv << "genome_id,generation,worker,weights,nodes,time_steps,calibrated,predicted_ms,actual_ms\n";
+        });
+    }
     
     Log::info("CSV files initialized successfully in %s\n", stats_dir.c_str());
 }
@@ -126,69 +275,186 @@ void initialize_csv_files() {
  * Close CSV files
  */
 void close_csv_files() {
-    if (training_indices_csv.is_open()) {
-        training_indices_csv.close();
+    // the end of the run is the checkpoint everything written so far is synced at
+    AsyncWriter::sync(true);
+    AsyncWriter::shutdown();
+    Log::info("CSV files closed\n");
+}
+
+/**
+ * Checkpoints the state of the search at the end of a generation: the islands, innovation counters and random
+ * number generators of ONENAS and the episode priorities of the online series. The checkpoint is serialized here,
+ * which only takes copying the genomes, and written to output_directory/checkpoints/checkpoint_<next_generation>.bin
+ * by the AsyncWriter so the workers are not kept waiting on the disk. The writer fsyncs the CSV streams, then writes
+ * the checkpoint to a .tmp file it fsyncs and renames, so a checkpoint under its real name is always complete and on
+ * disk along with the rows logged before it. Earlier checkpoints are kept.
+ */
+void write_checkpoint(int32_t next_generation, OnlineSeries* online_series) {
+    string checkpoint_directory = output_directory + "/checkpoints";
+    mkpath(checkpoint_directory.c_str(), 0777);
+    string checkpoint_filename = checkpoint_directory + "/checkpoint_" + to_string(next_generation) + ".bin";
+
+    ostringstream checkpoint_oss;
+    int32_t version = CHECKPOINT_VERSION;
+    write_binary_string(checkpoint_oss, CHECKPOINT_MAGIC, "checkpoint magic");
+    checkpoint_oss.write((char*) &version, sizeof(int32_t));
+    checkpoint_oss.write((char*) &next_generation, sizeof(int32_t));
+
+    onenas->write_checkpoint(checkpoint_oss);
+    online_series->write_checkpoint(checkpoint_oss);
+    write_binary_string(checkpoint_oss, CHECKPOINT_MAGIC, "checkpoint magic");
+
+    string checkpoint = checkpoint_oss.str();
+    Log::info("Checkpointing generation %d to '%s' (%d bytes)\n", next_generation, checkpoint_filename.c_str(),
+              (int32_t) checkpoint.size());
+    AsyncWriter::write_file(checkpoint_filename, [checkpoint](WriteBuffer& buffer) { buffer << checkpoint; }, true);
+}
+
+/**
+ * Restores the search from a checkpoint written by write_checkpoint with the same arguments.
+ *
+ * \return the generation to resume from
+ */
+int32_t read_checkpoint(string checkpoint_filename, OnlineSeries* online_series) {
+    ifstream checkpoint_file(checkpoint_filename, ios::in | ios::binary);
+    if (!checkpoint_file.is_open()) {
+        Log::fatal("ERROR: could not open checkpoint '%s'\n", checkpoint_filename.c_str());
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    string magic;
+    int32_t version, next_generation;
+    read_binary_string(checkpoint_file, magic, "checkpoint magic");
+    checkpoint_file.read((char*) &version, sizeof(int32_t));
+    checkpoint_file.read((char*) &next_generation, sizeof(int32_t));
+    if (!checkpoint_file.good() || magic != CHECKPOINT_MAGIC || version != CHECKPOINT_VERSION) {
+        Log::fatal(
+            "ERROR: '%s' is not a version %d ONENAS checkpoint\n", checkpoint_filename.c_str(), CHECKPOINT_VERSION
+        );
+        MPI_Abort(MPI_COMM_WORLD, 1);
     }
-    if (validation_test_indices_csv.is_open()) {
-        validation_test_indices_csv.close();
+
+    // the workers are waiting on the start generation, so they have to be taken down along with the master
+    if (!onenas->read_checkpoint(checkpoint_file) || !online_series->read_checkpoint(checkpoint_file)) {
+        Log::fatal("ERROR: could not resume from checkpoint '%s'\n", checkpoint_filename.c_str());
+        MPI_Abort(MPI_COMM_WORLD, 1);
     }
-    Log::info("CSV files closed\n");
+
+    read_binary_string(checkpoint_file, magic, "checkpoint magic");
+    if (!checkpoint_file.good() || magic != CHECKPOINT_MAGIC) {
+        Log::fatal("ERROR: checkpoint '%s' is incomplete or corrupt\n", checkpoint_filename.c_str());
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    Log::info("Resuming from checkpoint '%s' at generation %d\n", checkpoint_filename.c_str(), next_generation);
+    return next_generation;
 }
 
 /**
  * Write training indices for a genome to CSV
  */
 void write_training_indices_to_csv(int32_t genome_id, int32_t generation, const vector<int32_t>& training_indices) {
-    if (!training_indices_csv.is_open()) {
+    if (!AsyncWriter::is_stream_open(training_indices_csv)) {
         Log::error("Training indices CSV file is not open\n");
         return;
     }
     
-    training_indices_csv << genome_id << "," << generation << ",\"";
-    for (size_t i = 0; i < training_indices.size(); i++) {
-        if (i > 0) training_indices_csv << ";";
-        training_indices_csv << training_indices[i];
-    }
-    training_indices_csv << "\"\n";
-    training_indices_csv.flush(); // Ensure data is written immediately
+    // rows are buffered by the writer, not flushed one at a time
+    AsyncWriter::append(training_indices_csv, [genome_id, generation, training_indices](WriteBuffer& csv) {
+        csv << genome_id << "," << generation << ",\"";
+        for (size_t i = 0; i < training_indices.size(); i++) {
+            if (i > 0) csv << ";";
+            csv << training_indices[i];
+        }
+        csv << "\"\n";
+    });
 }
 
 /**
  * Write validation and test indices for a generation to CSV
  */
 void write_validation_test_indices_to_csv(int32_t generation, const vector<int32_t>& validation_indices, int32_t test_index) {
-    if (!validation_test_indices_csv.is_open()) {
+    if (!AsyncWriter::is_stream_open(validation_test_indices_csv)) {
         Log::error("Validation/test indices CSV file is not open\n");
         return;
     }
     
-    validation_test_indices_csv << generation << ",\"";
-    for (size_t i = 0; i < validation_indices.size(); i++) {
-        if (i > 0) validation_test_indices_csv << ";";
-        validation_test_indices_csv << validation_indices[i];
+    AsyncWriter::append(validation_test_indices_csv, [generation, validation_indices, test_index](WriteBuffer& csv) {
+        csv << generation << ",\"";
+        for (size_t i = 0; i < validation_indices.size(); i++) {
+            if (i > 0) csv << ";";
+            csv << validation_indices[i];
+        }
+        csv << "\"," << test_index << "\n";
+    });
+}
+
+/**
+ * Write a genome's predicted and actual training time to CSV
+ */
+void write_genome_cost_to_csv(
+    RNN_Genome* genome, int32_t generation, int32_t worker, const GenomeCost& cost, int32_t training_milliseconds
+) {
+    if (!AsyncWriter::is_stream_open(genome_costs_csv)) {
+        Log::error("Genome costs CSV file is not open\n");
+        return;
     }
-    validation_test_indices_csv << "\"," << test_index << "\n";
-    validation_test_indices_csv.flush(); // Ensure data is written immediately
+
+    int32_t genome_id = genome->get_generation_id();
+    int32_t weights = genome->get_number_weights();
+    int32_t nodes = genome->get_enabled_node_count();
+    AsyncWriter::append(genome_costs_csv, [=](WriteBuffer& csv) {
+        csv << genome_id << "," << generation << "," << worker << "," << weights << "," << nodes << ","
+            << (int64_t) cost.time_steps << "," << (cost.calibrated ? 1 : 0) << "," << cost.predicted_milliseconds
+            << "," << training_milliseconds << "\n";
+    });
 }
 
-void send_work_request(int32_t target) {
-    int32_t work_request_message[1];
-    work_request_message[0] = 0;
-    MPI_Send(work_request_message, 1, MPI_INT, target, WORK_REQUEST_TAG, MPI_COMM_WORLD);
+/**
+ * Asks the master for up to number_genomes genomes of the worker's generation, which are sent back after a
+ * GENOME_COUNT_TAG message saying how many are coming, or a TERMINATE_TAG if that generation has none left.
+ */
+void send_work_request(int32_t target, int32_t number_genomes, int32_t generation) {
+    int32_t work_request_message[2];
+    work_request_message[0] = number_genomes;
+    work_request_message[1] = generation;
+    MPI_Send(work_request_message, 2, MPI_INT, target, WORK_REQUEST_TAG, MPI_COMM_WORLD);
 }
 
-void receive_work_request(int32_t source) {
+void receive_work_request(int32_t source, int32_t& number_genomes, int32_t& generation) {
     MPI_Status status;
-    int32_t work_request_message[1];
-    MPI_Recv(work_request_message, 1, MPI_INT, source, WORK_REQUEST_TAG, MPI_COMM_WORLD, &status);
+    int32_t work_request_message[2];
+    MPI_Recv(work_request_message, 2, MPI_INT, source, WORK_REQUEST_TAG, MPI_COMM_WORLD, &status);
+    number_genomes = work_request_message[0];
+    generation = work_request_message[1];
+}
+
+void send_genome_count(int32_t target, int32_t number_genomes) {
+    int32_t count_message[1];
+    count_message[0] = number_genomes;
+    MPI_Send(count_message, 1, MPI_INT, target, GENOME_COUNT_TAG, MPI_COMM_WORLD);
 }
 
-RNN_Genome* receive_genome_from(int32_t source) {
+int32_t receive_genome_count(int32_t source) {
     MPI_Status status;
-    int32_t length_message[1];
-    MPI_Recv(length_message, 1, MPI_INT, source, GENOME_LENGTH_TAG, MPI_COMM_WORLD, &status);
+    int32_t count_message[1];
+    MPI_Recv(count_message, 1, MPI_INT, source, GENOME_COUNT_TAG, MPI_COMM_WORLD, &status);
+    return count_message[0];
+}
+
+/**
+ * Genomes sent back by a worker come with the milliseconds it took to train them, which are 0 for genomes sent by the
+ * master.
+ */
+RNN_Genome* receive_genome_from(int32_t source, int32_t* training_milliseconds = NULL) {
+    MPI_Status status;
+    int32_t length_message[2];
+    MPI_Recv(length_message, 2, MPI_INT, source, GENOME_LENGTH_TAG, MPI_COMM_WORLD, &status);
 
     int32_t length = length_message[0];
+    if (training_milliseconds != NULL) {
+        *training_milliseconds = length_message[1];
+    }
 
     Log::debug("receiving genome of length: %d from: %d\n", length, source);
 
@@ -207,7 +473,7 @@ RNN_Genome* receive_genome_from(int32_t source) {
     return genome;
 }
 
-void send_genome_to(int32_t target, RNN_Genome* genome) {
+void send_genome_to(int32_t target, RNN_Genome* genome, int32_t training_milliseconds = 0) {
     char* byte_array;
     int32_t length;
 
@@ -215,9 +481,10 @@ void send_genome_to(int32_t target, RNN_Genome* genome) {
 
     Log::debug("sending genome of length: %d to: %d\n", length, target);
 
-    int32_t length_message[1];
+    int32_t length_message[2];
     length_message[0] = length;
-    MPI_Send(length_message, 1, MPI_INT, target, GENOME_LENGTH_TAG, MPI_COMM_WORLD);
+    length_message[1] = training_milliseconds;
+    MPI_Send(length_message, 2, MPI_INT, target, GENOME_LENGTH_TAG, MPI_COMM_WORLD);
 
     Log::debug("sending genome to: %d\n", target);
     MPI_Send(byte_array, length, MPI_CHAR, target, GENOME_TAG, MPI_COMM_WORLD);
@@ -251,15 +518,19 @@ void populate_current_time_series_data(
         int32_t episode_id = train_index[i];  // This is the original episode ID
         TimeSeriesEpisode* episode = online_series->get_episode(episode_id);
         if (episode != nullptr) {
-            current_training_inputs.push_back(episode->get_inputs());
-            current_training_outputs.push_back(episode->get_outputs());
+            current_training_inputs.emplace_back();
+            current_training_outputs.emplace_back();
+            episode->export_data(current_training_inputs.back(), current_training_outputs.back());
             Log::debug("Worker: training episode ID: %d\n", episode_id);
         } else {
             Log::warning("Episode ID %d not found, falling back to legacy method\n", episode_id);
-            // Fallback to legacy method using original time series arrays
-            if (episode_id < (int32_t)time_series_inputs.size()) {
-                current_training_inputs.push_back(time_series_inputs[episode_id]);
-                current_training_outputs.push_back(time_series_outputs[episode_id]);
+            // Fallback to legacy method using the time series windows
+            if (episode_id >= 0 && episode_id < time_series_windows->get_number_windows()) {
+                current_training_inputs.emplace_back();
+                current_training_outputs.emplace_back();
+                time_series_windows->export_window(
+                    episode_id, current_training_inputs.back(), current_training_outputs.back()
+                );
                 Log::debug("Worker: training legacy index: %d\n", episode_id);
             } else {
                 Log::error("Episode ID %d out of bounds for both episodes and legacy data\n", episode_id);
@@ -272,15 +543,19 @@ void populate_current_time_series_data(
         int32_t episode_id = validation_index[i];  // This is the original episode ID
         TimeSeriesEpisode* episode = online_series->get_episode(episode_id);
         if (episode != nullptr) {
-            current_validation_inputs.push_back(episode->get_inputs());
-            current_validation_outputs.push_back(episode->get_outputs());
+            current_validation_inputs.emplace_back();
+            current_validation_outputs.emplace_back();
+            episode->export_data(current_validation_inputs.back(), current_validation_outputs.back());
             Log::debug("Worker: validation episode ID: %d\n", episode_id);
         } else {
             Log::warning("Episode ID %d not found for validation, falling back to legacy method\n", episode_id);  
-            // Fallback to legacy method using original time series arrays
-            if (episode_id < (int32_t)time_series_inputs.size()) {
-                current_validation_inputs.push_back(time_series_inputs[episode_id]);
-                current_validation_outputs.push_back(time_series_outputs[episode_id]);
+            // Fallback to legacy method using the time series windows
+            if (episode_id >= 0 && episode_id < time_series_windows->get_number_windows()) {
+                current_validation_inputs.emplace_back();
+                current_validation_outputs.emplace_back();
+                time_series_windows->export_window(
+                    episode_id, current_validation_inputs.back(), current_validation_outputs.back()
+                );
                 Log::debug("Worker: validation legacy index: %d\n", episode_id);
             } else {
                 Log::error("Episode ID %d out of bounds for both episodes and legacy data\n", episode_id);
@@ -301,8 +576,9 @@ void populate_test_and_validation_data(
     // test_index is an episode ID (original time series index)
     TimeSeriesEpisode* test_episode = online_series->get_episode(test_index);
     if (test_episode != nullptr) {
-        current_test_inputs.push_back(test_episode->get_inputs());
-        current_test_outputs.push_back(test_episode->get_outputs());
+        current_test_inputs.emplace_back();
+        current_test_outputs.emplace_back();
+        test_episode->export_data(current_test_inputs.back(), current_test_outputs.back());
     } else {
         Log::error("Test episode ID %d not found in episodes\n", test_index);
         exit(1);
@@ -313,8 +589,9 @@ void populate_test_and_validation_data(
         int32_t episode_id = validation_index[i];  // This is the original episode ID
         TimeSeriesEpisode* val_episode = online_series->get_episode(episode_id);
         if (val_episode != nullptr) {
-            current_validation_inputs.push_back(val_episode->get_inputs());
-            current_validation_outputs.push_back(val_episode->get_outputs());
+            current_validation_inputs.emplace_back();
+            current_validation_outputs.emplace_back();
+            val_episode->export_data(current_validation_inputs.back(), current_validation_outputs.back());
             Log::debug("validation episode ID: %d\n", episode_id);
         } else {
             Log::error("Validation episode ID %d not found in episodes\n", episode_id);
@@ -331,159 +608,490 @@ void master(int32_t max_rank, OnlineSeries* online_series, int32_t current_gener
     int32_t terminates_sent = 0;
     int32_t generated_genome = 0;
     int32_t evaluated_genome = 0;
-    while (true) {
-        // wait for a incoming message
+
+    DispatchedGenomes& dispatched = *dispatched_genomes;
+    int32_t timed_out_before = dispatched.get_timed_out_genomes();
+    int32_t dropped_before = dispatched.get_dropped_genomes();
+    // what the cost model predicted for the genomes out on workers, by generation id
+    map<int32_t, GenomeCost> dispatched_costs;
+    int32_t failed_genomes = 0;
+
+    // the cost model's mean relative error this generation, over the genomes predicted once it was calibrated
+    double prediction_error = 0.0;
+    int32_t predictions = 0;
+
+    // new genomes waiting to be sent
+    struct PendingGenome {
+        RNN_Genome* genome;
+        GenomeCost cost;
+    };
+    deque<PendingGenome> pending;
+
+    // idle workers which asked for work once there was nothing new left to send, while genomes were still out which
+    // may time out and need to be sent again. they are only terminated once nothing is out, as no worker of this
+    // generation would ask for work again to take the genomes otherwise.
+    vector<pair<int32_t, int32_t> > held_requests;
+
+    auto prepare_genome = [&]() {
+        onenas_mutex.lock();
+        RNN_Genome* genome = onenas->generate_genome();
+        onenas_mutex.unlock();
+
+        if (genome == NULL) {
+            Log::fatal("Returned NULL genome from generate genome function, this should never happen!\n");
+            exit(1);
+        }
+
+        // Master generates training indices using PER system
+        vector<int32_t> master_training_index;
+        online_series->get_training_index(master_training_index);
+
+        // Attach training indices to genome before sending to worker
+        genome->set_training_indices(master_training_index);
+
+        // Write training indices to CSV
+        write_training_indices_to_csv(genome->get_generation_id(), current_generation, master_training_index);
+
+        // the training series are trained on once to initialize and then once per epoch
+        GenomeCost cost;
+        cost.time_steps = 0;
+        for (int32_t i = 0; i < (int32_t) master_training_index.size(); i++) {
+            int32_t episode_id = master_training_index[i];
+            if (episode_id >= 0 && episode_id < time_series_windows->get_number_windows()) {
+                cost.time_steps += time_series_windows->get_window(episode_id).length;
+            }
+        }
+        cost.time_steps *= genome->get_bp_iterations() + 1;
+        cost.features = cost_model->get_features(genome, cost.time_steps);
+        cost.predicted_milliseconds = cost_model->predict(cost.features);
+        cost.calibrated = cost_model->is_calibrated();
+
+        generated_genome++;
+        return PendingGenome{genome, cost};
+    };
+
+    auto handle_work_request = [&](int32_t source, int32_t requested_genomes) {
+        // timed out genomes go out first
+        vector<RNN_Genome*> resent_genomes;
+        while ((int32_t) resent_genomes.size() < requested_genomes) {
+            RNN_Genome* genome = dispatched.next_resend(source);
+            if (genome == NULL) {
+                break;
+            }
+            resent_genomes.push_back(genome);
+        }
+
+        vector<PendingGenome> new_genomes;
+        while ((int32_t) (resent_genomes.size() + new_genomes.size()) < requested_genomes
+               && (!pending.empty() || !has_generated_enough_genomes(generated_genome))) {
+            if (pending.empty()) {
+                new_genomes.push_back(prepare_genome());
+            } else {
+                new_genomes.push_back(pending.front());
+                pending.pop_front();
+            }
+        }
+
+        int32_t number_genomes = resent_genomes.size() + new_genomes.size();
+        if (number_genomes == 0 && !dispatched.empty()
+            && genomes_received_from[source] + dispatched.get_abandoned(source) >= genomes_sent_to[source]) {
+            held_requests.push_back(pair<int32_t, int32_t>(source, requested_genomes));
+            return;
+        }
+        if (number_genomes == 0) {
+            Log::info("terminating worker: %d\n", source);
+            send_terminate_message(source);
+            terminated_generation[source] = current_generation;
+            terminates_sent++;
+
+            Log::info("sent: %d terminates of %d\n", terminates_sent, (max_rank - 1));
+            return;
+        }
+
+        send_genome_count(source, number_genomes);
+
+        for (int32_t i = 0; i < (int32_t) resent_genomes.size(); i++) {
+            send_genome_to(source, resent_genomes[i]);
+        }
+
+        for (int32_t i = 0; i < (int32_t) new_genomes.size(); i++) {
+            RNN_Genome* genome = new_genomes[i].genome;
+            int32_t generation_id = genome->get_generation_id();
+
+            Log::info(
+                "Master: sending genome %d with %d training indices (predicted %.1lf ms) to worker: %d\n",
+                generation_id, (int32_t) genome->get_training_indices().size(),
+                new_genomes[i].cost.predicted_milliseconds, source
+            );
+            send_genome_to(source, genome);
+            dispatched_costs[generation_id] = new_genomes[i].cost;
+            dispatched.sent(source, genome);
+        }
+        genomes_sent_to[source] += number_genomes;
+    };
+
+    auto handle_genome = [&](int32_t source) {
+        Log::debug("received genome from: %d\n", source);
+        int32_t training_milliseconds;
+        RNN_Genome* genome = receive_genome_from(source, &training_milliseconds);
+        genomes_received_from[source]++;
+
+        if (!dispatched.received(genome->get_generation_id(), source)) {
+            // a genome which was dropped after timing out, came back from another worker first, or is from an earlier
+            // generation
+            Log::info("Master: discarding late genome %d from worker %d\n", genome->get_generation_id(), source);
+            delete genome;
+            return;
+        }
+        GenomeCost cost = dispatched_costs[genome->get_generation_id()];
+        dispatched_costs.erase(genome->get_generation_id());
+
+        // Training history was already recorded when genome was generated
+        bool failed = isnan(genome->get_fitness()) || isinf(genome->get_fitness());
+        if (failed) {
+            failed_genomes++;
+        } else {
+            // genomes which failed stopped training early, so their times say little about their cost
+            cost_model->observe(cost.features, training_milliseconds);
+            if (cost.calibrated && training_milliseconds > 0) {
+                prediction_error += fabs(cost.predicted_milliseconds - training_milliseconds) / training_milliseconds;
+                predictions++;
+            }
+        }
+        write_genome_cost_to_csv(genome, current_generation, source, cost, training_milliseconds);
+
+        onenas_mutex.lock();
+        onenas->insert_genome(genome);
+        onenas_mutex.unlock();
+
+        // delete the genome as it won't be used again, a copy was inserted
+        delete genome;
+        evaluated_genome++;
+    };
+
+    if (dispatch_order == "longest_first") {
+        // generating the whole generation first only changes the order genomes are generated and trained in, as
+        // generating a genome does not depend on the genomes of its generation which have been trained
+        while (!has_generated_enough_genomes(generated_genome)) {
+            pending.push_back(prepare_genome());
+        }
+        stable_sort(pending.begin(), pending.end(), [](const PendingGenome& a, const PendingGenome& b) {
+            return a.cost.predicted_milliseconds > b.cost.predicted_milliseconds;
+        });
+
+        if (!pending.empty()) {
+            Log::info(
+                "Master: dispatching %d genomes longest expected first, predicted %.1lf to %.1lf ms (%s)\n",
+                (int32_t) pending.size(), pending.back().cost.predicted_milliseconds,
+                pending.front().cost.predicted_milliseconds,
+                cost_model->is_calibrated() ? "calibrated" : "uncalibrated, relative to weights times time steps"
+            );
+        }
+    }
+
+    // workers which finished the last generation before the master did asked for genomes of this one already
+    for (int32_t i = 0; i < (int32_t) deferred_requests.size(); i++) {
+        handle_work_request(deferred_requests[i].first, deferred_requests[i].second);
+    }
+    deferred_requests.clear();
+
+    // a worker asks for more genomes while it is still training others, and late workers are terminated at the start of
+    // the next generation, so the generation is over once every genome sent out has come back or been dropped
+    while (!has_generated_enough_genomes(generated_genome) || !pending.empty() || !dispatched.empty()) {
+        if (!held_requests.empty() && dispatched.has_resends()) {
+            vector<pair<int32_t, int32_t> > requests;
+            requests.swap(held_requests);
+            for (int32_t i = 0; i < (int32_t) requests.size(); i++) {
+                handle_work_request(requests[i].first, requests[i].second);
+            }
+        }
+
         MPI_Status status;
-        MPI_Probe(MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &status);
+        if (!dispatched.probe(status)) {
+            continue;
+        }
 
         int32_t source = status.MPI_SOURCE;
         int32_t tag = status.MPI_TAG;
         Log::debug("probe returned message from: %d with tag: %d\n", source, tag);
 
-        // if the message is a work request, send a genome
-
         if (tag == WORK_REQUEST_TAG) {
-            receive_work_request(source);
-            if (!has_generated_enough_genomes(generated_genome)) {
-                onenas_mutex.lock();
-                RNN_Genome *genome = onenas->generate_genome();
-                onenas_mutex.unlock();
-
-                if (genome != NULL) {
-                    // Master generates training indices using PER system
-                    vector<int32_t> master_training_index;
-                    online_series->get_training_index(master_training_index);
-                    
-                    // Attach training indices to genome before sending to worker
-                    int32_t generation_id = genome->get_generation_id();
-                    genome->set_training_indices(master_training_index);
-                    
-                    // Write training indices to CSV
-                    write_training_indices_to_csv(generation_id, current_generation, master_training_index);
-                    
-                    Log::info("Master: Generated %d training indices for genome %d, sending to worker: %d\n", 
-                             master_training_index.size(), generation_id, source);
-                    Log::debug("sending genome to: %d\n", source);
-                    send_genome_to(source, genome);
-
-                    //delete this genome as it will not be used again
-                    delete genome;
-                    generated_genome ++;
-                } else {
-                    Log::fatal("Returned NULL genome from generate genome function, this should never happen!\n");
-                    exit(1);
-                }
-            } else {
-                Log::info("terminating worker: %d\n", source);
-                send_terminate_message(source);
-                terminates_sent++;
+            int32_t requested_genomes, worker_generation;
+            receive_work_request(source, requested_genomes, worker_generation);
 
-                Log::info("sent: %d terminates of %d\n", terminates_sent, (max_rank - 1));
-                if (terminates_sent >= max_rank - 1) {
-                    Log::debug("Ending genome, generated genome is %d, evaluated genome is %d\n", generated_genome, evaluated_genome);
-                    return;
-                }
+            if (worker_generation < current_generation) {
+                // the worker was still busy when its generation ended
+                Log::info("terminating worker: %d, which is behind on generation %d\n", source, worker_generation);
+                send_terminate_message(source);
+                terminated_generation[source] = worker_generation;
+            } else if (worker_generation > current_generation) {
+                deferred_requests.push_back(pair<int32_t, int32_t>(source, requested_genomes));
+            } else {
+                handle_work_request(source, requested_genomes);
             }
 
         } else if (tag == GENOME_LENGTH_TAG) {
-            Log::debug("received genome from: %d\n", source);
-            RNN_Genome* genome = receive_genome_from(source);
+            handle_genome(source);
 
-            // Training history was already recorded when genome was generated
-            // No need to extract and re-add training indices here
+        } else {
+            Log::fatal("ERROR: received message from %d with unknown tag: %d", source, tag);
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+    }
 
-            onenas_mutex.lock();
-            onenas->insert_genome(genome);
-            onenas_mutex.unlock();
+    // nothing is out anymore, so these are terminated
+    for (int32_t i = 0; i < (int32_t) held_requests.size(); i++) {
+        handle_work_request(held_requests[i].first, held_requests[i].second);
+    }
 
-            // delete the genome as it won't be used again, a copy was inserted
+    int32_t timed_out_genomes = dispatched.get_timed_out_genomes() - timed_out_before;
+    int32_t dropped_genomes = dispatched.get_dropped_genomes() - dropped_before;
+    if (timed_out_genomes > 0 || failed_genomes > 0) {
+        Log::warning(
+            "Generation %d: %d genomes timed out (%d dropped), %d failed on the workers\n", current_generation,
+            timed_out_genomes, dropped_genomes, failed_genomes
+        );
+    }
+    if (predictions > 0) {
+        Log::info(
+            "Generation %d: cost model (%d genomes observed) mean relative error %.1lf%% over %d genomes\n",
+            current_generation, cost_model->get_number_observations(), 100.0 * prediction_error / predictions,
+            predictions
+        );
+    }
+    Log::debug(
+        "Ending generation, generated genome is %d, evaluated genome is %d, dropped genome is %d\n", generated_genome,
+        evaluated_genome, dropped_genomes
+    );
+}
+
+/**
+ * Answers the workers until each has been terminated for the final generation and has returned every genome it was
+ * sent, as they are not waited on at the end of each generation. Workers whose genomes out all timed out are hung and
+ * not waited on, returns false if there were any.
+ */
+bool finish_workers(int32_t max_rank, int32_t final_generation) {
+    auto is_hung = [&](int32_t rank) {
+        int32_t genomes_out = genomes_sent_to[rank] - genomes_received_from[rank];
+        return genomes_out > 0 && genomes_out == dispatched_genomes->get_abandoned(rank);
+    };
+
+    auto workers_done = [&]() {
+        for (int32_t rank = 1; rank < max_rank; rank++) {
+            if (is_hung(rank)) {
+                continue;
+            }
+            if (terminated_generation[rank] < final_generation || genomes_received_from[rank] < genomes_sent_to[rank]) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    while (!workers_done()) {
+        MPI_Status status;
+        MPI_Probe(MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &status);
+        int32_t source = status.MPI_SOURCE;
+        int32_t tag = status.MPI_TAG;
+
+        if (tag == WORK_REQUEST_TAG) {
+            int32_t requested_genomes, worker_generation;
+            receive_work_request(source, requested_genomes, worker_generation);
+            send_terminate_message(source);
+            terminated_generation[source] = worker_generation;
+
+        } else if (tag == GENOME_LENGTH_TAG) {
+            RNN_Genome* genome = receive_genome_from(source);
+            genomes_received_from[source]++;
+            dispatched_genomes->received(genome->get_generation_id(), source);
+            Log::info("Master: discarding late genome %d from worker %d\n", genome->get_generation_id(), source);
             delete genome;
-            evaluated_genome++;
-            // this genome will be deleted if/when removed from population
+
         } else {
             Log::fatal("ERROR: received message from %d with unknown tag: %d", source, tag);
             MPI_Abort(MPI_COMM_WORLD, 1);
         }
     }
+
+    bool all_terminated = true;
+    for (int32_t rank = 1; rank < max_rank; rank++) {
+        if (is_hung(rank)) {
+            Log::warning("worker %d is hung on a genome which timed out, no longer waiting for it\n", rank);
+            all_terminated = false;
+        }
+    }
+    return all_terminated;
 }
 
-void worker(int32_t rank, OnlineSeries* online_series) {
-    Log::set_id("worker_" + to_string(rank));
+/**
+ * Trains a genome received from the master on the training indices it was sent with. This only reads the online
+ * series, so the threads of a worker can all train genomes at the same time.
+ */
+int32_t train_genome(int32_t rank, OnlineSeries* online_series, RNN_Genome* genome) {
+    std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
 
-    while (true) {
-        Log::debug("sending work request!\n");
-        send_work_request(0);
-        Log::debug("sent work request!\n");
+    vector< vector< vector<double> > > current_training_inputs;
+    vector< vector< vector<double> > > current_training_outputs;
+    vector< vector< vector<double> > > current_validation_inputs;
+    vector< vector< vector<double> > > current_validation_outputs;
 
-        MPI_Status status;
-        MPI_Probe(0, MPI_ANY_TAG, MPI_COMM_WORLD, &status);
-        int32_t tag = status.MPI_TAG;
+    // Use training indices provided by master (attached to genome)
+    vector<int32_t> train_index = genome->get_training_indices();
+    vector<int32_t> validation_index;
 
-        Log::debug("probe received message with tag: %d\n", tag);
+    // Still generate validation indices locally (these don't need score-based prioritization)
+    online_series->get_validation_index(validation_index);
 
-        if (tag == TERMINATE_TAG) {
-            Log::debug("received terminate tag!\n");
-            receive_terminate_message(0);
-            break;
+    Log::info("Worker %d: Using %d training indices provided by master for genome %d\n", 
+             rank, train_index.size(), genome->get_generation_id());
 
-        } else if (tag == GENOME_LENGTH_TAG) {
-            Log::info("worker %d received genome!\n", rank);
-            RNN_Genome* genome = receive_genome_from(0);
+    // Use episode-based data population if available, otherwise use legacy method
+    populate_current_time_series_data(
+        online_series, train_index, validation_index, 
+        current_training_inputs, current_training_outputs, 
+        current_validation_inputs, current_validation_outputs
+    );
 
-            vector< vector< vector<double> > > current_training_inputs;
-            vector< vector< vector<double> > > current_training_outputs;
-            vector< vector< vector<double> > > current_validation_inputs;
-            vector< vector< vector<double> > > current_validation_outputs;
+    //have each worker write the backproagation to a separate log file
+    string log_id = "genome_" + to_string(genome->get_generation_id()) + "_worker_" + to_string(rank);
+    Log::set_id(log_id);
+    genome->set_training_limits(genome_limits.time_limit, genome_limits.memory_limit);
+    genome->backpropagate_stochastic(current_training_inputs, current_training_outputs, current_validation_inputs, current_validation_outputs, weight_update_method);
+    if (isnan(genome->get_fitness())) {
+        // training gave up on the genome, it goes back to the master as failed instead of being evaluated
+        Log::warning("Worker %d: training genome %d failed\n", rank, genome->get_generation_id());
+    } else {
+        genome->evaluate_online(current_validation_inputs, current_validation_outputs);
+    }
+    Log::release_id(log_id);
 
-            // Use training indices provided by master (attached to genome)
-            vector<int32_t> train_index = genome->get_training_indices();
-            vector<int32_t> validation_index;
+    // Training indices were provided by master and used for training
+    // No training history tracking needed with PER system
 
-            // Still generate validation indices locally (these don't need score-based prioritization)
-            online_series->get_validation_index(validation_index);
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+}
 
-            Log::info("Worker %d: Using %d training indices provided by master for genome %d\n", 
-                     rank, train_index.size(), genome->get_generation_id());
+void worker(int32_t rank, OnlineSeries* online_series, int32_t current_generation) {
+    string worker_log_id = "worker_" + to_string(rank);
+    Log::set_id(worker_log_id);
+
+    // genomes received from the master wait here for a training thread, and trained genomes wait for this thread to
+    // send them back
+    deque<RNN_Genome*> received_genomes;
+    // with the milliseconds each took to train, which the master calibrates its cost model with
+    deque<pair<RNN_Genome*, int32_t> > trained_genomes;
+    bool no_more_genomes = false;
+    mutex queue_mutex;
+    condition_variable genomes_received;
+    condition_variable genomes_trained;
+
+    vector<thread> threads;
+    for (int32_t i = 0; i < threads_per_rank; i++) {
+        string thread_log_id = worker_log_id + "_thread_" + to_string(i);
+
+        threads.push_back(thread([&, thread_log_id]() {
+            Log::set_id(thread_log_id);
+
+            unique_lock<mutex> lock(queue_mutex);
+            while (true) {
+                genomes_received.wait(lock, [&] { return !received_genomes.empty() || no_more_genomes; });
+                if (received_genomes.empty()) {
+                    break;
+                }
+                RNN_Genome* genome = received_genomes.front();
+                received_genomes.pop_front();
 
-            // Use episode-based data population if available, otherwise use legacy method
-            populate_current_time_series_data(
-                online_series, train_index, validation_index, 
-                current_training_inputs, current_training_outputs, 
-                current_validation_inputs, current_validation_outputs
-            );
+                lock.unlock();
+                int32_t training_milliseconds = train_genome(rank, online_series, genome);
+                Log::set_id(thread_log_id);
+                lock.lock();
 
-            //have each worker write the backproagation to a separate log file
-            string log_id = "genome_" + to_string(genome->get_generation_id()) + "_worker_" + to_string(rank);
-            Log::set_id(log_id);
-            genome->backpropagate_stochastic(current_training_inputs, current_training_outputs, current_validation_inputs, current_validation_outputs, weight_update_method);
-            genome->evaluate_online(current_validation_inputs, current_validation_outputs);
-            Log::release_id(log_id);
+                trained_genomes.push_back(pair<RNN_Genome*, int32_t>(genome, training_milliseconds));
+                genomes_trained.notify_one();
+            }
+            lock.unlock();
 
-            // Training indices were provided by master and used for training
-            // No training history tracking needed with PER system
+            Log::release_id(thread_log_id);
+        }));
+    }
 
-            // go back to the worker's log for MPI communication
-            Log::set_id("worker_" + to_string(rank));
+    // only this thread talks to the master, asking for as many genomes as there are idle threads and returning each
+    // genome as soon as it has been trained
+    int32_t training = 0;
+    bool terminated = false;
+    while (true) {
+        if (!terminated && training < threads_per_rank) {
+            Log::debug("sending work request!\n");
+            send_work_request(0, threads_per_rank - training, current_generation);
+            Log::debug("sent work request!\n");
 
-            send_genome_to(0, genome);
+            MPI_Status status;
+            MPI_Probe(0, MPI_ANY_TAG, MPI_COMM_WORLD, &status);
+            int32_t tag = status.MPI_TAG;
 
-            delete genome;
-        } else {
-            Log::fatal("ERROR: received message with unknown tag: %d\n", tag);
-            MPI_Abort(MPI_COMM_WORLD, 1);
+            Log::debug("probe received message with tag: %d\n", tag);
+
+            if (tag == TERMINATE_TAG) {
+                Log::debug("received terminate tag!\n");
+                receive_terminate_message(0);
+                terminated = true;
+
+                lock_guard<mutex> lock(queue_mutex);
+                no_more_genomes = true;
+                genomes_received.notify_all();
+
+            } else if (tag == GENOME_COUNT_TAG) {
+                int32_t number_genomes = receive_genome_count(0);
+                Log::info("worker %d receiving %d genomes!\n", rank, number_genomes);
+
+                vector<RNN_Genome*> genomes;
+                for (int32_t i = 0; i < number_genomes; i++) {
+                    genomes.push_back(receive_genome_from(0));
+                }
+                training += number_genomes;
+
+                lock_guard<mutex> lock(queue_mutex);
+                received_genomes.insert(received_genomes.end(), genomes.begin(), genomes.end());
+                genomes_received.notify_all();
+
+            } else {
+                Log::fatal("ERROR: received message with unknown tag: %d\n", tag);
+                MPI_Abort(MPI_COMM_WORLD, 1);
+            }
+            continue;
         }
+
+        if (training == 0) {
+            break;
+        }
+
+        deque<pair<RNN_Genome*, int32_t> > genomes;
+        {
+            unique_lock<mutex> lock(queue_mutex);
+            genomes_trained.wait(lock, [&] { return !trained_genomes.empty(); });
+            genomes.swap(trained_genomes);
+        }
+
+        for (int32_t i = 0; i < (int32_t) genomes.size(); i++) {
+            send_genome_to(0, genomes[i].first, genomes[i].second);
+            delete genomes[i].first;
+        }
+        training -= genomes.size();
+    }
+
+    for (int32_t i = 0; i < (int32_t) threads.size(); i++) {
+        threads[i].join();
     }
 
     // release the log file for the worker communication
-    Log::release_id("worker_" + to_string(rank));
+    Log::release_id(worker_log_id);
 }
 
 /**
  * Write normalized and sliced time series data to separate CSV files
  * The data will be in normalized form (0-1 range) to match prediction files
  */
-void write_sliced_files(const vector<vector<vector<double>>>& inputs, 
-                       const vector<vector<vector<double>>>& outputs,
+void write_sliced_files(const TimeSeriesWindows* windows,
                        const vector<string>& input_parameter_names,
                        const vector<string>& output_parameter_names,
                        const string& base_directory) {
@@ -491,53 +1099,54 @@ void write_sliced_files(const vector<vector<vector<double>>>& inputs,
     // Create the directory if it doesn't exist
     mkpath(base_directory.c_str(), 0777);
     
-    Log::info("Writing %d sliced files to directory: %s\n", inputs.size(), base_directory.c_str());
+    Log::info("Writing %d sliced files to directory: %s\n", windows->get_number_windows(), base_directory.c_str());
     
-    for (int32_t slice_idx = 0; slice_idx < (int32_t)inputs.size(); slice_idx++) {
+    vector<vector<double>> outputs;
+    for (int32_t slice_idx = 0; slice_idx < windows->get_number_windows(); slice_idx++) {
         string filename = base_directory + "/generation_" + to_string(slice_idx) + ".csv";
-        ofstream outfile(filename);
-        
-        if (!outfile.is_open()) {
-            Log::error("Failed to open file %s for writing\n", filename.c_str());
-            continue;
-        }
-        
-        // Write header with only input parameter names (output parameters are already in input)
-        bool first_column = true;
-        for (const string& param : input_parameter_names) {
-            if (!first_column) outfile << ",";
-            outfile << param;
-            first_column = false;
-        }
-        outfile << "\n";
-        
+
+        vector<vector<double>> inputs;
+        windows->export_window(slice_idx, inputs, outputs);
+
         // Get the number of time steps (should be the same for inputs and outputs)
-        int32_t time_steps = inputs[slice_idx][0].size();
-        int32_t num_input_params = inputs[slice_idx].size();
-        // int32_t num_output_params = outputs[slice_idx].size();
-        
-        // Write data rows (each row is a time step) - only input values since output parameters are already in input
-        for (int32_t t = 0; t < time_steps; t++) {
-            bool first_value = true;
-            
-            // Write only input values for this time step (normalized)
-            for (int32_t param = 0; param < num_input_params; param++) {
-                if (!first_value) outfile << ",";
-                outfile << inputs[slice_idx][param][t];
-                first_value = false;
+        int32_t time_steps = inputs[0].size();
+
+        AsyncWriter::write_file(filename, [input_parameter_names, inputs = std::move(inputs)](WriteBuffer& outfile) {
+            // Write header with only input parameter names (output parameters are already in input)
+            bool first_column = true;
+            for (const string& param : input_parameter_names) {
+                if (!first_column) outfile << ",";
+                outfile << param;
+                first_column = false;
             }
-            
             outfile << "\n";
-        }
-        
-        outfile.close();
-        Log::info("Written sliced file: %s with %d time steps (normalized values)\n", filename.c_str(), time_steps);
+
+            int32_t time_steps = inputs[0].size();
+            int32_t num_input_params = inputs.size();
+
+            // Write data rows (each row is a time step) - only input values since output parameters are already in input
+            for (int32_t t = 0; t < time_steps; t++) {
+                bool first_value = true;
+
+                // Write only input values for this time step (normalized)
+                for (int32_t param = 0; param < num_input_params; param++) {
+                    if (!first_value) outfile << ",";
+                    outfile << inputs[param][t];
+                    first_value = false;
+                }
+
+                outfile << "\n";
+            }
+        });
+        Log::debug("Queued sliced file: %s with %d time steps (normalized values)\n", filename.c_str(), time_steps);
     }
 }
 
 int main(int argc, char** argv) {
     std::cout << "Starting ONENAS MPI Program" << std::endl;
-    MPI_Init(&argc, &argv);
+    // the training threads of a worker never make MPI calls, only the main thread of each process does
+    int32_t provided;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
     std::cout << "MPI initialized" << std::endl;
     int32_t rank, max_rank;
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
@@ -552,22 +1161,65 @@ int main(int argc, char** argv) {
     Log::restrict_to_rank(0);
     std::cout << "Initialized log!" << std::endl;
 
+    // the threads per rank need the main thread to be able to make MPI calls while they run
+    if (provided < MPI_THREAD_FUNNELED) {
+        Log::fatal(
+            "ERROR: the MPI library only provides thread support level %d, onenas_mpi needs MPI_THREAD_FUNNELED (%d)\n",
+            provided, MPI_THREAD_FUNNELED
+        );
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
     // Load required parameters
     get_argument(arguments, "--number_islands", true, number_islands);
     get_argument(arguments, "--generated_population_size", true, generated_population_size);
     get_argument(arguments, "--output_directory", true, output_directory);
 
+    // running one rank per socket with a thread per core shares the data between the threads and needs far fewer
+    // MPI messages than one rank per core
+    get_argument(arguments, "--threads_per_rank", false, threads_per_rank);
+    if (threads_per_rank < 1) {
+        Log::fatal("ERROR: --threads_per_rank must be at least 1, it was %d\n", threads_per_rank);
+        exit(1);
+    }
+
+    // checkpoints let a search which died (or was stopped) be resumed with --resume_from <checkpoint file>
+    get_argument(arguments, "--checkpoint_frequency", false, checkpoint_frequency);
+    if (checkpoint_frequency < 0) {
+        Log::fatal("ERROR: --checkpoint_frequency must be at least 0, it was %d\n", checkpoint_frequency);
+        exit(1);
+    }
+    get_argument(arguments, "--resume_from", false, resume_from);
+
+    get_argument(arguments, "--dispatch_order", false, dispatch_order);
+    if (dispatch_order != "fifo" && dispatch_order != "longest_first") {
+        Log::fatal("ERROR: --dispatch_order must be fifo or longest_first, it was '%s'\n", dispatch_order.c_str());
+        exit(1);
+    }
+
+    if (!get_genome_limits(arguments, genome_limits)) {
+        exit(1);
+    }
+
+    // the master writes the predictions and stats files in the background instead of stalling the workers at the
+    // end of each generation
+    if (rank == 0) {
+        AsyncWriter::initialize(arguments);
+    }
+
     // Log::info("ONENAS will generate %d genomes per generation\n", generated_population_size * number_islands);
     Log::info("Output directory: %s\n", output_directory.c_str());
 
     TimeSeriesSets* time_series_sets = NULL;
     time_series_sets = TimeSeriesSets::generate_from_arguments(arguments);
-    slice_online_time_series(
-        arguments, time_series_sets, time_series_inputs, time_series_outputs
-    );
+    time_series_windows = slice_online_time_series(arguments, time_series_sets);
     Log::major_divider(Log::INFO, "Sliced time series!");
-    Log::info("Time series inputs shape: %d, %d, %d \n", time_series_inputs.size(), time_series_inputs[0].size(), time_series_inputs[0][0].size());
-    Log::info("Time series outputs shape: %d, %d, %d \n", time_series_outputs.size(), time_series_outputs[0].size(), time_series_outputs[0][0].size());
+    if (time_series_windows->get_number_windows() == 0) {
+        Log::fatal("ERROR: no training time series is long enough for a window of --time_series_length\n");
+        exit(1);
+    }
+    Log::info("Time series inputs shape: %d, %d, %d \n", time_series_windows->get_number_windows(), time_series_windows->get_number_inputs(), time_series_windows->get_window(0).length);
+    Log::info("Time series outputs shape: %d, %d, %d \n", time_series_windows->get_number_windows(), time_series_windows->get_number_outputs(), time_series_windows->get_window(0).length);
     
     // Check if user wants to write sliced files and write them if requested
     if (argument_exists(arguments, "--write_sliced_files") && rank == 0) {
@@ -575,13 +1227,13 @@ int main(int argc, char** argv) {
         vector<string> input_parameter_names = time_series_sets->get_input_parameter_names();
         vector<string> output_parameter_names = time_series_sets->get_output_parameter_names();
         
-        write_sliced_files(time_series_inputs, time_series_outputs, 
+        write_sliced_files(time_series_windows,
                           input_parameter_names, output_parameter_names, 
                           sliced_files_directory);
         Log::info("Sliced files written to: %s (normalized values)\n", sliced_files_directory.c_str());
     }
     
-    int32_t num_sets = time_series_inputs.size();
+    int32_t num_sets = time_series_windows->get_number_windows();
     Log::info("Time series number of sets after slicing: %d\n", num_sets);
     OnlineSeries* online_series = new OnlineSeries(num_sets, arguments);
 
@@ -594,15 +1246,26 @@ int main(int argc, char** argv) {
     }
     Log::info("Total generation is set to: %d\n", total_generation);
 
+    // when > 0, the elites are warm start trained on each newly arrived episode for this many steps before they are
+    // re-evaluated, instead of only being re-evaluated
+    get_argument(arguments, "--elite_fine_tune_steps", false, elite_fine_tune_steps);
+    // fine tuning runs on the master and holds up the next generation, this caps the steps over all elites (0 is no
+    // cap, leaving elite_fine_tune_steps times the number of elites)
+    get_argument(arguments, "--elite_fine_tune_max_steps", false, elite_fine_tune_max_steps);
+    if (elite_fine_tune_steps < 0 || elite_fine_tune_max_steps < 0) {
+        Log::fatal(
+            "ERROR: --elite_fine_tune_steps (%d) and --elite_fine_tune_max_steps (%d) must be at least 0\n",
+            elite_fine_tune_steps, elite_fine_tune_max_steps
+        );
+        exit(1);
+    }
+
     
     // Initialize episode management system
     Log::info("Initializing episode management system\n");
-    online_series->initialize_episodes(time_series_inputs, time_series_outputs);
+    online_series->initialize_episodes(time_series_windows);
     online_series->print_episode_stats();
     
-    // Optional: Clear global vectors to save memory if episodes are being used
-    // time_series_inputs.clear();
-    // time_series_outputs.clear();
     Log::info("Episode management initialization complete\n");
 
     weight_update_method = new WeightUpdate();
@@ -622,15 +1285,31 @@ int main(int argc, char** argv) {
 
     Log::clear_rank_restriction();
 
+    int32_t start_generation = 0;
     if (rank == 0) {
         onenas = generate_onenas_from_arguments(arguments, time_series_sets, weight_rules, seed_genome);
         Log::major_divider(Log::INFO, "Created ONENAS!");
+
+        if (resume_from != "") {
+            start_generation = read_checkpoint(resume_from, online_series);
+        }
         
         // Initialize CSV files for logging (only on master process)
-        initialize_csv_files();
+        initialize_csv_files(resume_from != "", start_generation);
     }
+    // the workers only need to know which generation the search is on
+    MPI_Bcast(&start_generation, 1, MPI_INT, 0, MPI_COMM_WORLD);
 
-    for (int32_t  current_generation = 0; current_generation < total_generation; current_generation ++) {
+    if (rank == 0) {
+        // the cost model is not checkpointed, a resumed search calibrates it again
+        cost_model = new GenomeCostModel();
+        dispatched_genomes = new DispatchedGenomes(genome_limits);
+        terminated_generation.assign(max_rank, start_generation - 1);
+        genomes_sent_to.assign(max_rank, 0);
+        genomes_received_from.assign(max_rank, 0);
+    }
+
+    for (int32_t current_generation = start_generation; current_generation < total_generation; current_generation++) {
         online_series->set_current_index(current_generation);
 
         if (rank ==0) {
@@ -642,9 +1321,10 @@ int main(int argc, char** argv) {
             
             master(max_rank, online_series, current_generation);           
         } else {
-            worker(rank, online_series);
+            worker(rank, online_series, current_generation);
         }
-        MPI_Barrier(MPI_COMM_WORLD);
+
+        // workers go on to the next generation while the master finalizes this one
         if (rank == 0) {
             Log::minor_divider(Log::INFO);
             vector <int32_t> validation_index;
@@ -669,6 +1349,30 @@ int main(int argc, char** argv) {
             // Finalize generation and get elite genomes for PER updates
             OneNasIslandSpeciationStrategy* onenas_strategy = dynamic_cast<OneNasIslandSpeciationStrategy*>(onenas->get_speciation_strategy());
             vector<RNN_Genome*> elite_genomes;
+            if (onenas_strategy != nullptr && elite_fine_tune_steps > 0) {
+                int32_t newest_index = online_series->get_newest_training_index();
+                TimeSeriesEpisode* newest_episode = online_series->get_episode(newest_index);
+                if (newest_episode != nullptr) {
+                    vector< vector< vector<double> > > newest_inputs(1);
+                    vector< vector< vector<double> > > newest_outputs(1);
+                    newest_episode->export_data(newest_inputs[0], newest_outputs[0]);
+                    Log::info("Fine tuning elites on newest training episode ID: %d\n", newest_index);
+                    std::chrono::time_point<std::chrono::steady_clock> fine_tune_start = std::chrono::steady_clock::now();
+                    int32_t fine_tune_steps = onenas_strategy->fine_tune_elite_population(
+                        newest_inputs, newest_outputs, elite_fine_tune_steps, elite_fine_tune_max_steps,
+                        weight_update_method
+                    );
+                    Log::info(
+                        "Generation %d: fine tuning the elites took %d steps and %lld ms\n", current_generation,
+                        fine_tune_steps,
+                        (long long) std::chrono::duration_cast<std::chrono::milliseconds>(
+                            std::chrono::steady_clock::now() - fine_tune_start
+                        ).count()
+                    );
+                } else {
+                    Log::error("Newest training episode ID %d not found in episodes\n", newest_index);
+                }
+            }
             if (onenas_strategy != nullptr) {
                 elite_genomes = onenas_strategy->finalize_generation_with_genomes(current_generation, current_validation_inputs, current_validation_outputs, current_test_inputs, current_test_outputs);
             } else {
@@ -691,17 +1395,16 @@ int main(int argc, char** argv) {
                 Log::debug("Training method is %s - skipping priority updates\n", online_series->get_training_method().c_str());
             }
             
-            // Clean up elite genome copies (they were created in finalize_generation)
-            for (RNN_Genome* genome : elite_genomes) {
-                if (genome != NULL) {
-                    delete genome;
-                }
-            }
+            // the elite genomes are owned by the speciation strategy, not copies
             elite_genomes.clear();
             
             Log::info("MPI Generation %d priority update complete\n", current_generation);
             
             onenas->update_log();
+
+            if (checkpoint_frequency > 0 && (current_generation + 1) % checkpoint_frequency == 0) {
+                write_checkpoint(current_generation + 1, online_series);
+            }
             
             // Track memory usage at end of generation
             Log::log_memory_usage("Generation " + std::to_string(current_generation) + " end");
@@ -713,11 +1416,19 @@ int main(int argc, char** argv) {
     
     // Close CSV files (only on master process)
     if (rank == 0) {
+        bool workers_finished = finish_workers(max_rank, total_generation - 1);
         close_csv_files();
+        if (!workers_finished) {
+            // the search is done and written, but MPI_Finalize would wait on the hung workers
+            Log::warning("aborting the hung workers\n");
+            MPI_Abort(MPI_COMM_WORLD, 0);
+        }
         
         // Clean up memory on master process
         Log::log_memory_usage("Before cleanup");
         delete onenas;
+        delete cost_model;
+        delete dispatched_genomes;
         delete online_series;
         delete weight_update_method;
         Log::log_memory_usage("After cleanup");
@@ -729,11 +1440,11 @@ int main(int argc, char** argv) {
     Log::release_id("main_" + to_string(rank));
     MPI_Finalize();
 
+    // the windows reference the time series sets' columns
+    delete time_series_windows;
     delete time_series_sets;
     
     // Clear global vectors to free memory
-    time_series_inputs.clear();
-    time_series_outputs.clear();
     time_series_index.clear();
     
     return 0;
@@ -0,0 +1,68 @@
+#include <atomic>
+using std::atomic;
+
+#include <string>
+using std::string;
+using std::to_string;
+
+#include <thread>
+using std::thread;
+
+#include <vector>
+using std::vector;
+
+#include "common/arguments.hxx"
+#include "common/async_writer.hxx"
+#include "common/log.hxx"
+#include "kfold_sweep.hxx"
+
+/**
+ *  Runs the same sweep as rnn_kfold_sweep on --number_threads threads of a single process, for machines without MPI.
+ */
+int main(int argc, char** argv) {
+    vector<string> arguments = vector<string>(argv, argv + argc);
+
+    Log::initialize(arguments);
+    Log::set_id("main");
+
+    int32_t number_threads;
+    get_argument(arguments, "--number_threads", true, number_threads);
+    if (number_threads < 1) {
+        Log::fatal("ERROR: --number_threads must be at least 1, it was %d\n", number_threads);
+        exit(1);
+    }
+
+    KFoldSweep* sweep = new KFoldSweep(arguments);
+
+    AsyncWriter::initialize(arguments);
+    sweep->open_results();
+
+    vector<int32_t> job_order = sweep->get_job_order();
+    atomic<int32_t> next_job(0);
+
+    vector<thread> threads;
+    for (int32_t i = 0; i < number_threads; i++) {
+        string log_id = "worker_" + to_string(i);
+
+        threads.push_back(thread([sweep, &job_order, &next_job, log_id]() {
+            Log::set_id(log_id);
+            for (int32_t job = next_job++; job < (int32_t) job_order.size(); job = next_job++) {
+                sweep->record_result(sweep->run_job(job_order[job], log_id));
+            }
+            Log::release_id(log_id);
+        }));
+    }
+
+    for (int32_t i = 0; i < number_threads; i++) {
+        threads[i].join();
+    }
+
+    AsyncWriter::sync(true);
+    AsyncWriter::shutdown();
+    delete sweep;
+
+    Log::info("completed!\n");
+    Log::release_id("main");
+
+    return 0;
+}
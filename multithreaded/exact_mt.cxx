@@ -22,6 +22,7 @@ using std::thread;
 #include <vector>
 using std::vector;
 
+#include "cnn/batch_thread_pool.hxx"
 #include "cnn/exact.hxx"
 #include "common/arguments.hxx"
 #include "image_tools/image_set.hxx"
@@ -32,10 +33,15 @@ vector<string> arguments;
 
 EXACT* exact;
 
+// shared by all the genome threads to split their mini-batches across (batch-level parallelism)
+BatchThreadPool* batch_thread_pool = NULL;
+
 bool finished = false;
 
 int32_t images_resize;
 
+string profile_directory = "";
+
 void exact_thread(
     const Images& training_images, const Images& validation_images, const Images& testing_images, int32_t id
 ) {
@@ -49,6 +55,12 @@ void exact_thread(
         }
 
         genome->set_name("thread_" + to_string(id));
+        genome->set_batch_thread_pool(batch_thread_pool);
+        if (profile_directory.compare("") != 0) {
+            genome->set_profile_filename(
+                profile_directory + "/genome_" + to_string(genome->get_generation_id()) + "_profile.csv"
+            );
+        }
         genome->initialize();
         genome->stochastic_backpropagation(training_images, images_resize, validation_images);
         genome->evaluate_test(testing_images);
@@ -65,9 +77,17 @@ void exact_thread(
 int main(int argc, char** argv) {
     arguments = vector<string>(argv, argv + argc);
 
+    // --number_threads genomes are trained concurrently, and each of them can split its mini-batches across a pool
+    // of --batch_threads helper threads which is shared by all the genomes
     int32_t number_threads;
     get_argument(arguments, "--number_threads", true, number_threads);
 
+    int32_t batch_threads = 0;
+    get_argument(arguments, "--batch_threads", false, batch_threads);
+
+    int32_t min_batch_slice = 4;
+    get_argument(arguments, "--min_batch_slice", false, min_batch_slice);
+
     int32_t padding;
     get_argument(arguments, "--padding", true, padding);
 
@@ -106,6 +126,14 @@ int main(int argc, char** argv) {
 
     get_argument(arguments, "--images_resize", true, images_resize);
 
+    // per edge/node timing profiles are written for every epoch of every genome if this is specified
+    get_argument(arguments, "--profile_directory", false, profile_directory);
+    bool annotate_hot_spots = argument_exists(arguments, "--annotate_hot_spots");
+
+    // keep a pareto front of validation error and inference cost (calibrated "operations" or measured "latency")
+    string multi_objective_cost = "none";
+    get_argument(arguments, "--multi_objective_cost", false, multi_objective_cost);
+
     Images training_images(training_filename, padding);
     Images validation_images(
         validation_filename, padding, training_images.get_average(), training_images.get_std_dev()
@@ -126,6 +154,21 @@ int main(int argc, char** argv) {
 #ifdef _MYSQL_
     }
 #endif
+    exact->set_annotate_hot_spots(annotate_hot_spots);
+
+    if (multi_objective_cost.compare("operations") == 0) {
+        exact->set_multi_objective_cost(EXACT_COST_OPERATIONS);
+    } else if (multi_objective_cost.compare("latency") == 0) {
+        exact->set_multi_objective_cost(EXACT_COST_LATENCY);
+    } else if (multi_objective_cost.compare("none") != 0) {
+        cerr << "ERROR: unknown --multi_objective_cost '" << multi_objective_cost
+             << "', options are none, operations or latency" << endl;
+        exit(1);
+    }
+
+    if (batch_threads > 0) {
+        batch_thread_pool = new BatchThreadPool(batch_threads, min_batch_slice);
+    }
 
     vector<thread> threads;
     for (int32_t i = 0; i < number_threads; i++) {
@@ -138,6 +181,10 @@ int main(int argc, char** argv) {
 
     finished = true;
 
+    if (batch_thread_pool != NULL) {
+        delete batch_thread_pool;
+    }
+
     cout << "completed!" << endl;
 
     return 0;
@@ -0,0 +1,50 @@
+#include "drift_detector.hxx"
+
+DriftDetector::DriftDetector(double _delta, double _threshold) : delta(_delta), threshold(_threshold) {
+    reset();
+}
+
+bool DriftDetector::observe(double value) {
+    number_observations++;
+    mean += (value - mean) / number_observations;
+
+    cumulative_sum += value - mean - delta;
+    if (cumulative_sum < minimum_sum) {
+        minimum_sum = cumulative_sum;
+    }
+
+    if (cumulative_sum - minimum_sum > threshold) {
+        reset();
+        return true;
+    }
+    return false;
+}
+
+void DriftDetector::reset() {
+    number_observations = 0;
+    mean = 0.0;
+    cumulative_sum = 0.0;
+    minimum_sum = 0.0;
+}
+
+double DriftDetector::get_statistic() const {
+    return cumulative_sum - minimum_sum;
+}
+
+int32_t DriftDetector::get_number_observations() const {
+    return number_observations;
+}
+
+void DriftDetector::write_checkpoint(ostream& out) const {
+    out.write((char*) &number_observations, sizeof(int32_t));
+    out.write((char*) &mean, sizeof(double));
+    out.write((char*) &cumulative_sum, sizeof(double));
+    out.write((char*) &minimum_sum, sizeof(double));
+}
+
+void DriftDetector::read_checkpoint(istream& in) {
+    in.read((char*) &number_observations, sizeof(int32_t));
+    in.read((char*) &mean, sizeof(double));
+    in.read((char*) &cumulative_sum, sizeof(double));
+    in.read((char*) &minimum_sum, sizeof(double));
+}
@@ -0,0 +1,55 @@
+#ifndef ONENAS_DRIFT_DETECTOR_HXX
+#define ONENAS_DRIFT_DETECTOR_HXX
+
+#include <cstdint>
+
+#include <iostream>
+using std::istream;
+using std::ostream;
+
+/**
+ * Page-Hinkley test for an increase in the mean of a stream of values, used to notice when the data stream has
+ * drifted away from what the population was trained on. The test keeps the cumulative sum of how far each value was
+ * above the running mean (less a tolerance of delta per value) and signals drift when that sum rises more than
+ * threshold above its minimum. Decreases are never flagged, as errors going down is what evolution should be doing.
+ */
+class DriftDetector {
+    private:
+        double delta;     /**< Deviations above the mean smaller than this are treated as noise. */
+        double threshold; /**< How far the cumulative sum has to rise above its minimum to signal drift. */
+
+        int32_t number_observations;
+        double mean;
+        double cumulative_sum;
+        double minimum_sum;
+
+    public:
+        DriftDetector(double _delta, double _threshold);
+
+        /**
+         * Adds the next value of the stream.
+         *
+         * \return true if drift was detected, in which case the test restarts from the next value
+         */
+        bool observe(double value);
+
+        /**
+         * Forgets the values seen so far.
+         */
+        void reset();
+
+        /**
+         * \return how far the cumulative sum currently is above its minimum
+         */
+        double get_statistic() const;
+
+        int32_t get_number_observations() const;
+
+        /**
+         * Writes and reads the state of the test for checkpoints, delta and threshold come from the arguments.
+         */
+        void write_checkpoint(ostream& out) const;
+        void read_checkpoint(istream& in);
+};
+
+#endif
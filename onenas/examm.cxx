@@ -1,4 +1,5 @@
 #include <algorithm>
+using std::max;
 using std::sort;
 
 #include <chrono>
@@ -280,6 +281,14 @@ void EXAMM::mutate(int32_t max_mutations, RNN_Genome* g) {
         g->get_mu_sigma(g->best_parameters, mu, sigma);
     }
 
+    // the optimizer state goes with the best parameters, so it is keyed by innovation number before the mutations
+    // change the structure and mapped back onto whatever structure results
+    map<tuple<int32_t, int32_t, int32_t>, pair<double, double> > optimizer_state;
+    if (g->best_parameters.size() > 0) {
+        g->get_optimizer_state(optimizer_state);
+    }
+    int32_t optimizer_epochs = g->get_optimizer_epochs();
+
     int32_t number_mutations = 0;
 
     for (;;) {
@@ -388,6 +397,7 @@ void EXAMM::mutate(int32_t max_mutations, RNN_Genome* g) {
 
     g->get_weights(new_parameters);
     g->initial_parameters = new_parameters;
+    g->set_optimizer_state(optimizer_state, optimizer_epochs);
 
     if (Log::at_level(Log::DEBUG)) {
         g->get_mu_sigma(new_parameters, mu, sigma);
@@ -835,6 +845,12 @@ RNN_Genome* EXAMM::crossover(RNN_Genome* p1, RNN_Genome* p2) {
             WEIGHT_TYPES_STRING[weight_inheritance].c_str(), WEIGHT_TYPES_STRING[weight_inheritance].c_str()
         );
         child->initialize_randomly(weight_rules);
+    } else {
+        // the more fit parent's optimizer state takes precedence for the weights both parents have
+        map<tuple<int32_t, int32_t, int32_t>, pair<double, double> > optimizer_state;
+        p1->get_optimizer_state(optimizer_state);
+        p2->get_optimizer_state(optimizer_state);
+        child->set_optimizer_state(optimizer_state, max(p1->get_optimizer_epochs(), p2->get_optimizer_epochs()));
     }
 
     child->get_weights(new_parameters);
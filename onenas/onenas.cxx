@@ -1,4 +1,9 @@
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include <algorithm>
+using std::max;
 using std::sort;
 
 #include <chrono>
@@ -16,12 +21,18 @@ using std::setw;
 
 #include <iostream>
 using std::endl;
+using std::istream;
+using std::ostream;
 
 #include <random>
 using std::minstd_rand0;
 using std::uniform_int_distribution;
 using std::uniform_real_distribution;
 
+#include <sstream>
+using std::istringstream;
+using std::ostringstream;
+
 #include <string>
 using std::string;
 using std::to_string;
@@ -60,14 +71,16 @@ ONENAS::~ONENAS() {
 
 ONENAS::ONENAS(
     int32_t _number_islands, SpeciationStrategy* _speciation_strategy,
-    WeightRules* _weight_rules, GenomeProperty* _genome_property, string _output_directory, string _save_genome_option
+    WeightRules* _weight_rules, GenomeProperty* _genome_property, string _output_directory, string _save_genome_option,
+    bool _append_log
 )
     : number_islands(_number_islands),
       speciation_strategy(_speciation_strategy),
       weight_rules(_weight_rules),
       genome_property(_genome_property),
       output_directory(_output_directory),
-      save_genome_option(_save_genome_option) {
+      save_genome_option(_save_genome_option),
+      append_log(_append_log) {
     total_bp_epochs = 0;
     edge_innovation_count = 0;
     node_innovation_count = 0;
@@ -112,11 +125,15 @@ void ONENAS::generate_log() {
     if (output_directory != "") {
         Log::info("Generating fitness log\n");
         mkpath(output_directory.c_str(), 0777);
-        log_file = new ofstream(output_directory + "/" + "fitness_log.csv");
-        (*log_file) << "Inserted Genomes, Total BP Epochs, Time, Best Val. MAE, Best Val. MSE, Enabled Nodes, Enabled "
-                       "Edges, Enabled Rec. Edges";
-        (*log_file) << speciation_strategy->get_strategy_information_headers();
-        (*log_file) << endl;
+        if (append_log) {
+            log_file = new ofstream(output_directory + "/" + "fitness_log.csv", std::ios_base::app);
+        } else {
+            log_file = new ofstream(output_directory + "/" + "fitness_log.csv");
+            (*log_file) << "Inserted Genomes, Total BP Epochs, Time, Best Val. MAE, Best Val. MSE, Enabled Nodes, "
+                           "Enabled Edges, Enabled Rec. Edges";
+            (*log_file) << speciation_strategy->get_strategy_information_headers();
+            (*log_file) << endl;
+        }
 
     } else {
         log_file = NULL;
@@ -144,6 +161,11 @@ void ONENAS::update_log() {
         if (best_genome == NULL) {
             best_genome = speciation_strategy->get_global_best_genome();
         }
+        if (best_genome == NULL) {
+            // every genome so far failed or was dropped, so there is nothing to log yet
+            Log::warning("no genome has been evaluated yet, not updating the ONENAS log\n");
+            return;
+        }
         std::chrono::time_point<std::chrono::system_clock> currentClock = std::chrono::system_clock::now();
         long milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(currentClock - startClock).count();
         (*log_file) << speciation_strategy->get_evaluated_genomes() << "," << total_bp_epochs << "," << milliseconds
@@ -275,6 +297,14 @@ void ONENAS::mutate(int32_t max_mutations, RNN_Genome* g) {
         g->get_mu_sigma(g->best_parameters, mu, sigma);
     }
 
+    // the optimizer state goes with the best parameters, so it is keyed by innovation number before the mutations
+    // change the structure and mapped back onto whatever structure results
+    map<tuple<int32_t, int32_t, int32_t>, pair<double, double> > optimizer_state;
+    if (g->best_parameters.size() > 0) {
+        g->get_optimizer_state(optimizer_state);
+    }
+    int32_t optimizer_epochs = g->get_optimizer_epochs();
+
     int32_t number_mutations = 0;
 
     for (;;) {
@@ -383,6 +413,7 @@ void ONENAS::mutate(int32_t max_mutations, RNN_Genome* g) {
 
     g->get_weights(new_parameters);
     g->initial_parameters = new_parameters;
+    g->set_optimizer_state(optimizer_state, optimizer_epochs);
 
     if (Log::at_level(Log::DEBUG)) {
         g->get_mu_sigma(new_parameters, mu, sigma);
@@ -829,6 +860,12 @@ RNN_Genome* ONENAS::crossover(RNN_Genome* p1, RNN_Genome* p2) {
             WEIGHT_TYPES_STRING[weight_inheritance].c_str(), WEIGHT_TYPES_STRING[weight_inheritance].c_str()
         );
         child->initialize_randomly(weight_rules);
+    } else {
+        // the more fit parent's optimizer state takes precedence for the weights both parents have
+        map<tuple<int32_t, int32_t, int32_t>, pair<double, double> > optimizer_state;
+        p1->get_optimizer_state(optimizer_state);
+        p2->get_optimizer_state(optimizer_state);
+        child->set_optimizer_state(optimizer_state, max(p1->get_optimizer_epochs(), p2->get_optimizer_epochs()));
     }
 
     child->get_weights(new_parameters);
@@ -955,4 +992,103 @@ void ONENAS::finalize_generation(int32_t current_generation, const vector< vecto
     // string filename = output_directory + "/generation_" + std::to_string(current_generation);
 
     speciation_strategy->finalize_generation(current_generation, validation_input, validation_output, test_input, test_output);
-}
\ No newline at end of file
+}
+void ONENAS::write_checkpoint(ostream& out) {
+    OneNasIslandSpeciationStrategy* onenas_strategy =
+        dynamic_cast<OneNasIslandSpeciationStrategy*>(speciation_strategy);
+    if (onenas_strategy == nullptr) {
+        Log::fatal("ERROR: checkpoints are only supported with the onenas speciation strategy\n");
+        exit(1);
+    }
+
+    out.write((char*) &edge_innovation_count, sizeof(int32_t));
+    out.write((char*) &node_innovation_count, sizeof(int32_t));
+    out.write((char*) &total_bp_epochs, sizeof(int32_t));
+
+    // the time column of the fitness log carries on from where the checkpoint was written
+    int64_t milliseconds =
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now() - startClock).count();
+    out.write((char*) &milliseconds, sizeof(int64_t));
+
+    ostringstream generator_oss;
+    generator_oss << generator;
+    write_binary_string(out, generator_oss.str(), "generator");
+
+    out.write((char*) &add_edge_rate, sizeof(double));
+    out.write((char*) &add_recurrent_edge_rate, sizeof(double));
+    out.write((char*) &add_node_rate, sizeof(double));
+
+    // how far the fitness log was written, so a resumed search can drop the rows logged after the checkpoint
+    int64_t log_length = -1;
+    if (log_file != NULL) {
+        log_file->flush();
+        log_length = (int64_t) log_file->tellp();
+
+        // the checkpoint is synced to disk, so the rows up to log_length have to be as well or a crash could leave the
+        // log shorter than the checkpoint says
+        string output_file = output_directory + "/fitness_log.csv";
+        int log_descriptor = open(output_file.c_str(), O_WRONLY);
+        if (log_descriptor < 0 || fsync(log_descriptor) != 0) {
+            Log::warning("could not sync '%s', a search resumed from this checkpoint will not truncate it\n",
+                         output_file.c_str());
+            log_length = -1;
+        }
+        if (log_descriptor >= 0) {
+            close(log_descriptor);
+        }
+    }
+    out.write((char*) &log_length, sizeof(int64_t));
+
+    onenas_strategy->write_checkpoint(out);
+}
+
+bool ONENAS::read_checkpoint(istream& in) {
+    OneNasIslandSpeciationStrategy* onenas_strategy =
+        dynamic_cast<OneNasIslandSpeciationStrategy*>(speciation_strategy);
+    if (onenas_strategy == nullptr) {
+        Log::fatal("ERROR: checkpoints are only supported with the onenas speciation strategy\n");
+        return false;
+    }
+
+    in.read((char*) &edge_innovation_count, sizeof(int32_t));
+    in.read((char*) &node_innovation_count, sizeof(int32_t));
+    in.read((char*) &total_bp_epochs, sizeof(int32_t));
+
+    int64_t milliseconds;
+    in.read((char*) &milliseconds, sizeof(int64_t));
+    startClock = std::chrono::system_clock::now() - std::chrono::milliseconds(milliseconds);
+
+    string generator_str;
+    read_binary_string(in, generator_str, "generator");
+    istringstream generator_iss(generator_str);
+    generator_iss >> generator;
+
+    in.read((char*) &add_edge_rate, sizeof(double));
+    in.read((char*) &add_recurrent_edge_rate, sizeof(double));
+    in.read((char*) &add_node_rate, sizeof(double));
+
+    int64_t log_length;
+    in.read((char*) &log_length, sizeof(int64_t));
+    if (log_file != NULL && log_length >= 0) {
+        // rows for the generations after the checkpoint would otherwise be in the fitness log twice
+        string output_file = output_directory + "/fitness_log.csv";
+        log_file->close();
+        // truncate would pad a log shorter than the checkpoint's length with zeros
+        struct stat log_stat;
+        if (stat(output_file.c_str(), &log_stat) != 0 || (int64_t) log_stat.st_size < log_length) {
+            Log::warning("'%s' is shorter than when the checkpoint was written, it is missing generations and was not "
+                         "truncated\n", output_file.c_str());
+        } else if (truncate(output_file.c_str(), (off_t) log_length) != 0) {
+            Log::warning("could not truncate '%s' to the checkpoint, it may repeat generations\n", output_file.c_str());
+        }
+        log_file->open(output_file, std::ios_base::app);
+    }
+
+    if (!onenas_strategy->read_checkpoint(in)) {
+        return false;
+    }
+
+    Log::info("ONENAS: Restored checkpoint, edge innovation count: %d, node innovation count: %d\n",
+              edge_innovation_count, node_innovation_count);
+    return true;
+}
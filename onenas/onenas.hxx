@@ -4,6 +4,10 @@
 #include <fstream>
 using std::ofstream;
 
+#include <iostream>
+using std::istream;
+using std::ostream;
+
 #include <map>
 using std::map;
 
@@ -79,12 +83,13 @@ class ONENAS {
 
     string genome_file_name;
     string save_genome_option;
+    bool append_log; /**< resumed searches append to the fitness log instead of starting a new one */
 
    public:
     ONENAS(
         int32_t _number_islands, SpeciationStrategy* _speciation_strategy,
         WeightRules* _weight_rules, GenomeProperty* _genome_property, string _output_directory,
-        string _save_genome_option
+        string _save_genome_option, bool _append_log = false
     );
 
     ~ONENAS();
@@ -139,6 +144,14 @@ class ONENAS {
      */
     void reduce_add_mutation_rates(double factor = 0.5);
 
+    /**
+     * Writes the innovation counters, random number generator, mutation rates and the speciation strategy's islands
+     * to a checkpoint, so a search can be resumed from the end of a generation with read_checkpoint, which returns
+     * false (after logging why) if the checkpoint does not fit this search.
+     */
+    void write_checkpoint(ostream& out);
+    bool read_checkpoint(istream& in);
+
     void finalize_generation(int32_t current_generation, const vector< vector< vector<double> > > &validation_input, const vector< vector< vector<double> > > &validation_output, const vector< vector< vector<double> > > &test_input, const vector< vector< vector<double> > > &test_output);
 };
 
@@ -195,9 +195,9 @@ void OneNasIsland::get_elite_population_ids(vector<int32_t>& good_genome_ids) {
 //     }
 // }
 
-void OneNasIsland::erase_island() {
+void OneNasIsland::erase_island(vector<RNN_Genome*> &retired_elites) {
     erased_generation_id = latest_generation_id;
-    elite_population->erase_population();
+    elite_population->release_population(retired_elites);
     generated_population->erase_population();
     erased = true;
     erase_again = 5;
@@ -262,6 +262,15 @@ void OneNasIsland::evaluate_elite_population(const vector< vector< vector<double
     }
 }
 
+void OneNasIsland::fine_tune_elite_population(const vector< vector< vector<double> > > &inputs, const vector< vector< vector<double> > > &outputs, int32_t fine_tune_steps, WeightUpdate *weight_update_method) {
+    Log::info("Fine tuning elite population on island %d for %d steps\n", id, fine_tune_steps);
+    vector<RNN_Genome *> elite_genomes = elite_population->get_genomes();
+    int32_t elite_population_size = elite_population->get_population_size();
+    for (int32_t i = 0; i < elite_population_size; i++) {
+        elite_genomes[i]->fine_tune_online(inputs, outputs, fine_tune_steps, weight_update_method);
+    }
+}
+
 
 void OneNasIsland::select_elite_population() {
     // vector<RNN_Genome*> elite_genomes = Elite_population->get_genomes();
@@ -300,4 +309,25 @@ void OneNasIsland::generation_check() {
     } else {
         Log::error("Generation check: Island %d generated population is not empty, its size is %d\n", id, generated_size());
     }
-}
\ No newline at end of file
+}
+
+void OneNasIsland::write_checkpoint(ostream& out) {
+    out.write((char*) &erased_generation_id, sizeof(int32_t));
+    out.write((char*) &latest_generation_id, sizeof(int32_t));
+    out.write((char*) &status, sizeof(int32_t));
+    out.write((char*) &erase_again, sizeof(int32_t));
+    out.write((char*) &erased, sizeof(bool));
+
+    elite_population->write_checkpoint(out);
+    generated_population->write_checkpoint(out);
+}
+
+bool OneNasIsland::read_checkpoint(istream& in) {
+    in.read((char*) &erased_generation_id, sizeof(int32_t));
+    in.read((char*) &latest_generation_id, sizeof(int32_t));
+    in.read((char*) &status, sizeof(int32_t));
+    in.read((char*) &erase_again, sizeof(int32_t));
+    in.read((char*) &erased, sizeof(bool));
+
+    return elite_population->read_checkpoint(in) && generated_population->read_checkpoint(in);
+}
@@ -5,6 +5,10 @@
 using std::sort;
 using std::upper_bound;
 
+#include <iostream>
+using std::istream;
+using std::ostream;
+
 #include <random>
 using std::minstd_rand0;
 using std::uniform_real_distribution;
@@ -178,8 +182,10 @@ class OneNasIsland {
         
         /**
          * erases the entire island and set the erased_generation_id.
+         *
+         * \param retired_elites gets the elite genomes, which are not deleted so the caller can keep using them
          */
-        void erase_island();
+        void erase_island(vector<RNN_Genome*> &retired_elites);
 
         void erase_structure_map();
 
@@ -214,6 +220,12 @@ class OneNasIsland {
 
         void evaluate_elite_population(const vector< vector< vector<double> > > &validation_input, const vector< vector< vector<double> > > &validation_output);
 
+        /**
+         * Warm starts each elite genome from its best parameters and optimizer state and gives it fine_tune_steps
+         * passes over the given (newly arrived) episodes.
+         */
+        void fine_tune_elite_population(const vector< vector< vector<double> > > &inputs, const vector< vector< vector<double> > > &outputs, int32_t fine_tune_steps, WeightUpdate *weight_update_method);
+
         void select_elite_population();
 
         void write_prediction(string filename, const vector< vector< vector<double> > > &test_input, const vector< vector< vector<double> > > &test_output);
@@ -223,6 +235,12 @@ class OneNasIsland {
         void generation_check();
 
         void get_elite_population_ids(vector<int32_t>& good_genome_ids);
+
+        /**
+         * Writes and reads the status and both populations of this island for checkpoints.
+         */
+        void write_checkpoint(ostream& out);
+        bool read_checkpoint(istream& in);
 };
 
 #endif
@@ -3,6 +3,10 @@ using std::function;
 
 #include <chrono>
 
+#include <cmath>
+using std::fmax;
+using std::log;
+
 //#include <iostream>
 
 #include <random>
@@ -16,11 +20,16 @@ using std::string;
 #include <fstream>
 using std::ofstream;
 
+#include <sstream>
+using std::istringstream;
+using std::ostringstream;
+
 #include "examm.hxx"
 #include "rnn/rnn_genome.hxx"
 #include "onenas_island_speciation_strategy.hxx"
 #include "onenas.hxx"
 
+#include "common/async_writer.hxx"
 #include "common/files.hxx"
 #include "common/log.hxx"
 
@@ -39,6 +48,7 @@ OneNasIslandSpeciationStrategy::OneNasIslandSpeciationStrategy(
                         generation_island(0),
                         number_of_islands(_number_of_islands),
                         generated_population_size(_generated_population_size),
+                        island_capacity(_generated_population_size),
                         elite_population_size(_elite_population_size),
                         mutation_rate(_mutation_rate),
                         intra_island_crossover_rate(_intra_island_crossover_rate),
@@ -58,6 +68,14 @@ OneNasIslandSpeciationStrategy::OneNasIslandSpeciationStrategy(
                         genome_better_count(0),
                         control_size_method(_control_size_method),
                         compare_with_naive(_compare_with_naive),
+                        adaptive_generation_budget(false),
+                        min_generated_population_size(_generated_population_size),
+                        max_generated_population_size(_generated_population_size),
+                        drift_stable_generations(0),
+                        generations_since_drift(0),
+                        validation_drift_detector(NULL),
+                        naive_drift_detector(NULL),
+                        naive_mse_ratio(-1.0),
                         onenas_instance(nullptr) {
     double rate_sum = mutation_rate + intra_island_crossover_rate + inter_island_crossover_rate;
     if (rate_sum != 1.0) {
@@ -94,6 +112,17 @@ OneNasIslandSpeciationStrategy::~OneNasIslandSpeciationStrategy() {
         }
     }
     islands.clear();
+
+    free_retired_elite_genomes();
+
+    if (validation_drift_detector != NULL) {
+        delete validation_drift_detector;
+        validation_drift_detector = NULL;
+    }
+    if (naive_drift_detector != NULL) {
+        delete naive_drift_detector;
+        naive_drift_detector = NULL;
+    }
     
     Log::debug("OneNasIslandSpeciationStrategy destructor completed\n");
 }
@@ -627,17 +656,24 @@ void OneNasIslandSpeciationStrategy::write_global_best_prediction(int32_t curren
     // Get predictions for the global best genome
     vector< vector< vector<double> > > predictions = global_best_genome->get_predictions(parameters, test_input, test_output);
     
-    // Calculate performance comparison between naive and genome predictions (only if comparison is enabled)
-    if (compare_with_naive) {
+    // Calculate performance comparison between naive and genome predictions (only if comparison is enabled, or the
+    // generation budget is following drift in it)
+    naive_mse_ratio = -1.0;
+    if (compare_with_naive || adaptive_generation_budget) {
         double naive_mse = 0.0;
         double genome_mse = 0.0;
         if (calculate_prediction_performance(predictions, test_output, naive_mse, genome_mse)) {
-            update_performance_counters(current_generation, naive_mse, genome_mse);
+            if (compare_with_naive) {
+                update_performance_counters(current_generation, naive_mse, genome_mse);
+            }
+            if (naive_mse > 0.0) {
+                naive_mse_ratio = genome_mse / naive_mse;
+            }
         }
     }
     
     // Write predictions to file
-    write_prediction_file(filename, predictions, test_input, test_output);
+    write_prediction_file(filename, std::move(predictions), test_input, test_output);
 }
 
 void OneNasIslandSpeciationStrategy::set_erased_islands_status() {
@@ -651,7 +687,9 @@ void OneNasIslandSpeciationStrategy::set_erased_islands_status() {
 
 void OneNasIslandSpeciationStrategy::initialize_population(function<void(int32_t, RNN_Genome*)>& mutate, WeightRules* weight_rules) {
     for (int32_t i = 0; i < number_of_islands; i++) {
-        OneNasIsland* new_island = new OneNasIsland(i, generated_population_size, elite_population_size);
+        // islands keep this capacity when the generation budget changes, so a larger budget means more offspring
+        // competing for the same slots
+        OneNasIsland* new_island = new OneNasIsland(i, island_capacity, elite_population_size);
         // if (start_filled) {
         //     new_island->fill_with_mutated_genomes(seed_genome, seed_stirs, tl_epigenetic_weights, mutate);
         // }
@@ -661,21 +699,18 @@ void OneNasIslandSpeciationStrategy::initialize_population(function<void(int32_t
 }
 
 void OneNasIslandSpeciationStrategy::finalize_generation(int32_t current_generation, const vector< vector< vector<double> > > &validation_input, const vector< vector< vector<double> > > &validation_output, const vector< vector< vector<double> > > &test_input, const vector< vector< vector<double> > > &test_output) {
-    // Just call our PER-specific method since we no longer need to extract IDs
-    vector<RNN_Genome*> elite_genomes = finalize_generation_with_genomes(current_generation, validation_input, validation_output, test_input, test_output);
-    
-    // Clean up the elite genome copies since they're not needed by the base class interface
-    for (RNN_Genome* genome : elite_genomes) {
-        if (genome != NULL) {
-            delete genome;
-        }
-    }
-    
+    // Just call our PER-specific method since we no longer need to extract IDs, the returned elites are not copies
+    // so there is nothing to clean up
+    finalize_generation_with_genomes(current_generation, validation_input, validation_output, test_input, test_output);
+
     Log::info("Base class finalize_generation: completed for generation %d\n", current_generation);
 }
 
 vector<RNN_Genome*> OneNasIslandSpeciationStrategy::finalize_generation_with_genomes(int32_t current_generation, const vector< vector< vector<double> > > &validation_input, const vector< vector< vector<double> > > &validation_output, const vector< vector< vector<double> > > &test_input, const vector< vector< vector<double> > > &test_output) {
     Log::info("OneNAS Speciation Strategy: Finalizing generation %d\n", current_generation);
+    // the previous generation's elite genomes are no longer used
+    free_retired_elite_genomes();
+
     evaluate_elite_population(validation_input, validation_output);
     select_elite_population();
     generation_check();
@@ -686,8 +721,7 @@ vector<RNN_Genome*> OneNasIslandSpeciationStrategy::finalize_generation_with_gen
         vector<RNN_Genome*> island_elites = islands[i]->get_genomes();
         for (RNN_Genome* genome : island_elites) {
             if (genome != NULL) {
-                // Create a copy of the genome for return
-                elite_genomes.push_back(genome->copy());
+                elite_genomes.push_back(genome);
             }
         }
     }
@@ -713,7 +747,10 @@ vector<RNN_Genome*> OneNasIslandSpeciationStrategy::finalize_generation_with_gen
     }
     
     write_global_best_prediction(current_generation, test_input, test_output);
-    save_genome(global_best_genome);
+    // there is no best genome yet if every genome of the first generations failed or was dropped by the master
+    if (global_best_genome != NULL) {
+        save_genome(global_best_genome);
+    }
     
     // Check if we should trigger network size control (only when compare_with_naive is still enabled)
     if (compare_with_naive && current_generation > 10) {
@@ -725,11 +762,16 @@ vector<RNN_Genome*> OneNasIslandSpeciationStrategy::finalize_generation_with_gen
             
             // Apply network size control
             control_network_size(control_size_method);
-            generated_population_size = (int32_t)(std::floor(generated_population_size * 0.25));
-            if (generated_population_size < 1) {
-                generated_population_size = 1;
+            if (adaptive_generation_budget) {
+                // the drift detectors own the generated population size, it shrinks on its own while the stream is stable
+                Log::info("Generation %d: Generated population size is adaptive, leaving it at %d\n", current_generation, generated_population_size);
+            } else {
+                generated_population_size = (int32_t)(std::floor(generated_population_size * 0.25));
+                if (generated_population_size < 1) {
+                    generated_population_size = 1;
+                }
+                Log::info("Generation %d: Reduced generated population size to %d\n", current_generation, generated_population_size);
             }
-            Log::info("Generation %d: Reduced generated population size to %d\n", current_generation, generated_population_size);
             
             // Disable further comparisons - this only happens once
             compare_with_naive = false;
@@ -743,6 +785,10 @@ vector<RNN_Genome*> OneNasIslandSpeciationStrategy::finalize_generation_with_gen
         Log::info("Generation %d: Genome file saved (performance comparison disabled)\n", current_generation);
     }
     
+    if (adaptive_generation_budget) {
+        update_generation_budget(current_generation);
+    }
+
     if (repopulation_frequency != 0) {
         do_repopulation(current_generation);
     }
@@ -762,7 +808,8 @@ void OneNasIslandSpeciationStrategy::do_repopulation(int32_t current_generation)
             for (int32_t i = 0; i < islands_to_exterminate; i++){
                 if (rank[i] >= 0){
                     Log::info("found island: %d is the worst island\n",rank[0]);
-                    islands[rank[i]]->erase_island();
+                    // the erased elites were returned for the priority updates, so they are retired instead of deleted
+                    islands[rank[i]]->erase_island(retired_elite_genomes);
                     // islands[rank[i]]->erase_structure_map();
                     islands[rank[i]]->set_status(OneNasIsland::REPOPULATING);
                 }
@@ -777,10 +824,175 @@ void OneNasIslandSpeciationStrategy::do_repopulation(int32_t current_generation)
     
 }
 
+void OneNasIslandSpeciationStrategy::free_retired_elite_genomes() {
+    for (int32_t i = 0; i < (int32_t)retired_elite_genomes.size(); i++) {
+        delete retired_elite_genomes[i];
+    }
+    retired_elite_genomes.clear();
+}
+
 void OneNasIslandSpeciationStrategy::set_onenas_instance(ONENAS* onenas_ref) {
     onenas_instance = onenas_ref;
 }
 
+void OneNasIslandSpeciationStrategy::write_checkpoint(ostream& out) {
+    out.write((char*) &number_of_islands, sizeof(int32_t));
+    out.write((char*) &generation_island, sizeof(int32_t));
+    out.write((char*) &generated_population_size, sizeof(int32_t));
+    out.write((char*) &generated_genomes, sizeof(int32_t));
+    out.write((char*) &evaluated_genomes, sizeof(int32_t));
+
+    // these are changed by the network size control
+    out.write((char*) &mutation_rate, sizeof(double));
+    out.write((char*) &intra_island_crossover_rate, sizeof(double));
+    out.write((char*) &inter_island_crossover_rate, sizeof(double));
+    out.write((char*) &compare_with_naive, sizeof(bool));
+    out.write((char*) &naive_better_count, sizeof(int32_t));
+    out.write((char*) &genome_better_count, sizeof(int32_t));
+
+    out.write((char*) &adaptive_generation_budget, sizeof(bool));
+    if (adaptive_generation_budget) {
+        out.write((char*) &generations_since_drift, sizeof(int32_t));
+        out.write((char*) &naive_mse_ratio, sizeof(double));
+        validation_drift_detector->write_checkpoint(out);
+        naive_drift_detector->write_checkpoint(out);
+    }
+
+    bool has_global_best = global_best_genome != NULL;
+    out.write((char*) &has_global_best, sizeof(bool));
+    if (has_global_best) {
+        ostringstream genome_oss;
+        global_best_genome->write_to_stream(genome_oss);
+        write_binary_string(out, genome_oss.str(), "global_best_genome");
+    }
+
+    for (int32_t i = 0; i < number_of_islands; i++) {
+        islands[i]->write_checkpoint(out);
+    }
+}
+
+bool OneNasIslandSpeciationStrategy::read_checkpoint(istream& in) {
+    int32_t checkpoint_islands;
+    in.read((char*) &checkpoint_islands, sizeof(int32_t));
+    if (checkpoint_islands != number_of_islands) {
+        Log::fatal("ERROR: checkpoint has %d islands but --number_islands is %d\n", checkpoint_islands, number_of_islands);
+        return false;
+    }
+
+    in.read((char*) &generation_island, sizeof(int32_t));
+    in.read((char*) &generated_population_size, sizeof(int32_t));
+    in.read((char*) &generated_genomes, sizeof(int32_t));
+    in.read((char*) &evaluated_genomes, sizeof(int32_t));
+
+    in.read((char*) &mutation_rate, sizeof(double));
+    in.read((char*) &intra_island_crossover_rate, sizeof(double));
+    in.read((char*) &inter_island_crossover_rate, sizeof(double));
+    in.read((char*) &compare_with_naive, sizeof(bool));
+    in.read((char*) &naive_better_count, sizeof(int32_t));
+    in.read((char*) &genome_better_count, sizeof(int32_t));
+
+    bool checkpoint_adaptive_budget;
+    in.read((char*) &checkpoint_adaptive_budget, sizeof(bool));
+    if (checkpoint_adaptive_budget != adaptive_generation_budget) {
+        Log::fatal("ERROR: the adaptive generation budget was %s when the checkpoint was written but is %s now\n",
+                checkpoint_adaptive_budget ? "on" : "off", adaptive_generation_budget ? "on" : "off");
+        return false;
+    }
+    if (adaptive_generation_budget) {
+        in.read((char*) &generations_since_drift, sizeof(int32_t));
+        in.read((char*) &naive_mse_ratio, sizeof(double));
+        validation_drift_detector->read_checkpoint(in);
+        naive_drift_detector->read_checkpoint(in);
+    }
+
+    if (global_best_genome != NULL) {
+        delete global_best_genome;
+        global_best_genome = NULL;
+    }
+    bool has_global_best;
+    in.read((char*) &has_global_best, sizeof(bool));
+    if (has_global_best) {
+        string genome_str;
+        read_binary_string(in, genome_str, "global_best_genome");
+        istringstream genome_iss(genome_str);
+        global_best_genome = new RNN_Genome(genome_iss);
+    }
+
+    // the elites retired by the last repopulation were only needed for that generation's priority updates
+    free_retired_elite_genomes();
+    for (int32_t i = 0; i < number_of_islands; i++) {
+        if (!islands[i]->read_checkpoint(in)) {
+            return false;
+        }
+    }
+
+    Log::info("OneNAS Strategy: Restored %d islands, %d genomes generated and %d evaluated so far\n", number_of_islands,
+            generated_genomes, evaluated_genomes);
+    return true;
+}
+
+void OneNasIslandSpeciationStrategy::set_adaptive_generation_budget(int32_t min_size, int32_t max_size,
+        int32_t stable_generations, double drift_delta, double drift_threshold) {
+    if (min_size < 1 || max_size < min_size) {
+        Log::fatal("ERROR: the adaptive generated population size needs 1 <= min (%d) <= max (%d)\n", min_size, max_size);
+        exit(1);
+    }
+
+    adaptive_generation_budget = true;
+    min_generated_population_size = min_size;
+    max_generated_population_size = max_size;
+    drift_stable_generations = stable_generations;
+    generations_since_drift = 0;
+
+    if (validation_drift_detector != NULL) delete validation_drift_detector;
+    if (naive_drift_detector != NULL) delete naive_drift_detector;
+    validation_drift_detector = new DriftDetector(drift_delta, drift_threshold);
+    naive_drift_detector = new DriftDetector(drift_delta, drift_threshold);
+
+    Log::info("OneNAS Strategy: Adaptive generated population size between %d and %d, shrinking after %d stable generations, drift delta %f and threshold %f\n",
+            min_generated_population_size, max_generated_population_size, drift_stable_generations, drift_delta, drift_threshold);
+}
+
+void OneNasIslandSpeciationStrategy::update_generation_budget(int32_t current_generation) {
+    // the logs of the errors are watched so the drift parameters do not depend on the scale of the data
+    bool drift = false;
+    if (global_best_genome != NULL) {
+        double elite_mse = global_best_genome->get_best_validation_mse();
+        if (validation_drift_detector->observe(log(fmax(elite_mse, 1e-12)))) {
+            Log::info("Generation %d: Drift detected in the best elite validation MSE (%f)\n", current_generation, elite_mse);
+            drift = true;
+        }
+    }
+
+    if (naive_mse_ratio > 0.0) {
+        if (naive_drift_detector->observe(log(fmax(naive_mse_ratio, 1e-12)))) {
+            Log::info("Generation %d: Drift detected in the genome to naive MSE ratio (%f)\n", current_generation, naive_mse_ratio);
+            drift = true;
+        }
+    }
+
+    int32_t previous_size = generated_population_size;
+    if (drift) {
+        // both detectors start over so the next drift is measured against the new regime
+        validation_drift_detector->reset();
+        naive_drift_detector->reset();
+        generations_since_drift = 0;
+        generated_population_size = max_generated_population_size;
+    } else {
+        generations_since_drift++;
+        if (generations_since_drift > drift_stable_generations) {
+            generated_population_size = generated_population_size / 2;
+            if (generated_population_size < min_generated_population_size) {
+                generated_population_size = min_generated_population_size;
+            }
+        }
+    }
+
+    Log::info("Generation %d: Generated population size %d -> %d (%d generations since drift, drift statistics %f and %f)\n",
+            current_generation, previous_size, generated_population_size, generations_since_drift,
+            validation_drift_detector->get_statistic(), naive_drift_detector->get_statistic());
+}
+
 void OneNasIslandSpeciationStrategy::control_network_size(string control_size_method) {
     if (control_size_method.compare("reduce_mutation_rate") == 0) {
         Log::info("Reducing mutation rates to control network size\n");
@@ -877,6 +1089,29 @@ void OneNasIslandSpeciationStrategy::evaluate_elite_population(const vector< vec
     }
 }
 
+int32_t OneNasIslandSpeciationStrategy::fine_tune_elite_population(const vector< vector< vector<double> > > &inputs, const vector< vector< vector<double> > > &outputs, int32_t fine_tune_steps, int32_t max_total_steps, WeightUpdate *weight_update_method) {
+    int32_t elites = 0;
+    for (int i = 0; i < number_of_islands; i++) {
+        elites += islands[i]->elite_size();
+    }
+    if (elites == 0) {
+        return 0;
+    }
+
+    if (max_total_steps > 0 && (int64_t) fine_tune_steps * elites > max_total_steps) {
+        fine_tune_steps = max_total_steps / elites;
+        Log::info("Fine tuning %d elites for %d steps each to stay within %d steps\n", elites, fine_tune_steps, max_total_steps);
+        if (fine_tune_steps == 0) {
+            return 0;
+        }
+    }
+
+    for (int i = 0; i < number_of_islands; i++) {
+        islands[i] -> fine_tune_elite_population(inputs, outputs, fine_tune_steps, weight_update_method);
+    }
+    return fine_tune_steps * elites;
+}
+
 void OneNasIslandSpeciationStrategy::select_elite_population() {
     for (int i = 0; i < number_of_islands; i++) {
         islands[i] -> select_elite_population();
@@ -945,7 +1180,7 @@ void OneNasIslandSpeciationStrategy::update_performance_counters(int32_t current
     }
 }
 
-void OneNasIslandSpeciationStrategy::write_prediction_file(const string &filename, const vector< vector< vector<double> > > &predictions, const vector< vector< vector<double> > > &test_input, const vector< vector< vector<double> > > &test_output) {
+void OneNasIslandSpeciationStrategy::write_prediction_file(const string &filename, vector< vector< vector<double> > > predictions, const vector< vector< vector<double> > > &test_input, const vector< vector< vector<double> > > &test_output) {
     if (global_best_genome == NULL) {
         Log::error("Cannot write prediction file: global_best_genome is NULL\n");
         return;
@@ -953,54 +1188,56 @@ void OneNasIslandSpeciationStrategy::write_prediction_file(const string &filenam
 
     int32_t num_outputs = global_best_genome->get_number_outputs();
     vector<string> output_parameter_names = global_best_genome->get_output_parameter_names();
-    
-    // Create output file
-    ofstream outfile(filename + "_global_best.csv");
-    outfile << "#";
+    int32_t time_length = (int32_t)test_input[0][0].size();
 
-    // Write expected output headers
-    for (int32_t i = 0; i < num_outputs; i++) {
-        if (i > 0) outfile << ",";
-        outfile << "expected_" << output_parameter_names[i];
-    }
-    
-    // Write naive prediction headers (previous timestep)
-    for (int32_t i = 0; i < num_outputs; i++) {
-        outfile << ",";
-        outfile << "naive_" << output_parameter_names[i];
-    }
+    // only the first test series is written, it is formatted and written on the async writer's thread
+    AsyncWriter::write_file(filename + "_global_best.csv",
+        [num_outputs, output_parameter_names, time_length, expected = test_output[0], predicted = std::move(predictions[0])](WriteBuffer &outfile) {
+            outfile << "#";
 
-    // Write global best genome prediction headers
-    for (int32_t i = 0; i < num_outputs; i++) {
-        outfile << ",";
-        outfile << "global_best_predicted_" << output_parameter_names[i];
-    }
+            // Write expected output headers
+            for (int32_t i = 0; i < num_outputs; i++) {
+                if (i > 0) outfile << ",";
+                outfile << "expected_" << output_parameter_names[i];
+            }
 
-    outfile << endl;
+            // Write naive prediction headers (previous timestep)
+            for (int32_t i = 0; i < num_outputs; i++) {
+                outfile << ",";
+                outfile << "naive_" << output_parameter_names[i];
+            }
 
-    // Write data rows
-    int32_t time_length = (int32_t)test_input[0][0].size();
-    for (int32_t j = 1; j < time_length; j++) {
-        // Write expected values
-        for (int32_t i = 0; i < num_outputs; i++) {
-            if (i > 0) outfile << ",";
-            outfile << test_output[0][i][j];
-        }
+            // Write global best genome prediction headers
+            for (int32_t i = 0; i < num_outputs; i++) {
+                outfile << ",";
+                outfile << "global_best_predicted_" << output_parameter_names[i];
+            }
 
-        // Write naive predictions (previous timestep)
-        for (int32_t i = 0; i < num_outputs; i++) {
-            outfile << ",";
-            outfile << test_output[0][i][j-1];
-        }
+            outfile << '\n';
 
-        // Write global best genome predictions
-        for (int32_t i = 0; i < num_outputs; i++) {
-            outfile << ",";
-            outfile << predictions[0][i][j];
+            // Write data rows
+            for (int32_t j = 1; j < time_length; j++) {
+                // Write expected values
+                for (int32_t i = 0; i < num_outputs; i++) {
+                    if (i > 0) outfile << ",";
+                    outfile << expected[i][j];
+                }
+
+                // Write naive predictions (previous timestep)
+                for (int32_t i = 0; i < num_outputs; i++) {
+                    outfile << ",";
+                    outfile << expected[i][j-1];
+                }
+
+                // Write global best genome predictions
+                for (int32_t i = 0; i < num_outputs; i++) {
+                    outfile << ",";
+                    outfile << predicted[i][j];
+                }
+                outfile << '\n';
+            }
         }
-        outfile << endl;
-    }
-    outfile.close();
-    
-    Log::info("Global best genome predictions written to %s_global_best.csv\n", filename.c_str());
+    );
+
+    Log::info("Global best genome predictions queued for %s_global_best.csv\n", filename.c_str());
 }
\ No newline at end of file
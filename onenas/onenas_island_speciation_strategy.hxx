@@ -4,6 +4,10 @@
 #include <functional>
 using std::function;
 
+#include <iostream>
+using std::istream;
+using std::ostream;
+
 #include <random>
 using std::minstd_rand0;
 using std::uniform_real_distribution;
@@ -12,6 +16,7 @@ using std::uniform_real_distribution;
 #include <string>
 using std::string;
 
+#include "drift_detector.hxx"
 #include "onenas_island.hxx"
 #include "rnn/rnn_genome.hxx"
 #include "speciation_strategy.hxx"
@@ -25,7 +30,9 @@ class OneNasIslandSpeciationStrategy : public SpeciationStrategy {
 
         int32_t number_of_islands; /**< the number of islands to have. */
 
-        int32_t generated_population_size; /**< the maximum number of genomes in an island. */
+        int32_t generated_population_size; /**< the number of genomes generated per generation, which the adaptive budget and the size control change. */
+
+        int32_t island_capacity; /**< the maximum number of generated genomes in an island, the starting generated_population_size. */
 
         int32_t elite_population_size;
 
@@ -62,6 +69,12 @@ class OneNasIslandSpeciationStrategy : public SpeciationStrategy {
         vector<OneNasIsland*> islands;
         RNN_Genome* global_best_genome;
 
+        /**
+         * Elites of islands erased by the last repopulation. They are among the elite genomes returned by
+         * finalize_generation_with_genomes, so they are kept until the next generation is finalized.
+         */
+        vector<RNN_Genome*> retired_elite_genomes;
+
         string output_directory;
         
         // Counters for comparing naive vs genome prediction performance
@@ -71,6 +84,17 @@ class OneNasIslandSpeciationStrategy : public SpeciationStrategy {
         // Control size method and comparison flag
         string control_size_method;   /**< Method for controlling network size when genome outperforms naive */
         bool compare_with_naive;      /**< Flag to enable/disable naive vs genome comparison */
+
+        // Adaptive generation budget, the number of genomes generated per island each generation follows drift in
+        // the stream instead of staying fixed
+        bool adaptive_generation_budget;
+        int32_t min_generated_population_size;   /**< The budget stable stretches are reduced down to. */
+        int32_t max_generated_population_size;   /**< The budget used after drift is detected. */
+        int32_t drift_stable_generations;        /**< Generations without drift before the budget starts shrinking. */
+        int32_t generations_since_drift;
+        DriftDetector* validation_drift_detector; /**< Watches the log of the best elite validation MSE. */
+        DriftDetector* naive_drift_detector;      /**< Watches the log of the genome to naive test MSE ratio. */
+        double naive_mse_ratio;                   /**< This generation's genome to naive test MSE ratio, or < 0. */
         
         // Forward declaration to avoid circular dependency
         ONENAS* onenas_instance;  /**< Reference to ONENAS instance for accessing mutation rates */
@@ -269,17 +293,26 @@ class OneNasIslandSpeciationStrategy : public SpeciationStrategy {
          * \param test_input the test input data
          * \param test_output the test output data
          */
-        void write_prediction_file(const string &filename, const vector< vector< vector<double> > > &predictions, const vector< vector< vector<double> > > &test_input, const vector< vector< vector<double> > > &test_output);
+        void write_prediction_file(const string &filename, vector< vector< vector<double> > > predictions, const vector< vector< vector<double> > > &test_input, const vector< vector< vector<double> > > &test_output);
 
         void set_erased_islands_status();
         
         // Base class implementation - required by SpeciationStrategy interface
         void finalize_generation(int32_t current_generation, const vector< vector< vector<double> > > &validation_input, const vector< vector< vector<double> > > &validation_output, const vector< vector< vector<double> > > &test_input, const vector< vector< vector<double> > > &test_output) override;
         
-        // New PER-specific method that returns elite genomes
+        // New PER-specific method that returns elite genomes. The genomes are still owned by the islands (or this
+        // strategy, for islands erased during repopulation) and are only valid until the next generation is finalized.
         vector<RNN_Genome*> finalize_generation_with_genomes(int32_t current_generation, const vector< vector< vector<double> > > &validation_input, const vector< vector< vector<double> > > &validation_output, const vector< vector< vector<double> > > &test_input, const vector< vector< vector<double> > > &test_output);
 
         void evaluate_elite_population(const vector< vector< vector<double> > > &validation_input, const vector< vector< vector<double> > > &validation_output);
+
+        /**
+         * Fine tunes the elites of every island for fine_tune_steps steps each (see
+         * OneNasIsland::fine_tune_elite_population). This runs on the master between generations, so if max_total_steps
+         * is > 0 the steps per elite are lowered to keep the total within it. Returns the total steps taken.
+         */
+        int32_t fine_tune_elite_population(const vector< vector< vector<double> > > &inputs, const vector< vector< vector<double> > > &outputs, int32_t fine_tune_steps, int32_t max_total_steps, WeightUpdate *weight_update_method);
+
         void select_elite_population();
         void get_elite_population_ids(vector<int32_t>& good_genome_ids);
         void clear_population();
@@ -306,17 +339,49 @@ class OneNasIslandSpeciationStrategy : public SpeciationStrategy {
 
         void do_repopulation(int32_t current_generation);
 
+        /**
+         * Deletes the elites of islands erased by the last repopulation.
+         */
+        void free_retired_elite_genomes();
+
         /**
          * Controls network size based on the specified method
          * \param control_size_method the method to use for controlling network size
          */
         void control_network_size(string control_size_method);
 
+        /**
+         * Turns on adapting the generated population size to drift in the stream: when drift is detected in the best
+         * elite validation MSE or in how the global best compares to the naive prediction, the budget goes up to
+         * max_size, and after stable_generations generations without drift it is halved each generation down to
+         * min_size.
+         *
+         * \param drift_delta and drift_threshold are the Page-Hinkley parameters, in terms of the log of the MSEs
+         */
+        void set_adaptive_generation_budget(int32_t min_size, int32_t max_size, int32_t stable_generations,
+                double drift_delta, double drift_threshold);
+
+        /**
+         * Feeds this generation's errors to the drift detectors and adjusts the generated population size.
+         */
+        void update_generation_budget(int32_t current_generation);
+
         /**
          * Sets the ONENAS instance reference for accessing mutation rates
          * \param onenas_ref pointer to the ONENAS instance
          */
         void set_onenas_instance(ONENAS* onenas_ref);
+
+        /**
+         * Writes the islands and everything this strategy adapts during the search to a checkpoint. This is meant
+         * to be called between generations, when the generated populations are empty.
+         */
+        void write_checkpoint(ostream& out);
+
+        /**
+         * Restores the state written by write_checkpoint into a strategy created from the same arguments.
+         */
+        bool read_checkpoint(istream& in);
 };
 
 
@@ -16,6 +16,12 @@ using std::to_string;
 
 #include <iostream>
 using std::endl;
+using std::istream;
+using std::ostream;
+
+#include <sstream>
+using std::istringstream;
+using std::ostringstream;
 
 #include <unordered_map>
 using std::unordered_map;
@@ -23,6 +29,7 @@ using std::unordered_map;
 #include "population.hxx"
 #include "rnn/rnn_genome.hxx"
 
+#include "common/async_writer.hxx"
 #include "common/log.hxx"
 
 Population::Population(int32_t _population_type, int32_t _max_size, int32_t _island_id) :  population_type(_population_type), max_size(_max_size), island_id(_island_id) {
@@ -338,6 +345,13 @@ void Population::erase_population() {
     erase_structure_map();
 }
 
+void Population::release_population(vector<RNN_Genome*> &released) {
+    released.insert(released.end(), genomes.begin(), genomes.end());
+    genomes.clear();
+
+    erase_structure_map();
+}
+
 void Population::erase_structure_map() {
     Log::debug("Erasing the structure map in the worst performing island\n");
     structure_map.clear();
@@ -359,10 +373,9 @@ void Population::sort_population(string sort_by) {
 }
 
 void Population::write_prediction(string filename, const vector< vector< vector<double> > > &test_input, const vector< vector< vector<double> > > &test_output) {
-    vector <vector <vector <vector<double>>>> predictions; // <genome <input sets < output parameter <value>>>>
+    vector <vector <vector<double>>> predictions; // <genome < output parameter <value>>> for the first input set
     int32_t num_genomes = (int32_t)genomes.size();
     int32_t num_outputs = genomes[0]->get_number_outputs();
-    vector <string> input_parameter_names = genomes[0]->get_input_parameter_names();
     vector <string> output_parameter_names = genomes[0]->get_output_parameter_names();
     for (int32_t i = 0; i < num_genomes; i++) {
         vector<double> parameters = genomes[i]->get_best_parameters();
@@ -370,79 +383,55 @@ void Population::write_prediction(string filename, const vector< vector< vector<
             Log::error("Genome %d best parameter size is %d\n", genomes[i]->get_generation_id(), parameters.size());
         }
 
-        predictions.push_back(genomes[i]->get_predictions(parameters, test_input, test_output));
-    }
-    ofstream outfile(filename + "_island_" + std::to_string(island_id) + ".csv");
-    outfile << "#";
-
-    // ofstream outfile_original(filename + "_original.csv");
-    // outfile_original << "#";
-
-    for (int32_t i = 0; i < num_outputs; i++) {
-        if (i > 0) outfile << ",";
-        // if (i > 0) outfile_original << ",";
-
-        outfile << "expected_" << output_parameter_names[i];
-        // outfile_original << "expected_" << output_parameter_names[i];
-        Log::debug("output_parameter_names[%d]: '%s'\n", i, output_parameter_names[i].c_str());
-    }
-    
-    for (int32_t i = 0; i < num_outputs; i++) {
-        outfile << ",";
-        // outfile_original << ",";
-
-        outfile << "naive_" << output_parameter_names[i];
-        // outfile_original << "naive_" << output_parameter_names[i];
-        Log::debug("output_parameter_names[%d]: '%s'\n", i, output_parameter_names[i].c_str());
-    }
-
-    for (int32_t g = 0; g < num_genomes; g++) {
-        for (int32_t i = 0; i < num_outputs; i++) {
-            outfile << ",";
-            // outfile_original << ",";
-
-            outfile << "genome_" << g << "_predicted_" << output_parameter_names[i];
-            // outfile_original << "genome_" << g << "_predicted_" << output_parameter_names[i];
-            Log::debug("output_parameter_names[%d]: '%s'\n", i, output_parameter_names[i].c_str());
-        }
+        predictions.push_back(std::move(genomes[i]->get_predictions(parameters, test_input, test_output)[0]));
     }
+    int32_t time_length = (int32_t)test_input[0][0].size();
 
-    outfile << endl;
-    // outfile_original << endl;
+    // formatted and written on the async writer's thread
+    AsyncWriter::write_file(filename + "_island_" + std::to_string(island_id) + ".csv",
+        [num_genomes, num_outputs, output_parameter_names, time_length, expected = test_output[0], predictions = std::move(predictions)](WriteBuffer &outfile) {
+            outfile << "#";
 
-    int32_t time_length = (int32_t)test_input[0][0].size();
-    for (int32_t j = 1; j < time_length; j++) {
+            for (int32_t i = 0; i < num_outputs; i++) {
+                if (i > 0) outfile << ",";
+                outfile << "expected_" << output_parameter_names[i];
+            }
 
-        for (int32_t i = 0; i < num_outputs; i++) {
-            if (i > 0) outfile << ",";
-            // if (i > 0) outfile_original << ",";
+            for (int32_t i = 0; i < num_outputs; i++) {
+                outfile << ",";
+                outfile << "naive_" << output_parameter_names[i];
+            }
 
-            outfile << test_output[0][i][j];
-            // outfile_original << time_series_sets->denormalize(output_parameter_names[i], test_output[0][i][j]);
-        }
+            for (int32_t g = 0; g < num_genomes; g++) {
+                for (int32_t i = 0; i < num_outputs; i++) {
+                    outfile << ",";
+                    outfile << "genome_" << g << "_predicted_" << output_parameter_names[i];
+                }
+            }
 
-        for (int32_t i = 0; i < num_outputs; i++) {
-            outfile << ",";
-            // outfile_original << ",";
+            outfile << '\n';
 
-            outfile << test_output[0][i][j-1];
-            // outfile_original << time_series_sets->denormalize(output_parameter_names[i], test_output[0][i][j-1]);
-        }
+            for (int32_t j = 1; j < time_length; j++) {
+                for (int32_t i = 0; i < num_outputs; i++) {
+                    if (i > 0) outfile << ",";
+                    outfile << expected[i][j];
+                }
 
-        for (int32_t g = 0; g < num_genomes; g++) {
-            for (int32_t i = 0; i < num_outputs; i++) {
-                outfile << ",";
-                // outfile_original << ",";
+                for (int32_t i = 0; i < num_outputs; i++) {
+                    outfile << ",";
+                    outfile << expected[i][j-1];
+                }
 
-                outfile << predictions[g][0][i][j];
-                // outfile_original << time_series_sets->denormalize(output_parameter_names[i], predictions[g][0][i][j]);
+                for (int32_t g = 0; g < num_genomes; g++) {
+                    for (int32_t i = 0; i < num_outputs; i++) {
+                        outfile << ",";
+                        outfile << predictions[g][i][j];
+                    }
+                }
+                outfile << '\n';
             }
         }
-        outfile << endl;
-        // outfile_original << endl;
-    }
-    outfile.close();
-    // outfile_original.close();
+    );
 }
 
 void Population::save_entire_population(string output_path) {
@@ -451,3 +440,41 @@ void Population::save_entire_population(string output_path) {
         genomes[i]->write_graphviz(output_path + "/genome_" + to_string(i) + ".gv");
     }
 }
+
+void Population::write_checkpoint(ostream& out) {
+    int32_t number_genomes = (int32_t)genomes.size();
+    out.write((char*) &number_genomes, sizeof(int32_t));
+
+    // each genome is length prefixed, as the genome format is only terminated by the end of its stream
+    for (int32_t i = 0; i < number_genomes; i++) {
+        ostringstream genome_oss;
+        genomes[i]->write_to_stream(genome_oss);
+        write_binary_string(out, genome_oss.str(), "genome");
+    }
+}
+
+bool Population::read_checkpoint(istream& in) {
+    erase_population();
+
+    int32_t number_genomes;
+    in.read((char*) &number_genomes, sizeof(int32_t));
+    if (!in.good() || number_genomes < 0 || number_genomes > max_size) {
+        Log::fatal("ERROR: checkpoint has %d genomes for island %d, which holds at most %d\n", number_genomes, island_id, max_size);
+        return false;
+    }
+
+    for (int32_t i = 0; i < number_genomes; i++) {
+        if (!in.good()) {
+            Log::fatal("ERROR: checkpoint ended before genome %d of island %d\n", i, island_id);
+            return false;
+        }
+        string genome_str;
+        read_binary_string(in, genome_str, "genome");
+        istringstream genome_iss(genome_str);
+
+        RNN_Genome* genome = new RNN_Genome(genome_iss);
+        genomes.push_back(genome);
+        structure_map[genome->get_structural_hash()].push_back(genome);
+    }
+    return true;
+}
@@ -5,6 +5,10 @@
 using std::sort;
 using std::upper_bound;
 
+#include <iostream>
+using std::istream;
+using std::ostream;
+
 #include <random>
 using std::minstd_rand0;
 using std::uniform_real_distribution;
@@ -146,6 +150,12 @@ class Population {
 
         void erase_population();
 
+        /**
+         * Empties the population like erase_population, but moves the genomes into released instead of deleting
+         * them, so the caller takes ownership of them.
+         */
+        void release_population(vector<RNN_Genome*> &released);
+
         void erase_structure_map();
 
         void sort_population(string sort_by);
@@ -154,6 +164,16 @@ class Population {
 
         void write_prediction(string filename, const vector< vector< vector<double> > > &test_input, const vector< vector< vector<double> > > &test_output);
 
+        /**
+         * Writes the genomes of this population (in their best to worst order) to a checkpoint.
+         */
+        void write_checkpoint(ostream& out);
+
+        /**
+         * Replaces the genomes of this population with the ones in a checkpoint, keeping their order.
+         */
+        bool read_checkpoint(istream& in);
+
 };
 
 #endif
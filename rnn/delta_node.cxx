@@ -26,6 +26,8 @@ using std::vector;
 Delta_Node::Delta_Node(int32_t _innovation_number, int32_t _type, double _depth)
     : RNN_Node_Interface(_innovation_number, _type, _depth) {
     node_type = DELTA_NODE;
+    sums_inputs = true;
+    summed_deltas = &RNN_Node_Interface::error_values;
 }
 
 Delta_Node::~Delta_Node() {
@@ -70,28 +72,24 @@ void Delta_Node::initialize_uniform_random(minstd_rand0& generator, uniform_real
 }
 
 double Delta_Node::get_gradient(string gradient_name) {
-    double gradient_sum = 0.0;
-
-    for (int32_t i = 0; i < series_length; i++) {
-        if (gradient_name == "alpha") {
-            gradient_sum += d_alpha[i];
-        } else if (gradient_name == "beta1") {
-            gradient_sum += d_beta1[i];
-        } else if (gradient_name == "beta2") {
-            gradient_sum += d_beta2[i];
-        } else if (gradient_name == "v") {
-            gradient_sum += d_v[i];
-        } else if (gradient_name == "r_bias") {
-            gradient_sum += d_r_bias[i];
-        } else if (gradient_name == "z_hat_bias") {
-            gradient_sum += d_z_hat_bias[i];
-        } else {
-            Log::fatal("ERROR: tried to get unknown gradient: '%s'\n", gradient_name.c_str());
-            exit(1);
-        }
+    check_weight_gradients(gradient_name);
+
+    if (gradient_name == "alpha") {
+        return weight_gradients[0];
+    } else if (gradient_name == "beta1") {
+        return weight_gradients[1];
+    } else if (gradient_name == "beta2") {
+        return weight_gradients[2];
+    } else if (gradient_name == "v") {
+        return weight_gradients[3];
+    } else if (gradient_name == "r_bias") {
+        return weight_gradients[4];
+    } else if (gradient_name == "z_hat_bias") {
+        return weight_gradients[5];
+    } else {
+        Log::fatal("ERROR: tried to get unknown gradient: '%s'\n", gradient_name.c_str());
+        exit(1);
     }
-
-    return gradient_sum;
 }
 
 void Delta_Node::print_gradient(string gradient_name) {
@@ -192,26 +190,26 @@ void Delta_Node::try_update_deltas(int32_t time) {
     d_z_prev[time] = d_z * r[time];
 
     double d_r = ((d_z * z_cap[time] * -1) + (d_z * z_prev)) * ld_r[time];
-    d_r_bias[time] = d_r;
+    weight_gradients[4] += d_r;
     d_input[time] = d_r;
 
     double d_z_cap = d_z * ld_z_cap[time] * (1 - r[time]);
     // d_z_hat_bias route
-    d_z_hat_bias[time] = d_z_cap;
+    weight_gradients[5] += d_z_cap;
 
     // z_hat_3 route
     d_input[time] += d_z_cap * beta2;
-    d_beta2[time] = d_z_cap * d2;
+    weight_gradients[2] += d_z_cap * d2;
 
     // z_hat_1 route
     double d1 = v * z_prev;
     d_input[time] += d_z_cap * alpha * d1;
-    d_alpha[time] = d_z_cap * d2 * d1;
+    weight_gradients[0] += d_z_cap * d2 * d1;
 
     // z_hat_2 route
-    d_beta1[time] = d_z_cap * d1;
+    weight_gradients[1] += d_z_cap * d1;
     double d_d1 = (d_z_cap * beta1) + (d2 * alpha * d_z_cap);
-    d_v[time] = d_d1 * z_prev;
+    weight_gradients[3] += d_d1 * z_prev;
     d_z_prev[time] += d_d1 * v;
 
     // reset the alpha/betas to be around 0
@@ -281,33 +279,9 @@ void Delta_Node::get_weights(int32_t& offset, vector<double>& parameters) const
     // Log::trace("got weights from offset %d to %d on Delta_node %d\n", start_offset, end_offset, innovation_number);
 }
 
-void Delta_Node::get_gradients(vector<double>& gradients) {
-    gradients.assign(NUMBER_DELTA_WEIGHTS, 0.0);
-
-    for (int32_t i = 0; i < NUMBER_DELTA_WEIGHTS; i++) {
-        gradients[i] = 0.0;
-    }
-
-    for (int32_t i = 0; i < series_length; i++) {
-        gradients[0] += d_alpha[i];
-        gradients[1] += d_beta1[i];
-        gradients[2] += d_beta2[i];
-        gradients[3] += d_v[i];
-
-        gradients[4] += d_r_bias[i];
-        gradients[5] += d_z_hat_bias[i];
-    }
-}
-
 void Delta_Node::reset(int32_t _series_length) {
     series_length = _series_length;
 
-    d_alpha.assign(series_length, 0.0);
-    d_beta1.assign(series_length, 0.0);
-    d_beta2.assign(series_length, 0.0);
-    d_v.assign(series_length, 0.0);
-    d_r_bias.assign(series_length, 0.0);
-    d_z_hat_bias.assign(series_length, 0.0);
     d_z_prev.assign(series_length, 0.0);
 
     r.assign(series_length, 0.0);
@@ -330,12 +304,6 @@ RNN_Node_Interface* Delta_Node::copy() const {
     Delta_Node* n = new Delta_Node(innovation_number, layer_type, depth);
 
     // copy Delta_Node values
-    n->d_alpha = d_alpha;
-    n->d_beta1 = d_beta1;
-    n->d_beta2 = d_beta2;
-    n->d_v = d_v;
-    n->d_r_bias = d_r_bias;
-    n->d_z_hat_bias = d_z_hat_bias;
     n->d_z_prev = d_z_prev;
 
     n->r = r;
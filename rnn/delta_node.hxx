@@ -24,12 +24,6 @@ class Delta_Node : public RNN_Node_Interface {
     double r_bias;
     double z_hat_bias;
 
-    vector<double> d_alpha;
-    vector<double> d_beta1;
-    vector<double> d_beta2;
-    vector<double> d_v;
-    vector<double> d_r_bias;
-    vector<double> d_z_hat_bias;
     vector<double> d_z_prev;
 
     vector<double> r;
@@ -66,8 +60,6 @@ class Delta_Node : public RNN_Node_Interface {
     void get_weights(int32_t& offset, vector<double>& parameters) const;
     void set_weights(int32_t& offset, const vector<double>& parameters);
 
-    void get_gradients(vector<double>& gradients);
-
     void reset(int32_t _series_length);
 
     void write_to_stream(ostream& out);
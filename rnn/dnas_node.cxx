@@ -22,10 +22,11 @@ DNASNode::DNASNode(
       z(vector<double>(nodes.size())),
       x(vector<double>(nodes.size())),
       g(vector<double>(nodes.size())),
-      d_pi(vector<double>(nodes.size())),
       noise(vector<double>(nodes.size())),
       counter(counter) {
     node_type = DNAS_NODE;
+    sums_inputs = true;
+    summed_deltas = &RNN_Node_Interface::error_values;
     generator.seed(std::random_device()());
     for (auto node : nodes) {
         node->total_inputs = 1;
@@ -42,9 +43,10 @@ DNASNode::DNASNode(const DNASNode& src) : RNN_Node_Interface(src.innovation_numb
     }
 
     node_type = DNAS_NODE;
+    sums_inputs = true;
+    summed_deltas = &RNN_Node_Interface::error_values;
 
     pi = src.pi;
-    d_pi = src.d_pi;
     z = src.z;
     g = src.g;
     x = src.x;
@@ -140,7 +142,6 @@ void DNASNode::calculate_z() {
 }
 
 void DNASNode::reset(int32_t series_length) {
-    d_pi = vector<double>(pi.size(), 0.0);
     d_input = vector<double>(series_length, 0.0);
     node_outputs = vector<vector<double>>(series_length, vector<double>(pi.size(), 0.0));
     output_values = vector<double>(series_length, 0.0);
@@ -162,6 +163,31 @@ void DNASNode::reset(int32_t series_length) {
     }
 }
 
+int32_t DNASNode::get_streaming_state_size() const {
+    // the sub-nodes carry the recurrent state, the weighted sum of their outputs is recomputed every step
+    int32_t state_size = 0;
+    for (auto node : nodes) {
+        state_size += node->get_streaming_state_size();
+    }
+    return state_size;
+}
+
+void DNASNode::load_streaming_state(const double* state) {
+    RNN_Node_Interface::load_streaming_state(state);
+
+    for (auto node : nodes) {
+        node->load_streaming_state(state);
+        state += node->get_streaming_state_size();
+    }
+}
+
+void DNASNode::save_streaming_state(int32_t time, double* state) const {
+    for (auto node : nodes) {
+        node->save_streaming_state(time, state);
+        state += node->get_streaming_state_size();
+    }
+}
+
 void DNASNode::input_fired(int32_t time, double incoming_output) {
     inputs_fired[time]++;
 
@@ -229,7 +255,7 @@ void DNASNode::try_update_deltas(int32_t time) {
             p *= ((delta * node_outputs[time][i]) / xtotal);
             p *= (1 - (x[i] / xtotal));
             p *= 1 / tao;
-            d_pi[i] += p;
+            weight_gradients[i] += p * 0.1;
         }
         d_input[time] = 0.0;
         for (auto node : nodes) {
@@ -334,42 +360,18 @@ void DNASNode::calculate_maxi() {
     }
 }
 
-void DNASNode::get_gradients(vector<double>& gradients) {
-    gradients.assign(get_number_weights(), 0.0);
+void DNASNode::set_weight_gradients(double* _weight_gradients) {
+    RNN_Node_Interface::set_weight_gradients(_weight_gradients);
 
-    // We want this to count weight updates, fetching gradients implies an impending weight update
+    // We want this to count weight updates, computing gradients implies an impending weight update
     counter += 1;
     calculate_maxi();
 
-    vector<double> temp;
-    int offset = 0;
-
-    if (counter >= CRYSTALLIZATION_THRESHOLD) {
-        offset += pi.size();
-        for (int32_t i = 0; i < (int32_t) nodes.size(); i++) {
-            RNN_Node_Interface* node = nodes[i];
-            if (i == maxi) {
-                node->get_gradients(temp);
-                for (int32_t j = 0; j < (int32_t) temp.size(); j++) {
-                    gradients[offset++] = temp[j];
-                }
-            } else {
-                offset += node->get_number_weights();
-            }
-        }
-    } else {
-        gradients.assign(get_number_weights(), 0.0);
-        int offset = 0;
-        for (int32_t i = 0; i < (int32_t) pi.size(); i++) {
-            gradients[offset++] = d_pi[i] * 0.1;
-        }
-
-        for (auto node : nodes) {
-            node->get_gradients(temp);
-            for (int32_t i = 0; i < (int32_t) temp.size(); i++) {
-                gradients[offset++] = temp[i];
-            }
-        }
+    // pi's gradients come first, then the sub-nodes', the same as in get_weights
+    int32_t offset = pi.size();
+    for (auto node : nodes) {
+        node->set_weight_gradients(_weight_gradients + offset);
+        offset += node->get_number_weights();
     }
 }
 
@@ -53,8 +53,6 @@ class DNASNode : public RNN_Node_Interface {
     // Sum of x values, saved for use in backprop.
     double xtotal = 0.0;
 
-    vector<double> d_pi;
-
     // A vector to put gumbel noise into; just to avoid re-allocation
     vector<double> noise;
 
@@ -106,8 +104,13 @@ class DNASNode : public RNN_Node_Interface {
 
     void set_pi(const vector<double>& new_pi);
 
-    virtual void get_gradients(vector<double>& gradients);
+    virtual void set_weight_gradients(double* _weight_gradients);
     virtual void reset(int32_t _series_length);
+
+    virtual int32_t get_streaming_state_size() const;
+    virtual void load_streaming_state(const double* state);
+    virtual void save_streaming_state(int32_t time, double* state) const;
+
     virtual void write_to_stream(ostream& out);
 
     virtual RNN_Node_Interface* copy() const;
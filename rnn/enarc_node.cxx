@@ -26,6 +26,8 @@ using std::vector;
 ENARC_Node::ENARC_Node(int32_t _innovation_number, int32_t _type, double _depth)
     : RNN_Node_Interface(_innovation_number, _type, _depth) {
     node_type = ENARC_NODE;
+    sums_inputs = true;
+    summed_deltas = &RNN_Node_Interface::error_values;
 }
 
 ENARC_Node::~ENARC_Node() {
@@ -98,37 +100,32 @@ void ENARC_Node::initialize_uniform_random(minstd_rand0& generator, uniform_real
 }
 
 double ENARC_Node::get_gradient(string gradient_name) {
-    double gradient_sum = 0.0;
-    for (int32_t i = 0; i < series_length; i++) {
-        if (gradient_name == "zw") {
-            gradient_sum += d_zw[i];
-        } else if (gradient_name == "rw") {
-            gradient_sum += d_rw[i];
-        } else if (gradient_name == "w1") {
-            gradient_sum += d_w1[i];
-
-        } else if (gradient_name == "w2") {
-            gradient_sum += d_w2[i];
-        } else if (gradient_name == "w3") {
-            gradient_sum += d_w3[i];
-        } else if (gradient_name == "w6") {
-            gradient_sum += d_w6[i];
-
-        } else if (gradient_name == "w4") {
-            gradient_sum += d_w4[i];
-
-        } else if (gradient_name == "w5") {
-            gradient_sum += d_w5[i];
-        } else if (gradient_name == "w7") {
-            gradient_sum += d_w7[i];
-        } else if (gradient_name == "w8") {
-            gradient_sum += d_w8[i];
-        } else {
-            Log::fatal("ERROR: tried to get unknown gradient: '%s'\n", gradient_name.c_str());
-            exit(1);
-        }
+    check_weight_gradients(gradient_name);
+
+    if (gradient_name == "zw") {
+        return weight_gradients[0];
+    } else if (gradient_name == "rw") {
+        return weight_gradients[1];
+    } else if (gradient_name == "w1") {
+        return weight_gradients[2];
+    } else if (gradient_name == "w2") {
+        return weight_gradients[3];
+    } else if (gradient_name == "w3") {
+        return weight_gradients[4];
+    } else if (gradient_name == "w6") {
+        return weight_gradients[5];
+    } else if (gradient_name == "w4") {
+        return weight_gradients[6];
+    } else if (gradient_name == "w5") {
+        return weight_gradients[7];
+    } else if (gradient_name == "w7") {
+        return weight_gradients[8];
+    } else if (gradient_name == "w8") {
+        return weight_gradients[9];
+    } else {
+        Log::fatal("ERROR: tried to get unknown gradient: '%s'\n", gradient_name.c_str());
+        exit(1);
     }
-    return gradient_sum;
 }
 
 void ENARC_Node::print_gradient(string gradient_name) {
@@ -236,31 +233,31 @@ void ENARC_Node::try_update_deltas(int32_t time) {
 
     // d_h *= 0.2;
 
-    d_w6[time] = d_h * l_w6_w1[time] * w1_z[time];
+    weight_gradients[5] += d_h * l_w6_w1[time] * w1_z[time];
 
-    d_w8[time] = d_h * l_w8_w3[time] * w3_w1[time];
-    d_w7[time] = d_h * l_w7_w3[time] * w3_w1[time];
-    d_w5[time] = d_h * l_w5_w3[time] * w3_w1[time];
+    weight_gradients[9] += d_h * l_w8_w3[time] * w3_w1[time];
+    weight_gradients[8] += d_h * l_w7_w3[time] * w3_w1[time];
+    weight_gradients[7] += d_h * l_w5_w3[time] * w3_w1[time];
 
-    d_w4[time] = d_h * l_w4_w2[time] * w2_w1[time];
+    weight_gradients[6] += d_h * l_w4_w2[time] * w2_w1[time];
 
     double d_h_tanh2 = d_h * l_w4_w2[time] * w4;
     double d_h_leaky2 = d_h * l_w8_w3[time] * w8 + d_h * l_w7_w3[time] * w7 + d_h * l_w5_w3[time] * w5;
 
-    d_w2[time] = d_h_tanh2 * l_w2_w1[time] * w1_z[time];
-    d_w3[time] = d_h_leaky2 * l_w3_w1[time] * w1_z[time];
+    weight_gradients[3] += d_h_tanh2 * l_w2_w1[time] * w1_z[time];
+    weight_gradients[4] += d_h_leaky2 * l_w3_w1[time] * w1_z[time];
 
     double d_h_tanh1 = d_h * l_w6_w1[time] * w6 + d_h_tanh2 * l_w2_w1[time] * w2 + d_h_leaky2 * l_w3_w1[time] * w3;
 
-    d_w1[time] = d_h_tanh1 * l_w1_z[time] * z[time];
+    weight_gradients[2] += d_h_tanh1 * l_w1_z[time] * z[time];
 
     double d_h_tanh = d_h_tanh1 * l_w1_z[time] * w1;
 
     d_h_prev[time] += d_h_tanh * l_d_z[time] * rw;
-    d_rw[time] = d_h_tanh * l_d_z[time] * h_prev;
+    weight_gradients[1] += d_h_tanh * l_d_z[time] * h_prev;
 
     d_input[time] += d_h_tanh * l_d_z[time] * zw;
-    d_zw[time] = d_h_tanh * l_d_z[time] * x;
+    weight_gradients[0] += d_h_tanh * l_d_z[time] * x;
 }
 
 void ENARC_Node::error_fired(int32_t time, double error) {
@@ -336,47 +333,9 @@ void ENARC_Node::get_weights(int32_t& offset, vector<double>& parameters) const
     // Log::trace("got weights from offset %d to %d on ENARC_Node %d\n", start_offset, end_offset, innovation_number);
 }
 
-void ENARC_Node::get_gradients(vector<double>& gradients) {
-    gradients.assign(NUMBER_ENARC_WEIGHTS, 0.0);
-
-    for (int32_t i = 0; i < NUMBER_ENARC_WEIGHTS; i++) {
-        gradients[i] = 0.0;
-    }
-
-    for (int32_t i = 0; i < series_length; i++) {
-        gradients[0] += d_zw[i];
-        gradients[1] += d_rw[i];
-
-        gradients[2] += d_w1[i];
-
-        gradients[3] += d_w2[i];
-        gradients[4] += d_w3[i];
-        gradients[5] += d_w6[i];
-
-        gradients[6] += d_w4[i];
-        gradients[7] += d_w5[i];
-        gradients[8] += d_w7[i];
-        gradients[9] += d_w8[i];
-    }
-}
-
 void ENARC_Node::reset(int32_t _series_length) {
     series_length = _series_length;
 
-    d_zw.assign(series_length, 0.0);
-    d_rw.assign(series_length, 0.0);
-
-    d_w1.assign(series_length, 0.0);
-
-    d_w2.assign(series_length, 0.0);
-    d_w3.assign(series_length, 0.0);
-    d_w6.assign(series_length, 0.0);
-
-    d_w4.assign(series_length, 0.0);
-    d_w5.assign(series_length, 0.0);
-    d_w7.assign(series_length, 0.0);
-    d_w8.assign(series_length, 0.0);
-
     d_h_prev.assign(series_length, 0.0);
 
     z.assign(series_length, 0.0);
@@ -434,20 +393,6 @@ RNN_Node_Interface* ENARC_Node::copy() const {
     n->w7 = w7;
     n->w8 = w8;
 
-    n->d_zw = d_zw;
-    n->d_rw = d_rw;
-
-    n->d_w1 = d_w1;
-
-    n->d_w2 = d_w2;
-    n->d_w3 = d_w3;
-    n->d_w6 = d_w6;
-
-    n->d_w4 = d_w4;
-    n->d_w5 = d_w5;
-
-    n->d_w7 = d_w7;
-    n->d_w8 = d_w8;
     n->d_h_prev = d_h_prev;
 
     n->z = z;
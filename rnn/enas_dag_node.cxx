@@ -33,6 +33,8 @@ using std::vector;
 ENAS_DAG_Node::ENAS_DAG_Node(int32_t _innovation_number, int32_t _type, double _depth)
     : RNN_Node_Interface(_innovation_number, _type, _depth) {
     node_type = ENAS_DAG_NODE;
+    sums_inputs = true;
+    summed_deltas = &RNN_Node_Interface::error_values;
 }
 
 ENAS_DAG_Node::~ENAS_DAG_Node() {
@@ -91,35 +93,32 @@ void ENAS_DAG_Node::initialize_uniform_random(minstd_rand0& generator, uniform_r
 }
 
 double ENAS_DAG_Node::get_gradient(string gradient_name) {
-    double gradient_sum = 0.0;
-    for (int32_t i = 0; i < series_length; i++) {
-        if (gradient_name == "zw") {
-            gradient_sum += d_zw[i];
-        } else if (gradient_name == "rw") {
-            gradient_sum += d_rw[i];
-        } else if (gradient_name == "w1") {
-            gradient_sum += d_weights[0][i];
-
-        } else if (gradient_name == "w2") {
-            gradient_sum += d_weights[1][i];
-        } else if (gradient_name == "w3") {
-            gradient_sum += d_weights[2][i];
-        } else if (gradient_name == "w4") {
-            gradient_sum += d_weights[3][i];
-        } else if (gradient_name == "w5") {
-            gradient_sum += d_weights[4][i];
-        } else if (gradient_name == "w6") {
-            gradient_sum += d_weights[5][i];
-        } else if (gradient_name == "w7") {
-            gradient_sum += d_weights[6][i];
-        } else if (gradient_name == "w8") {
-            gradient_sum += d_weights[7][i];
-        } else {
-            Log::fatal("ERROR: tried to get unknown gradient: '%s'\n", gradient_name.c_str());
-            exit(1);
-        }
+    check_weight_gradients(gradient_name);
+
+    if (gradient_name == "zw") {
+        return weight_gradients[0];
+    } else if (gradient_name == "rw") {
+        return weight_gradients[1];
+    } else if (gradient_name == "w1") {
+        return weight_gradients[2];
+    } else if (gradient_name == "w2") {
+        return weight_gradients[3];
+    } else if (gradient_name == "w3") {
+        return weight_gradients[4];
+    } else if (gradient_name == "w4") {
+        return weight_gradients[5];
+    } else if (gradient_name == "w5") {
+        return weight_gradients[6];
+    } else if (gradient_name == "w6") {
+        return weight_gradients[7];
+    } else if (gradient_name == "w7") {
+        return weight_gradients[8];
+    } else if (gradient_name == "w8") {
+        return weight_gradients[9];
+    } else {
+        Log::fatal("ERROR: tried to get unknown gradient: '%s'\n", gradient_name.c_str());
+        exit(1);
     }
-    return gradient_sum;
 }
 
 void ENAS_DAG_Node::print_gradient(string gradient_name) {
@@ -278,21 +277,21 @@ void ENAS_DAG_Node::try_update_deltas(int32_t time) {
 
     for (int32_t i = no_of_nodes - 1; i >= 1; i--) {
         int32_t incoming_node = connections[i] - 1;
-        d_weights[i - 1][time] = d_node_h[i] * l_Nodes[i][time] * Nodes[incoming_node][time];
+        weight_gradients[i + 1] += d_node_h[i] * l_Nodes[i][time] * Nodes[incoming_node][time];
         d_node_h[incoming_node] += d_node_h[i] * l_Nodes[i][time] * weights[i - 1];
     }
 
     d_h_prev[time] += d_node_h[0] * l_Nodes[0][time] * rw;
-    d_rw[time] = d_node_h[0] * l_Nodes[0][time] * h_prev;
+    weight_gradients[1] += d_node_h[0] * l_Nodes[0][time] * h_prev;
 
     d_input[time] += d_node_h[0] * l_Nodes[0][time] * zw;
-    d_zw[time] = d_node_h[0] * l_Nodes[0][time] * x;
+    weight_gradients[0] += d_node_h[0] * l_Nodes[0][time] * x;
 
     // d_h_prev[time] += d_h*l_Nodes[0][time]*rw;
-    // d_rw[time] =  d_h*l_Nodes[0][time]*h_prev;
+    // weight_gradients[1] +=  d_h*l_Nodes[0][time]*h_prev;
 
     // d_input[time] +=  d_h*l_Nodes[0][time]*zw;
-    // d_zw[time] = d_h*l_Nodes[0][time]*x;
+    // weight_gradients[0] += d_h*l_Nodes[0][time]*x;
 
     Log::debug(
         "DEBUG: output_fired on ENAS_DAG_Node %d at time %d is %d and total_outputs is %d\n", innovation_number, time,
@@ -366,37 +365,9 @@ void ENAS_DAG_Node::get_weights(int32_t& offset, vector<double>& parameters) con
     }
 }
 
-void ENAS_DAG_Node::get_gradients(vector<double>& gradients) {
-    gradients.assign(NUMBER_ENAS_DAG_WEIGHTS, 0.0);
-
-    for (int32_t i = 0; i < NUMBER_ENAS_DAG_WEIGHTS; i++) {
-        gradients[i] = 0.0;
-    }
-
-    for (int32_t i = 0; i < series_length; i++) {
-        gradients[0] += d_zw[i];
-        gradients[1] += d_rw[i];
-
-        gradients[2] += d_weights[0][i];
-
-        gradients[3] += d_weights[1][i];
-        gradients[4] += d_weights[2][i];
-        gradients[5] += d_weights[3][i];
-
-        gradients[6] += d_weights[4][i];
-        gradients[7] += d_weights[5][i];
-        gradients[8] += d_weights[6][i];
-        gradients[9] += d_weights[7][i];
-    }
-}
-
 void ENAS_DAG_Node::reset(int32_t _series_length) {
     series_length = _series_length;
 
-    d_zw.assign(series_length, 0.0);
-    d_rw.assign(series_length, 0.0);
-
-    d_weights.assign(NUMBER_ENAS_DAG_WEIGHTS, vector<double>(series_length, 0.0));
     d_h_prev.assign(series_length, 0.0);
     Nodes.assign(NUMBER_ENAS_DAG_WEIGHTS, vector<double>(series_length, 0.0));
     l_Nodes.assign(NUMBER_ENAS_DAG_WEIGHTS, vector<double>(series_length, 0.0));
@@ -419,12 +390,8 @@ RNN_Node_Interface* ENAS_DAG_Node::copy() const {
     n->rw = rw;
     n->zw = zw;
 
-    n->d_zw = d_zw;
-    n->d_rw = d_rw;
-
     for (int32_t i = 0; i < (int32_t) weights.size(); ++i) {
         n->weights[i] = weights[i];
-        n->d_weights[i] = d_weights[i];
     }
 
     n->d_h_prev = d_h_prev;
@@ -1,3 +1,7 @@
+#include <memory>
+using std::make_shared;
+using std::shared_ptr;
+
 #include "rnn/genome_property.hxx"
 
 #include "common/arguments.hxx"
@@ -6,14 +10,27 @@
 GenomeProperty::GenomeProperty() {
     bp_iterations = 10;
     dropout_probability = 0.0;
+    tbptt_window = 0;
+    tbptt_stride = 0;
     min_recurrent_depth = 1;
     max_recurrent_depth = 10;
+    metadata = make_shared<const RNN_Genome_Metadata>();
 }
 
 void GenomeProperty::generate_genome_property_from_arguments(const vector<string>& arguments) {
     get_argument(arguments, "--bp_iterations", true, bp_iterations);
     use_dropout = get_argument(arguments, "--dropout_probability", false, dropout_probability);
 
+    get_argument(arguments, "--tbptt_window", false, tbptt_window);
+    tbptt_stride = tbptt_window;
+    get_argument(arguments, "--tbptt_stride", false, tbptt_stride);
+    if (tbptt_window > 0 && (tbptt_stride <= 0 || tbptt_stride > tbptt_window)) {
+        Log::fatal(
+            "ERROR: --tbptt_stride (%d) needs to be > 0 and <= --tbptt_window (%d)\n", tbptt_stride, tbptt_window
+        );
+        exit(1);
+    }
+
     get_argument(arguments, "--min_recurrent_depth", false, min_recurrent_depth);
     get_argument(arguments, "--max_recurrent_depth", false, max_recurrent_depth);
 
@@ -21,6 +38,9 @@ void GenomeProperty::generate_genome_property_from_arguments(const vector<string
     Log::info(
         "Use dropout is set to %s, dropout probability is %f\n", use_dropout ? "True" : "False", dropout_probability
     );
+    if (tbptt_window > 0) {
+        Log::info("Using truncated BPTT with a window of %d steps and a stride of %d\n", tbptt_window, tbptt_stride);
+    }
     Log::info("Min recurrent depth is %d, max recurrent depth is %d\n", min_recurrent_depth, max_recurrent_depth);
 }
 
@@ -29,19 +49,20 @@ void GenomeProperty::set_genome_properties(RNN_Genome* genome) {
     if (use_dropout) {
         genome->enable_dropout(dropout_probability);
     }
-    genome->normalize_type = normalize_type;
-    genome->set_parameter_names(input_parameter_names, output_parameter_names);
-    genome->set_normalize_bounds(normalize_type, normalize_mins, normalize_maxs, normalize_avgs, normalize_std_devs);
+    genome->set_tbptt(tbptt_window, tbptt_stride);
+    genome->set_metadata(metadata);
 }
 
 void GenomeProperty::get_time_series_parameters(TimeSeriesSets* time_series_sets) {
-    input_parameter_names = time_series_sets->get_input_parameter_names();
-    output_parameter_names = time_series_sets->get_output_parameter_names();
-    normalize_type = time_series_sets->get_normalize_type();
-    normalize_mins = time_series_sets->get_normalize_mins();
-    normalize_maxs = time_series_sets->get_normalize_maxs();
-    normalize_avgs = time_series_sets->get_normalize_avgs();
-    normalize_std_devs = time_series_sets->get_normalize_std_devs();
+    shared_ptr<RNN_Genome_Metadata> time_series_metadata = make_shared<RNN_Genome_Metadata>();
+    time_series_metadata->input_parameter_names = time_series_sets->get_input_parameter_names();
+    time_series_metadata->output_parameter_names = time_series_sets->get_output_parameter_names();
+    time_series_metadata->normalize_type = time_series_sets->get_normalize_type();
+    time_series_metadata->normalize_mins = time_series_sets->get_normalize_mins();
+    time_series_metadata->normalize_maxs = time_series_sets->get_normalize_maxs();
+    time_series_metadata->normalize_avgs = time_series_sets->get_normalize_avgs();
+    time_series_metadata->normalize_std_devs = time_series_sets->get_normalize_std_devs();
+    metadata = time_series_metadata;
     number_inputs = time_series_sets->get_number_inputs();
     number_outputs = time_series_sets->get_number_outputs();
 }
@@ -15,20 +15,16 @@ class GenomeProperty {
     int32_t bp_iterations;
     bool use_dropout;
     double dropout_probability;
+    int32_t tbptt_window;
+    int32_t tbptt_stride;
     int32_t min_recurrent_depth;
     int32_t max_recurrent_depth;
 
     // TimeSeriesSets *time_series_sets;
     int32_t number_inputs;
     int32_t number_outputs;
-    vector<string> input_parameter_names;
-    vector<string> output_parameter_names;
-
-    string normalize_type;
-    map<string, double> normalize_mins;
-    map<string, double> normalize_maxs;
-    map<string, double> normalize_avgs;
-    map<string, double> normalize_std_devs;
+    // shared by every genome the properties are set on
+    shared_ptr<const RNN_Genome_Metadata> metadata;
 
    public:
     GenomeProperty();
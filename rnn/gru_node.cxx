@@ -26,6 +26,8 @@ using std::vector;
 GRU_Node::GRU_Node(int32_t _innovation_number, int32_t _type, double _depth)
     : RNN_Node_Interface(_innovation_number, _type, _depth) {
     node_type = GRU_NODE;
+    sums_inputs = true;
+    summed_deltas = &RNN_Node_Interface::error_values;
 }
 
 GRU_Node::~GRU_Node() {
@@ -90,34 +92,30 @@ void GRU_Node::initialize_uniform_random(minstd_rand0& generator, uniform_real_d
 }
 
 double GRU_Node::get_gradient(string gradient_name) {
-    double gradient_sum = 0.0;
-
-    for (int32_t i = 0; i < series_length; i++) {
-        if (gradient_name == "zw") {
-            gradient_sum += d_zw[i];
-        } else if (gradient_name == "zu") {
-            gradient_sum += d_zu[i];
-        } else if (gradient_name == "z_bias") {
-            gradient_sum += d_z_bias[i];
-        } else if (gradient_name == "rw") {
-            gradient_sum += d_rw[i];
-        } else if (gradient_name == "ru") {
-            gradient_sum += d_ru[i];
-        } else if (gradient_name == "r_bias") {
-            gradient_sum += d_r_bias[i];
-        } else if (gradient_name == "hw") {
-            gradient_sum += d_hw[i];
-        } else if (gradient_name == "hu") {
-            gradient_sum += d_hu[i];
-        } else if (gradient_name == "h_bias") {
-            gradient_sum += d_h_bias[i];
-        } else {
-            Log::fatal("ERROR: tried to get unknown gradient: '%s'\n", gradient_name.c_str());
-            exit(1);
-        }
+    check_weight_gradients(gradient_name);
+
+    if (gradient_name == "zw") {
+        return weight_gradients[0];
+    } else if (gradient_name == "zu") {
+        return weight_gradients[1];
+    } else if (gradient_name == "z_bias") {
+        return weight_gradients[2];
+    } else if (gradient_name == "rw") {
+        return weight_gradients[3];
+    } else if (gradient_name == "ru") {
+        return weight_gradients[4];
+    } else if (gradient_name == "r_bias") {
+        return weight_gradients[5];
+    } else if (gradient_name == "hw") {
+        return weight_gradients[6];
+    } else if (gradient_name == "hu") {
+        return weight_gradients[7];
+    } else if (gradient_name == "h_bias") {
+        return weight_gradients[8];
+    } else {
+        Log::fatal("ERROR: tried to get unknown gradient: '%s'\n", gradient_name.c_str());
+        exit(1);
     }
-
-    return gradient_sum;
 }
 
 void GRU_Node::print_gradient(string gradient_name) {
@@ -214,29 +212,29 @@ void GRU_Node::try_update_deltas(int32_t time) {
     d_h_prev[time] = d_h * z[time];
 
     double d_z = ((d_h * h_prev) - (d_h * h_tanh[time])) * ld_z[time];
-    d_z_bias[time] = d_z;
-    d_zu[time] = d_z * h_prev;
+    weight_gradients[2] += d_z;
+    weight_gradients[1] += d_z * h_prev;
     d_h_prev[time] += d_z * zu;
-    d_zw[time] = d_z * x;
+    weight_gradients[0] += d_z * x;
     d_input[time] = d_z * zw;
 
     double d_h_tanh = (1 - z[time]) * d_h * ld_h_tanh[time];
 
     d_input[time] += d_h_tanh * hw;
-    d_hw[time] = d_h_tanh * x;
+    weight_gradients[6] += d_h_tanh * x;
 
-    d_h_bias[time] = d_h_tanh;
+    weight_gradients[8] += d_h_tanh;
 
-    d_hu[time] = d_h_tanh * r[time] * h_prev;
+    weight_gradients[7] += d_h_tanh * r[time] * h_prev;
     double d_r = d_h_tanh * hu * h_prev * ld_r[time];
 
     d_h_prev[time] += d_h_tanh * hu * r[time];
 
-    d_r_bias[time] = d_r;
-    d_ru[time] = d_r * h_prev;
+    weight_gradients[5] += d_r;
+    weight_gradients[4] += d_r * h_prev;
     d_h_prev[time] += d_r * ru;
 
-    d_rw[time] = d_r * x;
+    weight_gradients[3] += d_r * x;
     d_input[time] += d_r * rw;
 
     // reset the reset gate bias to be around 0
@@ -312,43 +310,9 @@ void GRU_Node::get_weights(int32_t& offset, vector<double>& parameters) const {
     // Log::trace("got weights from offset %d to %d on GRU_Node %d\n", start_offset, end_offset, innovation_number);
 }
 
-void GRU_Node::get_gradients(vector<double>& gradients) {
-    gradients.assign(NUMBER_GRU_WEIGHTS, 0.0);
-
-    for (int32_t i = 0; i < NUMBER_GRU_WEIGHTS; i++) {
-        gradients[i] = 0.0;
-    }
-
-    for (int32_t i = 0; i < series_length; i++) {
-        gradients[0] += d_zw[i];
-        gradients[1] += d_zu[i];
-        gradients[2] += d_z_bias[i];
-
-        gradients[3] += d_rw[i];
-        gradients[4] += d_ru[i];
-        gradients[5] += d_r_bias[i];
-
-        gradients[6] += d_hw[i];
-        gradients[7] += d_hu[i];
-        gradients[8] += d_h_bias[i];
-    }
-}
-
 void GRU_Node::reset(int32_t _series_length) {
     series_length = _series_length;
 
-    d_zw.assign(series_length, 0.0);
-    d_zu.assign(series_length, 0.0);
-    d_z_bias.assign(series_length, 0.0);
-
-    d_rw.assign(series_length, 0.0);
-    d_ru.assign(series_length, 0.0);
-    d_r_bias.assign(series_length, 0.0);
-
-    d_hw.assign(series_length, 0.0);
-    d_hu.assign(series_length, 0.0);
-    d_h_bias.assign(series_length, 0.0);
-
     d_h_prev.assign(series_length, 0.0);
 
     z.assign(series_length, 0.0);
@@ -383,16 +347,6 @@ RNN_Node_Interface* GRU_Node::copy() const {
     n->hu = hu;
     n->h_bias = h_bias;
 
-    n->d_zw = d_zw;
-    n->d_zu = d_zu;
-    n->d_z_bias = d_z_bias;
-    n->d_rw = d_rw;
-    n->d_ru = d_ru;
-    n->d_r_bias = d_r_bias;
-    n->d_hw = d_hw;
-    n->d_hu = d_hu;
-    n->d_h_bias = d_h_bias;
-
     n->d_h_prev = d_h_prev;
 
     n->z = z;
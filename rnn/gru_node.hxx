@@ -28,16 +28,6 @@ class GRU_Node : public RNN_Node_Interface {
     double hu;
     double h_bias;
 
-    vector<double> d_zw;
-    vector<double> d_zu;
-    vector<double> d_z_bias;
-    vector<double> d_rw;
-    vector<double> d_ru;
-    vector<double> d_r_bias;
-    vector<double> d_hw;
-    vector<double> d_hu;
-    vector<double> d_h_bias;
-
     vector<double> d_h_prev;
 
     vector<double> z;
@@ -75,8 +65,6 @@ class GRU_Node : public RNN_Node_Interface {
     void get_weights(int32_t& offset, vector<double>& parameters) const;
     void set_weights(int32_t& offset, const vector<double>& parameters);
 
-    void get_gradients(vector<double>& gradients);
-
     void reset(int32_t _series_length);
 
     void write_to_stream(ostream& out);
@@ -24,6 +24,8 @@ using std::vector;
 LSTM_Node::LSTM_Node(int32_t _innovation_number, int32_t _type, double _depth)
     : RNN_Node_Interface(_innovation_number, _type, _depth) {
     node_type = LSTM_NODE;
+    sums_inputs = true;
+    summed_deltas = &RNN_Node_Interface::error_values;
 }
 
 LSTM_Node::~LSTM_Node() {
@@ -113,38 +115,34 @@ void LSTM_Node::initialize_uniform_random(minstd_rand0& generator, uniform_real_
 }
 
 double LSTM_Node::get_gradient(string gradient_name) {
-    double gradient_sum = 0.0;
-
-    for (int32_t i = 0; i < series_length; i++) {
-        if (gradient_name == "output_gate_update_weight") {
-            gradient_sum += d_output_gate_update_weight[i];
-        } else if (gradient_name == "output_gate_weight") {
-            gradient_sum += d_output_gate_weight[i];
-        } else if (gradient_name == "output_gate_bias") {
-            gradient_sum += d_output_gate_bias[i];
-        } else if (gradient_name == "input_gate_update_weight") {
-            gradient_sum += d_input_gate_update_weight[i];
-        } else if (gradient_name == "input_gate_weight") {
-            gradient_sum += d_input_gate_weight[i];
-        } else if (gradient_name == "input_gate_bias") {
-            gradient_sum += d_input_gate_bias[i];
-        } else if (gradient_name == "forget_gate_update_weight") {
-            gradient_sum += d_forget_gate_update_weight[i];
-        } else if (gradient_name == "forget_gate_weight") {
-            gradient_sum += d_forget_gate_weight[i];
-        } else if (gradient_name == "forget_gate_bias") {
-            gradient_sum += d_forget_gate_bias[i];
-        } else if (gradient_name == "cell_weight") {
-            gradient_sum += d_cell_weight[i];
-        } else if (gradient_name == "cell_bias") {
-            gradient_sum += d_cell_bias[i];
-        } else {
-            Log::fatal("ERROR: tried to get unknown gradient: '%s'\n", gradient_name.c_str());
-            exit(1);
-        }
+    check_weight_gradients(gradient_name);
+
+    if (gradient_name == "output_gate_update_weight") {
+        return weight_gradients[0];
+    } else if (gradient_name == "output_gate_weight") {
+        return weight_gradients[1];
+    } else if (gradient_name == "output_gate_bias") {
+        return weight_gradients[2];
+    } else if (gradient_name == "input_gate_update_weight") {
+        return weight_gradients[3];
+    } else if (gradient_name == "input_gate_weight") {
+        return weight_gradients[4];
+    } else if (gradient_name == "input_gate_bias") {
+        return weight_gradients[5];
+    } else if (gradient_name == "forget_gate_update_weight") {
+        return weight_gradients[6];
+    } else if (gradient_name == "forget_gate_weight") {
+        return weight_gradients[7];
+    } else if (gradient_name == "forget_gate_bias") {
+        return weight_gradients[8];
+    } else if (gradient_name == "cell_weight") {
+        return weight_gradients[9];
+    } else if (gradient_name == "cell_bias") {
+        return weight_gradients[10];
+    } else {
+        Log::fatal("ERROR: tried to get unknown gradient: '%s'\n", gradient_name.c_str());
+        exit(1);
     }
-
-    return gradient_sum;
 }
 
 void LSTM_Node::print_gradient(string gradient_name) {
@@ -238,9 +236,9 @@ void LSTM_Node::try_update_deltas(int32_t time) {
 
     // backprop output gate
     double d_output_gate = error * cell_out_tanh[time] * ld_output_gate[time];
-    d_output_gate_bias[time] = d_output_gate;
-    d_output_gate_update_weight[time] = d_output_gate * previous_cell_value;
-    d_output_gate_weight[time] = d_output_gate * input_value;
+    weight_gradients[2] += d_output_gate;
+    weight_gradients[0] += d_output_gate * previous_cell_value;
+    weight_gradients[1] += d_output_gate * input_value;
     d_prev_cell[time] += d_output_gate * output_gate_update_weight;
     d_input[time] += d_output_gate * output_gate_weight;
 
@@ -256,24 +254,24 @@ void LSTM_Node::try_update_deltas(int32_t time) {
     d_prev_cell[time] += d_cell_out * forget_gate_values[time];
 
     double d_forget_gate = d_cell_out * previous_cell_value * ld_forget_gate[time];
-    d_forget_gate_bias[time] = d_forget_gate;
-    d_forget_gate_update_weight[time] = d_forget_gate * previous_cell_value;
-    d_forget_gate_weight[time] = d_forget_gate * input_value;
+    weight_gradients[8] += d_forget_gate;
+    weight_gradients[6] += d_forget_gate * previous_cell_value;
+    weight_gradients[7] += d_forget_gate * input_value;
     d_prev_cell[time] += d_forget_gate * forget_gate_update_weight;
     d_input[time] += d_forget_gate * forget_gate_weight;
 
     // backprob input gate
     double d_input_gate = d_cell_out * cell_in_tanh[time] * ld_input_gate[time];
-    d_input_gate_bias[time] = d_input_gate;
-    d_input_gate_update_weight[time] = d_input_gate * previous_cell_value;
-    d_input_gate_weight[time] = d_input_gate * input_value;
+    weight_gradients[5] += d_input_gate;
+    weight_gradients[3] += d_input_gate * previous_cell_value;
+    weight_gradients[4] += d_input_gate * input_value;
     d_prev_cell[time] += d_input_gate * input_gate_update_weight;
     d_input[time] += d_input_gate * input_gate_weight;
 
     // backprop cell input
     double d_cell_in = d_cell_out * input_gate_values[time] * ld_cell_in[time];
-    d_cell_bias[time] = d_cell_in;
-    d_cell_weight[time] = d_cell_in * input_value;
+    weight_gradients[10] += d_cell_in;
+    weight_gradients[9] += d_cell_in * input_value;
     d_input[time] += d_cell_in * cell_weight;
 }
 
@@ -352,31 +350,6 @@ void LSTM_Node::get_weights(int32_t& offset, vector<double>& parameters) const {
     // Log::trace("got weights from offset %d to %d on LSTM_Node %d\n", start_offset, end_offset, innovation_number);
 }
 
-void LSTM_Node::get_gradients(vector<double>& gradients) {
-    gradients.assign(11, 0.0);
-
-    for (int32_t i = 0; i < 11; i++) {
-        gradients[i] = 0.0;
-    }
-
-    for (int32_t i = 0; i < series_length; i++) {
-        gradients[0] += d_output_gate_update_weight[i];
-        gradients[1] += d_output_gate_weight[i];
-        gradients[2] += d_output_gate_bias[i];
-
-        gradients[3] += d_input_gate_update_weight[i];
-        gradients[4] += d_input_gate_weight[i];
-        gradients[5] += d_input_gate_bias[i];
-
-        gradients[6] += d_forget_gate_update_weight[i];
-        gradients[7] += d_forget_gate_weight[i];
-        gradients[8] += d_forget_gate_bias[i];
-
-        gradients[9] += d_cell_weight[i];
-        gradients[10] += d_cell_bias[i];
-    }
-}
-
 void LSTM_Node::reset(int32_t _series_length) {
     series_length = _series_length;
 
@@ -392,21 +365,6 @@ void LSTM_Node::reset(int32_t _series_length) {
     d_input.assign(series_length, 0.0);
     d_prev_cell.assign(series_length, 0.0);
 
-    d_output_gate_update_weight.assign(series_length, 0.0);
-    d_output_gate_weight.assign(series_length, 0.0);
-    d_output_gate_bias.assign(series_length, 0.0);
-
-    d_input_gate_update_weight.assign(series_length, 0.0);
-    d_input_gate_weight.assign(series_length, 0.0);
-    d_input_gate_bias.assign(series_length, 0.0);
-
-    d_forget_gate_update_weight.assign(series_length, 0.0);
-    d_forget_gate_weight.assign(series_length, 0.0);
-    d_forget_gate_bias.assign(series_length, 0.0);
-
-    d_cell_weight.assign(series_length, 0.0);
-    d_cell_bias.assign(series_length, 0.0);
-
     output_gate_values.assign(series_length, 0.0);
     input_gate_values.assign(series_length, 0.0);
     forget_gate_values.assign(series_length, 0.0);
@@ -421,6 +379,21 @@ void LSTM_Node::reset(int32_t _series_length) {
     outputs_fired.assign(series_length, 0);
 }
 
+int32_t LSTM_Node::get_streaming_state_size() const {
+    // the output and the cell value
+    return 2;
+}
+
+void LSTM_Node::load_streaming_state(const double* state) {
+    RNN_Node_Interface::load_streaming_state(state);
+    cell_values[0] = state[1];
+}
+
+void LSTM_Node::save_streaming_state(int32_t time, double* state) const {
+    RNN_Node_Interface::save_streaming_state(time, state);
+    state[1] = cell_values[time];
+}
+
 RNN_Node_Interface* LSTM_Node::copy() const {
     LSTM_Node* n = new LSTM_Node(innovation_number, layer_type, depth);
 
@@ -456,21 +429,6 @@ RNN_Node_Interface* LSTM_Node::copy() const {
 
     n->d_prev_cell = d_prev_cell;
 
-    n->d_output_gate_update_weight = d_output_gate_update_weight;
-    n->d_output_gate_weight = d_output_gate_weight;
-    n->d_output_gate_bias = d_output_gate_bias;
-
-    n->d_input_gate_update_weight = d_input_gate_update_weight;
-    n->d_input_gate_weight = d_input_gate_weight;
-    n->d_input_gate_bias = d_input_gate_bias;
-
-    n->d_forget_gate_update_weight = d_forget_gate_update_weight;
-    n->d_forget_gate_weight = d_forget_gate_weight;
-    n->d_forget_gate_bias = d_forget_gate_bias;
-
-    n->d_cell_weight = d_cell_weight;
-    n->d_cell_bias = d_cell_bias;
-
     // copy RNN_Node_Interface values
     n->series_length = series_length;
     n->input_values = input_values;
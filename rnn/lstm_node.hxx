@@ -47,21 +47,6 @@ class LSTM_Node : public RNN_Node_Interface {
 
     vector<double> d_prev_cell;
 
-    vector<double> d_output_gate_update_weight;
-    vector<double> d_output_gate_weight;
-    vector<double> d_output_gate_bias;
-
-    vector<double> d_input_gate_update_weight;
-    vector<double> d_input_gate_weight;
-    vector<double> d_input_gate_bias;
-
-    vector<double> d_forget_gate_update_weight;
-    vector<double> d_forget_gate_weight;
-    vector<double> d_forget_gate_bias;
-
-    vector<double> d_cell_weight;
-    vector<double> d_cell_bias;
-
    public:
     LSTM_Node(int32_t _innovation_number, int32_t _type, double _depth);
     ~LSTM_Node();
@@ -90,10 +75,12 @@ class LSTM_Node : public RNN_Node_Interface {
     void get_weights(int32_t& offset, vector<double>& parameters) const;
     void set_weights(int32_t& offset, const vector<double>& parameters);
 
-    void get_gradients(vector<double>& gradients);
-
     void reset(int32_t _series_length);
 
+    int32_t get_streaming_state_size() const;
+    void load_streaming_state(const double* state);
+    void save_streaming_state(int32_t time, double* state) const;
+
     void write_to_stream(ostream& out);
 
     RNN_Node_Interface* copy() const;
@@ -26,6 +26,8 @@ using std::vector;
 MGU_Node::MGU_Node(int32_t _innovation_number, int32_t _layer_type, double _depth)
     : RNN_Node_Interface(_innovation_number, _layer_type, _depth) {
     node_type = MGU_NODE;
+    sums_inputs = true;
+    summed_deltas = &RNN_Node_Interface::error_values;
 }
 
 MGU_Node::~MGU_Node() {
@@ -74,28 +76,24 @@ void MGU_Node::initialize_uniform_random(minstd_rand0& generator, uniform_real_d
 }
 
 double MGU_Node::get_gradient(string gradient_name) {
-    double gradient_sum = 0.0;
-
-    for (int32_t i = 0; i < series_length; i++) {
-        if (gradient_name == "fw") {
-            gradient_sum += d_fw[i];
-        } else if (gradient_name == "fu") {
-            gradient_sum += d_fu[i];
-        } else if (gradient_name == "f_bias") {
-            gradient_sum += d_f_bias[i];
-        } else if (gradient_name == "hw") {
-            gradient_sum += d_hw[i];
-        } else if (gradient_name == "hu") {
-            gradient_sum += d_hu[i];
-        } else if (gradient_name == "h_bias") {
-            gradient_sum += d_h_bias[i];
-        } else {
-            Log::fatal("ERROR: tried to get unknown gradient: '%s'\n", gradient_name.c_str());
-            exit(1);
-        }
+    check_weight_gradients(gradient_name);
+
+    if (gradient_name == "fw") {
+        return weight_gradients[0];
+    } else if (gradient_name == "fu") {
+        return weight_gradients[1];
+    } else if (gradient_name == "f_bias") {
+        return weight_gradients[2];
+    } else if (gradient_name == "hw") {
+        return weight_gradients[3];
+    } else if (gradient_name == "hu") {
+        return weight_gradients[4];
+    } else if (gradient_name == "h_bias") {
+        return weight_gradients[5];
+    } else {
+        Log::fatal("ERROR: tried to get unknown gradient: '%s'\n", gradient_name.c_str());
+        exit(1);
     }
-
-    return gradient_sum;
 }
 
 void MGU_Node::print_gradient(string gradient_name) {
@@ -172,9 +170,9 @@ void MGU_Node::try_update_deltas(int32_t time) {
     d_h_prev[time] = d_out * (1 - f[time]);
 
     double d_h_tanh = d_out * f[time] * ld_h_tanh[time];
-    d_h_bias[time] = d_h_tanh;
-    d_hw[time] = d_h_tanh * x;
-    d_hu[time] = d_h_tanh * f[time] * h_prev;
+    weight_gradients[5] += d_h_tanh;
+    weight_gradients[3] += d_h_tanh * x;
+    weight_gradients[4] += d_h_tanh * f[time] * h_prev;
     d_input[time] += d_h_tanh * hw;
     d_h_prev[time] += d_h_tanh * hu * f[time];
 
@@ -183,9 +181,9 @@ void MGU_Node::try_update_deltas(int32_t time) {
 
     double d_f = d_f_sigmoid * ld_f[time];
 
-    d_f_bias[time] = d_f;
-    d_fu[time] = d_f * h_prev;
-    d_fw[time] = d_f * x;
+    weight_gradients[2] += d_f;
+    weight_gradients[1] += d_f * h_prev;
+    weight_gradients[0] += d_f * x;
     d_input[time] += d_f * fw;
     d_h_prev[time] += d_f * fu;
 }
@@ -251,34 +249,9 @@ void MGU_Node::get_weights(int32_t& offset, vector<double>& parameters) const {
     // Log::trace("got weights from offset %d to %d on MGU_Node %d\n", start_offset, end_offset, innovation_number);
 }
 
-void MGU_Node::get_gradients(vector<double>& gradients) {
-    gradients.assign(NUMBER_MGU_WEIGHTS, 0.0);
-
-    for (int32_t i = 0; i < NUMBER_MGU_WEIGHTS; i++) {
-        gradients[i] = 0.0;
-    }
-
-    for (int32_t i = 0; i < series_length; i++) {
-        gradients[0] += d_fw[i];
-        gradients[1] += d_fu[i];
-        gradients[2] += d_f_bias[i];
-        gradients[3] += d_hw[i];
-        gradients[4] += d_hu[i];
-        gradients[5] += d_h_bias[i];
-    }
-}
-
 void MGU_Node::reset(int32_t _series_length) {
     series_length = _series_length;
 
-    d_fw.assign(series_length, 0.0);
-    d_fu.assign(series_length, 0.0);
-    d_f_bias.assign(series_length, 0.0);
-
-    d_hw.assign(series_length, 0.0);
-    d_hu.assign(series_length, 0.0);
-    d_h_bias.assign(series_length, 0.0);
-
     d_h_prev.assign(series_length, 0.0);
 
     f.assign(series_length, 0.0);
@@ -308,13 +281,6 @@ RNN_Node_Interface* MGU_Node::copy() const {
     n->hu = hu;
     n->h_bias = h_bias;
 
-    n->d_fw = d_fw;
-    n->d_fu = d_fu;
-    n->d_f_bias = d_f_bias;
-    n->d_hw = d_hw;
-    n->d_hu = d_hu;
-    n->d_h_bias = d_h_bias;
-
     n->d_h_prev = d_h_prev;
 
     n->f = f;
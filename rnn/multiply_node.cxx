@@ -10,6 +10,8 @@ using std::vector;
 MULTIPLY_Node::MULTIPLY_Node(int32_t _innovation_number, int32_t _layer_type, double _depth)
     : RNN_Node_Interface(_innovation_number, _layer_type, _depth), bias(0) {
     node_type = MULTIPLY_NODE;
+    // inputs are multiplied, so only the deltas are summed
+    summed_deltas = &RNN_Node_Interface::d_input;
     Log::debug("created node: %d, layer type: %d, node type: MULTIPLY_NODE\n", innovation_number, layer_type);
 }
 
@@ -100,7 +102,7 @@ void MULTIPLY_Node::try_update_deltas(int32_t time) {
         exit(1);
     }
 
-    d_bias += d_input[time];
+    weight_gradients[0] += d_input[time];
     for (double& num : ordered_d_input[time]) {
         num *= d_input[time];
 
@@ -142,12 +144,14 @@ void MULTIPLY_Node::reset(int32_t _series_length) {
 
     inputs_fired.assign(series_length, 0);
     outputs_fired.assign(series_length, 0);
-
-    d_bias = 0.0;
 }
 
-void MULTIPLY_Node::get_gradients(vector<double>& gradients) {
-    gradients.assign(1, d_bias);
+void MULTIPLY_Node::load_streaming_state(const double* state) {
+    RNN_Node_Interface::load_streaming_state(state);
+
+    // clear keeps the capacity, so these do not reallocate once the first step has been taken
+    ordered_input[1].clear();
+    ordered_d_input[1].clear();
 }
 
 int32_t MULTIPLY_Node::get_number_weights() const {
@@ -183,7 +187,6 @@ RNN_Node_Interface* MULTIPLY_Node::copy() const {
         n = new MULTIPLY_Node(innovation_number, layer_type, depth);
     }
     n->bias = bias;
-    n->d_bias = d_bias;
     n->ordered_d_input = ordered_d_input;
     n->ordered_input = ordered_input;
 
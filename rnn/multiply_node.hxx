@@ -9,7 +9,6 @@ using std::vector;
 class MULTIPLY_Node : public RNN_Node_Interface {
    protected:
     double bias;
-    double d_bias;
 
     vector<vector<double>> ordered_input;
 
@@ -39,7 +38,7 @@ class MULTIPLY_Node : public RNN_Node_Interface {
 
     void reset(int32_t _series_length);
 
-    void get_gradients(vector<double>& gradients);
+    void load_streaming_state(const double* state);
 
     RNN_Node_Interface* copy() const;
 
@@ -81,7 +81,7 @@ void MULTIPLY_Node_GP::try_update_deltas(int32_t time) {
         exit(1);
     }
 
-    d_bias += (d_input[time] * input_values[time]);
+    weight_gradients[0] += (d_input[time] * input_values[time]);
     for (double& num : ordered_d_input[time]) {
         num *= d_input[time];
 
@@ -98,7 +98,6 @@ RNN_Node_Interface* MULTIPLY_Node_GP::copy() const {
         n = new MULTIPLY_Node_GP(innovation_number, layer_type, depth);
     }
     n->bias = bias;
-    n->d_bias = d_bias;
     n->ordered_d_input = ordered_d_input;
     n->ordered_input = ordered_input;
 
@@ -28,13 +28,6 @@ class RANDOM_DAG_Node : public RNN_Node_Interface {
     // weights for other nodes
     vector<double> weights;
 
-    // gradients of starting node 0
-    vector<double> d_zw;
-    vector<double> d_rw;
-
-    // gradients of other nodes
-    vector<vector<double>> d_weights;
-
     // gradient of prev output
     vector<double> d_h_prev;
 
@@ -74,8 +67,6 @@ class RANDOM_DAG_Node : public RNN_Node_Interface {
     void get_weights(int32_t& offset, vector<double>& parameters) const;
     void set_weights(int32_t& offset, const vector<double>& parameters);
 
-    void get_gradients(vector<double>& gradients);
-
     void reset(int32_t _series_length);
 
     void write_to_stream(ostream& out);
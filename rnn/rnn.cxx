@@ -1,5 +1,10 @@
 #include <algorithm>
+using std::find;
+using std::max;
+using std::min;
 using std::sort;
+using std::stable_sort;
+using std::swap;
 using std::upper_bound;
 
 #include <chrono>
@@ -555,18 +560,62 @@ double RNN::prediction_softmax(
 
 double RNN::prediction_mse(
     const vector<vector<double> >& series_data, const vector<vector<double> >& expected_outputs, bool using_dropout,
-    bool training, double dropout_probability
+    bool training, double dropout_probability, int32_t window
 ) {
-    forward_pass(series_data, using_dropout, training, dropout_probability);
-    return calculate_error_mse(expected_outputs);
+    int32_t total_length = (int32_t) series_data[0].size();
+    if (window <= 0 || window >= total_length) {
+        forward_pass(series_data, using_dropout, training, dropout_probability);
+        return calculate_error_mse(expected_outputs);
+    }
+
+    vector<double> squared_errors(output_nodes.size(), 0.0);
+    windowed_forward_pass(
+        series_data, window, using_dropout, training, dropout_probability,
+        [&](int32_t window_start, int32_t length) {
+            for (int32_t i = 0; i < (int32_t) output_nodes.size(); i++) {
+                for (int32_t time = 1; time < length; time++) {
+                    double error = output_nodes[i]->output_values[time] - expected_outputs[i][window_start + time - 1];
+                    squared_errors[i] += error * error;
+                }
+            }
+        }
+    );
+
+    double mse_sum = 0.0;
+    for (int32_t i = 0; i < (int32_t) output_nodes.size(); i++) {
+        mse_sum += squared_errors[i] / total_length;
+    }
+    return mse_sum;
 }
 
 double RNN::prediction_mae(
     const vector<vector<double> >& series_data, const vector<vector<double> >& expected_outputs, bool using_dropout,
-    bool training, double dropout_probability
+    bool training, double dropout_probability, int32_t window
 ) {
-    forward_pass(series_data, using_dropout, training, dropout_probability);
-    return calculate_error_mae(expected_outputs);
+    int32_t total_length = (int32_t) series_data[0].size();
+    if (window <= 0 || window >= total_length) {
+        forward_pass(series_data, using_dropout, training, dropout_probability);
+        return calculate_error_mae(expected_outputs);
+    }
+
+    vector<double> absolute_errors(output_nodes.size(), 0.0);
+    windowed_forward_pass(
+        series_data, window, using_dropout, training, dropout_probability,
+        [&](int32_t window_start, int32_t length) {
+            for (int32_t i = 0; i < (int32_t) output_nodes.size(); i++) {
+                for (int32_t time = 1; time < length; time++) {
+                    absolute_errors[i] +=
+                        fabs(output_nodes[i]->output_values[time] - expected_outputs[i][window_start + time - 1]);
+                }
+            }
+        }
+    );
+
+    double mae_sum = 0.0;
+    for (int32_t i = 0; i < (int32_t) output_nodes.size(); i++) {
+        mae_sum += absolute_errors[i] / total_length;
+    }
+    return mae_sum;
 }
 
 // vector<double> RNN::get_predictions(
@@ -589,7 +638,24 @@ double RNN::prediction_mae(
 //     return result;
 // }
 
-vector<vector<double>> RNN::get_predictions(const vector< vector<double> > &series_data, const vector< vector<double> > &expected_outputs, bool using_dropout, double dropout_probability) {
+vector<vector<double>> RNN::get_predictions(const vector< vector<double> > &series_data, const vector< vector<double> > &expected_outputs, bool using_dropout, double dropout_probability, int32_t window) {
+    int32_t total_length = (int32_t) series_data[0].size();
+    if (window > 0 && window < total_length) {
+        vector<vector<double>> results(output_nodes.size());
+        windowed_forward_pass(
+            series_data, window, using_dropout, false, dropout_probability,
+            [&](int32_t window_start, int32_t length) {
+                for (int32_t i = 0; i < (int32_t) output_nodes.size(); i++) {
+                    results[i].insert(
+                        results[i].end(), output_nodes[i]->output_values.begin() + 1,
+                        output_nodes[i]->output_values.begin() + length
+                    );
+                }
+            }
+        );
+        return results;
+    }
+
     forward_pass(series_data, using_dropout, false, dropout_probability);
 
     vector<vector<double>> results;
@@ -673,43 +739,275 @@ void RNN::get_analytic_gradient(
     const vector<vector<double> >& outputs, double& mse, vector<double>& analytic_gradient, bool using_dropout,
     bool training, double dropout_probability
 ) {
-    analytic_gradient.assign(test_parameters.size(), 0.0);
-
     set_weights(test_parameters);
     forward_pass(inputs, using_dropout, training, dropout_probability);
 
+    analytic_gradient.assign(test_parameters.size(), 0.0);
+    set_weight_gradients(analytic_gradient);
+
     mse = calculate_error_mse(outputs);
     backward_pass(mse * (1.0 / outputs[0].size()) * 2.0, using_dropout, training, dropout_probability);
+}
 
-    vector<double> current_gradients;
+void RNN::set_weight_gradients(vector<double>& gradients) {
+    if ((int32_t) gradients.size() != get_number_weights()) {
+        Log::fatal(
+            "ERROR! Trying to set weight gradients where the RNN has %d weights, and the gradients vector has %d "
+            "gradients!\n",
+            get_number_weights(), gradients.size()
+        );
+        exit(1);
+    }
 
     int32_t current = 0;
+
     for (int32_t i = 0; i < (int32_t) nodes.size(); i++) {
-        if (nodes[i]->is_reachable()) {
-            nodes[i]->get_gradients(current_gradients);
+        nodes[i]->set_weight_gradients(gradients.data() + current);
+        current += nodes[i]->get_number_weights();
+    }
 
-            for (int32_t j = 0; j < (int32_t) current_gradients.size(); j++) {
-                analytic_gradient[current] = current_gradients[j];
-                current++;
-            }
+    for (int32_t i = 0; i < (int32_t) edges.size(); i++) {
+        edges[i]->d_weight = gradients.data() + current++;
+    }
+
+    for (int32_t i = 0; i < (int32_t) recurrent_edges.size(); i++) {
+        recurrent_edges[i]->d_weight = gradients.data() + current++;
+    }
+}
+
+void RNN::start_windows() {
+    // each window's arrays start with a time 0 holding the node states carried over from the time before the window,
+    // these are where each node's carried state starts in node_states
+    node_state_offsets.clear();
+    int32_t node_state_size = 0;
+    for (int32_t i = 0; i < (int32_t) nodes.size(); i++) {
+        node_state_offsets.push_back(node_state_size);
+        node_state_size += nodes[i]->get_streaming_state_size();
+    }
+
+    // recurrent edges can also reach back past time 0, so the last history_length outputs before the window of each
+    // node a recurrent edge reads from are carried over as well. the carried values are fired deepest first, which is
+    // the order a full forward pass fires them in
+    carried_edges.clear();
+    for (int32_t i = 0; i < (int32_t) recurrent_edges.size(); i++) {
+        if (recurrent_edges[i]->is_reachable()) {
+            carried_edges.push_back(recurrent_edges[i]);
         }
     }
+    stable_sort(
+        carried_edges.begin(), carried_edges.end(),
+        [](const RNN_Recurrent_Edge* e1, const RNN_Recurrent_Edge* e2) {
+            return e1->get_recurrent_depth() > e2->get_recurrent_depth();
+        }
+    );
 
-    for (int32_t i = 0; i < (int32_t) edges.size(); i++) {
-        if (edges[i]->is_reachable()) {
-            analytic_gradient[current] = edges[i]->get_gradient();
-            current++;
+    history_length = 1;
+    history_nodes.clear();
+    history_slots.clear();
+    for (int32_t i = 0; i < (int32_t) carried_edges.size(); i++) {
+        history_length = max(history_length, carried_edges[i]->recurrent_depth);
+
+        int32_t slot = (int32_t) (find(history_nodes.begin(), history_nodes.end(), carried_edges[i]->input_node)
+                                  - history_nodes.begin());
+        if (slot == (int32_t) history_nodes.size()) {
+            history_nodes.push_back(carried_edges[i]->input_node);
         }
+        history_slots[carried_edges[i]] = slot;
+    }
+
+    node_states.assign(node_state_size, 0.0);
+    history.assign(history_nodes.size() * history_length, 0.0);
+    next_node_states.assign(node_state_size, 0.0);
+    next_history.assign(history.size(), 0.0);
+}
+
+void RNN::forward_window(
+    const vector<vector<double> >& series_data, int32_t window_start, int32_t length, bool using_dropout,
+    bool training, double dropout_probability
+) {
+    series_length = length;
+
+    for (int32_t i = 0; i < (int32_t) nodes.size(); i++) {
+        nodes[i]->reset(length);
+        nodes[i]->load_streaming_state(node_states.data() + node_state_offsets[i]);
+    }
+
+    for (int32_t i = 0; i < (int32_t) edges.size(); i++) {
+        edges[i]->reset(length);
     }
 
     for (int32_t i = 0; i < (int32_t) recurrent_edges.size(); i++) {
-        if (recurrent_edges[i]->is_reachable()) {
-            analytic_gradient[current] = recurrent_edges[i]->get_gradient();
-            current++;
+        recurrent_edges[i]->reset(length);
+    }
+
+    for (int32_t i = 0; i < (int32_t) carried_edges.size(); i++) {
+        RNN_Recurrent_Edge* carried_edge = carried_edges[i];
+        int32_t depth = carried_edge->recurrent_depth;
+        for (int32_t time = 1; time <= depth && time < length; time++) {
+            carried_edge->carried_propagate_forward(
+                time, history[(history_slots[carried_edge] * history_length) + depth - time]
+            );
+        }
+    }
+
+    for (int32_t time = 1; time < length; time++) {
+        int32_t series_time = window_start + time - 1;
+        for (int32_t i = 0; i < (int32_t) input_nodes.size(); i++) {
+            if (input_nodes[i]->is_reachable()) {
+                input_nodes[i]->input_fired(time, series_data[i][series_time]);
+            }
+        }
+
+        for (int32_t i = 0; i < (int32_t) edges.size(); i++) {
+            if (edges[i]->is_reachable()) {
+                if (using_dropout) {
+                    edges[i]->propagate_forward(time, training, dropout_probability);
+                } else {
+                    edges[i]->propagate_forward(time);
+                }
+            }
+        }
+
+        for (int32_t i = 0; i < (int32_t) recurrent_edges.size(); i++) {
+            if (recurrent_edges[i]->is_reachable()) {
+                recurrent_edges[i]->propagate_forward(time);
+            }
         }
     }
 }
 
+void RNN::save_window_state(int32_t carried_time) {
+    for (int32_t i = 0; i < (int32_t) nodes.size(); i++) {
+        nodes[i]->save_streaming_state(carried_time, next_node_states.data() + node_state_offsets[i]);
+    }
+
+    for (int32_t slot = 0; slot < (int32_t) history_nodes.size(); slot++) {
+        for (int32_t k = 0; k < history_length; k++) {
+            int32_t time = carried_time - k;
+            next_history[(slot * history_length) + k] =
+                (time >= 1) ? history_nodes[slot]->output_values[time] : history[(slot * history_length) - time];
+        }
+    }
+}
+
+void RNN::next_window() {
+    swap(node_states, next_node_states);
+    swap(history, next_history);
+}
+
+void RNN::windowed_forward_pass(
+    const vector<vector<double> >& series_data, int32_t window, bool using_dropout, bool training,
+    double dropout_probability, const function<void(int32_t, int32_t)>& window_done
+) {
+    int32_t total_length = (int32_t) series_data[0].size();
+    start_windows();
+
+    for (int32_t window_start = 0; window_start < total_length; window_start += window) {
+        int32_t length = min(window, total_length - window_start) + 1;
+        forward_window(series_data, window_start, length, using_dropout, training, dropout_probability);
+        window_done(window_start, length);
+
+        save_window_state(length - 1);
+        next_window();
+    }
+}
+
+void RNN::get_truncated_analytic_gradient(
+    const vector<double>& test_parameters, const vector<vector<double> >& inputs,
+    const vector<vector<double> >& outputs, int32_t window, int32_t stride, double& mse,
+    vector<double>& analytic_gradient, bool using_dropout, bool training, double dropout_probability
+) {
+    // every window's backward pass adds to the gradient
+    analytic_gradient.assign(test_parameters.size(), 0.0);
+    set_weight_gradients(analytic_gradient);
+    set_weights(test_parameters);
+
+    int32_t total_length = (int32_t) inputs[0].size();
+    start_windows();
+
+    vector<double> squared_errors(output_nodes.size(), 0.0);
+
+    // the gradient is linear in the error passed to error_fired, so the full series mse backward_pass multiplies it
+    // by (which is not known until the last window) is applied once at the end
+    double error_scale = (1.0 / total_length) * 2.0;
+
+    // each window adds the error of the next stride steps, and backpropagates it through the last window steps
+    for (int32_t loss_start = 0; loss_start < total_length; loss_start += stride) {
+        int32_t window_end = min(loss_start + stride, total_length);
+        int32_t window_start = max(0, window_end - window);
+        int32_t length = window_end - window_start + 1;
+
+        forward_window(inputs, window_start, length, using_dropout, training, dropout_probability);
+
+        // save the state at the time before the next window starts, which this window has already computed
+        int32_t next_end = min(window_end + stride, total_length);
+        save_window_state(max(0, next_end - window) - window_start);
+
+        // only the steps after the previous window's are errors, the ones before are there for the gradient to flow
+        // back through
+        for (int32_t i = 0; i < (int32_t) output_nodes.size(); i++) {
+            for (int32_t time = 1; time < length; time++) {
+                int32_t series_time = window_start + time - 1;
+                if (series_time >= loss_start) {
+                    double error = output_nodes[i]->output_values[time] - outputs[i][series_time];
+                    output_nodes[i]->error_values[time] = error;
+                    squared_errors[i] += error * error;
+                }
+            }
+        }
+
+        // the same as first_propagate_backward, except the gradient is truncated at time 1
+        for (int32_t i = 0; i < (int32_t) carried_edges.size(); i++) {
+            for (int32_t k = 0; k < carried_edges[i]->recurrent_depth && (length - 1 - k) >= 1; k++) {
+                carried_edges[i]->input_node->output_fired(length - 1 - k, 0.0);
+            }
+        }
+
+        for (int32_t time = length - 1; time >= 1; time--) {
+            for (int32_t i = 0; i < (int32_t) output_nodes.size(); i++) {
+                output_nodes[i]->error_fired(time, error_scale);
+            }
+
+            for (int32_t i = (int32_t) edges.size() - 1; i >= 0; i--) {
+                if (edges[i]->is_reachable()) {
+                    if (using_dropout) {
+                        edges[i]->propagate_backward(time, training, dropout_probability);
+                    } else {
+                        edges[i]->propagate_backward(time);
+                    }
+                }
+            }
+
+            for (int32_t i = (int32_t) recurrent_edges.size() - 1; i >= 0; i--) {
+                RNN_Recurrent_Edge* recurrent_edge = recurrent_edges[i];
+                if (!recurrent_edge->is_reachable()) {
+                    continue;
+                }
+
+                int32_t depth = recurrent_edge->recurrent_depth;
+                if (time - depth >= 1) {
+                    recurrent_edge->propagate_backward(time);
+                } else {
+                    recurrent_edge->carried_propagate_backward(
+                        time, history[(history_slots[recurrent_edge] * history_length) + depth - time]
+                    );
+                }
+            }
+        }
+
+        next_window();
+    }
+
+    mse = 0.0;
+    for (int32_t i = 0; i < (int32_t) output_nodes.size(); i++) {
+        mse += squared_errors[i] / total_length;
+    }
+
+    for (int32_t i = 0; i < (int32_t) analytic_gradient.size(); i++) {
+        analytic_gradient[i] *= mse;
+    }
+}
+
 void RNN::get_empirical_gradient(
     const vector<double>& test_parameters, const vector<vector<double> >& inputs,
     const vector<vector<double> >& outputs, double& mse, vector<double>& empirical_gradient, bool using_dropout,
@@ -750,6 +1048,91 @@ void RNN::get_empirical_gradient(
     mse = original_mse;
 }
 
+void RNN::get_truncated_empirical_gradient(
+    const vector<double>& test_parameters, const vector<vector<double> >& inputs,
+    const vector<vector<double> >& outputs, int32_t window, int32_t stride, double& mse,
+    vector<double>& empirical_gradient, bool using_dropout, bool training, double dropout_probability
+) {
+    empirical_gradient.assign(test_parameters.size(), 0.0);
+
+    int32_t total_length = (int32_t) inputs[0].size();
+
+    // the state each window starts from with the unperturbed weights, which the truncated gradient treats as a
+    // constant input to the window
+    vector<vector<double> > window_node_states;
+    vector<vector<double> > window_histories;
+
+    // the same windows and errors as get_truncated_analytic_gradient, recording the carried state when record is true
+    // and starting each window from the recorded state otherwise
+    auto windows_mse = [&](bool record) {
+        double squared_error = 0.0;
+        int32_t current_window = 0;
+
+        for (int32_t loss_start = 0; loss_start < total_length; loss_start += stride) {
+            int32_t window_end = min(loss_start + stride, total_length);
+            int32_t window_start = max(0, window_end - window);
+            int32_t length = window_end - window_start + 1;
+
+            if (record) {
+                window_node_states.push_back(node_states);
+                window_histories.push_back(history);
+            } else {
+                node_states = window_node_states[current_window];
+                history = window_histories[current_window];
+            }
+            current_window++;
+
+            forward_window(inputs, window_start, length, using_dropout, training, dropout_probability);
+
+            if (record) {
+                int32_t next_end = min(window_end + stride, total_length);
+                save_window_state(max(0, next_end - window) - window_start);
+                next_window();
+            }
+
+            for (int32_t i = 0; i < (int32_t) output_nodes.size(); i++) {
+                for (int32_t time = 1; time < length; time++) {
+                    int32_t series_time = window_start + time - 1;
+                    if (series_time >= loss_start) {
+                        double error = output_nodes[i]->output_values[time] - outputs[i][series_time];
+                        squared_error += error * error;
+                    }
+                }
+            }
+        }
+
+        return squared_error / total_length;
+    };
+
+    set_weights(test_parameters);
+    start_windows();
+    double original_mse = windows_mse(true);
+
+    double save;
+    double diff = 0.00001;
+    double mse1, mse2;
+
+    vector<double> parameters = test_parameters;
+    for (int32_t i = 0; i < (int32_t) parameters.size(); i++) {
+        save = parameters[i];
+
+        parameters[i] = save - diff;
+        set_weights(parameters);
+        mse1 = windows_mse(false);
+
+        parameters[i] = save + diff;
+        set_weights(parameters);
+        mse2 = windows_mse(false);
+
+        empirical_gradient[i] = (mse2 - mse1) / (2.0 * diff);
+        empirical_gradient[i] *= original_mse;
+
+        parameters[i] = save;
+    }
+
+    mse = original_mse;
+}
+
 void RNN::initialize_randomly() {
     int32_t number_of_weights = get_number_weights();
     vector<double> parameters(number_of_weights, 0.0);
@@ -1,6 +1,12 @@
 #ifndef EXAMM_RNN_GENOME_HXX
 #define EXAMM_RNN_GENOME_HXX
 
+#include <functional>
+using std::function;
+
+#include <map>
+using std::map;
+
 #include <string>
 using std::string;
 
@@ -20,10 +26,50 @@ class RNN {
     vector<RNN_Node_Interface*> input_nodes;
     vector<RNN_Node_Interface*> output_nodes;
 
+    // owned by the RNN and deleted one by one in ~RNN. every node and edge is its own heap allocation, as are their
+    // per time step buffers (allocated in reset, and only reallocated for a longer series), so rather than pooling
+    // them an RNN is built once per genome being trained and reused for its evaluations, see the RNN_Genome get_mse,
+    // get_mae and get_softmax overloads taking one
     vector<RNN_Node_Interface*> nodes;
     vector<RNN_Edge*> edges;
     vector<RNN_Recurrent_Edge*> recurrent_edges;
 
+    // the state carried from one window of a windowed pass to the next: each window's arrays start with a time 0
+    // holding the node states from the time before the window, and the last history_length outputs before the window
+    // of each node a recurrent edge reads from, history[(slot * history_length) + k] being the output of the slot's
+    // node k + 1 steps before the window
+    vector<int32_t> node_state_offsets;
+    vector<RNN_Recurrent_Edge*> carried_edges;
+    int32_t history_length;
+    vector<RNN_Node_Interface*> history_nodes;
+    map<RNN_Recurrent_Edge*, int32_t> history_slots;
+    vector<double> node_states;
+    vector<double> history;
+    vector<double> next_node_states;
+    vector<double> next_history;
+
+    // starts carrying state from zeros, as at the start of a series
+    void start_windows();
+    // forward passes series steps window_start .. window_start + length - 2 at times 1 .. length - 1
+    void forward_window(
+        const vector<vector<double> >& series_data, int32_t window_start, int32_t length, bool using_dropout,
+        bool training, double dropout_probability
+    );
+    // saves the state at carried_time of this window for the next one, which next_window then moves to
+    void save_window_state(int32_t carried_time);
+    void next_window();
+
+    /**
+     *  Forward passes the series in consecutive windows of at most window steps, carrying the state across them, and
+     *  calls window_done(window_start, length) after each with the window's outputs at times 1 .. length - 1 of the
+     *  output nodes. The outputs are the same as forward_pass's, but the nodes' and edges' arrays are only ever
+     *  window + 1 steps long.
+     */
+    void windowed_forward_pass(
+        const vector<vector<double> >& series_data, int32_t window, bool using_dropout, bool training,
+        double dropout_probability, const function<void(int32_t, int32_t)>& window_done
+    );
+
    public:
     RNN(vector<RNN_Node_Interface*>& _nodes, vector<RNN_Edge*>& _edges, const vector<string>& input_parameter_names,
         const vector<string>& output_parameter_names);
@@ -47,6 +93,13 @@ class RNN {
     );
     void backward_pass(double error, bool using_dropout, bool training, double dropout_probability);
 
+    /**
+     *  Points the nodes and edges at their weights' places in gradients (the same as in set_weights), so backward
+     *  passes add the gradients of the weights to it directly. gradients needs to stay allocated until the last
+     *  backward pass using it.
+     */
+    void set_weight_gradients(vector<double>& gradients);
+
     double calculate_error_softmax(const vector<vector<double> >& expected_outputs);
     double calculate_error_mse(const vector<vector<double> >& expected_outputs);
     double calculate_error_mae(const vector<vector<double> >& expected_outputs);
@@ -55,13 +108,18 @@ class RNN {
         const vector<vector<double> >& series_data, const vector<vector<double> >& expected_outputs, bool using_dropout,
         bool training, double dropout_probability
     );
+
+    /**
+     *  With window > 0 the series is forward passed in windows of at most window steps (see windowed_forward_pass),
+     *  so evaluating a long series takes no more memory than truncated BPTT training on it. The error is the same.
+     */
     double prediction_mse(
         const vector<vector<double> >& series_data, const vector<vector<double> >& expected_outputs, bool using_dropout,
-        bool training, double dropout_probability
+        bool training, double dropout_probability, int32_t window = 0
     );
     double prediction_mae(
         const vector<vector<double> >& series_data, const vector<vector<double> >& expected_outputs, bool using_dropout,
-        bool training, double dropout_probability
+        bool training, double dropout_probability, int32_t window = 0
     );
 
     // vector<double> get_predictions(
@@ -69,7 +127,7 @@ class RNN {
     //     double dropout_probability
     // );
 
-    vector<vector<double>> get_predictions(const vector< vector<double> > &series_data, const vector< vector<double> > &expected_outputs, bool using_dropout, double dropout_probability);
+    vector<vector<double>> get_predictions(const vector< vector<double> > &series_data, const vector< vector<double> > &expected_outputs, bool using_dropout, double dropout_probability, int32_t window = 0);
 
 
     void write_predictions(
@@ -90,14 +148,39 @@ class RNN {
         const vector<vector<double> >& outputs, double& mse, vector<double>& analytic_gradient, bool using_dropout,
         bool training, double dropout_probability
     );
+
+    /**
+     *  Truncated BPTT: the series is processed in windows of at most window steps, each ending stride steps after the
+     *  last one. The forward state is carried across windows, but each window only adds the error of its last stride
+     *  steps and backpropagates it no further back than the window's start, so the nodes' and edges' arrays are only
+     *  ever window + 1 steps long. stride must be <= window, with window >= the series length this is the same as
+     *  get_analytic_gradient.
+     */
+    void get_truncated_analytic_gradient(
+        const vector<double>& test_parameters, const vector<vector<double> >& inputs,
+        const vector<vector<double> >& outputs, int32_t window, int32_t stride, double& mse,
+        vector<double>& analytic_gradient, bool using_dropout, bool training, double dropout_probability
+    );
     void get_empirical_gradient(
         const vector<double>& test_parameters, const vector<vector<double> >& inputs,
         const vector<vector<double> >& outputs, double& mae, vector<double>& empirical_gradient, bool using_dropout,
         bool training, double dropout_probability
     );
 
+    /**
+     *  The central difference gradient of the error get_truncated_analytic_gradient is the gradient of: each window's
+     *  error with the state carried into the window held at its value for test_parameters.
+     */
+    void get_truncated_empirical_gradient(
+        const vector<double>& test_parameters, const vector<vector<double> >& inputs,
+        const vector<vector<double> >& outputs, int32_t window, int32_t stride, double& mse,
+        vector<double>& empirical_gradient, bool using_dropout, bool training, double dropout_probability
+    );
+
     // RNN* copy();
 
+    friend class StreamingRNN;
+
     friend void get_mse(
         RNN* genome, const vector<vector<double> >& expected, double& mse, vector<vector<double> >& deltas
     );
@@ -4,6 +4,7 @@
 
 RNN_Edge::RNN_Edge(int32_t _innovation_number, RNN_Node_Interface* _input_node, RNN_Node_Interface* _output_node) {
     innovation_number = _innovation_number;
+    d_weight = NULL;
     input_node = _input_node;
     output_node = _output_node;
 
@@ -27,6 +28,7 @@ RNN_Edge::RNN_Edge(
     const vector<RNN_Node_Interface*>& nodes
 ) {
     innovation_number = _innovation_number;
+    d_weight = NULL;
 
     input_innovation_number = _input_innovation_number;
     output_innovation_number = _output_innovation_number;
@@ -76,11 +78,52 @@ RNN_Edge::RNN_Edge(
     }
 }
 
-RNN_Edge* RNN_Edge::copy(const vector<RNN_Node_Interface*> new_nodes) {
+RNN_Edge::RNN_Edge(
+    int32_t _innovation_number, int32_t _input_innovation_number, int32_t _output_innovation_number,
+    const unordered_map<int32_t, RNN_Node_Interface*>& nodes_by_innovation
+) {
+    innovation_number = _innovation_number;
+    d_weight = NULL;
+
+    input_innovation_number = _input_innovation_number;
+    output_innovation_number = _output_innovation_number;
+
+    auto input = nodes_by_innovation.find(input_innovation_number);
+    if (input == nodes_by_innovation.end()) {
+        Log::fatal(
+            "ERROR initializing RNN_Edge, input node with innovation number; %d was not found!\n",
+            input_innovation_number
+        );
+        exit(1);
+    }
+    input_node = input->second;
+
+    auto output = nodes_by_innovation.find(output_innovation_number);
+    if (output == nodes_by_innovation.end()) {
+        Log::fatal(
+            "ERROR initializing RNN_Edge, output node with innovation number; %d was not found!\n",
+            output_innovation_number
+        );
+        exit(1);
+    }
+    output_node = output->second;
+}
+
+RNN_Edge* RNN_Edge::copy(const vector<RNN_Node_Interface*>& new_nodes) {
     RNN_Edge* e = new RNN_Edge(innovation_number, input_innovation_number, output_innovation_number, new_nodes);
+    copy_values_to(e);
+    return e;
+}
+
+RNN_Edge* RNN_Edge::copy(const unordered_map<int32_t, RNN_Node_Interface*>& new_nodes_by_innovation) {
+    RNN_Edge* e =
+        new RNN_Edge(innovation_number, input_innovation_number, output_innovation_number, new_nodes_by_innovation);
+    copy_values_to(e);
+    return e;
+}
 
+void RNN_Edge::copy_values_to(RNN_Edge* e) const {
     e->weight = weight;
-    e->d_weight = d_weight;
 
     e->outputs = outputs;
     e->deltas = deltas;
@@ -88,8 +131,6 @@ RNN_Edge* RNN_Edge::copy(const vector<RNN_Node_Interface*> new_nodes) {
     e->forward_reachable = forward_reachable;
     e->backward_reachable = backward_reachable;
     e->input_number = input_number;
-
-    return e;
 }
 
 void RNN_Edge::propagate_forward(int32_t time) {
@@ -113,7 +154,7 @@ void RNN_Edge::propagate_forward(int32_t time) {
     // input_node->innovation_number, output_node->innovation_number, output, input_node->output_values[time], weight);
 
     outputs[time] = output;
-    output_node->input_fired(time, output);
+    output_node->fire_input(time, output);
     input_number[time] = output_node->inputs_fired[time];
 }
 
@@ -143,7 +184,7 @@ void RNN_Edge::propagate_forward(int32_t time, bool training, double dropout_pro
     }
 
     outputs[time] = output;
-    output_node->input_fired(time, output);
+    output_node->fire_input(time, output);
     input_number[time] = output_node->inputs_fired[time];
 }
 
@@ -177,13 +218,13 @@ void RNN_Edge::propagate_backward(int32_t time) {
         || output_node->node_type == COS_NODE_GP || output_node->node_type == TANH_NODE_GP
         || output_node->node_type == SIGMOID_NODE_GP || output_node->node_type == SUM_NODE_GP
         || output_node->node_type == MULTIPLY_NODE_GP || output_node->node_type == INVERSE_NODE_GP) {
-        d_weight = 0.0;
+        *d_weight = 0.0;
     } else {
-        d_weight += delta * input_node->output_values[time];
+        *d_weight += delta * input_node->output_values[time];
     }
 
     deltas[time] = delta * weight;
-    input_node->output_fired(time, deltas[time]);
+    input_node->fire_output(time, deltas[time]);
 }
 
 void RNN_Edge::propagate_backward(int32_t time, bool training, double dropout_probability) {
@@ -222,17 +263,16 @@ void RNN_Edge::propagate_backward(int32_t time, bool training, double dropout_pr
         || output_node->node_type == COS_NODE_GP || output_node->node_type == TANH_NODE_GP
         || output_node->node_type == SIGMOID_NODE_GP || output_node->node_type == SUM_NODE_GP
         || output_node->node_type == MULTIPLY_NODE_GP || output_node->node_type == INVERSE_NODE_GP) {
-        d_weight = 0.0;
+        *d_weight = 0.0;
     } else {
-        d_weight += delta * input_node->output_values[time];
+        *d_weight += delta * input_node->output_values[time];
     }
 
     deltas[time] = delta * weight;
-    input_node->output_fired(time, deltas[time]);
+    input_node->fire_output(time, deltas[time]);
 }
 
 void RNN_Edge::reset(int32_t series_length) {
-    d_weight = 0.0;
     outputs.resize(series_length);
     deltas.resize(series_length);
     dropped_out.resize(series_length);
@@ -243,10 +283,6 @@ void RNN_Edge::set_weight(double weight) {
     this->weight = weight;
 }
 
-double RNN_Edge::get_gradient() const {
-    return d_weight;
-}
-
 int32_t RNN_Edge::get_innovation_number() const {
     return innovation_number;
 }
@@ -12,7 +12,8 @@ class RNN_Edge {
     vector<bool> dropped_out;
 
     double weight;
-    double d_weight;
+    // where backward passes add the gradient of weight, set by RNN::set_weight_gradients
+    double* d_weight;
 
     bool enabled;
     bool forward_reachable;
@@ -26,6 +27,8 @@ class RNN_Edge {
 
     vector<int32_t> input_number;
 
+    void copy_values_to(RNN_Edge* e) const;
+
    public:
     RNN_Edge(int32_t _innovation_number, RNN_Node_Interface* _input_node, RNN_Node_Interface* _output_node);
 
@@ -34,7 +37,13 @@ class RNN_Edge {
         const vector<RNN_Node_Interface*>& nodes
     );
 
-    RNN_Edge* copy(const vector<RNN_Node_Interface*> new_nodes);
+    RNN_Edge(
+        int32_t _innovation_number, int32_t _input_innovation_number, int32_t _output_innovation_number,
+        const unordered_map<int32_t, RNN_Node_Interface*>& nodes_by_innovation
+    );
+
+    RNN_Edge* copy(const vector<RNN_Node_Interface*>& new_nodes);
+    RNN_Edge* copy(const unordered_map<int32_t, RNN_Node_Interface*>& new_nodes_by_innovation);
 
     void reset(int32_t series_length);
 
@@ -46,7 +55,6 @@ class RNN_Edge {
 
     void set_weight(double weight);
 
-    double get_gradient() const;
     int32_t get_innovation_number() const;
     int32_t get_input_innovation_number() const;
     int32_t get_output_innovation_number() const;
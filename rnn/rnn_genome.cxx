@@ -50,6 +50,10 @@ using std::unordered_map;
 #include <map>
 using std::map;
 
+#include <memory>
+using std::make_shared;
+using std::shared_ptr;
+
 #include "common/color_table.hxx"
 #include "common/log.hxx"
 #include "common/random.hxx"
@@ -99,6 +103,10 @@ RNN_Genome::RNN_Genome(
     best_validation_mse = EXAMM_MAX_DOUBLE;
     best_validation_mae = EXAMM_MAX_DOUBLE;
 
+    optimizer_epochs = 0;
+
+    metadata = make_shared<const RNN_Genome_Metadata>();
+
     nodes = _nodes;
     edges = _edges;
     recurrent_edges = _recurrent_edges;
@@ -122,6 +130,9 @@ RNN_Genome::RNN_Genome(
     use_dropout = false;
     dropout_probability = 0.5;
 
+    tbptt_window = 0;
+    tbptt_stride = 0;
+
     log_filename = "";
 
     int16_t seed = std::chrono::system_clock::now().time_since_epoch().count();
@@ -144,8 +155,10 @@ RNN_Genome::RNN_Genome(
 void RNN_Genome::set_parameter_names(
     const vector<string>& _input_parameter_names, const vector<string>& _output_parameter_names
 ) {
-    input_parameter_names = _input_parameter_names;
-    output_parameter_names = _output_parameter_names;
+    shared_ptr<RNN_Genome_Metadata> updated = make_shared<RNN_Genome_Metadata>(*metadata);
+    updated->input_parameter_names = _input_parameter_names;
+    updated->output_parameter_names = _output_parameter_names;
+    metadata = updated;
 }
 
 RNN_Genome* RNN_Genome::copy() {
@@ -153,18 +166,7 @@ RNN_Genome* RNN_Genome::copy() {
     vector<RNN_Node_Interface*> node_copies;
     vector<RNN_Edge*> edge_copies;
     vector<RNN_Recurrent_Edge*> recurrent_edge_copies;
-
-    for (int32_t i = 0; i < (int32_t) nodes.size(); i++) {
-        node_copies.push_back(nodes[i]->copy());
-    }
-
-    for (int32_t i = 0; i < (int32_t) edges.size(); i++) {
-        edge_copies.push_back(edges[i]->copy(node_copies));
-    }
-
-    for (int32_t i = 0; i < (int32_t) recurrent_edges.size(); i++) {
-        recurrent_edge_copies.push_back(recurrent_edges[i]->copy(node_copies));
-    }
+    copy_genes(node_copies, edge_copies, recurrent_edge_copies);
 
     RNN_Genome* other = new RNN_Genome(node_copies, edge_copies, recurrent_edge_copies);
 
@@ -176,6 +178,9 @@ RNN_Genome* RNN_Genome::copy() {
     other->use_dropout = use_dropout;
     other->dropout_probability = dropout_probability;
 
+    other->tbptt_window = tbptt_window;
+    other->tbptt_stride = tbptt_stride;
+
     other->log_filename = log_filename;
 
 
@@ -186,14 +191,11 @@ RNN_Genome* RNN_Genome::copy() {
     other->best_validation_mae = best_validation_mae;
     other->best_parameters = best_parameters;
 
-    other->input_parameter_names = input_parameter_names;
-    other->output_parameter_names = output_parameter_names;
+    other->optimizer_velocity = optimizer_velocity;
+    other->optimizer_prev_velocity = optimizer_prev_velocity;
+    other->optimizer_epochs = optimizer_epochs;
 
-    other->normalize_type = normalize_type;
-    other->normalize_mins = normalize_mins;
-    other->normalize_maxs = normalize_maxs;
-    other->normalize_avgs = normalize_avgs;
-    other->normalize_std_devs = normalize_std_devs;
+    other->metadata = metadata;
 
     // reachability is assigned in the constructor
     // other->assign_reachability();
@@ -201,6 +203,41 @@ RNN_Genome* RNN_Genome::copy() {
     return other;
 }
 
+void RNN_Genome::copy_genes(
+    vector<RNN_Node_Interface*>& node_copies, vector<RNN_Edge*>& edge_copies,
+    vector<RNN_Recurrent_Edge*>& recurrent_edge_copies
+) const {
+    // the edge copies look their nodes up by innovation number, indexing the node copies once instead of having every
+    // edge search the whole node list
+    unordered_map<int32_t, RNN_Node_Interface*> nodes_by_innovation;
+    nodes_by_innovation.reserve(nodes.size());
+
+    node_copies.reserve(nodes.size());
+    for (int32_t i = 0; i < (int32_t) nodes.size(); i++) {
+        RNN_Node_Interface* node_copy = nodes[i]->copy();
+        node_copies.push_back(node_copy);
+
+        if (!nodes_by_innovation.emplace(node_copy->innovation_number, node_copy).second) {
+            Log::fatal(
+                "ERROR in copying genome, list of nodes has multiple nodes with innovation number %d -- this should "
+                "never happen.\n",
+                node_copy->innovation_number
+            );
+            exit(1);
+        }
+    }
+
+    edge_copies.reserve(edges.size());
+    for (int32_t i = 0; i < (int32_t) edges.size(); i++) {
+        edge_copies.push_back(edges[i]->copy(nodes_by_innovation));
+    }
+
+    recurrent_edge_copies.reserve(recurrent_edges.size());
+    for (int32_t i = 0; i < (int32_t) recurrent_edges.size(); i++) {
+        recurrent_edge_copies.push_back(recurrent_edges[i]->copy(nodes_by_innovation));
+    }
+}
+
 RNN_Genome::~RNN_Genome() {
     RNN_Node_Interface* node;
 
@@ -341,43 +378,53 @@ int32_t RNN_Genome::get_node_count(int32_t node_type) {
 
 
 
-vector<string> RNN_Genome::get_input_parameter_names() const {
-    return input_parameter_names;
+const vector<string>& RNN_Genome::get_input_parameter_names() const {
+    return metadata->input_parameter_names;
 }
 
-vector<string> RNN_Genome::get_output_parameter_names() const {
-    return output_parameter_names;
+const vector<string>& RNN_Genome::get_output_parameter_names() const {
+    return metadata->output_parameter_names;
+}
+
+const shared_ptr<const RNN_Genome_Metadata>& RNN_Genome::get_metadata() const {
+    return metadata;
+}
+
+void RNN_Genome::set_metadata(const shared_ptr<const RNN_Genome_Metadata>& _metadata) {
+    metadata = _metadata;
 }
 
 void RNN_Genome::set_normalize_bounds(
     string _normalize_type, const map<string, double>& _normalize_mins, const map<string, double>& _normalize_maxs,
     const map<string, double>& _normalize_avgs, const map<string, double>& _normalize_std_devs
 ) {
-    normalize_type = _normalize_type;
-    normalize_mins = _normalize_mins;
-    normalize_maxs = _normalize_maxs;
-    normalize_avgs = _normalize_avgs;
-    normalize_std_devs = _normalize_std_devs;
+    shared_ptr<RNN_Genome_Metadata> updated = make_shared<RNN_Genome_Metadata>(*metadata);
+    updated->normalize_type = _normalize_type;
+    updated->normalize_mins = _normalize_mins;
+    updated->normalize_maxs = _normalize_maxs;
+    updated->normalize_avgs = _normalize_avgs;
+    updated->normalize_std_devs = _normalize_std_devs;
+    metadata = updated;
 }
 
-string RNN_Genome::get_normalize_type() const {
-    return normalize_type;
+const string& RNN_Genome::get_normalize_type() const {
+    return metadata->normalize_type;
 }
 
-map<string, double> RNN_Genome::get_normalize_mins() const {
-    return normalize_mins;
+const map<string, double>& RNN_Genome::get_normalize_mins() const {
+    return metadata->normalize_mins;
 }
 
-map<string, double> RNN_Genome::get_normalize_maxs() const {
-    return normalize_maxs;
+const map<string, double>& RNN_Genome::get_normalize_maxs() const {
+    return metadata->normalize_maxs;
 }
 
-map<string, double> RNN_Genome::get_normalize_avgs() const {
-    return normalize_avgs;
+const map<string, double>& RNN_Genome::get_normalize_avgs() const {
+    return metadata->normalize_avgs;
 }
 
-map<string, double> RNN_Genome::get_normalize_std_devs() const {
-    return normalize_std_devs;
+const map<string, double>& RNN_Genome::get_normalize_std_devs() const {
+    return metadata->normalize_std_devs;
 }
 
 int32_t RNN_Genome::get_group_id() const {
@@ -412,6 +459,39 @@ int32_t RNN_Genome::get_enabled_recurrent_edge_count() {
     return count;
 }
 
+void RNN_Genome::set_training_limits(double max_seconds, int32_t max_memory_mb) {
+    training_time_limit = max_seconds;
+    training_memory_limit_kb = (long) max_memory_mb * 1024;
+}
+
+bool RNN_Genome::exceeded_training_limits(
+    std::chrono::time_point<std::chrono::system_clock> start_clock, bool check_memory
+) {
+    if (training_time_limit > 0.0) {
+        double seconds = std::chrono::duration<double>(std::chrono::system_clock::now() - start_clock).count();
+        if (seconds > training_time_limit) {
+            Log::warning(
+                "genome %d exceeded the training time limit (%.3lf of %.3lf seconds), giving up on it\n",
+                generation_id, seconds, training_time_limit
+            );
+            return true;
+        }
+    }
+
+    // memory usage is for the whole process, so with multiple training threads this is a budget they share
+    if (check_memory && training_memory_limit_kb > 0) {
+        long memory_kb = Log::get_memory_usage_kb();
+        if (memory_kb > training_memory_limit_kb) {
+            Log::warning(
+                "genome %d exceeded the training memory limit (%ld of %ld kb), giving up on it\n", generation_id,
+                memory_kb, training_memory_limit_kb
+            );
+            return true;
+        }
+    }
+    return false;
+}
+
 void RNN_Genome::set_bp_iterations(int32_t _bp_iterations) {
     // if (epochs_acc_freq > 0) {
     //     if (generation_id < epochs_acc_freq) bp_iterations = 0;
@@ -461,6 +541,11 @@ void RNN_Genome::enable_dropout(double _dropout_probability) {
     dropout_probability = _dropout_probability;
 }
 
+void RNN_Genome::set_tbptt(int32_t _tbptt_window, int32_t _tbptt_stride) {
+    tbptt_window = _tbptt_window;
+    tbptt_stride = _tbptt_stride;
+}
+
 void RNN_Genome::set_log_filename(string _log_filename) {
     log_filename = _log_filename;
 }
@@ -622,6 +707,7 @@ void RNN_Genome::initialize_randomly(WeightRules* weight_rules) {
 
     this->set_best_parameters(initial_parameters);
     this->set_weights(initial_parameters);
+    clear_optimizer_state();
 }
 
 void RNN_Genome::initialize_xavier(RNN_Node_Interface* n) {
@@ -825,25 +911,12 @@ RNN* RNN_Genome::get_rnn() {
     vector<RNN_Node_Interface*> node_copies;
     vector<RNN_Edge*> edge_copies;
     vector<RNN_Recurrent_Edge*> recurrent_edge_copies;
+    copy_genes(node_copies, edge_copies, recurrent_edge_copies);
 
-    for (int32_t i = 0; i < (int32_t) nodes.size(); i++) {
-        node_copies.push_back(nodes[i]->copy());
-        // if (nodes[i]->layer_type == INPUT_LAYER || nodes[i]->layer_type == OUTPUT_LAYER || nodes[i]->is_reachable())
-        // node_copies.push_back( nodes[i]->copy() );
-    }
-
-    for (int32_t i = 0; i < (int32_t) edges.size(); i++) {
-        edge_copies.push_back(edges[i]->copy(node_copies));
-        // if (edges[i]->is_reachable()) edge_copies.push_back( edges[i]->copy(node_copies) );
-    }
-
-    for (int32_t i = 0; i < (int32_t) recurrent_edges.size(); i++) {
-        recurrent_edge_copies.push_back(recurrent_edges[i]->copy(node_copies));
-        // if (recurrent_edges[i]->is_reachable()) recurrent_edge_copies.push_back(
-        // recurrent_edges[i]->copy(node_copies) );
-    }
-
-    return new RNN(node_copies, edge_copies, recurrent_edge_copies, input_parameter_names, output_parameter_names);
+    return new RNN(
+        node_copies, edge_copies, recurrent_edge_copies, metadata->input_parameter_names,
+        metadata->output_parameter_names
+    );
 }
 
 vector<double> RNN_Genome::get_best_parameters() const {
@@ -937,32 +1010,16 @@ void RNN_Genome::get_analytic_gradient(
     }
     delete[] mses;
 
+    // each rnn's backward pass adds its gradient to analytic_gradient
+    analytic_gradient.assign(parameters.size(), 0.0);
     for (int32_t i = 0; i < (int32_t) rnns.size(); i++) {
         double d_mse = 0.0;
         d_mse = mse_sum * (1.0 / outputs[i][0].size()) * 2.0;
+        rnns[i]->set_weight_gradients(analytic_gradient);
         rnns[i]->backward_pass(d_mse, use_dropout, training, dropout_probability);
     }
 
     mse = mse_sum;
-
-    vector<double> current_gradients;
-    analytic_gradient.assign(parameters.size(), 0.0);
-    for (int32_t k = 0; k < (int32_t) rnns.size(); k++) {
-        int32_t current = 0;
-        for (int32_t i = 0; i < rnns[k]->get_number_nodes(); i++) {
-            rnns[k]->get_node(i)->get_gradients(current_gradients);
-
-            for (int32_t j = 0; j < (int32_t) current_gradients.size(); j++) {
-                analytic_gradient[current] += current_gradients[j];
-                current++;
-            }
-        }
-
-        for (int32_t i = 0; i < rnns[k]->get_number_edges(); i++) {
-            analytic_gradient[current] += rnns[k]->get_edge(i)->get_gradient();
-            current++;
-        }
-    }
 }
 
 void RNN_Genome::backpropagate(
@@ -1014,8 +1071,9 @@ void RNN_Genome::backpropagate(
         if (output_log != NULL) {
             (*output_log) << iteration << " " << mse << " " << validation_mse << " " << best_validation_mse << endl;
         }
-        weight_update_method->norm_gradients(analytic_gradient, norm);
-        weight_update_method->update_weights(parameters, velocity, prev_velocity, analytic_gradient, iteration);
+        weight_update_method->norm_and_update_weights(
+            parameters, velocity, prev_velocity, analytic_gradient, norm, iteration
+        );
         Log::info(
             "iteration %10d, mse: %10lf, v_mse: %10lf, bv_mse: %10lf, norm: %lf", iteration, mse, validation_mse,
             best_validation_mse, norm
@@ -1032,6 +1090,22 @@ void RNN_Genome::backpropagate(
     this->set_weights(best_parameters);
 }
 
+void RNN_Genome::get_training_gradient(
+    RNN* rnn, const vector<double>& parameters, const vector<vector<double> >& inputs,
+    const vector<vector<double> >& outputs, double& mse, vector<double>& analytic_gradient
+) {
+    if (tbptt_window > 0) {
+        rnn->get_truncated_analytic_gradient(
+            parameters, inputs, outputs, tbptt_window, tbptt_stride, mse, analytic_gradient, use_dropout, true,
+            dropout_probability
+        );
+    } else {
+        rnn->get_analytic_gradient(
+            parameters, inputs, outputs, mse, analytic_gradient, use_dropout, true, dropout_probability
+        );
+    }
+}
+
 void RNN_Genome::backpropagate_stochastic(
     const vector<vector<vector<double> > >& inputs, const vector<vector<vector<double> > >& outputs,
     const vector<vector<vector<double> > >& validation_inputs,
@@ -1046,6 +1120,16 @@ void RNN_Genome::backpropagate_stochastic(
     vector<double> analytic_gradient;
     vector<double> prev_gradient(n_parameters, 0.0);
 
+    // continue from the optimizer state inherited along with the initial parameters, if there is one
+    int32_t start_epoch = 0;
+    if ((int32_t) optimizer_velocity.size() == n_parameters
+        && (int32_t) optimizer_prev_velocity.size() == n_parameters) {
+        velocity = optimizer_velocity;
+        prev_velocity = optimizer_prev_velocity;
+        start_epoch = optimizer_epochs;
+        Log::debug("warm starting the optimizer from epoch %d\n", start_epoch);
+    }
+
     double mse;
     double norm = 0.0;
     RNN* rnn = get_rnn();
@@ -1060,19 +1144,27 @@ void RNN_Genome::backpropagate_stochastic(
             "outputs.size(): %d, log filename: '%s'\n",
             i, n_series, parameters.size(), inputs.size(), outputs.size(), log_filename.c_str()
         );
-        rnn->get_analytic_gradient(
-            parameters, inputs[i], outputs[i], mse, analytic_gradient, use_dropout, true, dropout_probability
-        );
+        get_training_gradient(rnn, parameters, inputs[i], outputs[i], mse, analytic_gradient);
         Log::trace("got analytic gradient.\n");
         norm = weight_update_method->get_norm(analytic_gradient);
     }
     Log::trace("initialized previous values.\n");
 
-    // TODO: need to get validation mse on the RNN not the genome
-    double validation_mse = get_mse(parameters, validation_inputs, validation_outputs);
+    if (exceeded_training_limits(startClock, true)) {
+        delete rnn;
+        best_parameters = parameters;
+        this->best_validation_mse = NAN;
+        this->best_validation_mae = NAN;
+        return;
+    }
+
+    double validation_mse = get_mse(rnn, parameters, validation_inputs, validation_outputs);
     best_validation_mse = validation_mse;
-    best_validation_mae = get_mae(parameters, validation_inputs, validation_outputs);
+    best_validation_mae = get_mae(rnn, parameters, validation_inputs, validation_outputs);
     best_parameters = parameters;
+    optimizer_velocity = velocity;
+    optimizer_prev_velocity = prev_velocity;
+    optimizer_epochs = start_epoch;
 
     Log::trace("got initial mses.\n");
     Log::info("initial validation_mse: %lf, best validation mse: %lf\n", validation_mse, best_validation_mse);
@@ -1093,9 +1185,8 @@ void RNN_Genome::backpropagate_stochastic(
         for (int32_t k = 0; k < (int32_t) shuffle_order.size(); k++) {
             int32_t random_selection = shuffle_order[k];
             prev_gradient = analytic_gradient;
-            rnn->get_analytic_gradient(
-                parameters, inputs[random_selection], outputs[random_selection], mse, analytic_gradient, use_dropout,
-                true, dropout_probability
+            get_training_gradient(
+                rnn, parameters, inputs[random_selection], outputs[random_selection], mse, analytic_gradient
             );
 
             norm = weight_update_method->get_norm(analytic_gradient);
@@ -1112,18 +1203,36 @@ void RNN_Genome::backpropagate_stochastic(
                 return;
             }
 
+            // a genome too slow or too large to train (e.g. very deep recurrent connections) fails the same way, so
+            // the process training it is freed up instead of stalling the search
+            if (exceeded_training_limits(startClock, k == 0)) {
+                delete rnn;
+                if (output_log != NULL) {
+                    output_log->close();
+                    delete output_log;
+                }
+                best_parameters = parameters;
+                this->best_validation_mse = NAN;
+                this->best_validation_mae = NAN;
+                return;
+            }
+
             avg_norm += norm;
-            weight_update_method->norm_gradients(analytic_gradient, norm);
-            weight_update_method->update_weights(parameters, velocity, prev_velocity, analytic_gradient, iteration);
+            weight_update_method->norm_and_update_weights(
+                parameters, velocity, prev_velocity, analytic_gradient, norm, start_epoch + iteration
+            );
         }
         this->set_weights(parameters);
-        double training_mse = get_mse(parameters, inputs, outputs);
-        validation_mse = get_mse(parameters, validation_inputs, validation_outputs);
+        double training_mse = get_mse(rnn, parameters, inputs, outputs);
+        validation_mse = get_mse(rnn, parameters, validation_inputs, validation_outputs);
 
         if (validation_mse < best_validation_mse) {
             best_validation_mse = validation_mse;
-            best_validation_mae = get_mae(parameters, validation_inputs, validation_outputs);
+            best_validation_mae = get_mae(rnn, parameters, validation_inputs, validation_outputs);
             best_parameters = parameters;
+            optimizer_velocity = velocity;
+            optimizer_prev_velocity = prev_velocity;
+            optimizer_epochs = start_epoch + iteration + 1;
         }
         if (output_log != NULL) {
             std::chrono::time_point<std::chrono::system_clock> currentClock = std::chrono::system_clock::now();
@@ -1143,6 +1252,123 @@ void RNN_Genome::backpropagate_stochastic(
     get_mu_sigma(best_parameters, _mu, _sigma);
 }
 
+void RNN_Genome::get_weight_keys(vector<tuple<int32_t, int32_t, int32_t> >& keys) {
+    keys.clear();
+
+    for (int32_t i = 0; i < (int32_t) nodes.size(); i++) {
+        for (int32_t j = 0; j < nodes[i]->get_number_weights(); j++) {
+            keys.push_back(tuple<int32_t, int32_t, int32_t>(0, nodes[i]->innovation_number, j));
+        }
+    }
+
+    for (int32_t i = 0; i < (int32_t) edges.size(); i++) {
+        keys.push_back(tuple<int32_t, int32_t, int32_t>(1, edges[i]->innovation_number, 0));
+    }
+
+    for (int32_t i = 0; i < (int32_t) recurrent_edges.size(); i++) {
+        keys.push_back(tuple<int32_t, int32_t, int32_t>(2, recurrent_edges[i]->innovation_number, 0));
+    }
+}
+
+void RNN_Genome::get_optimizer_state(map<tuple<int32_t, int32_t, int32_t>, pair<double, double> >& state) {
+    vector<tuple<int32_t, int32_t, int32_t> > keys;
+    get_weight_keys(keys);
+
+    if (optimizer_velocity.size() != keys.size() || optimizer_prev_velocity.size() != keys.size()) {
+        return;
+    }
+
+    for (int32_t i = 0; i < (int32_t) keys.size(); i++) {
+        state.insert(make_pair(keys[i], make_pair(optimizer_velocity[i], optimizer_prev_velocity[i])));
+    }
+}
+
+void RNN_Genome::set_optimizer_state(
+    const map<tuple<int32_t, int32_t, int32_t>, pair<double, double> >& state, int32_t epochs
+) {
+    if (state.size() == 0) {
+        clear_optimizer_state();
+        return;
+    }
+
+    vector<tuple<int32_t, int32_t, int32_t> > keys;
+    get_weight_keys(keys);
+
+    optimizer_velocity.assign(keys.size(), 0.0);
+    optimizer_prev_velocity.assign(keys.size(), 0.0);
+    for (int32_t i = 0; i < (int32_t) keys.size(); i++) {
+        auto found = state.find(keys[i]);
+        if (found != state.end()) {
+            optimizer_velocity[i] = found->second.first;
+            optimizer_prev_velocity[i] = found->second.second;
+        }
+    }
+    optimizer_epochs = epochs;
+}
+
+void RNN_Genome::clear_optimizer_state() {
+    optimizer_velocity.clear();
+    optimizer_prev_velocity.clear();
+    optimizer_epochs = 0;
+}
+
+int32_t RNN_Genome::get_optimizer_epochs() const {
+    return optimizer_epochs;
+}
+
+void RNN_Genome::fine_tune_online(
+    const vector<vector<vector<double> > >& inputs, const vector<vector<vector<double> > >& outputs,
+    int32_t fine_tune_steps, WeightUpdate* weight_update_method
+) {
+    int32_t n_parameters = this->get_number_weights();
+
+    vector<double> parameters = best_parameters;
+    if ((int32_t) parameters.size() != n_parameters) {
+        parameters = initial_parameters;
+    }
+
+    // the moments only line up with the weights if they came from training this same structure
+    if ((int32_t) optimizer_velocity.size() != n_parameters
+        || (int32_t) optimizer_prev_velocity.size() != n_parameters) {
+        optimizer_velocity.assign(n_parameters, 0.0);
+        optimizer_prev_velocity.assign(n_parameters, 0.0);
+        optimizer_epochs = 0;
+    }
+
+    vector<double> velocity = optimizer_velocity;
+    vector<double> prev_velocity = optimizer_prev_velocity;
+    vector<double> analytic_gradient;
+
+    double mse;
+    double norm;
+    RNN* rnn = get_rnn();
+
+    for (int32_t step = 0; step < fine_tune_steps; step++) {
+        for (int32_t i = 0; i < (int32_t) inputs.size(); i++) {
+            get_training_gradient(rnn, parameters, inputs[i], outputs[i], mse, analytic_gradient);
+
+            norm = weight_update_method->get_norm(analytic_gradient);
+            if (isnan(norm) || isinf(norm)) {
+                // keep the weights and moments from before fine tuning rather than the ones which blew up
+                Log::warning("fine tuning genome %d got a %lf gradient norm, skipping it\n", generation_id, norm);
+                delete rnn;
+                return;
+            }
+
+            weight_update_method->norm_and_update_weights(
+                parameters, velocity, prev_velocity, analytic_gradient, norm, optimizer_epochs + step
+            );
+        }
+    }
+    delete rnn;
+
+    best_parameters = parameters;
+    optimizer_velocity = velocity;
+    optimizer_prev_velocity = prev_velocity;
+    optimizer_epochs += fine_tune_steps;
+    this->set_weights(best_parameters);
+}
+
 ofstream* RNN_Genome::create_log_file() {
     ofstream* output_log = NULL;
     if (log_filename != "") {
@@ -1186,6 +1412,16 @@ double RNN_Genome::get_softmax(
     const vector<vector<vector<double> > >& outputs
 ) {
     RNN* rnn = get_rnn();
+    double avg_softmax = get_softmax(rnn, parameters, inputs, outputs);
+    delete rnn;
+
+    return avg_softmax;
+}
+
+double RNN_Genome::get_softmax(
+    RNN* rnn, const vector<double>& parameters, const vector<vector<vector<double> > >& inputs,
+    const vector<vector<vector<double> > >& outputs
+) {
     rnn->set_weights(parameters);
 
     double softmax = 0.0;
@@ -1199,8 +1435,6 @@ double RNN_Genome::get_softmax(
         Log::trace("series[%5d]: Softmax: %5.10lf\n", i, softmax);
     }
 
-    delete rnn;
-
     avg_softmax /= inputs.size();
     Log::trace("average Softmax: %5.10lf\n", avg_softmax);
     return avg_softmax;
@@ -1211,21 +1445,29 @@ double RNN_Genome::get_mse(
     const vector<vector<vector<double> > >& outputs
 ) {
     RNN* rnn = get_rnn();
+    double avg_mse = get_mse(rnn, parameters, inputs, outputs);
+    delete rnn;
+
+    return avg_mse;
+}
+
+double RNN_Genome::get_mse(
+    RNN* rnn, const vector<double>& parameters, const vector<vector<vector<double> > >& inputs,
+    const vector<vector<vector<double> > >& outputs
+) {
     rnn->set_weights(parameters);
 
     double mse = 0.0;
     double avg_mse = 0.0;
 
     for (int32_t i = 0; i < (int32_t) inputs.size(); i++) {
-        mse = rnn->prediction_mse(inputs[i], outputs[i], use_dropout, false, dropout_probability);
+        mse = rnn->prediction_mse(inputs[i], outputs[i], use_dropout, false, dropout_probability, tbptt_window);
 
         avg_mse += mse;
 
         Log::trace("series[%5d]: MSE: %5.10lf\n", i, mse);
     }
 
-    delete rnn;
-
     avg_mse /= inputs.size();
     Log::trace("average MSE: %5.10lf\n", avg_mse);
     return avg_mse;
@@ -1236,21 +1478,29 @@ double RNN_Genome::get_mae(
     const vector<vector<vector<double> > >& outputs
 ) {
     RNN* rnn = get_rnn();
+    double avg_mae = get_mae(rnn, parameters, inputs, outputs);
+    delete rnn;
+
+    return avg_mae;
+}
+
+double RNN_Genome::get_mae(
+    RNN* rnn, const vector<double>& parameters, const vector<vector<vector<double> > >& inputs,
+    const vector<vector<vector<double> > >& outputs
+) {
     rnn->set_weights(parameters);
 
     double mae;
     double avg_mae = 0.0;
 
     for (int32_t i = 0; i < (int32_t) inputs.size(); i++) {
-        mae = rnn->prediction_mae(inputs[i], outputs[i], use_dropout, false, dropout_probability);
+        mae = rnn->prediction_mae(inputs[i], outputs[i], use_dropout, false, dropout_probability, tbptt_window);
 
         avg_mae += mae;
 
         Log::debug("series[%5d] MAE: %5.10lf\n", i, mae);
     }
 
-    delete rnn;
-
     avg_mae /= inputs.size();
     Log::debug("average MAE: %5.10lf\n", avg_mae);
     return avg_mae;
@@ -1284,7 +1534,7 @@ vector< vector< vector<double> > > RNN_Genome::get_predictions(const vector<doub
 
     //one input vector per testing file
     for (int32_t i = 0; i < (int32_t)inputs.size(); i++) {
-        all_results.push_back(rnn->get_predictions(inputs[i], outputs[i], use_dropout, dropout_probability));
+        all_results.push_back(rnn->get_predictions(inputs[i], outputs[i], use_dropout, dropout_probability, tbptt_window));
     }
 
     delete rnn;
@@ -1314,8 +1564,8 @@ void RNN_Genome::write_predictions(
         Log::info("output filename: '%s'\n", output_filename.c_str());
 
         rnn->write_predictions(
-            output_filename, input_parameter_names, output_parameter_names, inputs[i], outputs[i], time_series_sets,
-            use_dropout, dropout_probability
+            output_filename, metadata->input_parameter_names, metadata->output_parameter_names, inputs[i], outputs[i],
+            time_series_sets, use_dropout, dropout_probability
         );
     }
 
@@ -3019,8 +3269,8 @@ void RNN_Genome::write_graphviz(string filename) {
         outfile << "\t\tnode" << nodes[i]->innovation_number << " [shape=box,color=green,label=\"input "
                 << nodes[i]->innovation_number << "\\ndepth " << nodes[i]->depth;
 
-        if (input_parameter_names.size() != 0) {
-            outfile << "\\n" << input_parameter_names[input_name_index - 1];
+        if (metadata->input_parameter_names.size() != 0) {
+            outfile << "\\n" << metadata->input_parameter_names[input_name_index - 1];
         }
 
         outfile << "\"];" << endl;
@@ -3050,8 +3300,8 @@ void RNN_Genome::write_graphviz(string filename) {
         outfile << "\t\tnode" << nodes[i]->get_innovation_number() << " [shape=box,color=blue,label=\"output "
                 << nodes[i]->innovation_number << "\\ndepth " << nodes[i]->depth;
 
-        if (output_parameter_names.size() != 0) {
-            outfile << "\\n" << output_parameter_names[output_name_index - 1];
+        if (metadata->output_parameter_names.size() != 0) {
+            outfile << "\\n" << metadata->output_parameter_names[output_name_index - 1];
         }
 
         outfile << "\"];" << endl;
@@ -3161,7 +3411,7 @@ void read_map(istream& in, map<string, double>& m) {
     }
 }
 
-void write_map(ostream& out, map<string, double>& m) {
+void write_map(ostream& out, const map<string, double>& m) {
     out << m.size();
 
     for (auto iterator = m.begin(); iterator != m.end(); iterator++) {
@@ -3183,7 +3433,7 @@ void read_map(istream& in, map<string, int32_t>& m) {
     }
 }
 
-void write_map(ostream& out, map<string, int32_t>& m) {
+void write_map(ostream& out, const map<string, int32_t>& m) {
     out << m.size();
     for (auto iterator = m.begin(); iterator != m.end(); iterator++) {
         out << " " << iterator->first;
@@ -3343,7 +3593,20 @@ RNN_Node_Interface* RNN_Genome::read_node_from_stream(istream& bin_istream) {
 void RNN_Genome::read_from_stream(istream& bin_istream) {
     Log::debug("READING GENOME FROM STREAM\n");
 
+    int32_t format_version = 0;
     bin_istream.read((char*) &generation_id, sizeof(int32_t));
+    if (generation_id == RNN_GENOME_MAGIC) {
+        bin_istream.read((char*) &format_version, sizeof(int32_t));
+        if (format_version > RNN_GENOME_VERSION) {
+            Log::fatal(
+                "ERROR: genome format version %d is newer than this build reads (%d)\n", format_version,
+                RNN_GENOME_VERSION
+            );
+            exit(1);
+        }
+        bin_istream.read((char*) &generation_id, sizeof(int32_t));
+    }
+    Log::debug("genome format version: %d\n", format_version);
     bin_istream.read((char*) &group_id, sizeof(int32_t));
     bin_istream.read((char*) &bp_iterations, sizeof(int32_t));
     bin_istream.read((char*) &genome_type, sizeof(int32_t));
@@ -3415,24 +3678,24 @@ void RNN_Genome::read_from_stream(istream& bin_istream) {
         best_parameters.clear();  // ← Ensure it's empty when n_best_parameters is 0
     }
 
-    input_parameter_names.clear();
+    shared_ptr<RNN_Genome_Metadata> read_metadata = make_shared<RNN_Genome_Metadata>();
+
     int32_t n_input_parameter_names;
     bin_istream.read((char*) &n_input_parameter_names, sizeof(int32_t));
     Log::debug("reading %d input parameter names.\n", n_input_parameter_names);
     for (int32_t i = 0; i < n_input_parameter_names; i++) {
         string input_parameter_name;
         read_binary_string(bin_istream, input_parameter_name, "input_parameter_names[" + std::to_string(i) + "]");
-        input_parameter_names.push_back(input_parameter_name);
+        read_metadata->input_parameter_names.push_back(input_parameter_name);
     }
 
-    output_parameter_names.clear();
     int32_t n_output_parameter_names;
     bin_istream.read((char*) &n_output_parameter_names, sizeof(int32_t));
     Log::debug("reading %d output parameter names.\n", n_output_parameter_names);
     for (int32_t i = 0; i < n_output_parameter_names; i++) {
         string output_parameter_name;
         read_binary_string(bin_istream, output_parameter_name, "output_parameter_names[" + std::to_string(i) + "]");
-        output_parameter_names.push_back(output_parameter_name);
+        read_metadata->output_parameter_names.push_back(output_parameter_name);
     }
 
     int32_t n_nodes;
@@ -3501,27 +3764,28 @@ void RNN_Genome::read_from_stream(istream& bin_istream) {
         recurrent_edges.push_back(recurrent_edge);
     }
 
-    read_binary_string(bin_istream, normalize_type, "normalize_type");
+    read_binary_string(bin_istream, read_metadata->normalize_type, "normalize_type");
 
     string normalize_mins_str;
     read_binary_string(bin_istream, normalize_mins_str, "normalize_mins");
     istringstream normalize_mins_iss(normalize_mins_str);
-    read_map(normalize_mins_iss, normalize_mins);
+    read_map(normalize_mins_iss, read_metadata->normalize_mins);
 
     string normalize_maxs_str;
     read_binary_string(bin_istream, normalize_maxs_str, "normalize_maxs");
     istringstream normalize_maxs_iss(normalize_maxs_str);
-    read_map(normalize_maxs_iss, normalize_maxs);
+    read_map(normalize_maxs_iss, read_metadata->normalize_maxs);
 
     string normalize_avgs_str;
     read_binary_string(bin_istream, normalize_avgs_str, "normalize_avgs");
     istringstream normalize_avgs_iss(normalize_avgs_str);
-    read_map(normalize_avgs_iss, normalize_avgs);
+    read_map(normalize_avgs_iss, read_metadata->normalize_avgs);
 
     string normalize_std_devs_str;
     read_binary_string(bin_istream, normalize_std_devs_str, "normalize_std_devs");
     istringstream normalize_std_devs_iss(normalize_std_devs_str);
-    read_map(normalize_std_devs_iss, normalize_std_devs);
+    read_map(normalize_std_devs_iss, read_metadata->normalize_std_devs);
+    metadata = read_metadata;
 
     // Read training indices
     int32_t training_indices_size;
@@ -3532,6 +3796,27 @@ void RNN_Genome::read_from_stream(istream& bin_istream) {
         bin_istream.read((char*) &training_indices[i], sizeof(int32_t));
     }
 
+    clear_optimizer_state();
+    if (format_version >= 1) {
+        int32_t n_optimizer_parameters;
+        bin_istream.read((char*) &n_optimizer_parameters, sizeof(int32_t));
+        bin_istream.read((char*) &optimizer_epochs, sizeof(int32_t));
+        Log::debug("reading %d optimizer parameters.\n", n_optimizer_parameters);
+        if (n_optimizer_parameters > 0) {
+            optimizer_velocity.resize(n_optimizer_parameters);
+            optimizer_prev_velocity.resize(n_optimizer_parameters);
+            bin_istream.read((char*) &optimizer_velocity[0], sizeof(double) * n_optimizer_parameters);
+            bin_istream.read((char*) &optimizer_prev_velocity[0], sizeof(double) * n_optimizer_parameters);
+        }
+    }
+
+    tbptt_window = 0;
+    tbptt_stride = 0;
+    if (format_version >= 2) {
+        bin_istream.read((char*) &tbptt_window, sizeof(int32_t));
+        bin_istream.read((char*) &tbptt_stride, sizeof(int32_t));
+    }
+
     assign_reachability();
 }
 
@@ -3554,6 +3839,10 @@ void RNN_Genome::write_to_file(string bin_filename) {
 }
 
 void RNN_Genome::write_to_stream(ostream& bin_ostream) {
+    int32_t magic = RNN_GENOME_MAGIC;
+    int32_t format_version = RNN_GENOME_VERSION;
+    bin_ostream.write((char*) &magic, sizeof(int32_t));
+    bin_ostream.write((char*) &format_version, sizeof(int32_t));
 
     bin_ostream.write((char*) &generation_id, sizeof(int32_t));
     bin_ostream.write((char*) &group_id, sizeof(int32_t));
@@ -3608,17 +3897,19 @@ void RNN_Genome::write_to_stream(ostream& bin_ostream) {
         bin_ostream.write((char*) &best_parameters[0], sizeof(double) * best_parameters.size());
     }
 
-    int32_t n_input_parameter_names = (int32_t) input_parameter_names.size();
+    int32_t n_input_parameter_names = (int32_t) metadata->input_parameter_names.size();
     bin_ostream.write((char*) &n_input_parameter_names, sizeof(int32_t));
-    for (int32_t i = 0; i < (int32_t) input_parameter_names.size(); i++) {
-        write_binary_string(bin_ostream, input_parameter_names[i], "input_parameter_names[" + std::to_string(i) + "]");
+    for (int32_t i = 0; i < (int32_t) metadata->input_parameter_names.size(); i++) {
+        write_binary_string(
+            bin_ostream, metadata->input_parameter_names[i], "input_parameter_names[" + std::to_string(i) + "]"
+        );
     }
 
-    int32_t n_output_parameter_names = (int32_t) output_parameter_names.size();
+    int32_t n_output_parameter_names = (int32_t) metadata->output_parameter_names.size();
     bin_ostream.write((char*) &n_output_parameter_names, sizeof(int32_t));
-    for (int32_t i = 0; i < (int32_t) output_parameter_names.size(); i++) {
+    for (int32_t i = 0; i < (int32_t) metadata->output_parameter_names.size(); i++) {
         write_binary_string(
-            bin_ostream, output_parameter_names[i], "output_parameter_names[" + std::to_string(i) + "]"
+            bin_ostream, metadata->output_parameter_names[i], "output_parameter_names[" + std::to_string(i) + "]"
         );
     }
 
@@ -3659,25 +3950,25 @@ void RNN_Genome::write_to_stream(ostream& bin_ostream) {
         recurrent_edges[i]->write_to_stream(bin_ostream);
     }
 
-    write_binary_string(bin_ostream, normalize_type, "normalize_type");
+    write_binary_string(bin_ostream, metadata->normalize_type, "normalize_type");
 
     ostringstream normalize_mins_oss;
-    write_map(normalize_mins_oss, normalize_mins);
+    write_map(normalize_mins_oss, metadata->normalize_mins);
     string normalize_mins_str = normalize_mins_oss.str();
     write_binary_string(bin_ostream, normalize_mins_str, "normalize_mins");
 
     ostringstream normalize_maxs_oss;
-    write_map(normalize_maxs_oss, normalize_maxs);
+    write_map(normalize_maxs_oss, metadata->normalize_maxs);
     string normalize_maxs_str = normalize_maxs_oss.str();
     write_binary_string(bin_ostream, normalize_maxs_str, "normalize_maxs");
 
     ostringstream normalize_avgs_oss;
-    write_map(normalize_avgs_oss, normalize_avgs);
+    write_map(normalize_avgs_oss, metadata->normalize_avgs);
     string normalize_avgs_str = normalize_avgs_oss.str();
     write_binary_string(bin_ostream, normalize_avgs_str, "normalize_avgs");
 
     ostringstream normalize_std_devs_oss;
-    write_map(normalize_std_devs_oss, normalize_std_devs);
+    write_map(normalize_std_devs_oss, metadata->normalize_std_devs);
     string normalize_std_devs_str = normalize_std_devs_oss.str();
     write_binary_string(bin_ostream, normalize_std_devs_str, "normalize_std_devs");
 
@@ -3687,6 +3978,18 @@ void RNN_Genome::write_to_stream(ostream& bin_ostream) {
     for (int32_t i = 0; i < training_indices_size; i++) {
         bin_ostream.write((char*) &training_indices[i], sizeof(int32_t));
     }
+
+    // the optimizer state, so offspring trained on workers can pass it on (empty if the genome has none)
+    int32_t n_optimizer_parameters = (int32_t) optimizer_velocity.size();
+    bin_ostream.write((char*) &n_optimizer_parameters, sizeof(int32_t));
+    bin_ostream.write((char*) &optimizer_epochs, sizeof(int32_t));
+    if (n_optimizer_parameters > 0) {
+        bin_ostream.write((char*) &optimizer_velocity[0], sizeof(double) * n_optimizer_parameters);
+        bin_ostream.write((char*) &optimizer_prev_velocity[0], sizeof(double) * n_optimizer_parameters);
+    }
+
+    bin_ostream.write((char*) &tbptt_window, sizeof(int32_t));
+    bin_ostream.write((char*) &tbptt_stride, sizeof(int32_t));
 }
 
 void RNN_Genome::update_innovation_counts(int32_t& node_innovation_count, int32_t& edge_innovation_count) {
@@ -3812,8 +4115,8 @@ void RNN_Genome::transfer_to(
     }
 
     Log::info("original input parameter names:\n");
-    for (int32_t i = 0; i < (int32_t) input_parameter_names.size(); i++) {
-        Log::info_no_header(" %s", input_parameter_names[i].c_str());
+    for (int32_t i = 0; i < (int32_t) metadata->input_parameter_names.size(); i++) {
+        Log::info_no_header(" %s", metadata->input_parameter_names[i].c_str());
     }
     Log::info_no_header("\n");
 
@@ -3907,8 +4210,8 @@ void RNN_Genome::transfer_to(
     }
 
     Log::info("original output parameter names:\n");
-    for (int32_t i = 0; i < (int32_t) output_parameter_names.size(); i++) {
-        Log::info_no_header(" %s", output_parameter_names[i].c_str());
+    for (int32_t i = 0; i < (int32_t) metadata->output_parameter_names.size(); i++) {
+        Log::info_no_header(" %s", metadata->output_parameter_names[i].c_str());
     }
     Log::info_no_header("\n");
 
@@ -1,6 +1,8 @@
 #ifndef RNN_BPTT_HXX
 #define RNN_BPTT_HXX
 
+#include <chrono>
+
 #include <fstream>
 using std::ifstream;
 using std::istream;
@@ -10,17 +12,43 @@ using std::ostream;
 #include <map>
 using std::map;
 
+#include <memory>
+using std::shared_ptr;
+
 #include <random>
 using std::minstd_rand0;
 using std::mt19937;
 using std::uniform_int_distribution;
 using std::uniform_real_distribution;
 
+#include <tuple>
+using std::tuple;
+
+#include <utility>
+using std::make_pair;
+using std::pair;
+
 #include <vector>
 using std::vector;
 
 #include "common/random.hxx"
 #include "rnn.hxx"
+
+/**
+ * The parameter names and normalization bounds of a genome. These are the same for every genome in a run, so genome
+ * copies share one instance instead of copying the vectors and maps. It is never modified once shared, the setters
+ * in RNN_Genome replace it with a new instance instead.
+ */
+struct RNN_Genome_Metadata {
+    vector<string> input_parameter_names;
+    vector<string> output_parameter_names;
+
+    string normalize_type;
+    map<string, double> normalize_mins;
+    map<string, double> normalize_maxs;
+    map<string, double> normalize_avgs;
+    map<string, double> normalize_std_devs;
+};
 #include "rnn_edge.hxx"
 #include "rnn_node_interface.hxx"
 #include "rnn_recurrent_edge.hxx"
@@ -34,6 +62,13 @@ using std::vector;
 #define GENERATED 10
 #define ELITE 11
 
+// genome streams start with RNN_GENOME_MAGIC and their format version, so a reader never has to probe for the end of
+// the stream (genomes are embedded in checkpoints and other streams). streams written before this start directly with
+// the (never negative) generation id and are read as version 0. version 1 added the optimizer state, version 2 the
+// truncated BPTT window and stride.
+#define RNN_GENOME_MAGIC   (-0x45584D4D)
+#define RNN_GENOME_VERSION 2
+
 extern vector<int32_t> dnas_node_types;
 
 string parse_fitness(double fitness);
@@ -50,6 +85,12 @@ class RNN_Genome {
     bool use_dropout;
     double dropout_probability;
 
+    // truncated BPTT window and stride in time steps, a window of 0 backpropagates through the whole series. the
+    // validation mse/mae and predictions are also computed a window at a time, so with a window set neither training
+    // nor evaluation allocates node values for the full series length
+    int32_t tbptt_window;
+    int32_t tbptt_stride;
+
     string structural_hash;
 
     string log_filename;
@@ -62,6 +103,12 @@ class RNN_Genome {
     double best_validation_mae;
     vector<double> best_parameters;
 
+    // the weight update method's moments (velocity and prev_velocity) at best_parameters, and how many epochs they
+    // have been updated for, so training can be continued warm instead of starting the optimizer over
+    vector<double> optimizer_velocity;
+    vector<double> optimizer_prev_velocity;
+    int32_t optimizer_epochs;
+
     minstd_rand0 generator;
 
     uniform_real_distribution<double> rng;
@@ -74,18 +121,18 @@ class RNN_Genome {
     vector<RNN_Edge*> edges;
     vector<RNN_Recurrent_Edge*> recurrent_edges;
 
-    vector<string> input_parameter_names;
-    vector<string> output_parameter_names;
-
-    string normalize_type;
-    map<string, double> normalize_mins;
-    map<string, double> normalize_maxs;
-    map<string, double> normalize_avgs;
-    map<string, double> normalize_std_devs;
+    shared_ptr<const RNN_Genome_Metadata> metadata;
 
     // Training indices used for this genome in online learning
     vector<int32_t> training_indices;
 
+    // wall clock seconds and resident memory (in kb) training may use before the genome is given up on, 0 is no limit.
+    // these belong to the process training the genome so are not copied or serialized
+    double training_time_limit = 0.0;
+    long training_memory_limit_kb = 0;
+
+    bool exceeded_training_limits(std::chrono::time_point<std::chrono::system_clock> start_clock, bool check_memory);
+
    public:
     void sort_nodes_by_depth();
     void sort_edges_by_depth();
@@ -101,6 +148,14 @@ class RNN_Genome {
 
     RNN_Genome* copy();
 
+    /**
+     * Deep copies the nodes and edges, with the edge copies connected to the node copies.
+     */
+    void copy_genes(
+        vector<RNN_Node_Interface*>& node_copies, vector<RNN_Edge*>& edge_copies,
+        vector<RNN_Recurrent_Edge*>& recurrent_edge_copies
+    ) const;
+
     ~RNN_Genome();
 
     static string print_statistics_header();
@@ -134,14 +189,17 @@ class RNN_Genome {
         const map<string, double>& _normalize_avgs, const map<string, double>& _normalize_std_devs
     );
 
-    string get_normalize_type() const;
-    map<string, double> get_normalize_mins() const;
-    map<string, double> get_normalize_maxs() const;
-    map<string, double> get_normalize_avgs() const;
-    map<string, double> get_normalize_std_devs() const;
+    const string& get_normalize_type() const;
+    const map<string, double>& get_normalize_mins() const;
+    const map<string, double>& get_normalize_maxs() const;
+    const map<string, double>& get_normalize_avgs() const;
+    const map<string, double>& get_normalize_std_devs() const;
 
-    vector<string> get_input_parameter_names() const;
-    vector<string> get_output_parameter_names() const;
+    const vector<string>& get_input_parameter_names() const;
+    const vector<string>& get_output_parameter_names() const;
+
+    const shared_ptr<const RNN_Genome_Metadata>& get_metadata() const;
+    void set_metadata(const shared_ptr<const RNN_Genome_Metadata>& _metadata);
 
     int32_t get_group_id() const;
     void set_group_id(int32_t _group_id);
@@ -155,8 +213,16 @@ class RNN_Genome {
     void set_stochastic(bool stochastic);
     void disable_dropout();
     void enable_dropout(double _dropout_probability);
+    void set_tbptt(int32_t _tbptt_window, int32_t _tbptt_stride);
     void set_log_filename(string _log_filename);
 
+    /**
+     *  Bounds how long backpropagate_stochastic may run (in seconds) and how large the training process may grow (in
+     *  MB). A genome going over either is treated like one with NaN gradients: training stops and its fitness is NaN.
+     *  0 turns a limit off.
+     */
+    void set_training_limits(double max_seconds, int32_t max_memory_mb);
+
     void get_weights(vector<double>& parameters);
     void set_weights(const vector<double>& parameters);
 
@@ -204,12 +270,49 @@ class RNN_Genome {
         const vector<vector<vector<double> > >& validation_outputs, WeightUpdate* weight_update_method
     );
 
+    // the gradient backpropagate_stochastic and fine_tune_online train with, truncated if tbptt_window is set
+    void get_training_gradient(
+        RNN* rnn, const vector<double>& parameters, const vector<vector<double> >& inputs,
+        const vector<vector<double> >& outputs, double& mse, vector<double>& analytic_gradient
+    );
+
     void backpropagate_stochastic(
         const vector<vector<vector<double> > >& inputs, const vector<vector<vector<double> > >& outputs,
         const vector<vector<vector<double> > >& validation_inputs,
         const vector<vector<vector<double> > >& validation_outputs, WeightUpdate* weight_update_method
     );
 
+    /**
+     *  Keys each of the genome's weights (in get_weights order) by whether it belongs to a node (0), edge (1) or
+     *  recurrent edge (2), that component's innovation number and the weight's index within the component, so weights
+     *  can be matched up between genomes with different structures.
+     */
+    void get_weight_keys(vector<tuple<int32_t, int32_t, int32_t> >& keys);
+
+    /**
+     *  Adds the optimizer state (velocity, prev_velocity) of each weight to state by its weight key, without replacing
+     *  any already there. The keys come from the current structure, so this needs to be called before it is mutated.
+     */
+    void get_optimizer_state(map<tuple<int32_t, int32_t, int32_t>, pair<double, double> >& state);
+
+    /**
+     *  Sets the optimizer state for the current structure from state, weights which are not in it start from 0.
+     */
+    void set_optimizer_state(const map<tuple<int32_t, int32_t, int32_t>, pair<double, double> >& state, int32_t epochs);
+    void clear_optimizer_state();
+    int32_t get_optimizer_epochs() const;
+
+    /**
+     *  Continues training from best_parameters for fine_tune_steps passes over the given series (typically just the
+     *  newest episode), starting from the optimizer state saved by previous training instead of from scratch.
+     *  best_parameters and the optimizer state are replaced with where it ends up, the validation mse is left for
+     *  the caller to re-evaluate.
+     */
+    void fine_tune_online(
+        const vector<vector<vector<double> > >& inputs, const vector<vector<vector<double> > >& outputs,
+        int32_t fine_tune_steps, WeightUpdate* weight_update_method
+    );
+
     double get_softmax(
         const vector<double>& parameters, const vector<vector<vector<double> > >& inputs,
         const vector<vector<vector<double> > >& outputs
@@ -223,6 +326,21 @@ class RNN_Genome {
         const vector<vector<vector<double> > >& outputs
     );
 
+    // the same as above, but evaluated on an RNN already built from this genome (e.g. the one being trained) so its
+    // nodes, edges and buffers are reused instead of building and tearing down a new RNN for every evaluation
+    double get_softmax(
+        RNN* rnn, const vector<double>& parameters, const vector<vector<vector<double> > >& inputs,
+        const vector<vector<vector<double> > >& outputs
+    );
+    double get_mse(
+        RNN* rnn, const vector<double>& parameters, const vector<vector<vector<double> > >& inputs,
+        const vector<vector<vector<double> > >& outputs
+    );
+    double get_mae(
+        RNN* rnn, const vector<double>& parameters, const vector<vector<vector<double> > >& inputs,
+        const vector<vector<vector<double> > >& outputs
+    );
+
     // vector<vector<double> > get_predictions(
     //     const vector<double>& parameters, const vector<vector<vector<double> > >& inputs,
     //     const vector<vector<vector<double> > >& outputs
@@ -11,6 +11,8 @@ RNN_Node::RNN_Node(int32_t _innovation_number, int32_t _layer_type, double _dept
     : RNN_Node_Interface(_innovation_number, _layer_type, _depth), bias(0) {
     // node type will be simple, jordan or elman
     node_type = _node_type;
+    sums_inputs = true;
+    summed_deltas = &RNN_Node_Interface::d_input;
     Log::trace("created node: %d, layer type: %d, node type: %d\n", innovation_number, layer_type, node_type);
 }
 
@@ -20,6 +22,8 @@ RNN_Node::RNN_Node(
     : RNN_Node_Interface(_innovation_number, _layer_type, _depth, _parameter_name), bias(0) {
     // node type will be simple, jordan or elman
     node_type = _node_type;
+    sums_inputs = true;
+    summed_deltas = &RNN_Node_Interface::d_input;
     Log::trace("created node: %d, layer type: %d, node type: %d\n", innovation_number, layer_type, node_type);
 }
 
@@ -107,10 +111,8 @@ void RNN_Node::try_update_deltas(int32_t time) {
     }
 
     d_input[time] *= ld_output[time];
-    if (node_type == OUTPUT_NODE_GP || node_type == INPUT_NODE_GP) {
-        d_bias = 0.0;
-    } else {
-        d_bias += d_input[time];
+    if (node_type != OUTPUT_NODE_GP && node_type != INPUT_NODE_GP) {
+        weight_gradients[0] += d_input[time];
     }
 }
 
@@ -144,12 +146,6 @@ void RNN_Node::reset(int32_t _series_length) {
 
     inputs_fired.assign(series_length, 0);
     outputs_fired.assign(series_length, 0);
-
-    d_bias = 0.0;
-}
-
-void RNN_Node::get_gradients(vector<double>& gradients) {
-    gradients.assign(1, d_bias);
 }
 
 int32_t RNN_Node::get_number_weights() const {
@@ -189,7 +185,6 @@ RNN_Node_Interface* RNN_Node::copy() const {
 
     // copy RNN_Node values
     n->bias = bias;
-    n->d_bias = d_bias;
     n->ld_output = ld_output;
 
     // copy RNN_Node_Interface values
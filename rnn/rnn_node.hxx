@@ -9,7 +9,6 @@ using std::vector;
 class RNN_Node : public RNN_Node_Interface {
    protected:
     double bias;
-    double d_bias;
 
     vector<double> ld_output;
 
@@ -46,8 +45,6 @@ class RNN_Node : public RNN_Node_Interface {
 
     void reset(int32_t _series_length);
 
-    void get_gradients(vector<double>& gradients);
-
     RNN_Node_Interface* copy() const;
 
     void write_to_stream(ostream& out);
@@ -121,6 +121,10 @@ RNN_Node_Interface::RNN_Node_Interface(int32_t _innovation_number, int32_t _laye
     : innovation_number(_innovation_number), layer_type(_layer_type), depth(_depth) {
     total_inputs = 0;
 
+    sums_inputs = false;
+    summed_deltas = NULL;
+    weight_gradients = NULL;
+
     enabled = true;
     forward_reachable = false;
     backward_reachable = false;
@@ -142,6 +146,10 @@ RNN_Node_Interface::RNN_Node_Interface(
     : innovation_number(_innovation_number), layer_type(_layer_type), depth(_depth), parameter_name(_parameter_name) {
     total_inputs = 0;
 
+    sums_inputs = false;
+    summed_deltas = NULL;
+    weight_gradients = NULL;
+
     enabled = true;
     forward_reachable = false;
     backward_reachable = false;
@@ -215,3 +223,36 @@ void RNN_Node_Interface::write_to_stream(ostream& out) {
 
     write_binary_string(out, parameter_name, "parameter_name");
 }
+
+void RNN_Node_Interface::set_weight_gradients(double* _weight_gradients) {
+    weight_gradients = _weight_gradients;
+}
+
+void RNN_Node_Interface::check_weight_gradients(const string& gradient_name) const {
+    if (weight_gradients == NULL) {
+        Log::fatal(
+            "ERROR: tried to get gradient '%s' of node %d, which has no gradients until RNN::set_weight_gradients is "
+            "called\n",
+            gradient_name.c_str(), innovation_number
+        );
+        exit(1);
+    }
+}
+
+int32_t RNN_Node_Interface::get_streaming_state_size() const {
+    // the node types without a cell only carry their previous output forward
+    return 1;
+}
+
+void RNN_Node_Interface::load_streaming_state(const double* state) {
+    input_values[1] = 0.0;
+    output_values[1] = 0.0;
+    inputs_fired[1] = 0;
+    outputs_fired[1] = 0;
+
+    output_values[0] = state[0];
+}
+
+void RNN_Node_Interface::save_streaming_state(int32_t time, double* state) const {
+    state[0] = output_values[time];
+}
@@ -103,6 +103,22 @@ class RNN_Node_Interface {
     int32_t total_inputs;
     int32_t total_outputs;
 
+    // Node types whose input_fired only adds the incoming value to input_values until the last input arrives set
+    // sums_inputs, and node types whose output_fired only adds the delta to one of their vectors until the last
+    // output arrives point summed_deltas at it. Edges then do those sums inline with fire_input and fire_output, and
+    // only make the virtual call for the value which completes the node, instead of one per edge per time step.
+    // That completing call is still virtual: nodes are not grouped by type or run through per type kernels, as a node
+    // is evaluated by whichever edge completes its inputs rather than by a loop over the nodes which could be bucketed.
+    bool sums_inputs;
+    vector<double> RNN_Node_Interface::*summed_deltas;
+
+    // where backward passes add the gradients of this node's weights, see set_weight_gradients
+    double* weight_gradients;
+
+    // exits with an error if set_weight_gradients has not been called yet, for the get_gradient methods reading
+    // weight_gradients
+    void check_weight_gradients(const string& gradient_name) const;
+
    public:
     // this constructor is for hidden nodes
     RNN_Node_Interface(int32_t _innovation_number, int32_t _layer_type, double _depth);
@@ -124,6 +140,25 @@ class RNN_Node_Interface {
     virtual void output_fired(int32_t time, double delta) = 0;
     virtual void error_fired(int32_t time, double error) = 0;
 
+    // the same as input_fired and output_fired, used by the edges
+    inline void fire_input(int32_t time, double incoming_output) {
+        if (sums_inputs && inputs_fired[time] + 1 < total_inputs) {
+            inputs_fired[time]++;
+            input_values[time] += incoming_output;
+        } else {
+            input_fired(time, incoming_output);
+        }
+    }
+
+    inline void fire_output(int32_t time, double delta) {
+        if (summed_deltas != NULL && outputs_fired[time] + 1 < total_outputs) {
+            outputs_fired[time]++;
+            (this->*summed_deltas)[time] += delta;
+        } else {
+            output_fired(time, delta);
+        }
+    }
+
     virtual int32_t get_number_weights() const = 0;
 
     virtual void get_weights(vector<double>& parameters) const = 0;
@@ -132,12 +167,22 @@ class RNN_Node_Interface {
     virtual void set_weights(int32_t& offset, const vector<double>& parameters) = 0;
     virtual void reset(int32_t _series_length) = 0;
 
-    virtual void get_gradients(vector<double>& gradients) = 0;
+    // points the node at the get_number_weights() gradients backward passes add its weights' gradients to, which
+    // are in the same order as get_weights. they are only ever added to, so they need to be zeroed before the first
+    // backward pass and accumulate over any after it.
+    virtual void set_weight_gradients(double* _weight_gradients);
 
     virtual RNN_Node_Interface* copy() const = 0;
 
     virtual void write_to_stream(ostream& out);
 
+    // used by StreamingRNN and truncated BPTT, which keep the state carried over from before the steps being computed
+    // at time 0 of the node's arrays. load_streaming_state clears time 1 and restores time 0 from state,
+    // save_streaming_state copies what was computed at time out to state.
+    virtual int32_t get_streaming_state_size() const;
+    virtual void load_streaming_state(const double* state);
+    virtual void save_streaming_state(int32_t time, double* state) const;
+
     int32_t get_node_type() const;
     int32_t get_layer_type() const;
     int32_t get_innovation_number() const;
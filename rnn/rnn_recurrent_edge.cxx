@@ -7,6 +7,7 @@ RNN_Recurrent_Edge::RNN_Recurrent_Edge(
     RNN_Node_Interface* _output_node
 ) {
     innovation_number = _innovation_number;
+    d_weight = NULL;
     recurrent_depth = _recurrent_depth;
 
     if (recurrent_depth <= 0) {
@@ -41,6 +42,7 @@ RNN_Recurrent_Edge::RNN_Recurrent_Edge(
     int32_t _output_innovation_number, const vector<RNN_Node_Interface*>& nodes
 ) {
     innovation_number = _innovation_number;
+    d_weight = NULL;
     recurrent_depth = _recurrent_depth;
 
     input_innovation_number = _input_innovation_number;
@@ -99,15 +101,69 @@ RNN_Recurrent_Edge::RNN_Recurrent_Edge(
     }
 }
 
-RNN_Recurrent_Edge* RNN_Recurrent_Edge::copy(const vector<RNN_Node_Interface*> new_nodes) {
+RNN_Recurrent_Edge::RNN_Recurrent_Edge(
+    int32_t _innovation_number, int32_t _recurrent_depth, int32_t _input_innovation_number,
+    int32_t _output_innovation_number, const unordered_map<int32_t, RNN_Node_Interface*>& nodes_by_innovation
+) {
+    innovation_number = _innovation_number;
+    d_weight = NULL;
+    recurrent_depth = _recurrent_depth;
+
+    input_innovation_number = _input_innovation_number;
+    output_innovation_number = _output_innovation_number;
+
+    if (recurrent_depth <= 0) {
+        Log::fatal("ERROR, trying to create a recurrent edge with recurrent depth <= 0\n");
+        Log::fatal("innovation number: %d\n", innovation_number);
+        Log::fatal("input_innovation_number: %d\n", input_innovation_number);
+        Log::fatal("output_innovation_number: %d\n", output_innovation_number);
+        exit(1);
+    }
+
+    auto input = nodes_by_innovation.find(input_innovation_number);
+    if (input == nodes_by_innovation.end()) {
+        Log::fatal(
+            "ERROR initializing RNN_Recurrent_Edge, input node with innovation number; %d was not found!\n",
+            input_innovation_number
+        );
+        exit(1);
+    }
+    input_node = input->second;
+
+    auto output = nodes_by_innovation.find(output_innovation_number);
+    if (output == nodes_by_innovation.end()) {
+        Log::fatal(
+            "ERROR initializing RNN_Recurrent_Edge, output node with innovation number; %d was not found!\n",
+            output_innovation_number
+        );
+        exit(1);
+    }
+    output_node = output->second;
+}
+
+RNN_Recurrent_Edge* RNN_Recurrent_Edge::copy(const vector<RNN_Node_Interface*>& new_nodes) {
     RNN_Recurrent_Edge* e = new RNN_Recurrent_Edge(
         innovation_number, recurrent_depth, input_innovation_number, output_innovation_number, new_nodes
     );
+    copy_values_to(e);
+    return e;
+}
+
+RNN_Recurrent_Edge* RNN_Recurrent_Edge::copy(
+    const unordered_map<int32_t, RNN_Node_Interface*>& new_nodes_by_innovation
+) {
+    RNN_Recurrent_Edge* e = new RNN_Recurrent_Edge(
+        innovation_number, recurrent_depth, input_innovation_number, output_innovation_number,
+        new_nodes_by_innovation
+    );
+    copy_values_to(e);
+    return e;
+}
 
+void RNN_Recurrent_Edge::copy_values_to(RNN_Recurrent_Edge* e) const {
     e->recurrent_depth = recurrent_depth;
 
     e->weight = weight;
-    e->d_weight = d_weight;
 
     e->outputs = outputs;
     e->deltas = deltas;
@@ -117,8 +173,6 @@ RNN_Recurrent_Edge* RNN_Recurrent_Edge::copy(const vector<RNN_Node_Interface*> n
     e->backward_reachable = backward_reachable;
 
     e->input_number = input_number;
-
-    return e;
 }
 
 int32_t RNN_Recurrent_Edge::get_innovation_number() const {
@@ -149,7 +203,7 @@ const RNN_Node_Interface* RNN_Recurrent_Edge::get_output_node() const {
 // input fireds are correct
 void RNN_Recurrent_Edge::first_propagate_forward() {
     for (int32_t i = 0; i < recurrent_depth; i++) {
-        output_node->input_fired(i, 0.0);
+        output_node->fire_input(i, 0.0);
         input_number[i] = output_node->inputs_fired[i];
     }
 }
@@ -170,7 +224,7 @@ void RNN_Recurrent_Edge::propagate_forward(int32_t time) {
         // innovation_number, time, time + recurrent_depth, input_innovation_number, output_innovation_number);
 
         outputs[time + recurrent_depth] = output;
-        output_node->input_fired(time + recurrent_depth, output);
+        output_node->fire_input(time + recurrent_depth, output);
         input_number[time + recurrent_depth] = output_node->inputs_fired[time + recurrent_depth];
     }
 }
@@ -181,7 +235,7 @@ void RNN_Recurrent_Edge::first_propagate_backward() {
     for (int32_t i = 0; i < recurrent_depth; i++) {
         // Log::trace("FIRST propagating backward on recurrent edge %d to time %d from node %d to node %d\n",
         // innovation_number, series_length - 1 - i, output_innovation_number, input_innovation_number);
-        input_node->output_fired(series_length - 1 - i, 0.0);
+        input_node->fire_output(series_length - 1 - i, 0.0);
     }
 }
 
@@ -228,19 +282,53 @@ void RNN_Recurrent_Edge::propagate_backward(int32_t time) {
             || output_node->node_type == COS_NODE_GP || output_node->node_type == TANH_NODE_GP
             || output_node->node_type == SIGMOID_NODE_GP || output_node->node_type == SUM_NODE_GP
             || output_node->node_type == MULTIPLY_NODE_GP || output_node->node_type == INVERSE_NODE_GP) {
-            d_weight = 0.0;
+            *d_weight = 0.0;
         } else {
-            d_weight += delta * input_node->output_values[time - recurrent_depth];
+            *d_weight += delta * input_node->output_values[time - recurrent_depth];
         }
 
         deltas[time] = delta * weight;
-        input_node->output_fired(time - recurrent_depth, deltas[time]);
+        input_node->fire_output(time - recurrent_depth, deltas[time]);
+    }
+}
+
+void RNN_Recurrent_Edge::carried_propagate_forward(int32_t time, double input_value) {
+    outputs[time] = input_value * weight;
+    output_node->fire_input(time, outputs[time]);
+    input_number[time] = output_node->inputs_fired[time];
+}
+
+void RNN_Recurrent_Edge::carried_propagate_backward(int32_t time, double input_value) {
+    if (output_node->outputs_fired[time] != output_node->total_outputs) {
+        Log::fatal(
+            "ERROR! carried propagate backward called on recurrent edge %d where output_node->outputs_fired[%d] (%d) "
+            "!= total_outputs (%d)\n",
+            innovation_number, time, output_node->outputs_fired[time], output_node->total_outputs
+        );
+        exit(1);
     }
+
+    double delta;
+    if (output_node->node_type == MULTIPLY_NODE || output_node->node_type == MULTIPLY_NODE_GP) {
+        delta = output_node->ordered_d_input[time][input_number[time] - 1];
+    } else {
+        delta = output_node->d_input[time];
+    }
+
+    // the same as propagate_backward, the GP node types do not train their recurrent weights
+    if (output_node->node_type == OUTPUT_NODE_GP || output_node->node_type == SIN_NODE_GP
+        || output_node->node_type == COS_NODE_GP || output_node->node_type == TANH_NODE_GP
+        || output_node->node_type == SIGMOID_NODE_GP || output_node->node_type == SUM_NODE_GP
+        || output_node->node_type == MULTIPLY_NODE_GP || output_node->node_type == INVERSE_NODE_GP) {
+        *d_weight = 0.0;
+    } else {
+        *d_weight += delta * input_value;
+    }
+    deltas[time] = delta * weight;
 }
 
 void RNN_Recurrent_Edge::reset(int32_t _series_length) {
     series_length = _series_length;
-    d_weight = 0.0;
     outputs.resize(series_length);
     deltas.resize(series_length);
     input_number.resize(series_length);
@@ -250,10 +338,6 @@ int32_t RNN_Recurrent_Edge::get_recurrent_depth() const {
     return recurrent_depth;
 }
 
-double RNN_Recurrent_Edge::get_gradient() {
-    return d_weight;
-}
-
 bool RNN_Recurrent_Edge::is_enabled() const {
     return enabled;
 }
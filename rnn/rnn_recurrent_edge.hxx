@@ -17,7 +17,8 @@ class RNN_Recurrent_Edge {
     vector<double> deltas;
 
     double weight;
-    double d_weight;
+    // where backward passes add the gradient of weight, set by RNN::set_weight_gradients
+    double* d_weight;
 
     bool enabled;
     bool forward_reachable;
@@ -31,6 +32,8 @@ class RNN_Recurrent_Edge {
 
     vector<int32_t> input_number;
 
+    void copy_values_to(RNN_Recurrent_Edge* e) const;
+
    public:
     RNN_Recurrent_Edge(
         int32_t _innovation_number, int32_t _recurrent_depth, RNN_Node_Interface* _input_node,
@@ -42,6 +45,11 @@ class RNN_Recurrent_Edge {
         int32_t _output_innovation_number, const vector<RNN_Node_Interface*>& nodes
     );
 
+    RNN_Recurrent_Edge(
+        int32_t _innovation_number, int32_t _recurrent_depth, int32_t _input_innovation_number,
+        int32_t _output_innovation_number, const unordered_map<int32_t, RNN_Node_Interface*>& nodes_by_innovation
+    );
+
     void reset(int32_t _series_length);
 
     void first_propagate_forward();
@@ -49,12 +57,17 @@ class RNN_Recurrent_Edge {
     void propagate_forward(int32_t time);
     void propagate_backward(int32_t time);
 
+    // used by truncated BPTT when time - recurrent_depth is before the steps in the arrays: the input node's output
+    // at that time is passed in instead, and no delta is passed back to it
+    void carried_propagate_forward(int32_t time, double input_value);
+    void carried_propagate_backward(int32_t time, double input_value);
+
     int32_t get_recurrent_depth() const;
-    double get_gradient();
     bool is_enabled() const;
     bool is_reachable() const;
 
-    RNN_Recurrent_Edge* copy(const vector<RNN_Node_Interface*> new_nodes);
+    RNN_Recurrent_Edge* copy(const vector<RNN_Node_Interface*>& new_nodes);
+    RNN_Recurrent_Edge* copy(const unordered_map<int32_t, RNN_Node_Interface*>& new_nodes_by_innovation);
 
     int32_t get_innovation_number() const;
     int32_t get_input_innovation_number() const;
@@ -74,6 +87,7 @@ class RNN_Recurrent_Edge {
     friend class EXAMM;
     friend class ONENAS;
     friend class RecDepthFrequencyTable;
+    friend class StreamingRNN;
 };
 
 struct sort_RNN_Recurrent_Edges_by_depth {
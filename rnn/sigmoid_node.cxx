@@ -26,7 +26,6 @@ RNN_Node_Interface* SIGMOID_Node::copy() const {
     SIGMOID_Node* n = new SIGMOID_Node(innovation_number, layer_type, depth);
     // copy RNN_Node values
     n->bias = bias;
-    n->d_bias = d_bias;
     n->ld_output = ld_output;
 
     // copy RNN_Node_Interface values
@@ -0,0 +1,189 @@
+#include <algorithm>
+using std::fill;
+using std::stable_sort;
+
+#include <vector>
+using std::vector;
+
+#include "common/log.hxx"
+#include "streaming_rnn.hxx"
+
+StreamingRNN::StreamingRNN(RNN_Genome* genome, const vector<double>& parameters) {
+    rnn = genome->get_rnn();
+    rnn->set_weights(parameters);
+
+    number_inputs = (int32_t) rnn->input_nodes.size();
+    number_outputs = (int32_t) rnn->output_nodes.size();
+
+    // the arrays are sized once here, from then on load_streaming_state only clears the step being computed
+    for (int32_t i = 0; i < (int32_t) rnn->nodes.size(); i++) {
+        rnn->nodes[i]->reset(2);
+    }
+
+    for (int32_t i = 0; i < (int32_t) rnn->edges.size(); i++) {
+        rnn->edges[i]->reset(2);
+        if (rnn->edges[i]->is_reachable()) {
+            edges.push_back(rnn->edges[i]);
+        }
+    }
+
+    node_state_size = 0;
+    for (int32_t i = 0; i < (int32_t) rnn->nodes.size(); i++) {
+        node_state_offsets.push_back(node_state_size);
+        node_state_size += rnn->nodes[i]->get_streaming_state_size();
+    }
+
+    history_length = 1;
+    for (int32_t i = 0; i < (int32_t) rnn->recurrent_edges.size(); i++) {
+        RNN_Recurrent_Edge* recurrent_edge = rnn->recurrent_edges[i];
+        recurrent_edge->reset(2);
+
+        if (recurrent_edge->is_reachable()) {
+            recurrent_edges.push_back(recurrent_edge);
+            if (recurrent_edge->recurrent_depth > history_length) {
+                history_length = recurrent_edge->recurrent_depth;
+            }
+        }
+    }
+
+    // RNN::forward_pass fires recurrent edges when their input time is computed, so the inputs for a time step arrive
+    // deepest first and in edge order within a depth. firing them in the same order keeps the sums bit for bit the
+    // same as a full forward pass
+    stable_sort(
+        recurrent_edges.begin(), recurrent_edges.end(),
+        [](const RNN_Recurrent_Edge* e1, const RNN_Recurrent_Edge* e2) {
+            return e1->get_recurrent_depth() > e2->get_recurrent_depth();
+        }
+    );
+
+    for (int32_t i = 0; i < (int32_t) recurrent_edges.size(); i++) {
+        int32_t slot = -1;
+        for (int32_t j = 0; j < (int32_t) history_nodes.size(); j++) {
+            if (history_nodes[j] == recurrent_edges[i]->input_node) {
+                slot = j;
+                break;
+            }
+        }
+
+        if (slot < 0) {
+            slot = (int32_t) history_nodes.size();
+            history_nodes.push_back(recurrent_edges[i]->input_node);
+        }
+        recurrent_edge_slots.push_back(slot);
+    }
+
+    state_size = 1 + node_state_size + ((int32_t) history_nodes.size() * history_length);
+
+    Log::debug(
+        "created streaming rnn with %d nodes, %d reachable edges, %d reachable recurrent edges, history length %d and "
+        "state size %d\n",
+        rnn->nodes.size(), edges.size(), recurrent_edges.size(), history_length, state_size
+    );
+}
+
+StreamingRNN::~StreamingRNN() {
+    delete rnn;
+}
+
+int32_t StreamingRNN::get_number_inputs() const {
+    return number_inputs;
+}
+
+int32_t StreamingRNN::get_number_outputs() const {
+    return number_outputs;
+}
+
+int32_t StreamingRNN::get_history_length() const {
+    return history_length;
+}
+
+int32_t StreamingRNN::get_state_size() const {
+    return state_size;
+}
+
+int32_t StreamingRNN::open_stream() {
+    stream_states.push_back(vector<double>(state_size, 0.0));
+    return (int32_t) stream_states.size() - 1;
+}
+
+int32_t StreamingRNN::get_number_streams() const {
+    return (int32_t) stream_states.size();
+}
+
+void StreamingRNN::reset_stream(int32_t stream) {
+    fill(stream_states[stream].begin(), stream_states[stream].end(), 0.0);
+}
+
+int64_t StreamingRNN::get_stream_time(int32_t stream) const {
+    return (int64_t) stream_states[stream][0];
+}
+
+void StreamingRNN::step(int32_t stream, const double* inputs, double* outputs) {
+    double* state = stream_states[stream].data();
+    int64_t time = (int64_t) state[0];
+    double* node_states = state + 1;
+    double* history = node_states + node_state_size;
+
+    for (int32_t i = 0; i < (int32_t) rnn->nodes.size(); i++) {
+        rnn->nodes[i]->load_streaming_state(node_states + node_state_offsets[i]);
+    }
+
+    // the history starts zeroed, so a recurrent edge reaching back before the start of the stream fires 0.0 the same
+    // as first_propagate_forward does
+    for (int32_t i = 0; i < (int32_t) recurrent_edges.size(); i++) {
+        RNN_Recurrent_Edge* recurrent_edge = recurrent_edges[i];
+        int64_t position = (time - recurrent_edge->recurrent_depth + history_length) % history_length;
+        double value = history[(recurrent_edge_slots[i] * history_length) + position];
+
+        recurrent_edge->output_node->input_fired(1, value * recurrent_edge->weight);
+    }
+
+    for (int32_t i = 0; i < number_inputs; i++) {
+        if (rnn->input_nodes[i]->is_reachable()) {
+            rnn->input_nodes[i]->input_fired(1, inputs[i]);
+        }
+    }
+
+    for (int32_t i = 0; i < (int32_t) edges.size(); i++) {
+        edges[i]->propagate_forward(1);
+    }
+
+    for (int32_t i = 0; i < number_outputs; i++) {
+        outputs[i] = rnn->output_nodes[i]->output_values[1];
+    }
+
+    for (int32_t i = 0; i < (int32_t) rnn->nodes.size(); i++) {
+        rnn->nodes[i]->save_streaming_state(1, node_states + node_state_offsets[i]);
+    }
+
+    int64_t position = time % history_length;
+    for (int32_t i = 0; i < (int32_t) history_nodes.size(); i++) {
+        history[(i * history_length) + position] = history_nodes[i]->output_values[1];
+    }
+
+    state[0] = (double) (time + 1);
+}
+
+void StreamingRNN::step(
+    const vector<int32_t>& streams, const vector<vector<double> >& inputs, vector<vector<double> >& outputs
+) {
+    for (int32_t i = 0; i < (int32_t) streams.size(); i++) {
+        step(streams[i], inputs[i].data(), outputs[i].data());
+    }
+}
+
+void StreamingRNN::snapshot(int32_t stream, vector<double>& state) const {
+    state = stream_states[stream];
+}
+
+void StreamingRNN::restore(int32_t stream, const vector<double>& state) {
+    if ((int32_t) state.size() != state_size) {
+        Log::fatal(
+            "ERROR: restoring streaming rnn stream %d from a state of size %d, but the state size is %d\n", stream,
+            state.size(), state_size
+        );
+        exit(1);
+    }
+
+    stream_states[stream] = state;
+}
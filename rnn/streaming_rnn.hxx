@@ -0,0 +1,79 @@
+#ifndef EXAMM_STREAMING_RNN_HXX
+#define EXAMM_STREAMING_RNN_HXX
+
+#include <cstdint>
+
+#include <vector>
+using std::vector;
+
+#include "rnn.hxx"
+#include "rnn_edge.hxx"
+#include "rnn_genome.hxx"
+#include "rnn_node_interface.hxx"
+#include "rnn_recurrent_edge.hxx"
+
+/**
+ *  Runs a trained genome over open ended streams one time step at a time, instead of re-running the forward pass over
+ *  a whole series. The nodes and edges are only two time steps long, and each stream keeps the state its nodes carry
+ *  between steps plus a ring buffer with the last max recurrent depth outputs of the nodes that recurrent edges read
+ *  from, so a step costs O(network size) no matter how long the stream has been running. All the state is allocated
+ *  when a stream is opened, stepping does not allocate.
+ *
+ *  A stream's state is a flat vector of doubles: the number of steps taken, then the node states, then the recurrent
+ *  history. snapshot and restore copy it out and back in, so a stream can be moved or rolled back.
+ */
+class StreamingRNN {
+   private:
+    RNN* rnn;
+
+    int32_t number_inputs;
+    int32_t number_outputs;
+
+    // the largest recurrent depth of a reachable recurrent edge (at least 1)
+    int32_t history_length;
+
+    // where each node's carried state starts, relative to the start of the node states
+    vector<int32_t> node_state_offsets;
+    int32_t node_state_size;
+
+    // nodes which are the input of a reachable recurrent edge, and the history slot each recurrent edge reads from
+    vector<RNN_Node_Interface*> history_nodes;
+    vector<RNN_Recurrent_Edge*> recurrent_edges;
+    vector<int32_t> recurrent_edge_slots;
+
+    vector<RNN_Edge*> edges;
+
+    int32_t state_size;
+    vector<vector<double> > stream_states;
+
+   public:
+    StreamingRNN(RNN_Genome* genome, const vector<double>& parameters);
+    ~StreamingRNN();
+
+    int32_t get_number_inputs() const;
+    int32_t get_number_outputs() const;
+    int32_t get_history_length() const;
+    int32_t get_state_size() const;
+
+    int32_t open_stream();
+    int32_t get_number_streams() const;
+    void reset_stream(int32_t stream);
+    int64_t get_stream_time(int32_t stream) const;
+
+    /**
+     *  Takes one time step on the stream, inputs has number_inputs values in the genome's input parameter order and
+     *  number_outputs values are written to outputs in its output parameter order.
+     */
+    void step(int32_t stream, const double* inputs, double* outputs);
+
+    /**
+     *  Takes one time step on each of the given streams, inputs and outputs are indexed the same as streams and
+     *  outputs needs to already be sized.
+     */
+    void step(const vector<int32_t>& streams, const vector<vector<double> >& inputs, vector<vector<double> >& outputs);
+
+    void snapshot(int32_t stream, vector<double>& state) const;
+    void restore(int32_t stream, const vector<double>& state);
+};
+
+#endif
@@ -25,7 +25,6 @@ RNN_Node_Interface* TANH_Node::copy() const {
     TANH_Node* n = new TANH_Node(innovation_number, layer_type, depth);
     // copy RNN_Node values
     n->bias = bias;
-    n->d_bias = d_bias;
     n->ld_output = ld_output;
 
     // copy RNN_Node_Interface values
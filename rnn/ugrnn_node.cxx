@@ -26,6 +26,8 @@ using std::vector;
 UGRNN_Node::UGRNN_Node(int32_t _innovation_number, int32_t _type, double _depth)
     : RNN_Node_Interface(_innovation_number, _type, _depth) {
     node_type = UGRNN_NODE;
+    sums_inputs = true;
+    summed_deltas = &RNN_Node_Interface::error_values;
 }
 
 UGRNN_Node::~UGRNN_Node() {
@@ -74,28 +76,24 @@ void UGRNN_Node::initialize_uniform_random(minstd_rand0& generator, uniform_real
 }
 
 double UGRNN_Node::get_gradient(string gradient_name) {
-    double gradient_sum = 0.0;
-
-    for (int32_t i = 0; i < series_length; i++) {
-        if (gradient_name == "cw") {
-            gradient_sum += d_cw[i];
-        } else if (gradient_name == "ch") {
-            gradient_sum += d_ch[i];
-        } else if (gradient_name == "c_bias") {
-            gradient_sum += d_c_bias[i];
-        } else if (gradient_name == "gw") {
-            gradient_sum += d_gw[i];
-        } else if (gradient_name == "gh") {
-            gradient_sum += d_gh[i];
-        } else if (gradient_name == "g_bias") {
-            gradient_sum += d_g_bias[i];
-        } else {
-            Log::fatal("ERROR: tried to get unknown gradient: '%s'\n", gradient_name.c_str());
-            exit(1);
-        }
+    check_weight_gradients(gradient_name);
+
+    if (gradient_name == "cw") {
+        return weight_gradients[0];
+    } else if (gradient_name == "ch") {
+        return weight_gradients[1];
+    } else if (gradient_name == "c_bias") {
+        return weight_gradients[2];
+    } else if (gradient_name == "gw") {
+        return weight_gradients[3];
+    } else if (gradient_name == "gh") {
+        return weight_gradients[4];
+    } else if (gradient_name == "g_bias") {
+        return weight_gradients[5];
+    } else {
+        Log::fatal("ERROR: tried to get unknown gradient: '%s'\n", gradient_name.c_str());
+        exit(1);
     }
-
-    return gradient_sum;
 }
 
 void UGRNN_Node::print_gradient(string gradient_name) {
@@ -180,20 +178,20 @@ void UGRNN_Node::try_update_deltas(int32_t time) {
     d_h_prev[time] = d_h * g[time];
 
     double d_g = ((d_h * h_prev) - (d_h * c[time])) * ld_g[time];
-    d_g_bias[time] = d_g;
-    d_gh[time] = d_g * h_prev;
+    weight_gradients[5] += d_g;
+    weight_gradients[4] += d_g * h_prev;
     d_h_prev[time] += d_g * gh;
-    d_gw[time] = d_g * x;
+    weight_gradients[3] += d_g * x;
     d_input[time] = d_g * gw;
 
     double d_c = (1 - g[time]) * d_h * ld_c[time];
 
     d_input[time] += d_c * cw;
-    d_cw[time] = d_c * x;
+    weight_gradients[0] += d_c * x;
 
-    d_c_bias[time] = d_c;
+    weight_gradients[2] += d_c;
 
-    d_ch[time] = d_c * h_prev;
+    weight_gradients[1] += d_c * h_prev;
     d_h_prev[time] += d_c * ch;
 
     // reset the reset gate bias to be around 0
@@ -261,35 +259,9 @@ void UGRNN_Node::get_weights(int32_t& offset, vector<double>& parameters) const
     // Log::debug("got weights from offset %d to %d on UGRNN_Node %d\n", start_offset, end_offset, innovation_number);
 }
 
-void UGRNN_Node::get_gradients(vector<double>& gradients) {
-    gradients.assign(NUMBER_UGRNN_WEIGHTS, 0.0);
-
-    for (int32_t i = 0; i < NUMBER_UGRNN_WEIGHTS; i++) {
-        gradients[i] = 0.0;
-    }
-
-    for (int32_t i = 0; i < series_length; i++) {
-        gradients[0] += d_cw[i];
-        gradients[1] += d_ch[i];
-        gradients[2] += d_c_bias[i];
-
-        gradients[3] += d_gw[i];
-        gradients[4] += d_gh[i];
-        gradients[5] += d_g_bias[i];
-    }
-}
-
 void UGRNN_Node::reset(int32_t _series_length) {
     series_length = _series_length;
 
-    d_cw.assign(series_length, 0.0);
-    d_ch.assign(series_length, 0.0);
-    d_c_bias.assign(series_length, 0.0);
-
-    d_gw.assign(series_length, 0.0);
-    d_gh.assign(series_length, 0.0);
-    d_g_bias.assign(series_length, 0.0);
-
     d_h_prev.assign(series_length, 0.0);
 
     c.assign(series_length, 0.0);
@@ -319,13 +291,6 @@ RNN_Node_Interface* UGRNN_Node::copy() const {
     n->gh = gh;
     n->g_bias = g_bias;
 
-    n->d_cw = d_cw;
-    n->d_ch = d_ch;
-    n->d_c_bias = d_c_bias;
-    n->d_gw = d_gw;
-    n->d_gh = d_gh;
-    n->d_g_bias = d_g_bias;
-
     n->d_h_prev = d_h_prev;
 
     n->c = c;
@@ -24,13 +24,6 @@ class UGRNN_Node : public RNN_Node_Interface {
     double gh;
     double g_bias;
 
-    vector<double> d_cw;
-    vector<double> d_ch;
-    vector<double> d_c_bias;
-    vector<double> d_gw;
-    vector<double> d_gh;
-    vector<double> d_g_bias;
-
     vector<double> d_h_prev;
 
     vector<double> c;
@@ -66,8 +59,6 @@ class UGRNN_Node : public RNN_Node_Interface {
     void get_weights(int32_t& offset, vector<double>& parameters) const;
     void set_weights(int32_t& offset, const vector<double>& parameters);
 
-    void get_gradients(vector<double>& gradients);
-
     void reset(int32_t _series_length);
 
     void write_to_stream(ostream& out);
@@ -0,0 +1,587 @@
+#include <cmath>
+
+#include <algorithm>
+using std::max;
+
+#include <atomic>
+using std::atomic;
+
+#include <climits>
+
+#include <condition_variable>
+using std::condition_variable;
+
+#include <fstream>
+using std::ifstream;
+using std::ios;
+
+#include <mutex>
+using std::lock_guard;
+using std::mutex;
+using std::unique_lock;
+
+#include <string>
+using std::string;
+using std::to_string;
+
+#include <thread>
+using std::thread;
+
+#include <vector>
+using std::vector;
+
+#include "common/arguments.hxx"
+#include "common/log.hxx"
+#include "rnn/rnn_genome.hxx"
+#include "rnn/streaming_rnn.hxx"
+#include "rnn_serve_protocol.hxx"
+
+/**
+ *  A genome loaded once and kept in memory, along with the transforms to take raw values to and from the normalized
+ *  values it was trained on, for each input and output parameter:
+ *      normalized = ((value - shift) / scale) / norm_max
+ *      value = (normalized * norm_max * scale) + shift
+ *  which is the same as TimeSeriesSets for min_max (norm_max is 1) and avg_std_dev normalization.
+ */
+struct ServedModel {
+    string genome_filename;
+    RNN_Genome* genome;
+    StreamingRNN* streaming_rnn;
+
+    vector<double> input_shifts;
+    vector<double> input_scales;
+    vector<double> input_norm_maxs;
+
+    vector<double> output_shifts;
+    vector<double> output_scales;
+    vector<double> output_norm_maxs;
+};
+
+/**
+ *  A SERVE_STEP request waiting for the inference thread to batch it with the others.
+ */
+struct PendingStep {
+    int32_t model;
+    int32_t stream;
+    const double* inputs;
+    double* outputs;
+    bool done;
+};
+
+vector<string> arguments;
+
+mutex models_mutex;
+vector<ServedModel*> models;
+
+mutex queue_mutex;
+condition_variable queue_condition;
+condition_variable done_condition;
+vector<PendingStep*> pending_steps;
+// read by the accept loop and connection threads without holding queue_mutex
+atomic<bool> shutting_down(false);
+
+int listen_fd = -1;
+
+bool get_transform(
+    RNN_Genome* genome, const string& parameter_name, double& shift, double& scale, double& norm_max, string& error
+) {
+    string normalize_type = genome->get_normalize_type();
+
+    if (normalize_type.compare("") == 0 || normalize_type.compare("none") == 0) {
+        shift = 0.0;
+        scale = 1.0;
+        norm_max = 1.0;
+        return true;
+    }
+
+    map<string, double> mins = genome->get_normalize_mins();
+    map<string, double> maxs = genome->get_normalize_maxs();
+    if (mins.count(parameter_name) == 0 || maxs.count(parameter_name) == 0) {
+        error = "genome has no normalization bounds for parameter '" + parameter_name + "'";
+        return false;
+    }
+
+    double min = mins[parameter_name];
+    double max = maxs[parameter_name];
+
+    if (normalize_type.compare("min_max") == 0) {
+        shift = min;
+        // a parameter which was constant in the training data would otherwise divide by zero
+        scale = max > min ? max - min : 1.0;
+        norm_max = 1.0;
+        return true;
+
+    } else if (normalize_type.compare("avg_std_dev") == 0) {
+        map<string, double> avgs = genome->get_normalize_avgs();
+        map<string, double> std_devs = genome->get_normalize_std_devs();
+        if (avgs.count(parameter_name) == 0 || std_devs.count(parameter_name) == 0) {
+            error = "genome has no normalization avg/std dev for parameter '" + parameter_name + "'";
+            return false;
+        }
+
+        shift = avgs[parameter_name];
+        scale = std_devs[parameter_name] > 0.0 ? std_devs[parameter_name] : 1.0;
+        norm_max = fmax((min - shift) / scale, (max - shift) / scale);
+        if (norm_max <= 0.0) {
+            norm_max = 1.0;
+        }
+        return true;
+    }
+
+    error = "unknown normalize type '" + normalize_type + "'";
+    return false;
+}
+
+ServedModel* load_model(string genome_filename, string& error) {
+    // RNN_Genome(string) exits if it can't open the file, which would take the server down with it on a bad swap
+    ifstream bin_infile(genome_filename, ios::in | ios::binary);
+    if (!bin_infile.good()) {
+        error = "could not open genome file '" + genome_filename + "' for reading";
+        return NULL;
+    }
+
+    ServedModel* model = new ServedModel();
+    model->genome_filename = genome_filename;
+    model->genome = new RNN_Genome(bin_infile);
+    bin_infile.close();
+    model->streaming_rnn = new StreamingRNN(model->genome, model->genome->get_best_parameters());
+
+    vector<string> input_parameter_names = model->genome->get_input_parameter_names();
+    vector<string> output_parameter_names = model->genome->get_output_parameter_names();
+
+    bool valid = true;
+    for (int32_t i = 0; valid && i < (int32_t) input_parameter_names.size(); i++) {
+        double shift, scale, norm_max;
+        valid = get_transform(model->genome, input_parameter_names[i], shift, scale, norm_max, error);
+        model->input_shifts.push_back(shift);
+        model->input_scales.push_back(scale);
+        model->input_norm_maxs.push_back(norm_max);
+    }
+
+    for (int32_t i = 0; valid && i < (int32_t) output_parameter_names.size(); i++) {
+        double shift, scale, norm_max;
+        valid = get_transform(model->genome, output_parameter_names[i], shift, scale, norm_max, error);
+        model->output_shifts.push_back(shift);
+        model->output_scales.push_back(scale);
+        model->output_norm_maxs.push_back(norm_max);
+    }
+
+    if (!valid) {
+        delete model->streaming_rnn;
+        delete model->genome;
+        delete model;
+        return NULL;
+    }
+
+    Log::info(
+        "loaded '%s': %d inputs, %d outputs, recurrent history of %d steps, %d doubles of state per stream\n",
+        genome_filename.c_str(), model->streaming_rnn->get_number_inputs(), model->streaming_rnn->get_number_outputs(),
+        model->streaming_rnn->get_history_length(), model->streaming_rnn->get_state_size()
+    );
+    return model;
+}
+
+void delete_model(ServedModel* model) {
+    delete model->streaming_rnn;
+    delete model->genome;
+    delete model;
+}
+
+/**
+ *  Takes everything which has queued up since the last batch, and makes one StreamingRNN::step call per model for all
+ *  of the streams in it (which steps the streams one after another). Connection threads only wait on this, so the more clients there are the larger the batches get.
+ */
+void inference_thread() {
+    Log::set_id("inference");
+
+    vector<PendingStep*> batch;
+
+    // reused between batches so stepping doesn't allocate once they've grown to the largest batch size
+    vector<int32_t> batch_streams;
+    vector<vector<double> > batch_inputs;
+    vector<vector<double> > batch_outputs;
+    vector<PendingStep*> batch_steps;
+
+    while (true) {
+        {
+            unique_lock<mutex> lock(queue_mutex);
+            queue_condition.wait(lock, [] { return pending_steps.size() > 0 || shutting_down; });
+            if (pending_steps.size() == 0) {
+                break;
+            }
+            batch.swap(pending_steps);
+        }
+
+        {
+            lock_guard<mutex> models_lock(models_mutex);
+
+            for (int32_t m = 0; m < (int32_t) models.size(); m++) {
+                ServedModel* model = models[m];
+                int32_t number_inputs = model->streaming_rnn->get_number_inputs();
+                int32_t number_outputs = model->streaming_rnn->get_number_outputs();
+
+                batch_streams.clear();
+                batch_steps.clear();
+                for (int32_t i = 0; i < (int32_t) batch.size(); i++) {
+                    if (batch[i]->model == m) {
+                        batch_streams.push_back(batch[i]->stream);
+                        batch_steps.push_back(batch[i]);
+                    }
+                }
+                if (batch_steps.size() == 0) {
+                    continue;
+                }
+
+                if (batch_inputs.size() < batch_steps.size()) {
+                    batch_inputs.resize(batch_steps.size());
+                    batch_outputs.resize(batch_steps.size());
+                }
+
+                for (int32_t i = 0; i < (int32_t) batch_steps.size(); i++) {
+                    batch_inputs[i].resize(number_inputs);
+                    batch_outputs[i].resize(number_outputs);
+                    for (int32_t j = 0; j < number_inputs; j++) {
+                        batch_inputs[i][j] = ((batch_steps[i]->inputs[j] - model->input_shifts[j])
+                                              / model->input_scales[j])
+                                             / model->input_norm_maxs[j];
+                    }
+                }
+
+                model->streaming_rnn->step(batch_streams, batch_inputs, batch_outputs);
+
+                for (int32_t i = 0; i < (int32_t) batch_steps.size(); i++) {
+                    for (int32_t j = 0; j < number_outputs; j++) {
+                        batch_steps[i]->outputs[j] = (batch_outputs[i][j] * model->output_norm_maxs[j]
+                                                      * model->output_scales[j])
+                                                     + model->output_shifts[j];
+                    }
+                }
+            }
+        }
+
+        {
+            lock_guard<mutex> lock(queue_mutex);
+            for (int32_t i = 0; i < (int32_t) batch.size(); i++) {
+                batch[i]->done = true;
+            }
+        }
+        done_condition.notify_all();
+        batch.clear();
+    }
+
+    Log::release_id("inference");
+}
+
+bool write_error(int fd, string message) {
+    Log::warning("%s\n", message.c_str());
+    return serve_write_response(fd, SERVE_ERROR, message.c_str(), (int32_t) message.size());
+}
+
+/**
+ *  Checks the model and stream of a request (stream is only checked if check_stream is true), returning the number of
+ *  inputs and outputs of the model.
+ */
+bool check_request(
+    int32_t model, int32_t stream, bool check_stream, int32_t& number_inputs, int32_t& number_outputs, string& error
+) {
+    lock_guard<mutex> models_lock(models_mutex);
+
+    if (model < 0 || model >= (int32_t) models.size()) {
+        error = "unknown model " + to_string(model);
+        return false;
+    }
+
+    StreamingRNN* streaming_rnn = models[model]->streaming_rnn;
+    if (check_stream && (stream < 0 || stream >= streaming_rnn->get_number_streams())) {
+        error = "unknown stream " + to_string(stream) + " on model " + to_string(model);
+        return false;
+    }
+
+    number_inputs = streaming_rnn->get_number_inputs();
+    number_outputs = streaming_rnn->get_number_outputs();
+    return true;
+}
+
+/**
+ *  The largest payload a valid request with this command can have: the inputs of the model with the most of them for
+ *  a step, a path for a swap and nothing otherwise. Checked before the payload is read, so a client can't make the
+ *  server allocate whatever length it sends.
+ */
+int32_t max_payload_length(int32_t command) {
+    if (command == SERVE_STEP) {
+        lock_guard<mutex> models_lock(models_mutex);
+        int32_t max_inputs = 0;
+        for (int32_t i = 0; i < (int32_t) models.size(); i++) {
+            max_inputs = max(max_inputs, models[i]->streaming_rnn->get_number_inputs());
+        }
+        return max_inputs * (int32_t) sizeof(double);
+    } else if (command == SERVE_SWAP_GENOME) {
+        return PATH_MAX;
+    }
+    return 0;
+}
+
+void connection_thread(int fd, int32_t connection_id) {
+    string log_id = "connection_" + to_string(connection_id);
+    Log::set_id(log_id);
+    Log::debug("accepted connection %d\n", connection_id);
+
+    vector<char> payload;
+    vector<double> inputs;
+    vector<double> outputs;
+
+    while (true) {
+        int32_t header[4];
+        if (!serve_read(fd, header, sizeof(header))) {
+            break;
+        }
+
+        int32_t command = header[0];
+        int32_t model = header[1];
+        int32_t stream = header[2];
+        if (!serve_read_payload(fd, header[3], max_payload_length(command), payload)) {
+            Log::warning(
+                "connection %d sent a %d byte payload for command %d, closing it\n", connection_id, header[3], command
+            );
+            break;
+        }
+
+        bool written = false;
+        string error;
+        int32_t number_inputs, number_outputs;
+
+        if (command == SERVE_INFO) {
+            if (!check_request(model, stream, false, number_inputs, number_outputs, error)) {
+                written = write_error(fd, error);
+            } else {
+                int32_t number_models;
+                {
+                    lock_guard<mutex> models_lock(models_mutex);
+                    number_models = (int32_t) models.size();
+                }
+                int32_t info[3] = {number_models, number_inputs, number_outputs};
+                written = serve_write_response(fd, SERVE_OK, info, sizeof(info));
+            }
+
+        } else if (command == SERVE_OPEN_STREAM) {
+            if (!check_request(model, stream, false, number_inputs, number_outputs, error)) {
+                written = write_error(fd, error);
+            } else {
+                int32_t new_stream;
+                {
+                    lock_guard<mutex> models_lock(models_mutex);
+                    new_stream = models[model]->streaming_rnn->open_stream();
+                }
+                written = serve_write_response(fd, SERVE_OK, &new_stream, sizeof(new_stream));
+            }
+
+        } else if (command == SERVE_RESET_STREAM) {
+            if (!check_request(model, stream, true, number_inputs, number_outputs, error)) {
+                written = write_error(fd, error);
+            } else {
+                {
+                    lock_guard<mutex> models_lock(models_mutex);
+                    models[model]->streaming_rnn->reset_stream(stream);
+                }
+                written = serve_write_response(fd, SERVE_OK, NULL, 0);
+            }
+
+        } else if (command == SERVE_STEP) {
+            if (!check_request(model, stream, true, number_inputs, number_outputs, error)) {
+                written = write_error(fd, error);
+            } else if ((int32_t) payload.size() != number_inputs * (int32_t) sizeof(double)) {
+                written = write_error(
+                    fd, "step on model " + to_string(model) + " expects " + to_string(number_inputs)
+                            + " inputs but got " + to_string(payload.size()) + " bytes"
+                );
+            } else {
+                inputs.resize(number_inputs);
+                outputs.resize(number_outputs);
+                memcpy(inputs.data(), payload.data(), payload.size());
+
+                PendingStep pending_step = {model, stream, inputs.data(), outputs.data(), false};
+                bool queued = false;
+                {
+                    // the inference thread drains everything queued before it sees shutting_down with an empty
+                    // queue, so only steps arriving after the shutdown need to be turned away here
+                    unique_lock<mutex> lock(queue_mutex);
+                    if (!shutting_down) {
+                        pending_steps.push_back(&pending_step);
+                        queue_condition.notify_one();
+                        done_condition.wait(lock, [&pending_step] { return pending_step.done; });
+                        queued = true;
+                    }
+                }
+
+                if (!queued) {
+                    written = write_error(fd, "step on model " + to_string(model) + " after the server shut down");
+                } else {
+                    written = serve_write_response(
+                        fd, SERVE_OK, outputs.data(), (int32_t) (outputs.size() * sizeof(double))
+                    );
+                }
+            }
+
+        } else if (command == SERVE_SWAP_GENOME) {
+            string genome_filename(payload.begin(), payload.end());
+
+            if (!check_request(model, stream, false, number_inputs, number_outputs, error)) {
+                written = write_error(fd, error);
+            } else {
+                // loading can take a while, so it's done before taking the lock and steps keep being served on the
+                // old genome until the swap
+                ServedModel* new_model = load_model(genome_filename, error);
+
+                if (new_model == NULL) {
+                    written = write_error(fd, "could not swap in '" + genome_filename + "': " + error);
+                } else {
+                    ServedModel* old_model = NULL;
+                    {
+                        lock_guard<mutex> models_lock(models_mutex);
+                        RNN_Genome* old_genome = models[model]->genome;
+
+                        if (new_model->genome->get_input_parameter_names() == old_genome->get_input_parameter_names()
+                            && new_model->genome->get_output_parameter_names()
+                                   == old_genome->get_output_parameter_names()) {
+                            old_model = models[model];
+
+                            // the new genome has its own structure, so open streams keep their ids but restart
+                            // from an empty state
+                            while (new_model->streaming_rnn->get_number_streams()
+                                   < old_model->streaming_rnn->get_number_streams()) {
+                                new_model->streaming_rnn->open_stream();
+                            }
+                            models[model] = new_model;
+                        }
+                    }
+
+                    if (old_model == NULL) {
+                        delete_model(new_model);
+                        written = write_error(
+                            fd, "could not swap in '" + genome_filename
+                                    + "': its input and output parameters differ from the genome being served"
+                        );
+                    } else {
+                        Log::info(
+                            "swapped model %d from '%s' to '%s'\n", model, old_model->genome_filename.c_str(),
+                            genome_filename.c_str()
+                        );
+                        delete_model(old_model);
+                        written = serve_write_response(fd, SERVE_OK, NULL, 0);
+                    }
+                }
+            }
+
+        } else if (command == SERVE_SHUTDOWN) {
+            Log::info("received shutdown\n");
+            {
+                lock_guard<mutex> lock(queue_mutex);
+                shutting_down = true;
+            }
+            queue_condition.notify_all();
+            written = serve_write_response(fd, SERVE_OK, NULL, 0);
+
+            // wakes up the accept in main
+            shutdown(listen_fd, SHUT_RDWR);
+
+        } else {
+            written = write_error(fd, "unknown command " + to_string(command));
+        }
+
+        if (!written) {
+            break;
+        }
+    }
+
+    Log::debug("closing connection %d\n", connection_id);
+    close(fd);
+    Log::release_id(log_id);
+}
+
+int main(int argc, char** argv) {
+    arguments = vector<string>(argv, argv + argc);
+
+    Log::initialize(arguments);
+    Log::set_id("main");
+
+    vector<string> genome_filenames;
+    get_argument_vector(arguments, "--genome_files", true, genome_filenames);
+
+    // listen on a unix domain socket if --socket_path is given, otherwise on localhost:--port
+    string socket_path = "";
+    get_argument(arguments, "--socket_path", false, socket_path);
+
+    int32_t port = 0;
+    get_argument(arguments, "--port", false, port);
+
+    if (socket_path.compare("") == 0 && port <= 0) {
+        Log::fatal("ERROR: rnn_serve needs either --socket_path or --port\n");
+        exit(1);
+    }
+
+    for (int32_t i = 0; i < (int32_t) genome_filenames.size(); i++) {
+        string error;
+        ServedModel* model = load_model(genome_filenames[i], error);
+        if (model == NULL) {
+            Log::fatal("ERROR: could not load '%s': %s\n", genome_filenames[i].c_str(), error.c_str());
+            exit(1);
+        }
+        models.push_back(model);
+    }
+
+    listen_fd = serve_listen(socket_path, port);
+    if (listen_fd < 0) {
+        Log::fatal("ERROR: could not listen: %s\n", strerror(errno));
+        exit(1);
+    }
+
+    if (socket_path.compare("") != 0) {
+        Log::info("serving %d genomes on '%s'\n", models.size(), socket_path.c_str());
+    } else {
+        Log::info("serving %d genomes on localhost:%d\n", models.size(), port);
+    }
+
+    thread inference(inference_thread);
+
+    int32_t connection_id = 0;
+    while (true) {
+        int fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0) {
+            // a shutdown request closes the listening socket to get out of here
+            if (shutting_down) {
+                break;
+            }
+            Log::warning("accept failed: %s\n", strerror(errno));
+            continue;
+        }
+
+        if (socket_path.compare("") == 0) {
+            int no_delay = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+        }
+
+        // connections are independent of each other and close themselves, so they are not joined
+        thread(connection_thread, fd, connection_id++).detach();
+    }
+
+    {
+        lock_guard<mutex> lock(queue_mutex);
+        shutting_down = true;
+    }
+    queue_condition.notify_all();
+    inference.join();
+
+    for (int32_t i = 0; i < (int32_t) models.size(); i++) {
+        delete_model(models[i]);
+    }
+    models.clear();
+
+    close(listen_fd);
+    if (socket_path.compare("") != 0) {
+        unlink(socket_path.c_str());
+    }
+
+    Log::info("rnn_serve shut down\n");
+    Log::release_id("main");
+    return 0;
+}
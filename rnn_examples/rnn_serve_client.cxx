@@ -0,0 +1,269 @@
+#include <chrono>
+
+#include <cmath>
+
+#include <functional>
+using std::cref;
+
+#include <mutex>
+using std::lock_guard;
+using std::mutex;
+
+#include <string>
+using std::string;
+
+#include <thread>
+using std::thread;
+
+#include <vector>
+using std::vector;
+
+#include "common/arguments.hxx"
+#include "common/log.hxx"
+#include "rnn/rnn_genome.hxx"
+#include "rnn_serve_protocol.hxx"
+#include "time_series/time_series.hxx"
+
+/**
+ *  A loopback test for rnn_serve: replays the testing files through the server on --number_streams concurrent streams
+ *  (each on its own connection, stream i replays file i % number of files) and checks the denormalized predictions
+ *  against RNN_Genome's own for the same genome file. If --swap_genome_file is given it is then hot swapped in and
+ *  the check is repeated against it.
+ */
+
+vector<string> arguments;
+
+string socket_path = "";
+int32_t port = 0;
+
+mutex results_mutex;
+double max_difference = 0.0;
+int64_t total_steps = 0;
+bool failed = false;
+
+int connect_to_server() {
+    int fd = serve_connect(socket_path, port);
+    if (fd < 0) {
+        Log::fatal("ERROR: could not connect to rnn_serve: %s\n", strerror(errno));
+        exit(1);
+    }
+    return fd;
+}
+
+bool request(int fd, int32_t command, int32_t stream, const void* payload, int32_t length, vector<char>& response) {
+    int32_t status;
+    if (!serve_write_request(fd, command, 0, stream, payload, length) || !serve_read_response(fd, status, response)) {
+        Log::error("lost the connection to rnn_serve\n");
+        return false;
+    }
+
+    if (status != SERVE_OK) {
+        Log::error("rnn_serve returned an error: %s\n", string(response.begin(), response.end()).c_str());
+        return false;
+    }
+    return true;
+}
+
+void stream_thread(
+    const vector<vector<double> >& inputs, const vector<vector<double> >& expected, int32_t number_outputs
+) {
+    int fd = connect_to_server();
+    vector<char> response;
+
+    bool ok = request(fd, SERVE_OPEN_STREAM, 0, NULL, 0, response);
+    int32_t stream = 0;
+    if (ok) {
+        memcpy(&stream, response.data(), sizeof(int32_t));
+    }
+
+    double difference = 0.0;
+    int32_t series_length = ok ? (int32_t) inputs[0].size() : 0;
+    vector<double> step_inputs(inputs.size());
+
+    for (int32_t time = 0; time < series_length && ok; time++) {
+        for (int32_t i = 0; i < (int32_t) inputs.size(); i++) {
+            step_inputs[i] = inputs[i][time];
+        }
+
+        ok = request(
+            fd, SERVE_STEP, stream, step_inputs.data(), (int32_t) (step_inputs.size() * sizeof(double)), response
+        );
+        if (ok && (int32_t) response.size() != number_outputs * (int32_t) sizeof(double)) {
+            Log::error("step returned %d bytes, expected %d outputs\n", response.size(), number_outputs);
+            ok = false;
+        }
+
+        for (int32_t i = 0; ok && i < number_outputs; i++) {
+            double output;
+            memcpy(&output, response.data() + (i * sizeof(double)), sizeof(double));
+            // relative to the magnitude of the value, as denormalized outputs can be in any units
+            difference = fmax(difference, fabs(output - expected[i][time]) / fmax(1.0, fabs(expected[i][time])));
+        }
+    }
+    close(fd);
+
+    lock_guard<mutex> lock(results_mutex);
+    max_difference = fmax(max_difference, difference);
+    total_steps += series_length;
+    failed = failed || !ok;
+}
+
+/**
+ *  Computes the predictions RNN_Genome makes for the raw testing inputs, denormalized, as the reference for what
+ *  the server should return.
+ */
+void get_expected(
+    string genome_filename, const vector<string>& testing_filenames, int32_t time_offset,
+    vector<vector<vector<double> > >& raw_inputs, vector<vector<vector<double> > >& expected
+) {
+    RNN_Genome* genome = new RNN_Genome(genome_filename);
+    vector<string> output_parameter_names = genome->get_output_parameter_names();
+
+    TimeSeriesSets* time_series_sets = TimeSeriesSets::generate_test(
+        testing_filenames, genome->get_input_parameter_names(), output_parameter_names
+    );
+
+    vector<vector<vector<double> > > raw_outputs;
+    time_series_sets->export_test_series(time_offset, raw_inputs, raw_outputs);
+
+    string normalize_type = genome->get_normalize_type();
+    if (normalize_type.compare("min_max") == 0) {
+        time_series_sets->normalize_min_max(genome->get_normalize_mins(), genome->get_normalize_maxs());
+    } else if (normalize_type.compare("avg_std_dev") == 0) {
+        time_series_sets->normalize_avg_std_dev(
+            genome->get_normalize_avgs(), genome->get_normalize_std_devs(), genome->get_normalize_mins(),
+            genome->get_normalize_maxs()
+        );
+    }
+
+    vector<vector<vector<double> > > inputs, outputs;
+    time_series_sets->export_test_series(time_offset, inputs, outputs);
+
+    RNN* rnn = genome->get_rnn();
+    rnn->set_weights(genome->get_best_parameters());
+
+    expected.clear();
+    for (int32_t i = 0; i < (int32_t) inputs.size(); i++) {
+        expected.push_back(rnn->get_predictions(inputs[i], outputs[i], false, 0.0));
+
+        if (normalize_type.compare("min_max") == 0 || normalize_type.compare("avg_std_dev") == 0) {
+            for (int32_t j = 0; j < (int32_t) expected[i].size(); j++) {
+                for (int32_t k = 0; k < (int32_t) expected[i][j].size(); k++) {
+                    expected[i][j][k] = time_series_sets->denormalize(output_parameter_names[j], expected[i][j][k]);
+                }
+            }
+        }
+    }
+
+    delete rnn;
+    delete time_series_sets;
+    delete genome;
+}
+
+bool check_server(string genome_filename, const vector<string>& testing_filenames, int32_t time_offset) {
+    vector<vector<vector<double> > > raw_inputs, expected;
+    get_expected(genome_filename, testing_filenames, time_offset, raw_inputs, expected);
+
+    int fd = connect_to_server();
+    vector<char> response;
+    if (!request(fd, SERVE_INFO, 0, NULL, 0, response)) {
+        exit(1);
+    }
+    close(fd);
+
+    int32_t info[3];
+    memcpy(info, response.data(), sizeof(info));
+    int32_t number_outputs = info[2];
+    if (info[1] != (int32_t) raw_inputs[0].size() || number_outputs != (int32_t) expected[0].size()) {
+        Log::fatal(
+            "ERROR: server has %d inputs and %d outputs, but '%s' has %d and %d\n", info[1], number_outputs,
+            genome_filename.c_str(), raw_inputs[0].size(), expected[0].size()
+        );
+        exit(1);
+    }
+
+    int32_t number_streams = (int32_t) testing_filenames.size();
+    get_argument(arguments, "--number_streams", false, number_streams);
+
+    max_difference = 0.0;
+    total_steps = 0;
+    failed = false;
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    vector<thread> threads;
+    for (int32_t i = 0; i < number_streams; i++) {
+        int32_t series = i % (int32_t) raw_inputs.size();
+        threads.push_back(thread(stream_thread, cref(raw_inputs[series]), cref(expected[series]), number_outputs));
+    }
+    for (int32_t i = 0; i < (int32_t) threads.size(); i++) {
+        threads[i].join();
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+    Log::info(
+        "'%s': %d streams, %ld steps in %lf seconds (%lf steps/second), max relative error: %le\n",
+        genome_filename.c_str(), number_streams, total_steps, seconds, total_steps / seconds, max_difference
+    );
+
+    double tolerance = 1e-9;
+    get_argument(arguments, "--tolerance", false, tolerance);
+
+    if (failed || max_difference > tolerance) {
+        Log::error("FAILED\n");
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    arguments = vector<string>(argv, argv + argc);
+
+    Log::initialize(arguments);
+    Log::set_id("main");
+
+    get_argument(arguments, "--socket_path", false, socket_path);
+    get_argument(arguments, "--port", false, port);
+
+    if (socket_path.compare("") == 0 && port <= 0) {
+        Log::fatal("ERROR: rnn_serve_client needs either --socket_path or --port\n");
+        exit(1);
+    }
+
+    string genome_filename;
+    get_argument(arguments, "--genome_file", true, genome_filename);
+
+    vector<string> testing_filenames;
+    get_argument_vector(arguments, "--testing_filenames", true, testing_filenames);
+
+    int32_t time_offset = 1;
+    get_argument(arguments, "--time_offset", false, time_offset);
+
+    bool passed = check_server(genome_filename, testing_filenames, time_offset);
+
+    string swap_genome_filename = "";
+    get_argument(arguments, "--swap_genome_file", false, swap_genome_filename);
+
+    if (passed && swap_genome_filename.compare("") != 0) {
+        int fd = connect_to_server();
+        vector<char> response;
+        passed = request(
+            fd, SERVE_SWAP_GENOME, 0, swap_genome_filename.c_str(), (int32_t) swap_genome_filename.size(), response
+        );
+        close(fd);
+
+        passed = passed && check_server(swap_genome_filename, testing_filenames, time_offset);
+    }
+
+    if (argument_exists(arguments, "--shutdown")) {
+        int fd = connect_to_server();
+        vector<char> response;
+        request(fd, SERVE_SHUTDOWN, 0, NULL, 0, response);
+        close(fd);
+    }
+
+    Log::info(passed ? "PASSED\n" : "FAILED\n");
+    Log::release_id("main");
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,213 @@
+#ifndef RNN_SERVE_PROTOCOL_HXX
+#define RNN_SERVE_PROTOCOL_HXX
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+#include <string>
+using std::string;
+
+#include <vector>
+using std::vector;
+
+/**
+ *  The framing used between rnn_serve and its clients, over a unix domain socket or tcp on localhost (so everything
+ *  is sent in host byte order). A request is four int32_ts: the command, the model (the position of its genome file
+ *  in --genome_files), the stream and the number of payload bytes, followed by the payload. A response is two
+ *  int32_ts: the status and the number of payload bytes, followed by the payload, which is an error message if the
+ *  status is SERVE_ERROR.
+ *
+ *  SERVE_INFO           -> int32_t number_models, number_inputs, number_outputs of the model
+ *  SERVE_OPEN_STREAM    -> int32_t stream
+ *  SERVE_RESET_STREAM   -> nothing
+ *  SERVE_STEP           number_inputs doubles, raw (not normalized) in the genome's input parameter order
+ *                       -> number_outputs doubles, denormalized in the genome's output parameter order
+ *  SERVE_SWAP_GENOME    the genome filename to replace the model with -> nothing
+ *  SERVE_SHUTDOWN       -> nothing
+ */
+
+#define SERVE_INFO         0
+#define SERVE_OPEN_STREAM  1
+#define SERVE_RESET_STREAM 2
+#define SERVE_STEP         3
+#define SERVE_SWAP_GENOME  4
+#define SERVE_SHUTDOWN     5
+
+#define SERVE_OK    0
+#define SERVE_ERROR 1
+
+#define SERVE_LISTEN_BACKLOG 64
+
+// responses are outputs or error messages, far smaller than this
+#define SERVE_MAX_RESPONSE_LENGTH (1 << 20)
+
+inline bool serve_read(int fd, void* buffer, int32_t length) {
+    char* current = (char*) buffer;
+    while (length > 0) {
+        ssize_t result = read(fd, current, length);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result <= 0) {
+            return false;
+        }
+        current += result;
+        length -= result;
+    }
+    return true;
+}
+
+inline bool serve_write(int fd, const void* buffer, int32_t length) {
+    const char* current = (const char*) buffer;
+    while (length > 0) {
+        ssize_t result = send(fd, current, length, MSG_NOSIGNAL);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result <= 0) {
+            return false;
+        }
+        current += result;
+        length -= result;
+    }
+    return true;
+}
+
+inline bool serve_write_request(
+    int fd, int32_t command, int32_t model, int32_t stream, const void* payload, int32_t payload_length
+) {
+    int32_t header[4] = {command, model, stream, payload_length};
+    return serve_write(fd, header, sizeof(header)) && serve_write(fd, payload, payload_length);
+}
+
+inline bool serve_write_response(int fd, int32_t status, const void* payload, int32_t payload_length) {
+    int32_t header[2] = {status, payload_length};
+    return serve_write(fd, header, sizeof(header)) && serve_write(fd, payload, payload_length);
+}
+
+/**
+ *  Reads a payload of payload_length bytes, failing without reading it if the length is negative or larger than
+ *  max_length, as it comes from the other side of the connection.
+ */
+inline bool serve_read_payload(int fd, int32_t payload_length, int32_t max_length, vector<char>& payload) {
+    if (payload_length < 0 || payload_length > max_length) {
+        return false;
+    }
+    payload.resize(payload_length);
+    return serve_read(fd, payload.data(), payload_length);
+}
+
+inline bool serve_read_response(int fd, int32_t& status, vector<char>& payload) {
+    int32_t header[2];
+    if (!serve_read(fd, header, sizeof(header))) {
+        return false;
+    }
+    status = header[0];
+    return serve_read_payload(fd, header[1], SERVE_MAX_RESPONSE_LENGTH, payload);
+}
+
+/**
+ *  Opens a listening socket on socket_path, or on localhost:port if socket_path is empty. Returns -1 on failure with
+ *  errno set.
+ */
+inline int serve_listen(string socket_path, int32_t port) {
+    int fd;
+    if (socket_path.compare("") != 0) {
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) {
+            return -1;
+        }
+
+        sockaddr_un address;
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+
+        // a socket file left behind by a server which did not shut down cleanly would make bind fail
+        unlink(socket_path.c_str());
+        if (bind(fd, (sockaddr*) &address, sizeof(address)) < 0) {
+            close(fd);
+            return -1;
+        }
+    } else {
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0) {
+            return -1;
+        }
+
+        int reuse = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+        sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons(port);
+
+        if (bind(fd, (sockaddr*) &address, sizeof(address)) < 0) {
+            close(fd);
+            return -1;
+        }
+    }
+
+    if (listen(fd, SERVE_LISTEN_BACKLOG) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ *  Connects to a server listening on socket_path, or on localhost:port if socket_path is empty. Returns -1 on failure
+ *  with errno set.
+ */
+inline int serve_connect(string socket_path, int32_t port) {
+    int fd;
+    if (socket_path.compare("") != 0) {
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) {
+            return -1;
+        }
+
+        sockaddr_un address;
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+
+        if (connect(fd, (sockaddr*) &address, sizeof(address)) < 0) {
+            close(fd);
+            return -1;
+        }
+    } else {
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0) {
+            return -1;
+        }
+
+        sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons(port);
+
+        if (connect(fd, (sockaddr*) &address, sizeof(address)) < 0) {
+            close(fd);
+            return -1;
+        }
+
+        // steps are small request/response round trips, so don't let nagle hold them back
+        int no_delay = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+    }
+    return fd;
+}
+
+#endif
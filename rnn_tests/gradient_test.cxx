@@ -1,3 +1,6 @@
+#include <algorithm>
+using std::max;
+
 #include <chrono>
 #include <fstream>
 using std::getline;
@@ -43,6 +46,51 @@ void generate_random_vector(int number_parameters, vector<double>& v) {
     }
 }
 
+/**
+ * Checks the truncated BPTT gradient with the given window and stride against the central difference one. With the
+ * window at least the series length it has to match the full gradient, otherwise the gradient of the windows' errors
+ * with the state carried into each window held fixed. Returns true if it failed.
+ */
+bool truncated_gradient_test(
+    RNN* rnn, const vector<double>& parameters, const vector<vector<double> >& inputs,
+    const vector<vector<double> >& outputs, int32_t window, int32_t stride
+) {
+    double analytic_mse, empirical_mse;
+    vector<double> analytic_gradient, empirical_gradient;
+
+    rnn->get_truncated_analytic_gradient(
+        parameters, inputs, outputs, window, stride, analytic_mse, analytic_gradient, false, true, 0.0
+    );
+    if (window >= (int32_t) inputs[0].size()) {
+        rnn->get_empirical_gradient(parameters, inputs, outputs, empirical_mse, empirical_gradient, false, true, 0.0);
+    } else {
+        rnn->get_truncated_empirical_gradient(
+            parameters, inputs, outputs, window, stride, empirical_mse, empirical_gradient, false, true, 0.0
+        );
+    }
+
+    bool failed = false;
+    for (uint32_t j = 0; j < analytic_gradient.size(); j++) {
+        double difference = analytic_gradient[j] - empirical_gradient[j];
+
+        if (fabs(difference) > 10e-10) {
+            failed = true;
+            Log::info(
+                "\t\tFAILED analytic gradient[%d]: %lf, empirical gradient[%d]: %lf, difference: %lf, TBPTT window: "
+                "%d, stride: %d\n",
+                j, analytic_gradient[j], j, empirical_gradient[j], difference, window, stride
+            );
+        } else {
+            Log::debug(
+                "\t\tPASSED analytic gradient[%d]: %lf, empirical gradient[%d]: %lf, difference: %lf, TBPTT window: "
+                "%d, stride: %d\n",
+                j, analytic_gradient[j], j, empirical_gradient[j], difference, window, stride
+            );
+        }
+    }
+    return failed;
+}
+
 void gradient_test(
     string name, RNN_Genome* genome, const vector<vector<double> >& inputs, const vector<vector<double> >& outputs,
     WeightRules* weight_rules
@@ -144,6 +192,30 @@ void gradient_test(
         }
     }
 
+    int32_t length = (int32_t) inputs[0].size();
+    int32_t short_window = max(1, length / 3);
+    for (int32_t i = 0; i < test_iterations; i++) {
+        if (i == 0) {
+            Log::debug_no_header("\n");
+        }
+        Log::debug("\tAttempt %d USING TRUNCATED BPTT\n", i);
+
+        generate_random_vector(rnn->get_number_weights(), parameters);
+
+        // the window covering the whole series, then shorter windows which do not and which overlap
+        bool iteration_failed = truncated_gradient_test(rnn, parameters, inputs, outputs, length, length);
+        iteration_failed |= truncated_gradient_test(rnn, parameters, inputs, outputs, short_window, short_window);
+        iteration_failed |=
+            truncated_gradient_test(rnn, parameters, inputs, outputs, short_window, max(1, short_window / 2));
+
+        if (iteration_failed) {
+            failed = true;
+            Log::info("\tITERATION %d FAILED!\n\n", i);
+        } else {
+            Log::debug("\tITERATION %d PASSED!\n\n", i);
+        }
+    }
+
     delete rnn;
 
     if (!failed) {
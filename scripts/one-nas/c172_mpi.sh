@@ -24,9 +24,11 @@
 
 # TIME SERIES PROCESSING:
 # --time_series_length <int>                   : Length of time series sequences for slicing
+# --time_series_stride <int>                   : Rows between slice starts, less than the length overlaps (default: length)
 # --train_sequence_length <int>               : Length for training sequences (if different)
 # --validation_sequence_length <int>          : Length for validation sequences (if different)
 # --normalize <type>                          : Normalization type: 'min_max', 'avg_std_dev', or 'none'
+# --preprocessing_threads <int>               : Threads loading and normalizing the files (default: all cores)
 
 # ONLINE LEARNING ARGUMENTS:
 # --num_training_sets <int>                   : Number of training sets per generation
@@ -101,6 +103,7 @@
 # --max_header_length <int>                   : Maximum header length for logging (default: 256)
 # --max_message_length <int>                  : Maximum message length for logging (default: 1024)
 # --generate_op_log                           : Flag to generate operation logs
+# --io_queue_size <int>                      : Output files queued for the background writer before blocking (default: 64)
 
 # DNAS-SPECIFIC ARGUMENTS:
 # --dnas_node_types <type1> <type2> ...       : Node types for DNAS evolution
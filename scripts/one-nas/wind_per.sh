@@ -111,6 +111,12 @@
 # PERFORMANCE CONTROL ARGUMENTS:
 # --compare_with_naive                        : Flag to enable naive vs genome prediction comparison
 # --control_size_method <method>              : Network size control method: 'reduce_mutation_rate', 'reduce_add_mutation', 'none'
+# --adaptive_generation_budget                : Flag to scale genomes generated per generation with drift in the stream
+# --min_generated_population_size <int>       : Budget stable stretches shrink to (default: generated size / 4)
+# --max_generated_population_size <int>       : Budget used after drift is detected (default: generated size * 2)
+# --drift_stable_generations <int>            : Generations without drift before the budget shrinks (default: 5)
+# --drift_delta <float>                       : Page-Hinkley tolerance on the log of the MSEs (default: 0.05)
+# --drift_threshold <float>                   : Page-Hinkley detection threshold on the log of the MSEs (default: 1.0)
 
 # ISLAND REPOPULATION ARGUMENTS:
 # --repopulation_frequency <int>              : Frequency for island repopulation events
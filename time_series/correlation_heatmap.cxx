@@ -37,7 +37,13 @@ int main(int argc, char** argv) {
     string target_parameter_name;
     get_argument(arguments, "--target_parameter_name", true, target_parameter_name);
 
-    vector<string> parameter_names = time_series_sets->get_input_parameter_names();
+    vector<string> parameter_names;
+    vector<string> input_parameter_names = time_series_sets->get_input_parameter_names();
+    for (int32_t j = 0; j < (int32_t) input_parameter_names.size(); j++) {
+        if (input_parameter_names[j].compare(target_parameter_name) != 0) {
+            parameter_names.push_back(input_parameter_names[j]);
+        }
+    }
 
     for (int32_t i = 0; i < time_series_sets->get_number_series(); i++) {
         TimeSeriesSet* tss = time_series_sets->get_set(i);
@@ -62,18 +68,18 @@ int main(int argc, char** argv) {
         ofstream correlations_csv(correlations_csv_filename);
         ofstream headers_txt(headers_txt_filename);
 
-        for (int32_t j = 0; j < (int32_t) parameter_names.size(); j++) {
-            if (parameter_names[j].compare(target_parameter_name) == 0) {
-                continue;
-            }
+        // correlations[0][j][k] is the correlation of the target with parameter j lagged by k
+        vector<vector<vector<double> > > correlations;
+        tss->get_correlations(
+            {target_parameter_name}, parameter_names, max_lag, time_series_sets->get_number_threads(), correlations
+        );
 
+        for (int32_t j = 0; j < (int32_t) parameter_names.size(); j++) {
             for (int32_t k = 1; k < max_lag; k++) {
-                double correlation = tss->get_correlation(target_parameter_name, parameter_names[j], k);
-
                 if (k > 1) {
                     correlations_csv << ",";
                 }
-                correlations_csv << correlation;
+                correlations_csv << correlations[0][j][k];
             }
             correlations_csv << endl;
 
@@ -10,6 +10,12 @@ using std::ifstream;
 
 #include <iostream>
 using std::ios;
+using std::istream;
+using std::ostream;
+
+#include <sstream>
+using std::istringstream;
+using std::ostringstream;
 
 #include <sys/stat.h>
 
@@ -18,15 +24,13 @@ using std::min;
 #include <algorithm> 
 using std::shuffle;
 using std::min_element;
+using std::find;
 
 #include <random>
 using std::mt19937;
 using std::random_device;
 using std::uniform_real_distribution;
 
-#include <unordered_set>
-using std::unordered_set;
-
 #include <cmath>
 using std::pow;
 
@@ -43,6 +47,12 @@ OnlineSeries::OnlineSeries(const int32_t _total_num_sets,const vector<string> &a
     num_test_sets = 1;
     // Initialize episodes vector
     episodes.reserve(total_num_sets);
+
+    priority_tree = NULL;
+    per_reference_generation = 0;
+    per_available_episodes = 0;
+    random_device rd;
+    per_generator = mt19937(rd());
 }
 
 OnlineSeries::~OnlineSeries() {
@@ -54,6 +64,12 @@ OnlineSeries::~OnlineSeries() {
         }
     }
     episodes.clear();
+    episodes_by_id.clear();
+
+    if (priority_tree != NULL) {
+        delete priority_tree;
+        priority_tree = NULL;
+    }
 }
 
 void OnlineSeries::get_online_arguments(const vector<string> &arguments) {
@@ -99,61 +115,103 @@ void OnlineSeries::uniform_random_sample_index(vector<int32_t>& training_index)
     }
 }
 
-void OnlineSeries::prioritized_experience_replay(vector<int32_t>& training_index) {
-    shuffle_data();
-    training_index.clear();
+// the weight an episode is sampled with is its priority to the power of alpha: P(i) = p_i^alpha / sum(p_j^alpha).
+// it is calculated at the reference generation, which scales every available episode's weight by the same factor
+double OnlineSeries::calculate_sampling_weight(int32_t episode_id) const {
+    TimeSeriesEpisode* episode = episodes_by_id[episode_id];
+    if (episode == NULL) {
+        // Fallback priority for episodes not found
+        Log::warning("Episode %d not found, using default priority\n", episode_id);
+        return 1.0;
+    }
 
-    int32_t current_generation = current_index - num_training_sets; // Calculate current generation
+    double priority = episode->calculate_priority(per_reference_generation, per_alpha, per_lambda, per_epsilon);
+    return pow(priority, per_alpha);
+}
 
-    // Calculate priorities for all available episodes
-    vector<double> priorities;
-    priorities.reserve(avalibale_training_index.size());
-    
-    for (int32_t episode_id : avalibale_training_index) {
-        TimeSeriesEpisode* episode = get_episode(episode_id);
-        if (episode != NULL) {
-            double priority = episode->calculate_priority(current_generation, per_alpha, per_lambda, per_epsilon);
-            priorities.push_back(priority);
-        } else {
-            // Fallback priority for episodes not found
-            priorities.push_back(1.0);
-            Log::warning("Episode %d not found, using default priority\n", episode_id);
+void OnlineSeries::update_sampling_weight(int32_t episode_id) {
+    if (priority_tree == NULL || episode_id < 0 || episode_id >= per_available_episodes) {
+        return;  // the weight is calculated when the episode becomes available
+    }
+    priority_tree->update(episode_id, calculate_sampling_weight(episode_id));
+}
+
+// brings the sum tree up to date for the current generation: (re)creates it if the episodes changed, rebuilds the
+// weights against a new reference generation if the decay since the last one is getting too large, and adds the
+// episodes which have become available since the last call
+void OnlineSeries::update_priority_tree(int32_t current_generation) {
+    int32_t number_ids = (int32_t)episodes_by_id.size();
+
+    if (priority_tree == NULL || priority_tree->get_number_items() != number_ids) {
+        if (priority_tree != NULL) {
+            delete priority_tree;
+        }
+        priority_tree = new PrioritySumTree(number_ids);
+        per_reference_generation = current_generation;
+        per_available_episodes = 0;
+    } else if (per_alpha * per_lambda * (current_generation - per_reference_generation) > PER_REBASE_EXPONENT) {
+        Log::debug("PER: rebuilding sampling weights relative to generation %d\n", current_generation);
+        per_reference_generation = current_generation;
+        for (int32_t episode_id = 0; episode_id < per_available_episodes; episode_id++) {
+            update_sampling_weight(episode_id);
         }
     }
 
-    // Apply alpha exponentiation for sampling probability: P(i) = p_i^alpha / sum(p_j^alpha)
-    vector<double> sampling_weights;
-    sampling_weights.reserve(priorities.size());
-    
-    for (double priority : priorities) {
-        double weight = pow(priority, per_alpha);
-        sampling_weights.push_back(weight);
+    int32_t available_episodes = min(current_index, number_ids);
+    while (per_available_episodes > available_episodes) {
+        per_available_episodes--;
+        priority_tree->update(per_available_episodes, 0.0);
+    }
+    while (per_available_episodes < available_episodes) {
+        per_available_episodes++;
+        update_sampling_weight(per_available_episodes - 1);
     }
+}
+
+void OnlineSeries::prioritized_experience_replay(vector<int32_t>& training_index) {
+    training_index.clear();
+
+    int32_t current_generation = current_index - num_training_sets; // Calculate current generation
+    update_priority_tree(current_generation);
 
     Log::info("PER: Using priority-based sampling with alpha=%.3f, lambda=%.3f\n", per_alpha, per_lambda);
 
-    // Random number generator for sampling
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::discrete_distribution<> dist(sampling_weights.begin(), sampling_weights.end());
-
-    // Sample without replacement
-    std::unordered_set<int32_t> seen;
-    while ((int32_t)training_index.size() < num_training_sets) {
-        int32_t sampled_idx = dist(gen);  // Index into avalibale_training_index
-        int32_t actual_episode_id = avalibale_training_index[sampled_idx];
-        
-        if (seen.find(actual_episode_id) == seen.end()) {
-            training_index.push_back(actual_episode_id);
-            seen.insert(actual_episode_id);
-            
-            // Debug info for first few selections
-            if (training_index.size() <= 3) {
-                Log::debug("Selected episode %d (priority: %.6f, weight: %.6f)\n", 
-                          actual_episode_id, priorities[sampled_idx], sampling_weights[sampled_idx]);
+    // Sample without replacement: each sampled episode's weight is zeroed in the tree so the next draw is over the
+    // remaining episodes, and the weights are put back afterwards
+    int32_t number_samples = min(num_training_sets, per_available_episodes);
+    vector<double> sampled_weights;
+    uniform_real_distribution<double> uniform(0.0, 1.0);
+
+    while ((int32_t)training_index.size() < number_samples) {
+        double total_weight = priority_tree->get_total_weight();
+
+        int32_t episode_id;
+        if (total_weight > 0.0) {
+            episode_id = priority_tree->find(uniform(per_generator) * total_weight);
+        } else {
+            // every remaining weight has decayed to zero, fall back to picking uniformly from what is left
+            vector<int32_t> remaining;
+            for (int32_t i = 0; i < per_available_episodes; i++) {
+                if (find(training_index.begin(), training_index.end(), i) == training_index.end()) {
+                    remaining.push_back(i);
+                }
             }
+            episode_id = remaining[(int32_t)(uniform(per_generator) * remaining.size()) % remaining.size()];
+        }
+
+        training_index.push_back(episode_id);
+        sampled_weights.push_back(priority_tree->get_weight(episode_id));
+        priority_tree->update(episode_id, 0.0);
+
+        // Debug info for first few selections
+        if (training_index.size() <= 3) {
+            Log::debug("Selected episode %d (weight: %.6f of %.6f)\n", episode_id, sampled_weights.back(), total_weight);
         }
     }
+
+    for (int32_t i = 0; i < (int32_t)training_index.size(); i++) {
+        priority_tree->update(training_index[i], sampled_weights[i]);
+    }
 }
 
 vector<int32_t> OnlineSeries::get_training_index(vector<int32_t>& training_index) {
@@ -184,6 +242,10 @@ int32_t OnlineSeries::get_test_index() {
     return current_index + num_validation_sets;
 }
 
+int32_t OnlineSeries::get_newest_training_index() {
+    return current_index - 1;
+}
+
 void OnlineSeries::update_episode_priorities(const vector<RNN_Genome*>& elite_genomes, int32_t current_generation) {
     // Skip priority updates for uniform sampling
     if (get_training_data_method.compare("Uniform") == 0) {
@@ -246,6 +308,7 @@ void OnlineSeries::update_episode_priorities(const vector<RNN_Genome*>& elite_ge
             if (new_episode->get_availability_generation() != current_generation) {
                 new_episode->set_availability_generation(current_generation);
             }
+            update_sampling_weight(new_episode_id);
             
             Log::info("PER: Updated new episode %d - MSE: %.6f -> %.6f, availability_gen: %d\n", 
                      new_episode_id, old_mse, best_mse, current_generation);
@@ -279,6 +342,7 @@ void OnlineSeries::update_episode_priorities(const vector<RNN_Genome*>& elite_ge
             // More conservative update - blend old and new MSE values
             double blended_mse = 0.7 * old_mse + 0.3 * avg_mse;
             episode->set_validation_mse(blended_mse);
+            update_sampling_weight(episode_id);
             
             episodes_updated++;
             
@@ -394,6 +458,22 @@ void OnlineSeries::write_priorities_to_csv(int32_t generation, const string& sta
 
 void OnlineSeries::add_episode(TimeSeriesEpisode* episode) {
     episodes.push_back(episode);
+
+    int32_t episode_id = episode->get_episode_id();
+    if (episode_id < 0) {
+        Log::error("Cannot add episode with negative id %d\n", episode_id);
+        exit(1);
+    }
+    if (episode_id >= (int32_t)episodes_by_id.size()) {
+        episodes_by_id.resize(episode_id + 1, NULL);
+    }
+    episodes_by_id[episode_id] = episode;
+
+    // the sum tree is rebuilt for the new set of episodes the next time it is sampled from
+    if (priority_tree != NULL) {
+        delete priority_tree;
+        priority_tree = NULL;
+    }
 }
 
 void OnlineSeries::initialize_episodes(const vector<vector<vector<double>>>& inputs, const vector<vector<vector<double>>>& outputs) {
@@ -405,6 +485,7 @@ void OnlineSeries::initialize_episodes(const vector<vector<vector<double>>>& inp
         }
     }
     episodes.clear();
+    episodes_by_id.clear();
     
     int32_t num_episodes = min(inputs.size(), outputs.size());
     
@@ -414,20 +495,42 @@ void OnlineSeries::initialize_episodes(const vector<vector<vector<double>>>& inp
         episode->set_availability_generation(i);
         // Initialize with default MSE - will be updated when genomes are evaluated
         episode->set_validation_mse(1.0);
-        episodes.push_back(episode);
+        add_episode(episode);
     }
     
     Log::info("Initialized %d episodes with PER priority system\n", num_episodes);
 }
 
-TimeSeriesEpisode* OnlineSeries::get_episode(int32_t episode_id) {
-    // Search for episode by ID, not by vector index
+void OnlineSeries::initialize_episodes(const TimeSeriesWindows* windows) {
+    // Clean up any existing episodes first
     for (int32_t i = 0; i < (int32_t)episodes.size(); i++) {
-        if (episodes[i] != NULL && episodes[i]->get_episode_id() == episode_id) {
-            return episodes[i];
+        if (episodes[i] != NULL) {
+            delete episodes[i];
+            episodes[i] = NULL;
         }
     }
-    return NULL;
+    episodes.clear();
+    episodes_by_id.clear();
+
+    // the episodes only describe their window, the data is exported from the windows when it is used
+    int32_t num_episodes = windows->get_number_windows();
+
+    for (int32_t i = 0; i < num_episodes; i++) {
+        TimeSeriesEpisode* episode = new TimeSeriesEpisode(i, windows, i);
+        episode->set_availability_generation(i);
+        episode->set_validation_mse(1.0);
+        add_episode(episode);
+    }
+
+    Log::info("Initialized %d windowed episodes with PER priority system\n", num_episodes);
+}
+
+TimeSeriesEpisode* OnlineSeries::get_episode(int32_t episode_id) {
+    // Look up the episode by ID, not by vector index
+    if (episode_id < 0 || episode_id >= (int32_t)episodes_by_id.size()) {
+        return NULL;
+    }
+    return episodes_by_id[episode_id];
 }
 
 void OnlineSeries::print_episode_stats() {
@@ -444,4 +547,55 @@ void OnlineSeries::print_episode_stats() {
 int32_t OnlineSeries::get_max_generation() {
     int32_t max_generation = total_num_sets - num_training_sets - num_validation_sets - num_test_sets;
     return max_generation;
-}
\ No newline at end of file
+}
+
+void OnlineSeries::write_checkpoint(ostream& out) {
+    int32_t number_ids = (int32_t)episodes_by_id.size();
+    out.write((char*) &number_ids, sizeof(int32_t));
+
+    for (int32_t episode_id = 0; episode_id < number_ids; episode_id++) {
+        double validation_mse = 1.0;
+        int32_t availability_generation = episode_id;
+        if (episodes_by_id[episode_id] != NULL) {
+            validation_mse = episodes_by_id[episode_id]->get_validation_mse();
+            availability_generation = episodes_by_id[episode_id]->get_availability_generation();
+        }
+        out.write((char*) &validation_mse, sizeof(double));
+        out.write((char*) &availability_generation, sizeof(int32_t));
+    }
+
+    ostringstream generator_oss;
+    generator_oss << per_generator;
+    write_binary_string(out, generator_oss.str(), "per_generator");
+}
+
+bool OnlineSeries::read_checkpoint(istream& in) {
+    int32_t number_ids;
+    in.read((char*) &number_ids, sizeof(int32_t));
+    if (number_ids != (int32_t)episodes_by_id.size()) {
+        Log::fatal("ERROR: checkpoint has %d episodes but the time series were sliced into %d\n", number_ids, (int32_t)episodes_by_id.size());
+        return false;
+    }
+
+    for (int32_t episode_id = 0; episode_id < number_ids; episode_id++) {
+        double validation_mse;
+        int32_t availability_generation;
+        in.read((char*) &validation_mse, sizeof(double));
+        in.read((char*) &availability_generation, sizeof(int32_t));
+        if (episodes_by_id[episode_id] != NULL) {
+            episodes_by_id[episode_id]->set_validation_mse(validation_mse);
+            episodes_by_id[episode_id]->set_availability_generation(availability_generation);
+        }
+    }
+
+    string generator_str;
+    read_binary_string(in, generator_str, "per_generator");
+    istringstream generator_iss(generator_str);
+    generator_iss >> per_generator;
+
+    if (priority_tree != NULL) {
+        delete priority_tree;
+        priority_tree = NULL;
+    }
+    return true;
+}
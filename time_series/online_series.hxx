@@ -2,6 +2,7 @@
 #define ONLINE_SERIES_HXX
 
 #include <iostream>
+using std::istream;
 using std::ostream;
 
 #include <string>
@@ -19,8 +20,15 @@ using std::unordered_set;
 #include <random>
 using std::normal_distribution;
 using std::default_random_engine;
+using std::mt19937;
 
+#include "priority_sum_tree.hxx"
 #include "time_series_episode.hxx"
+#include "time_series_windows.hxx"
+
+// the sampling weights in the PER sum tree are relative to a reference generation, once the temporal decay since
+// then reaches this exponent the weights are rebuilt against the current generation so they stay in double range
+#define PER_REBASE_EXPONENT 50.0
 
 // Forward declarations
 class RNN_Genome;
@@ -29,6 +37,7 @@ class OnlineSeries {
     private:
         // Episode management - PER approach
         vector<TimeSeriesEpisode*> episodes;
+        vector<TimeSeriesEpisode*> episodes_by_id; // indexed by episode id, NULL for ids without an episode
         
         // Core configuration
         int32_t total_num_sets;
@@ -44,6 +53,18 @@ class OnlineSeries {
         double per_alpha;    // prioritization strength [0, 1]
         double per_lambda;   // temporal decay rate
         double per_epsilon;  // small constant for priority calculation
+
+        // PER sampling state, persistent across calls. the temporal decay exp(-lambda * (g - a_i)) only differs
+        // between episodes by their availability generation a_i, so the weights are stored relative to
+        // per_reference_generation and the common factor for the current generation cancels out when sampling
+        PrioritySumTree* priority_tree;
+        int32_t per_reference_generation;
+        int32_t per_available_episodes;  // episode ids below this have their weight in the tree
+        mt19937 per_generator;
+
+        double calculate_sampling_weight(int32_t episode_id) const;
+        void update_sampling_weight(int32_t episode_id);
+        void update_priority_tree(int32_t current_generation);
         
     public:
         OnlineSeries(int32_t _num_sets, const vector<string> &arguments);
@@ -52,6 +73,7 @@ class OnlineSeries {
         // Episode management methods
         void add_episode(TimeSeriesEpisode* episode);
         void initialize_episodes(const vector<vector<vector<double>>>& inputs, const vector<vector<vector<double>>>& outputs);
+        void initialize_episodes(const TimeSeriesWindows* windows);  // windows has to outlive the episodes
         TimeSeriesEpisode* get_episode(int32_t episode_id);
         void print_episode_stats();
         
@@ -66,6 +88,7 @@ class OnlineSeries {
         vector<int32_t> get_training_index(vector<int32_t>& training_index);
         vector< int32_t > get_validation_index(vector<int32_t>& validation_index);
         int32_t get_test_index();
+        int32_t get_newest_training_index();  // the episode which joined the training window this generation
         
         // PER priority system methods
         void update_episode_priorities(const vector<RNN_Genome*>& elite_genomes, int32_t current_generation);
@@ -76,6 +99,11 @@ class OnlineSeries {
         string get_training_method() const { return get_training_data_method; }
 
         int32_t get_max_generation();
+
+        // Checkpoints of the episode priorities and the PER random number generator, the sum tree is rebuilt from
+        // the priorities the next time it is sampled from
+        void write_checkpoint(ostream& out);
+        bool read_checkpoint(istream& in);
 };
 
 #endif
\ No newline at end of file
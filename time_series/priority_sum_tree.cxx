@@ -0,0 +1,47 @@
+#include "priority_sum_tree.hxx"
+
+PrioritySumTree::PrioritySumTree(int32_t _number_items) : number_items(_number_items), number_leaves(1) {
+    while (number_leaves < number_items) {
+        number_leaves *= 2;
+    }
+    tree.assign(2 * number_leaves, 0.0);
+}
+
+int32_t PrioritySumTree::get_number_items() const {
+    return number_items;
+}
+
+void PrioritySumTree::update(int32_t item, double weight) {
+    int32_t position = number_leaves + item;
+    tree[position] = weight;
+
+    // recompute the sums from the children instead of adding the difference so rounding errors never accumulate
+    for (position /= 2; position >= 1; position /= 2) {
+        tree[position] = tree[2 * position] + tree[(2 * position) + 1];
+    }
+}
+
+double PrioritySumTree::get_weight(int32_t item) const {
+    return tree[number_leaves + item];
+}
+
+double PrioritySumTree::get_total_weight() const {
+    return tree[1];
+}
+
+int32_t PrioritySumTree::find(double value) const {
+    int32_t position = 1;
+    while (position < number_leaves) {
+        int32_t left = 2 * position;
+        // never descend into an empty subtree, which rounding in value could otherwise cause
+        if (value < tree[left] || tree[left + 1] <= 0.0) {
+            position = left;
+        } else {
+            value -= tree[left];
+            position = left + 1;
+        }
+    }
+
+    int32_t item = position - number_leaves;
+    return item < number_items ? item : number_items - 1;
+}
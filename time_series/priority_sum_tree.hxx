@@ -0,0 +1,35 @@
+#ifndef PRIORITY_SUM_TREE_HXX
+#define PRIORITY_SUM_TREE_HXX
+
+#include <cstdint>
+
+#include <vector>
+using std::vector;
+
+/**
+ * A binary sum tree (segment tree) over the sampling weights of a fixed number of items. Each internal node holds
+ * the sum of its children, so updating a weight and finding the item at a given point of the cumulative weight are
+ * both O(log n).
+ */
+class PrioritySumTree {
+   private:
+    int32_t number_items;
+    int32_t number_leaves;  // number_items rounded up to a power of two
+    vector<double> tree;    // tree[1] is the root, the leaves start at tree[number_leaves]
+
+   public:
+    PrioritySumTree(int32_t _number_items);
+
+    int32_t get_number_items() const;
+
+    void update(int32_t item, double weight);
+    double get_weight(int32_t item) const;
+    double get_total_weight() const;
+
+    /**
+     * Returns the item whose range of the cumulative weight contains value, where 0 <= value < get_total_weight().
+     */
+    int32_t find(double value) const;
+};
+
+#endif
@@ -1,7 +1,13 @@
 #include <algorithm>
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
+using std::count;
 using std::find;
 
+#include <atomic>
+using std::atomic;
+
 #include <fstream>
 using std::ifstream;
 
@@ -23,6 +29,10 @@ using std::invalid_argument;
 
 #include <string>
 using std::string;
+using std::to_string;
+
+#include <thread>
+using std::thread;
 
 #include <vector>
 using std::vector;
@@ -43,6 +53,22 @@ double TimeSeries::get_value(int32_t i) {
     return values[i];
 }
 
+/**
+ *  Merges the mean and sum of squared differences from the mean (m2) of count2 values into those of count1 values
+ *  (Chan et al.'s parallel form of Welford's algorithm).
+ */
+static void merge_moments(double& count1, double& mean1, double& m2_1, double count2, double mean2, double m2_2) {
+    if (count2 == 0) {
+        return;
+    }
+
+    double count = count1 + count2;
+    double delta = mean2 - mean1;
+    mean1 += delta * (count2 / count);
+    m2_1 += m2_2 + (delta * delta) * ((count1 * count2) / count);
+    count1 = count;
+}
+
 void TimeSeries::calculate_statistics() {
     min = numeric_limits<double>::max();
     min_change = numeric_limits<double>::max();
@@ -53,35 +79,90 @@ void TimeSeries::calculate_statistics() {
     std_dev = 0.0;
     variance = 0.0;
 
-    for (uint32_t i = 0; i < values.size(); i++) {
-        average += values[i];
+    int32_t number_values = (int32_t) values.size();
+    if (number_values == 0) {
+        return;
+    }
 
-        if (min > values[i]) {
-            min = values[i];
-        }
-        if (max < values[i]) {
-            max = values[i];
-        }
+    // everything is calculated in one pass with Welford's running mean and m2 instead of summing for the average and
+    // then going back over the values for the variance. the first value starts things off, the rest are interleaved
+    // over independent lanes (value i + 1 going to lane i % STATISTICS_LANES) so the loop has no dependencies between
+    // consecutive values and can be vectorized, and the lanes are merged at the end
+    const int32_t STATISTICS_LANES = 4;
+    double lane_min[STATISTICS_LANES], lane_max[STATISTICS_LANES];
+    double lane_min_change[STATISTICS_LANES], lane_max_change[STATISTICS_LANES];
+    double lane_mean[STATISTICS_LANES], lane_m2[STATISTICS_LANES];
+    for (int32_t lane = 0; lane < STATISTICS_LANES; lane++) {
+        lane_min[lane] = values[0];
+        lane_max[lane] = values[0];
+        lane_min_change[lane] = numeric_limits<double>::max();
+        lane_max_change[lane] = -numeric_limits<double>::max();
+        lane_mean[lane] = 0.0;
+        lane_m2[lane] = 0.0;
+    }
 
-        if (i > 0) {
-            double diff = values[i] - values[i - 1];
+    const double* value = values.data();
+    int32_t number_blocks = (number_values - 1) / STATISTICS_LANES;
+    for (int32_t block = 0; block < number_blocks; block++) {
+        double lane_count = block + 1;
+        const double* current = value + 1 + (block * STATISTICS_LANES);
 
-            if (diff < min_change) {
-                min_change = diff;
-            }
-            if (diff > max_change) {
-                max_change = diff;
-            }
+        for (int32_t lane = 0; lane < STATISTICS_LANES; lane++) {
+            double v = current[lane];
+            double change = v - current[lane - 1];
+
+            lane_min[lane] = v < lane_min[lane] ? v : lane_min[lane];
+            lane_max[lane] = v > lane_max[lane] ? v : lane_max[lane];
+            lane_min_change[lane] = change < lane_min_change[lane] ? change : lane_min_change[lane];
+            lane_max_change[lane] = change > lane_max_change[lane] ? change : lane_max_change[lane];
+
+            double delta = v - lane_mean[lane];
+            lane_mean[lane] += delta / lane_count;
+            lane_m2[lane] += delta * (v - lane_mean[lane]);
+        }
+    }
+
+    double count = 1.0;
+    double mean = values[0];
+    double m2 = 0.0;
+    for (int32_t lane = 0; lane < STATISTICS_LANES; lane++) {
+        if (lane_min[lane] < min) {
+            min = lane_min[lane];
+        }
+        if (lane_max[lane] > max) {
+            max = lane_max[lane];
         }
+        if (lane_min_change[lane] < min_change) {
+            min_change = lane_min_change[lane];
+        }
+        if (lane_max_change[lane] > max_change) {
+            max_change = lane_max_change[lane];
+        }
+        merge_moments(count, mean, m2, number_blocks, lane_mean[lane], lane_m2[lane]);
     }
 
-    average /= values.size();
+    // the values left over after the last full block
+    for (int32_t i = 1 + (number_blocks * STATISTICS_LANES); i < number_values; i++) {
+        double change = values[i] - values[i - 1];
+
+        if (values[i] < min) {
+            min = values[i];
+        }
+        if (values[i] > max) {
+            max = values[i];
+        }
+        if (change < min_change) {
+            min_change = change;
+        }
+        if (change > max_change) {
+            max_change = change;
+        }
 
-    for (uint32_t i = 0; i < values.size(); i++) {
-        double diff = values[i] - average;
-        variance += diff * diff;
+        merge_moments(count, mean, m2, 1.0, values[i], 0.0);
     }
-    variance /= values.size() - 1;
+
+    average = mean;
+    variance = m2 / (number_values - 1);
 
     std_dev = sqrt(variance);
 }
@@ -131,22 +212,25 @@ void TimeSeries::normalize_min_max(double min, double max) {
         min, max, this->min, this->max
     );
 
-    for (int32_t i = 0; i < (int32_t) values.size(); i++) {
-        if (values[i] < min) {
-            Log::warning(
-                "normalizing series %s, value[%d] %lf was less than min for normalization: %lf\n", name.c_str(), i,
-                values[i], min
-            );
-        }
-
-        if (values[i] > max) {
-            Log::warning(
-                "normalizing series %s, value[%d] %lf was greater than max for normalization: %lf\n", name.c_str(), i,
-                values[i], max
-            );
-        }
+    // values outside of the bounds are counted and reported once for the series, so the loop does not branch
+    int32_t below_min = 0;
+    int32_t above_max = 0;
+    double range = max - min;
+
+    double* value = values.data();
+    int32_t number_values = (int32_t) values.size();
+    for (int32_t i = 0; i < number_values; i++) {
+        below_min += value[i] < min;
+        above_max += value[i] > max;
+        value[i] = (value[i] - min) / range;
+    }
 
-        values[i] = (values[i] - min) / (max - min);
+    if (below_min > 0 || above_max > 0) {
+        Log::warning(
+            "normalizing series %s, %d values were less than min for normalization: %lf and %d were greater than max "
+            "for normalization: %lf\n",
+            name.c_str(), below_min, min, above_max, max
+        );
     }
 }
 
@@ -158,8 +242,10 @@ void TimeSeries::normalize_avg_std_dev(double avg, double std_dev, double norm_m
         name.c_str(), avg, std_dev, norm_max, this->average, this->std_dev
     );
 
-    for (int32_t i = 0; i < (int32_t) values.size(); i++) {
-        values[i] = ((values[i] - avg) / std_dev) / norm_max;
+    double* value = values.data();
+    int32_t number_values = (int32_t) values.size();
+    for (int32_t i = 0; i < number_values; i++) {
+        value[i] = ((value[i] - avg) / std_dev) / norm_max;
     }
 }
 
@@ -193,6 +279,13 @@ double TimeSeries::get_correlation(const TimeSeries* other, int32_t lag) const {
     return correlation;
 }
 
+void TimeSeries::get_correlations(const TimeSeries* other, int32_t max_lag, vector<double>& correlations) const {
+    correlations.resize(max_lag);
+    for (int32_t lag = 0; lag < max_lag; lag++) {
+        correlations[lag] = get_correlation(other, lag);
+    }
+}
+
 TimeSeries::TimeSeries() {
 }
 
@@ -217,6 +310,10 @@ void TimeSeries::copy_values(vector<double>& series) {
     series = values;
 }
 
+const vector<double>& TimeSeries::get_values() const {
+    return values;
+}
+
 void string_split(const string& s, char delim, vector<string>& result) {
     stringstream ss;
     ss.str(s);
@@ -300,6 +397,15 @@ TimeSeriesSet::TimeSeriesSet(string _filename, const vector<string>& _fields) {
         add_time_series(fields[i]);
     }
 
+    // the series each column of the file is added to, NULL for the unused columns
+    vector<TimeSeries*> column_series(file_fields.size(), NULL);
+    for (int32_t i = 0; i < (int32_t) file_fields.size(); i++) {
+        if (file_fields_used[i]) {
+            column_series[i] = time_series[file_fields[i]];
+        }
+    }
+    bool tracing = Log::at_level(Log::TRACE);
+
     int32_t row = 1;
     while (getline(ts_file, line)) {
         if (line.size() == 0 || line[0] == '#' || row < 0) {
@@ -307,32 +413,49 @@ TimeSeriesSet::TimeSeriesSet(string _filename, const vector<string>& _fields) {
             continue;
         }
 
-        vector<string> parts;
-        string_split(line, ',', parts);
+        // the values are parsed in place rather than splitting the row into strings. a trailing empty value is not
+        // counted, the same as splitting with getline
+        int32_t number_parts = (int32_t) count(line.begin(), line.end(), ',') + 1;
+        if (line.back() == ',') {
+            number_parts--;
+        }
 
-        if (parts.size() != file_fields.size()) {
+        if (number_parts != (int32_t) file_fields.size()) {
             Log::fatal(
                 "ERROR! number of values in row %d was %d, but there were %d fields in the header.\n", row,
-                parts.size(), file_fields.size()
+                number_parts, file_fields.size()
             );
             exit(1);
         }
 
-        for (int32_t i = 0; i < (int32_t) parts.size(); i++) {
-            if (!file_fields_used[i]) {
-                continue;
+        const char* part = line.c_str();
+        for (int32_t i = 0; i < number_parts; i++) {
+            const char* part_end = strchr(part, ',');
+            if (part_end == NULL) {
+                part_end = line.c_str() + line.size();
             }
 
-            Log::trace("parts[%d]: %s being added to '%s'\n", i, parts[i].c_str(), file_fields[i].c_str());
+            if (column_series[i] != NULL) {
+                if (tracing) {
+                    Log::trace(
+                        "parts[%d]: %s being added to '%s'\n", i, string(part, part_end).c_str(),
+                        file_fields[i].c_str()
+                    );
+                }
 
-            try {
-                time_series[file_fields[i]]->add_value(stod(parts[i]));
-            } catch (const invalid_argument& ia) {
-                Log::error(
-                    "file: '%s' -- invalid argument: '%s' on row %d and column %d: '%s', value: '%s'\n",
-                    filename.c_str(), ia.what(), row, i, file_fields[i].c_str(), parts[i].c_str()
-                );
+                char* value_end;
+                double value = strtod(part, &value_end);
+                if (value_end == part) {
+                    Log::error(
+                        "file: '%s' -- invalid argument on row %d and column %d: '%s', value: '%s'\n",
+                        filename.c_str(), row, i, file_fields[i].c_str(), string(part, part_end).c_str()
+                    );
+                } else {
+                    column_series[i]->add_value(value);
+                }
             }
+
+            part = part_end + 1;
         }
 
         row++;
@@ -398,6 +521,15 @@ void TimeSeriesSet::get_series(string field_name, vector<double>& series) {
     time_series[field_name]->copy_values(series);
 }
 
+const TimeSeries* TimeSeriesSet::get_time_series(string field_name) const {
+    auto series = time_series.find(field_name);
+    if (series == time_series.end()) {
+        Log::fatal("ERROR: time series set '%s' does not have a field '%s'\n", filename.c_str(), field_name.c_str());
+        exit(1);
+    }
+    return series->second;
+}
+
 double TimeSeriesSet::get_min(string field) {
     return time_series[field]->get_min();
 }
@@ -426,12 +558,13 @@ double TimeSeriesSet::get_max_change(string field) {
     return time_series[field]->get_max_change();
 }
 
+// these use at() rather than [] as they are called for different fields of the same set from multiple threads
 void TimeSeriesSet::normalize_min_max(string field, double min, double max) {
-    time_series[field]->normalize_min_max(min, max);
+    time_series.at(field)->normalize_min_max(min, max);
 }
 
 void TimeSeriesSet::normalize_avg_std_dev(string field, double avg, double std_dev, double norm_max) {
-    time_series[field]->normalize_avg_std_dev(avg, std_dev, norm_max);
+    time_series.at(field)->normalize_avg_std_dev(avg, std_dev, norm_max);
 }
 
 double TimeSeriesSet::get_correlation(string field1, string field2, int32_t lag) const {
@@ -441,6 +574,30 @@ double TimeSeriesSet::get_correlation(string field1, string field2, int32_t lag)
     return first_series->get_correlation(second_series, lag);
 }
 
+void TimeSeriesSet::get_correlations(
+    const vector<string>& fields1, const vector<string>& fields2, int32_t max_lag, int32_t number_threads,
+    vector<vector<vector<double> > >& correlations
+) const {
+    vector<const TimeSeries*> series1;
+    for (int32_t i = 0; i < (int32_t) fields1.size(); i++) {
+        series1.push_back(get_time_series(fields1[i]));
+    }
+
+    vector<const TimeSeries*> series2;
+    for (int32_t i = 0; i < (int32_t) fields2.size(); i++) {
+        series2.push_back(get_time_series(fields2[i]));
+    }
+
+    correlations.assign(fields1.size(), vector<vector<double> >(fields2.size()));
+
+    int32_t number_pairs = (int32_t) (series1.size() * series2.size());
+    parallel_for(number_threads, number_pairs, [&](int32_t pair) {
+        int32_t i = pair / (int32_t) series2.size();
+        int32_t j = pair % (int32_t) series2.size();
+        series1[i]->get_correlations(series2[j], max_lag, correlations[i][j]);
+    });
+}
+
 /**
  *  Time offset < 0 generates input data. Do not use the last <time_offset> values
  *  Time offset > 0 generates output data. Do not use the first <time_offset> values
@@ -582,6 +739,45 @@ void TimeSeriesSet::select_parameters(
     select_parameters(combined_parameters);
 }
 
+void parallel_for(int32_t number_threads, int32_t number_items, const function<void(int32_t)>& work) {
+    if (number_threads > number_items) {
+        number_threads = number_items;
+    }
+
+    if (number_threads <= 1) {
+        for (int32_t i = 0; i < number_items; i++) {
+            work(i);
+        }
+        return;
+    }
+
+    // the log ids are unique over all calls and over the MPI ranks sharing an output directory, as a log file is
+    // truncated when an id is first written to
+    static atomic<int32_t> log_id_counter(0);
+    string log_id_prefix = "preprocessing_";
+    if (Log::get_rank() >= 0) {
+        log_id_prefix += to_string(Log::get_rank()) + "_";
+    }
+
+    atomic<int32_t> next_item(0);
+    vector<thread> threads;
+    for (int32_t i = 0; i < number_threads; i++) {
+        string log_id = log_id_prefix + to_string(log_id_counter++);
+
+        threads.push_back(thread([&work, &next_item, number_items, log_id]() {
+            Log::set_id(log_id);
+            for (int32_t item = next_item++; item < number_items; item = next_item++) {
+                work(item);
+            }
+            Log::release_id(log_id);
+        }));
+    }
+
+    for (int32_t i = 0; i < number_threads; i++) {
+        threads[i].join();
+    }
+}
+
 void TimeSeriesSets::help_message() {
     Log::info("TimeSeriesSets initialization options from arguments:\n");
     Log::info("\tFile input:\n");
@@ -611,6 +807,12 @@ void TimeSeriesSets::help_message() {
     );
     Log::info("\t\t\t\tThe settings string requires at one of 'i' or 'o'.\n");
 
+    Log::info("\tPreprocessing:\n");
+    Log::info(
+        "\t\t--preprocessing_threads <int>: (optional) the number of threads files are loaded and normalized with, "
+        "defaults to 1. every MPI rank starts its own threads, so with one rank per core this should stay 1\n"
+    );
+
     Log::info("\tNormalization:\n");
     Log::info(
         "\t\t--normalize <type>: (optional) normalize the data. Types can be 'min_max' or 'avg_std_dev'. 'min_max' "
@@ -620,7 +822,7 @@ void TimeSeriesSets::help_message() {
     );
 }
 
-TimeSeriesSets::TimeSeriesSets() : normalize_type("none") {
+TimeSeriesSets::TimeSeriesSets() : normalize_type("none"), number_threads(1) {
 }
 
 TimeSeriesSets::~TimeSeriesSets() {
@@ -731,13 +933,15 @@ void TimeSeriesSets::load_time_series() {
         Log::debug("got time series filenames:\n");
     }
 
+    // reading and parsing the files is most of the time spent preprocessing, so they are loaded in parallel
+    time_series.assign(filenames.size(), NULL);
+    parallel_for(number_threads, (int32_t) filenames.size(), [this](int32_t i) {
+        time_series[i] = new TimeSeriesSet(filenames[i], all_parameter_names);
+    });
+
     for (int32_t i = 0; i < (int32_t) filenames.size(); i++) {
         Log::info("\t%s\n", filenames[i].c_str());
-
-        TimeSeriesSet* ts = new TimeSeriesSet(filenames[i], all_parameter_names);
-        time_series.push_back(ts);
-
-        rows += ts->get_number_rows();
+        rows += time_series[i]->get_number_rows();
     }
     Log::debug("number of time series files: %d, total rows: %d\n", filenames.size(), rows);
 }
@@ -832,6 +1036,12 @@ TimeSeriesSets* TimeSeriesSets::generate_from_arguments(const vector<string>& ar
         exit(1);
     }
 
+    get_argument(arguments, "--preprocessing_threads", false, tss->number_threads);
+    if (tss->number_threads < 1) {
+        Log::fatal("ERROR: --preprocessing_threads must be at least 1, it was %d\n", tss->number_threads);
+        exit(1);
+    }
+
     tss->load_time_series();
 
     tss->normalize_type = "";
@@ -921,6 +1131,16 @@ double TimeSeriesSets::denormalize(string field_name, double value) {
     }
 }
 
+void TimeSeriesSets::normalize_columns(const function<void(TimeSeriesSet*, int32_t)>& normalize) {
+    // each column of each set is normalized separately, so the work is split up even when there is only one set
+    int32_t number_parameters = (int32_t) all_parameter_names.size();
+    int32_t number_columns = (int32_t) time_series.size() * number_parameters;
+
+    parallel_for(number_threads, number_columns, [this, &normalize, number_parameters](int32_t column) {
+        normalize(time_series[column / number_parameters], column % number_parameters);
+    });
+}
+
 void TimeSeriesSets::normalize_min_max() {
     Log::info("doing min/max normalization:\n");
 
@@ -959,13 +1179,14 @@ void TimeSeriesSets::normalize_min_max() {
         }
 
         Log::info_no_header("%30s, min: %22.10lf, max: %22.10lf\n", parameter_name.c_str(), min, max);
-
-        // for each series, subtract min, divide by (max - min)
-        for (int32_t j = 0; j < (int32_t) time_series.size(); j++) {
-            time_series[j]->normalize_min_max(parameter_name, min, max);
-        }
     }
 
+    // for each series, subtract min, divide by (max - min)
+    normalize_columns([this](TimeSeriesSet* set, int32_t parameter) {
+        string parameter_name = all_parameter_names[parameter];
+        set->normalize_min_max(parameter_name, normalize_mins.at(parameter_name), normalize_maxs.at(parameter_name));
+    });
+
     normalize_type = "min_max";
 }
 
@@ -997,19 +1218,22 @@ void TimeSeriesSets::normalize_min_max(
             }
             exit(1);
         }
-
-        // for each series, subtract min, divide by (max - min)
-        for (int32_t j = 0; j < (int32_t) time_series.size(); j++) {
-            time_series[j]->normalize_min_max(field, normalize_mins[field], normalize_maxs[field]);
-        }
     }
 
+    // for each series, subtract min, divide by (max - min)
+    normalize_columns([this](TimeSeriesSet* set, int32_t parameter) {
+        string field = all_parameter_names[parameter];
+        set->normalize_min_max(field, normalize_mins.at(field), normalize_maxs.at(field));
+    });
+
     normalize_type = "min_max";
 }
 
 void TimeSeriesSets::normalize_avg_std_dev() {
     Log::info("doing min/max normalization:\n");
 
+    vector<double> norm_maxs(all_parameter_names.size());
+
     for (int32_t i = 0; i < (int32_t) all_parameter_names.size(); i++) {
         string parameter_name = all_parameter_names[i];
 
@@ -1081,12 +1305,18 @@ void TimeSeriesSets::normalize_avg_std_dev() {
             parameter_name.c_str(), min, max, avg, norm_max, std_dev
         );
 
-        // for each series, subtract min, divide by (max - min)
-        for (int32_t j = 0; j < (int32_t) time_series.size(); j++) {
-            time_series[j]->normalize_avg_std_dev(parameter_name, avg, std_dev, norm_max);
-        }
+        norm_maxs[i] = norm_max;
     }
 
+    // for each series, subtract avg, divide by std_dev; then divide by normalized_max to make between -1 and 1
+    normalize_columns([this, &norm_maxs](TimeSeriesSet* set, int32_t parameter) {
+        string parameter_name = all_parameter_names[parameter];
+        set->normalize_avg_std_dev(
+            parameter_name, normalize_avgs.at(parameter_name), normalize_std_devs.at(parameter_name),
+            norm_maxs[parameter]
+        );
+    });
+
     normalize_type = "avg_std_dev";
 }
 
@@ -1099,6 +1329,7 @@ void TimeSeriesSets::normalize_avg_std_dev(
     normalize_mins = _normalize_mins;
     normalize_maxs = _normalize_maxs;
 
+    vector<double> norm_maxs(all_parameter_names.size());
     for (int32_t i = 0; i < (int32_t) all_parameter_names.size(); i++) {
         string field = all_parameter_names[i];
 
@@ -1150,14 +1381,17 @@ void TimeSeriesSets::normalize_avg_std_dev(
         double norm_min = (min - avg) / std_dev;
         double norm_max = (max - avg) / std_dev;
 
-        norm_max = fmax(norm_min, norm_max);
-
-        // for each series, subtract avg, divide by std_dev; then divide by normalized_max to make between -1 and 1
-        for (int32_t j = 0; j < (int32_t) time_series.size(); j++) {
-            time_series[j]->normalize_avg_std_dev(field, avg, std_dev, norm_max);
-        }
+        norm_maxs[i] = fmax(norm_min, norm_max);
     }
 
+    // for each series, subtract avg, divide by std_dev; then divide by normalized_max to make between -1 and 1
+    normalize_columns([this, &norm_maxs](TimeSeriesSet* set, int32_t parameter) {
+        string field = all_parameter_names[parameter];
+        set->normalize_avg_std_dev(
+            field, normalize_avgs.at(field), normalize_std_devs.at(field), norm_maxs[parameter]
+        );
+    });
+
     normalize_type = "avg_std_dev";
 }
 
@@ -1303,10 +1537,26 @@ vector<string> TimeSeriesSets::get_output_parameter_names() const {
     return output_parameter_names;
 }
 
+vector<string> TimeSeriesSets::get_shift_parameter_names() const {
+    return shift_parameter_names;
+}
+
+vector<int> TimeSeriesSets::get_training_indexes() const {
+    return training_indexes;
+}
+
+vector<int> TimeSeriesSets::get_test_indexes() const {
+    return test_indexes;
+}
+
 int32_t TimeSeriesSets::get_number_series() const {
     return (int32_t) time_series.size();
 }
 
+int32_t TimeSeriesSets::get_number_threads() const {
+    return number_threads;
+}
+
 int32_t TimeSeriesSets::get_number_inputs() const {
     return (int32_t) input_parameter_names.size();
 }
@@ -1,6 +1,9 @@
 #ifndef EXAMM_TIME_SERIES_HXX
 #define EXAMM_TIME_SERIES_HXX
 
+#include <functional>
+using std::function;
+
 #include <iostream>
 using std::ostream;
 
@@ -54,10 +57,12 @@ class TimeSeries {
     void cut(int32_t start, int32_t stop);
 
     double get_correlation(const TimeSeries* other, int32_t lag) const;
+    void get_correlations(const TimeSeries* other, int32_t max_lag, vector<double>& correlations) const;
 
     TimeSeries* copy();
 
     void copy_values(vector<double>& series);
+    const vector<double>& get_values() const;
 };
 
 class TimeSeriesSet {
@@ -83,6 +88,7 @@ class TimeSeriesSet {
     vector<string> get_fields() const;
 
     void get_series(string field_name, vector<double>& series);
+    const TimeSeries* get_time_series(string field_name) const;
 
     double get_min(string field);
     double get_average(string field);
@@ -94,6 +100,16 @@ class TimeSeriesSet {
 
     double get_correlation(string field1, string field2, int32_t lag) const;
 
+    /**
+     *  Calculates the correlations of each of fields1 with each of fields2 lagged by 0 to max_lag - 1 rows (see
+     *  TimeSeries::get_correlation), correlations[i][j][lag] being for fields1[i] and fields2[j]. The pairs are split
+     *  over number_threads threads.
+     */
+    void get_correlations(
+        const vector<string>& fields1, const vector<string>& fields2, int32_t max_lag, int32_t number_threads,
+        vector<vector<vector<double> > >& correlations
+    ) const;
+
     void normalize_min_max(string field, double min, double max);
     void normalize_avg_std_dev(string field, double avg, double std_dev, double norm_max);
 
@@ -113,10 +129,20 @@ class TimeSeriesSet {
     void select_parameters(const vector<string>& input_parameter_names, const vector<string>& output_parameter_names);
 };
 
+/**
+ *  Calls work(i) for each i in [0, number_items), spread over up to number_threads threads which take the next item
+ *  as they finish one. Each thread gets its own log id so the work can log.
+ */
+void parallel_for(int32_t number_threads, int32_t number_items, const function<void(int32_t)>& work);
+
 class TimeSeriesSets {
    private:
     string normalize_type;
 
+    // files are loaded and normalized on this many threads, 1 unless --preprocessing_threads is given as every MPI rank
+    // preprocesses its own copy of the data
+    int32_t number_threads;
+
     vector<string> filenames;
 
     vector<int> training_indexes;
@@ -138,6 +164,11 @@ class TimeSeriesSets {
     void parse_parameters_string(const vector<string>& p);
     void load_time_series();
 
+    /**
+     *  Calls normalize(set, parameter) for every set and index into all_parameter_names, in parallel.
+     */
+    void normalize_columns(const function<void(TimeSeriesSet*, int32_t)>& normalize);
+
    public:
     static void help_message();
 
@@ -188,8 +219,13 @@ class TimeSeriesSets {
 
     vector<string> get_input_parameter_names() const;
     vector<string> get_output_parameter_names() const;
+    vector<string> get_shift_parameter_names() const;
+
+    vector<int> get_training_indexes() const;
+    vector<int> get_test_indexes() const;
 
     int32_t get_number_series() const;
+    int32_t get_number_threads() const;
 
     int32_t get_number_inputs() const;
     int32_t get_number_outputs() const;
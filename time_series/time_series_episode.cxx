@@ -10,11 +10,15 @@ using std::ofstream;
 using std::ifstream;
 
 TimeSeriesEpisode::TimeSeriesEpisode(int32_t id) 
-    : episode_id(id), validation_mse(1.0), availability_generation(0), is_loaded(false) {
+    : episode_id(id), windows(NULL), window(-1), validation_mse(1.0), availability_generation(0), is_loaded(false) {
 }
 
 TimeSeriesEpisode::TimeSeriesEpisode(int32_t id, const vector<vector<double>>& _inputs, const vector<vector<double>>& _outputs)
-    : episode_id(id), inputs(_inputs), outputs(_outputs), validation_mse(1.0), availability_generation(0), is_loaded(true) {
+    : episode_id(id), inputs(_inputs), outputs(_outputs), windows(NULL), window(-1), validation_mse(1.0), availability_generation(0), is_loaded(true) {
+}
+
+TimeSeriesEpisode::TimeSeriesEpisode(int32_t id, const TimeSeriesWindows* _windows, int32_t _window)
+    : episode_id(id), windows(_windows), window(_window), validation_mse(1.0), availability_generation(0), is_loaded(false) {
 }
 
 TimeSeriesEpisode::~TimeSeriesEpisode() {
@@ -44,6 +48,15 @@ void TimeSeriesEpisode::set_data(const vector<vector<double>>& _inputs, const ve
     // update_access_time();
 }
 
+void TimeSeriesEpisode::export_data(vector<vector<double>>& _inputs, vector<vector<double>>& _outputs) const {
+    if (!is_loaded && windows != NULL) {
+        windows->export_window(window, _inputs, _outputs);
+    } else {
+        _inputs = inputs;
+        _outputs = outputs;
+    }
+}
+
 void TimeSeriesEpisode::set_validation_mse(double mse) {
     validation_mse = mse;
 }
@@ -94,10 +107,10 @@ bool TimeSeriesEpisode::is_data_loaded() const {
 }
 
 void TimeSeriesEpisode::ensure_loaded() {
-    if (!is_loaded) {
-        // For now, this is a no-op since we keep everything in memory
-        // Future implementation could load from disk here
-        Log::debug("Episode %d data access - already in memory\n", episode_id);
+    if (!is_loaded && windows != NULL) {
+        windows->export_window(window, inputs, outputs);
+        is_loaded = true;
+        Log::debug("Episode %d data access - exported window %d\n", episode_id, window);
     }
 }
 
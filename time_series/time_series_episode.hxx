@@ -12,11 +12,17 @@ using std::string;
 using std::unique_ptr;
 using std::vector;
 
+#include "time_series_windows.hxx"
+
 class TimeSeriesEpisode {
    private:
     int32_t episode_id; // episode id is the index of the episode in the original time series - this NEVER changes
     vector<vector<double>> inputs;
     vector<vector<double>> outputs;
+
+    // when set, the data is the window over these windows' series instead of being held by the episode
+    const TimeSeriesWindows* windows;
+    int32_t window;
     
     // PER-based priority system
     double validation_mse;  // MSE used for priority calculation
@@ -29,6 +35,7 @@ class TimeSeriesEpisode {
     // Constructors
     TimeSeriesEpisode(int32_t id);
     TimeSeriesEpisode(int32_t id, const vector<vector<double>>& inputs, const vector<vector<double>>& outputs);
+    TimeSeriesEpisode(int32_t id, const TimeSeriesWindows* windows, int32_t window);
     
     // Destructor
     ~TimeSeriesEpisode();
@@ -37,6 +44,8 @@ class TimeSeriesEpisode {
     const vector<vector<double>>& get_inputs();
     const vector<vector<double>>& get_outputs();
     void set_data(const vector<vector<double>>& inputs, const vector<vector<double>>& outputs);
+    // copies the data into inputs and outputs, for a windowed episode without keeping a copy in the episode
+    void export_data(vector<vector<double>>& inputs, vector<vector<double>>& outputs) const;
     
     // Priority system methods
     void set_validation_mse(double mse);
@@ -47,7 +56,7 @@ class TimeSeriesEpisode {
     
     // Memory management
     bool is_data_loaded() const;
-    void ensure_loaded();  // Make sure data is in memory
+    void ensure_loaded();  // Make sure data is in memory, a windowed episode keeps a copy from then on
     
     // Episode identification
     int32_t get_episode_id() const;
@@ -0,0 +1,138 @@
+#include <algorithm>
+using std::find;
+
+#include <string>
+using std::string;
+
+#include <vector>
+using std::vector;
+
+#include "common/log.hxx"
+#include "time_series_windows.hxx"
+
+TimeSeriesWindows::TimeSeriesWindows(
+    TimeSeriesSets* time_series_sets, const vector<int>& _series_indexes, int32_t _time_offset
+) {
+    time_offset = _time_offset;
+    if (time_offset < 0) {
+        Log::fatal("ERROR: time series windows need a time offset >= 0, but it was %d\n", time_offset);
+        exit(1);
+    }
+
+    vector<string> input_parameter_names = time_series_sets->get_input_parameter_names();
+    vector<string> output_parameter_names = time_series_sets->get_output_parameter_names();
+    vector<string> shift_parameter_names = time_series_sets->get_shift_parameter_names();
+
+    for (int32_t i = 0; i < (int32_t) input_parameter_names.size(); i++) {
+        input_shifted.push_back(
+            find(shift_parameter_names.begin(), shift_parameter_names.end(), input_parameter_names[i])
+            != shift_parameter_names.end()
+        );
+    }
+
+    for (int32_t i = 0; i < (int32_t) _series_indexes.size(); i++) {
+        TimeSeriesSet* set = time_series_sets->get_set(_series_indexes[i]);
+
+        vector<const vector<double>*> inputs;
+        for (int32_t j = 0; j < (int32_t) input_parameter_names.size(); j++) {
+            inputs.push_back(&set->get_time_series(input_parameter_names[j])->get_values());
+        }
+
+        vector<const vector<double>*> outputs;
+        for (int32_t j = 0; j < (int32_t) output_parameter_names.size(); j++) {
+            outputs.push_back(&set->get_time_series(output_parameter_names[j])->get_values());
+        }
+
+        input_columns.push_back(inputs);
+        output_columns.push_back(outputs);
+        series_indexes.push_back(_series_indexes[i]);
+        series_rows.push_back(set->get_number_rows());
+    }
+}
+
+void TimeSeriesWindows::generate(int32_t sequence_length, int32_t stride) {
+    if (sequence_length > 0 && stride <= 0) {
+        Log::fatal("ERROR: time series windows need a stride > 0, but it was %d\n", stride);
+        exit(1);
+    }
+
+    windows.clear();
+    for (int32_t series = 0; series < (int32_t) series_rows.size(); series++) {
+        int32_t usable_rows = series_rows[series] - time_offset;
+
+        if (sequence_length <= 0) {
+            if (usable_rows > 0) {
+                windows.push_back({series, 0, usable_rows, time_offset});
+            }
+        } else {
+            for (int32_t start = 0; start + sequence_length <= usable_rows; start += stride) {
+                windows.push_back({series, start, sequence_length, time_offset});
+            }
+        }
+
+        Log::debug(
+            "time series %d has %d rows with time offset %d, %d windows in total\n", series_indexes[series],
+            usable_rows, time_offset, windows.size()
+        );
+    }
+
+    Log::info(
+        "Generated %d windows of length %d with stride %d over %d time series\n", windows.size(), sequence_length,
+        stride, series_rows.size()
+    );
+}
+
+int32_t TimeSeriesWindows::get_number_windows() const {
+    return (int32_t) windows.size();
+}
+
+int32_t TimeSeriesWindows::get_number_series() const {
+    return (int32_t) series_rows.size();
+}
+
+int32_t TimeSeriesWindows::get_number_inputs() const {
+    return (int32_t) input_shifted.size();
+}
+
+int32_t TimeSeriesWindows::get_number_outputs() const {
+    return output_columns.size() == 0 ? 0 : (int32_t) output_columns[0].size();
+}
+
+int32_t TimeSeriesWindows::get_time_offset() const {
+    return time_offset;
+}
+
+const TimeSeriesWindow& TimeSeriesWindows::get_window(int32_t window) const {
+    return windows.at(window);
+}
+
+void TimeSeriesWindows::export_window(
+    int32_t window, vector<vector<double> >& inputs, vector<vector<double> >& outputs
+) const {
+    const TimeSeriesWindow& w = windows.at(window);
+    const vector<const vector<double>*>& series_inputs = input_columns[w.series];
+    const vector<const vector<double>*>& series_outputs = output_columns[w.series];
+
+    inputs.resize(series_inputs.size());
+    for (int32_t i = 0; i < (int32_t) series_inputs.size(); i++) {
+        auto first = series_inputs[i]->begin() + w.start + (input_shifted[i] ? w.time_offset : 0);
+        inputs[i].assign(first, first + w.length);
+    }
+
+    outputs.resize(series_outputs.size());
+    for (int32_t i = 0; i < (int32_t) series_outputs.size(); i++) {
+        auto first = series_outputs[i]->begin() + w.start + w.time_offset;
+        outputs[i].assign(first, first + w.length);
+    }
+}
+
+void TimeSeriesWindows::export_windows(
+    vector<vector<vector<double> > >& inputs, vector<vector<vector<double> > >& outputs
+) const {
+    inputs.resize(windows.size());
+    outputs.resize(windows.size());
+
+    for (int32_t i = 0; i < (int32_t) windows.size(); i++) {
+        export_window(i, inputs[i], outputs[i]);
+    }
+}
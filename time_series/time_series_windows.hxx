@@ -0,0 +1,66 @@
+#ifndef EXAMM_TIME_SERIES_WINDOWS_HXX
+#define EXAMM_TIME_SERIES_WINDOWS_HXX
+
+#include <cstdint>
+
+#include <vector>
+using std::vector;
+
+#include "time_series.hxx"
+
+/**
+ *  A window of one of the exported series: the inputs are its rows [start, start + length) and the outputs are the
+ *  rows time_offset later (as are the inputs which are shift parameters), the same as exporting the series with that
+ *  time offset and slicing out [start, start + length).
+ */
+struct TimeSeriesWindow {
+    int32_t series;
+    int32_t start;
+    int32_t length;
+    int32_t time_offset;
+};
+
+/**
+ *  Describes episodes as windows over the columns of a TimeSeriesSets instead of copying each of them out, so a
+ *  window costs four ints until it is exported. The columns are referenced, not copied, so exporting gives the values
+ *  the TimeSeriesSets has at the time (e.g. normalized), and it has to outlive this and must not be cut or split.
+ */
+class TimeSeriesWindows {
+   private:
+    int32_t time_offset;
+
+    // the columns of each exported series, [series][parameter], in the input and output parameter orders
+    vector<vector<const vector<double>*> > input_columns;
+    vector<vector<const vector<double>*> > output_columns;
+    vector<int32_t> series_indexes;
+    vector<int32_t> series_rows;
+
+    // inputs which are shift parameters are read time_offset rows later, like the outputs
+    vector<bool> input_shifted;
+
+    vector<TimeSeriesWindow> windows;
+
+   public:
+    TimeSeriesWindows(TimeSeriesSets* time_series_sets, const vector<int>& _series_indexes, int32_t _time_offset);
+
+    /**
+     *  Replaces the windows with windows of sequence_length rows, starting every stride rows of each series, the
+     *  series in the order they were given. A stride smaller than the sequence length gives overlapping windows,
+     *  trailing rows which do not fill a window are dropped. A sequence length <= 0 gives one window per series over
+     *  all of it.
+     */
+    void generate(int32_t sequence_length, int32_t stride);
+
+    int32_t get_number_windows() const;
+    int32_t get_number_series() const;
+    int32_t get_number_inputs() const;
+    int32_t get_number_outputs() const;
+    int32_t get_time_offset() const;
+
+    const TimeSeriesWindow& get_window(int32_t window) const;
+
+    void export_window(int32_t window, vector<vector<double> >& inputs, vector<vector<double> >& outputs) const;
+    void export_windows(vector<vector<vector<double> > >& inputs, vector<vector<vector<double> > >& outputs) const;
+};
+
+#endif
@@ -1,5 +1,9 @@
 #include "weight_update.hxx"
 
+#include <algorithm>
+using std::max;
+using std::min;
+
 #include <cmath>
 
 #include "common/arguments.hxx"
@@ -77,20 +81,31 @@ void WeightUpdate::update_weights(
     vector<double>& parameters, vector<double>& velocity, vector<double>& prev_velocity, vector<double>& gradient,
     int32_t epoch
 ) {
+    norm_and_update_weights(parameters, velocity, prev_velocity, gradient, NAN, epoch);
+}
+
+void WeightUpdate::norm_and_update_weights(
+    vector<double>& parameters, vector<double>& velocity, vector<double>& prev_velocity,
+    const vector<double>& gradient, double norm, int32_t epoch
+) {
+    // a NAN norm (from update_weights) is never over or under a threshold, so the gradient is used as is
+    double gradient_multiplier = get_norm_multiplier(norm);
+
+    Log::trace("Doing weight update with method: %s \n", WEIGHT_UPDATE_METHOD_STRING[weight_update_method].c_str());
     if (weight_update_method == VANILLA) {
-        vanilla_weight_update(parameters, velocity, prev_velocity, gradient, epoch);
+        fused_weight_update<VANILLA>(parameters, velocity, prev_velocity, gradient, gradient_multiplier, epoch);
     } else if (weight_update_method == MOMENTUM) {
-        momentum_weight_update(parameters, velocity, prev_velocity, gradient, epoch);
+        fused_weight_update<MOMENTUM>(parameters, velocity, prev_velocity, gradient, gradient_multiplier, epoch);
     } else if (weight_update_method == NESTEROV) {
-        nesterov_weight_update(parameters, velocity, prev_velocity, gradient, epoch);
+        fused_weight_update<NESTEROV>(parameters, velocity, prev_velocity, gradient, gradient_multiplier, epoch);
     } else if (weight_update_method == ADAGRAD) {
-        adagrad_weight_update(parameters, velocity, prev_velocity, gradient, epoch);
+        fused_weight_update<ADAGRAD>(parameters, velocity, prev_velocity, gradient, gradient_multiplier, epoch);
     } else if (weight_update_method == RMSPROP) {
-        rmsprop_weight_update(parameters, velocity, prev_velocity, gradient, epoch);
+        fused_weight_update<RMSPROP>(parameters, velocity, prev_velocity, gradient, gradient_multiplier, epoch);
     } else if (weight_update_method == ADAM) {
-        adam_weight_update(parameters, velocity, prev_velocity, gradient, epoch);
+        fused_weight_update<ADAM>(parameters, velocity, prev_velocity, gradient, gradient_multiplier, epoch);
     } else if (weight_update_method == ADAM_BIAS) {
-        adam_bias_weight_update(parameters, velocity, prev_velocity, gradient, epoch);
+        fused_weight_update<ADAM_BIAS>(parameters, velocity, prev_velocity, gradient, gradient_multiplier, epoch);
     } else {
         Log::fatal(
             "Unrecognized weight update method's enom number: %d, this should never happen!\n", weight_update_method
@@ -99,104 +114,74 @@ void WeightUpdate::update_weights(
     }
 }
 
-void WeightUpdate::vanilla_weight_update(
-    vector<double>& parameters, vector<double>& velocity, vector<double>& prev_velocity, vector<double>& gradient,
-    int32_t epoch
-) {
-    Log::trace("Doing weight update with method: %s \n", WEIGHT_UPDATE_METHOD_STRING[weight_update_method].c_str());
-    for (int32_t i = 0; i < (int32_t) parameters.size(); i++) {
-        parameters[i] -= learning_rate * gradient[i];
-        gradient_clip(parameters[i]);
-    }
-}
-
-void WeightUpdate::momentum_weight_update(
-    vector<double>& parameters, vector<double>& velocity, vector<double>& prev_velocity, vector<double>& gradient,
-    int32_t epoch
-) {
-    Log::trace("Doing weight update with method: %s \n", WEIGHT_UPDATE_METHOD_STRING[weight_update_method].c_str());
-    for (int32_t i = 0; i < (int32_t) parameters.size(); i++) {
-        velocity[i] = momentum * velocity[i] - learning_rate * gradient[i];
-        parameters[i] += velocity[i];
-        gradient_clip(parameters[i]);
-    }
-}
-
-void WeightUpdate::nesterov_weight_update(
-    vector<double>& parameters, vector<double>& velocity, vector<double>& prev_velocity, vector<double>& gradient,
-    int32_t epoch
-) {
-    Log::info("Doing weight update with method: %s \n", WEIGHT_UPDATE_METHOD_STRING[weight_update_method].c_str());
-    for (int32_t i = 0; i < (int32_t) parameters.size(); i++) {
-        prev_velocity[i] = velocity[i];
-        velocity[i] = momentum * velocity[i] - learning_rate * gradient[i];
-        parameters[i] += -momentum * prev_velocity[i] + (1 + momentum) * velocity[i];
-        gradient_clip(parameters[i]);
-    }
-}
-
-void WeightUpdate::adagrad_weight_update(
-    vector<double>& parameters, vector<double>& velocity, vector<double>& prev_velocity, vector<double>& gradient,
-    int32_t epoch
-) {
-    Log::trace("Doing weight update with method: %s \n", WEIGHT_UPDATE_METHOD_STRING[weight_update_method].c_str());
-    for (int32_t i = 0; i < (int32_t) parameters.size(); i++) {
-        // here the velocity is the "cache" in Adagrad
-        velocity[i] += gradient[i] * gradient[i];
-        parameters[i] += -learning_rate * gradient[i] / (sqrt(velocity[i]) + epsilon);
-        gradient_clip(parameters[i]);
-    }
-}
-
-void WeightUpdate::rmsprop_weight_update(
-    vector<double>& parameters, vector<double>& velocity, vector<double>& prev_velocity, vector<double>& gradient,
-    int32_t epoch
+template <WeightUpdateMethod method>
+void WeightUpdate::fused_weight_update(
+    vector<double>& parameters, vector<double>& velocity, vector<double>& prev_velocity,
+    const vector<double>& gradient, double gradient_multiplier, int32_t epoch
 ) {
-    Log::trace("Doing weight update with method: %s \n", WEIGHT_UPDATE_METHOD_STRING[weight_update_method].c_str());
-    for (int32_t i = 0; i < (int32_t) parameters.size(); i++) {
-        // here the velocity is the "cache" in RMSProp
-        velocity[i] = decay_rate * velocity[i] + (1 - decay_rate) * gradient[i] * gradient[i];
-        parameters[i] += -learning_rate * gradient[i] / (sqrt(velocity[i]) + epsilon);
-        gradient_clip(parameters[i]);
-    }
-}
-
-void WeightUpdate::adam_weight_update(
-    vector<double>& parameters, vector<double>& velocity, vector<double>& prev_velocity, vector<double>& gradient,
-    int32_t epoch
-) {
-    Log::trace("Doing weight update with method: %s \n", WEIGHT_UPDATE_METHOD_STRING[weight_update_method].c_str());
-    for (int32_t i = 0; i < (int32_t) parameters.size(); i++) {
-        // here the velocity is the "v" in adam, the prev_velocity is "m" in adam
-        prev_velocity[i] = beta1 * prev_velocity[i] + (1 - beta1) * gradient[i];
-        velocity[i] = beta2 * velocity[i] + (1 - beta2) * (gradient[i] * gradient[i]);
-        parameters[i] += -learning_rate * prev_velocity[i] / (sqrt(velocity[i]) + epsilon);
-        gradient_clip(parameters[i]);
-    }
-}
+    int32_t n_parameters = (int32_t) parameters.size();
+    double* p = parameters.data();
+    double* v = velocity.data();
+    double* pv = prev_velocity.data();
+    const double* g = gradient.data();
+
+    // the settings are copied to locals as writing the weights could otherwise change them as far as the compiler
+    // knows, and everything which does not depend on the weight is worked out once (to the same values the per
+    // weight expressions would give, so the results do not change)
+    double learning_rate = this->learning_rate;
+    double momentum = this->momentum;
+    double epsilon = this->epsilon;
+    double decay_rate = this->decay_rate;
+    double beta1 = this->beta1;
+    double beta2 = this->beta2;
+    double negative_learning_rate = -learning_rate;
+    double one_minus_decay_rate = 1 - decay_rate;
+    double one_minus_beta1 = 1 - beta1;
+    double one_minus_beta2 = 1 - beta2;
+    double one_plus_momentum = 1 + momentum;
+    double beta1_correction = 1 - pow(beta1, epoch);
+    double beta2_correction = 1 - pow(beta2, epoch);
+
+    for (int32_t i = 0; i < n_parameters; i++) {
+        double gi = gradient_multiplier * g[i];
+
+        if constexpr (method == VANILLA) {
+            p[i] -= learning_rate * gi;
+        } else if constexpr (method == MOMENTUM) {
+            v[i] = momentum * v[i] - learning_rate * gi;
+            p[i] += v[i];
+        } else if constexpr (method == NESTEROV) {
+            pv[i] = v[i];
+            v[i] = momentum * v[i] - learning_rate * gi;
+            p[i] += -momentum * pv[i] + one_plus_momentum * v[i];
+        } else if constexpr (method == ADAGRAD) {
+            // here the velocity is the "cache" in Adagrad
+            v[i] += gi * gi;
+            p[i] += negative_learning_rate * gi / (sqrt(v[i]) + epsilon);
+        } else if constexpr (method == RMSPROP) {
+            // here the velocity is the "cache" in RMSProp
+            v[i] = decay_rate * v[i] + one_minus_decay_rate * gi * gi;
+            p[i] += negative_learning_rate * gi / (sqrt(v[i]) + epsilon);
+        } else if constexpr (method == ADAM) {
+            // here the velocity is the "v" in adam, the prev_velocity is "m" in adam
+            pv[i] = beta1 * pv[i] + one_minus_beta1 * gi;
+            v[i] = beta2 * v[i] + one_minus_beta2 * (gi * gi);
+            p[i] += negative_learning_rate * pv[i] / (sqrt(v[i]) + epsilon);
+        } else if constexpr (method == ADAM_BIAS) {
+            pv[i] = beta1 * pv[i] + one_minus_beta1 * gi;
+            double mt = pv[i] / beta1_correction;
+            v[i] = beta2 * v[i] + one_minus_beta2 * (gi * gi);
+            double vt = v[i] / beta2_correction;
+            p[i] += negative_learning_rate * mt / (sqrt(vt) + epsilon);
+        }
 
-void WeightUpdate::adam_bias_weight_update(
-    vector<double>& parameters, vector<double>& velocity, vector<double>& prev_velocity, vector<double>& gradient,
-    int32_t epoch
-) {
-    Log::trace("Doing weight update with method: %s \n", WEIGHT_UPDATE_METHOD_STRING[weight_update_method].c_str());
-    for (int32_t i = 0; i < (int32_t) parameters.size(); i++) {
-        // here the velocity is the "v" in adam, the prev_velocity is "m" in adam
-        prev_velocity[i] = beta1 * prev_velocity[i] + (1 - beta1) * gradient[i];
-        double mt = prev_velocity[i] / (1 - pow(beta1, epoch));
-        velocity[i] = beta2 * velocity[i] + (1 - beta2) * (gradient[i] * gradient[i]);
-        double vt = velocity[i] / (1 - pow(beta2, epoch));
-        parameters[i] += -learning_rate * mt / (sqrt(vt) + epsilon);
-        gradient_clip(parameters[i]);
+        gradient_clip(p[i]);
     }
 }
 
 void WeightUpdate::gradient_clip(double& parameter) {
-    if (parameter < -10.0) {
-        parameter = -10.0;
-    } else if (parameter > 10.0) {
-        parameter = 10.0;
-    }
+    // min/max instead of branches so the update loops vectorize, in this order a NAN weight stays NAN
+    parameter = max(min(parameter, 10.0), -10.0);
 }
 
 double WeightUpdate::get_learning_rate() {
@@ -243,21 +228,25 @@ double WeightUpdate::get_norm(vector<double>& analytic_gradient) {
     return norm;
 }
 
-void WeightUpdate::norm_gradients(vector<double>& analytic_gradient, double norm) {
+double WeightUpdate::get_norm_multiplier(double norm) {
     if (use_high_norm && norm > high_threshold) {
         double high_threshold_norm = high_threshold / norm;
         Log::debug_no_header(", OVER THRESHOLD, multiplier: %lf", high_threshold_norm);
-
-        for (int32_t i = 0; i < (int32_t) analytic_gradient.size(); i++) {
-            analytic_gradient[i] = high_threshold_norm * analytic_gradient[i];
-        }
+        return high_threshold_norm;
 
     } else if (use_low_norm && norm < low_threshold) {
         double low_threshold_norm = low_threshold / norm;
         Log::debug_no_header(", UNDER THRESHOLD, multiplier: %lf", low_threshold_norm);
+        return low_threshold_norm;
+    }
+    return 1.0;
+}
 
+void WeightUpdate::norm_gradients(vector<double>& analytic_gradient, double norm) {
+    double multiplier = get_norm_multiplier(norm);
+    if (multiplier != 1.0) {
         for (int32_t i = 0; i < (int32_t) analytic_gradient.size(); i++) {
-            analytic_gradient[i] = low_threshold_norm * analytic_gradient[i];
+            analytic_gradient[i] = multiplier * analytic_gradient[i];
         }
     }
 }
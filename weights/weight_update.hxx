@@ -45,6 +45,19 @@ class WeightUpdate {
     bool use_low_norm;
     double low_threshold;
 
+    /**
+     * Does the whole update for one optimizer in a single pass over the weights: each gradient is scaled by
+     * gradient_multiplier, the moments and weights are updated and the weights are clipped. It is instantiated per
+     * method so the inner loop has no branches on the method and can be vectorized.
+     */
+    template <WeightUpdateMethod method>
+    void fused_weight_update(
+        vector<double>& parameters, vector<double>& velocity, vector<double>& prev_velocity,
+        const vector<double>& gradient, double gradient_multiplier, int32_t epoch
+    );
+
+    double get_norm_multiplier(double norm);
+
    public:
     WeightUpdate();
     explicit WeightUpdate(const vector<string>& arguments);
@@ -55,33 +68,14 @@ class WeightUpdate {
         int32_t epoch
     );
 
-    void vanilla_weight_update(
-        vector<double>& parameters, vector<double>& velocity, vector<double>& prev_velocity, vector<double>& gradient,
-        int32_t epoch
-    );
-    void momentum_weight_update(
-        vector<double>& parameters, vector<double>& velocity, vector<double>& prev_velocity, vector<double>& gradient,
-        int32_t epoch
-    );
-    void nesterov_weight_update(
-        vector<double>& parameters, vector<double>& velocity, vector<double>& prev_velocity, vector<double>& gradient,
-        int32_t epoch
-    );
-    void adagrad_weight_update(
-        vector<double>& parameters, vector<double>& velocity, vector<double>& prev_velocity, vector<double>& gradient,
-        int32_t epoch
-    );
-    void rmsprop_weight_update(
-        vector<double>& parameters, vector<double>& velocity, vector<double>& prev_velocity, vector<double>& gradient,
-        int32_t epoch
-    );
-    void adam_weight_update(
-        vector<double>& parameters, vector<double>& velocity, vector<double>& prev_velocity, vector<double>& gradient,
-        int32_t epoch
-    );
-    void adam_bias_weight_update(
-        vector<double>& parameters, vector<double>& velocity, vector<double>& prev_velocity, vector<double>& gradient,
-        int32_t epoch
+    /**
+     * The same as norm_gradients followed by update_weights, but the gradient is scaled on the fly in the same pass
+     * which updates the weights instead of being rewritten first, so it is left unchanged. norm should come from
+     * get_norm(gradient).
+     */
+    void norm_and_update_weights(
+        vector<double>& parameters, vector<double>& velocity, vector<double>& prev_velocity,
+        const vector<double>& gradient, double norm, int32_t epoch
     );
 
     void gradient_clip(double& parameter);